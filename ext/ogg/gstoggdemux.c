@@ -45,6 +45,9 @@
 #define GLIB_DISABLE_DEPRECATION_WARNINGS
 
 #include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
 #include <gst/gst-i18n-plugin.h>
 #include <gst/tag/tag.h>
 
@@ -53,6 +56,8 @@
 #include "gst/glib-compat-private.h"
 
 #define CHUNKSIZE (8500)        /* this is out of vorbisfile */
+/* sequential reads grow up to this size */
+#define MAX_CHUNKSIZE (64*1024)
 
 /* we hope we get a granpos within this many bytes off the end */
 #define DURATION_CHUNK_OFFSET (64*1024)
@@ -60,6 +65,19 @@
 /* stop duration checks within this much of EOS */
 #define EOS_AVOIDANCE_THRESHOLD 8192
 
+/* minimum distance between two entries of the seek index */
+#define INDEX_SPACING (32*1024)
+
+/* seek index cache file layout, all values big endian:
+ *  "OGIX", version (32 bits), file length (64 bits), chains (32 bits)
+ * for each chain:
+ *  chain offset (64 bits), entries (32 bits)
+ *  for each entry: page offset (64 bits), page time (64 bits) */
+#define INDEX_FILE_VERSION 1
+#define INDEX_FILE_HEADER_SIZE 20
+#define INDEX_FILE_CHAIN_SIZE 12
+#define INDEX_FILE_ENTRY_SIZE 16
+
 #define GST_FLOW_LIMIT GST_FLOW_CUSTOM_ERROR
 #define GST_FLOW_SKIP_PUSH GST_FLOW_CUSTOM_SUCCESS_1
 
@@ -82,6 +100,14 @@ GST_DEBUG_CATEGORY (gst_ogg_demux_debug);
 GST_DEBUG_CATEGORY (gst_ogg_demux_setup_debug);
 #define GST_CAT_DEFAULT gst_ogg_demux_debug
 
+/* a page we have seen in the stream, the time is the end time of the page
+ * in the running time of the whole stream */
+typedef struct
+{
+  gint64 offset;
+  GstClockTime time;
+} GstOggIndexEntry;
+
 
 static ogg_packet *
 _ogg_packet_copy (const ogg_packet * packet)
@@ -1787,6 +1813,7 @@ gst_ogg_chain_new (GstOggDemux * ogg)
   chain->segment_start = GST_CLOCK_TIME_NONE;
   chain->segment_stop = GST_CLOCK_TIME_NONE;
   chain->total_time = GST_CLOCK_TIME_NONE;
+  chain->index = g_array_new (FALSE, FALSE, sizeof (GstOggIndexEntry));
 
   return chain;
 }
@@ -1802,6 +1829,7 @@ gst_ogg_chain_free (GstOggChain * chain)
     gst_object_unref (pad);
   }
   g_array_free (chain->streams, TRUE);
+  g_array_free (chain->index, TRUE);
   g_slice_free (GstOggChain, chain);
 }
 
@@ -1932,7 +1960,21 @@ static GstStaticPadTemplate ogg_demux_sink_template_factory =
     GST_STATIC_CAPS ("application/ogg; application/x-annodex")
     );
 
+#define DEFAULT_INDEX_CACHE_DIR NULL
+
+enum
+{
+  PROP_0,
+  PROP_INDEX_CACHE_DIR,
+  PROP_SEEK_PULLS
+};
+
 static void gst_ogg_demux_finalize (GObject * object);
+static void gst_ogg_demux_clear_cache (GstOggDemux * ogg);
+static void gst_ogg_demux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_ogg_demux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 static GstFlowReturn gst_ogg_demux_read_chain (GstOggDemux * ogg,
     GstOggChain ** chain);
@@ -1980,6 +2022,40 @@ gst_ogg_demux_class_init (GstOggDemuxClass * klass)
   gstelement_class->send_event = gst_ogg_demux_receive_event;
 
   gobject_class->finalize = gst_ogg_demux_finalize;
+  gobject_class->set_property = gst_ogg_demux_set_property;
+  gobject_class->get_property = gst_ogg_demux_get_property;
+
+  /**
+   * GstOggDemux:index-cache-dir:
+   *
+   * In pull mode, oggdemux remembers the byte offsets of the pages it reads
+   * and uses them to narrow down later seeks. When this property is set, the
+   * index is stored in a file in this directory when going to READY and
+   * loaded again the next time the same file is opened, so that seeking in
+   * a file without a Skeleton index does not have to bisect the whole file
+   * every time.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_INDEX_CACHE_DIR,
+      g_param_spec_string ("index-cache-dir", "Index cache directory",
+          "Directory to keep the seek index of pulled streams in, "
+          "NULL to not keep the index",
+          DEFAULT_INDEX_CACHE_DIR,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstOggDemux:seek-pulls
+   *
+   * The number of pull requests the last seek in pull mode did. This shows
+   * how much the seek index helped to find the seek position.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_SEEK_PULLS,
+      g_param_spec_uint ("seek-pulls", "Seek pulls",
+          "Number of pull requests done by the last seek in pull mode",
+          0, G_MAXUINT, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -2009,6 +2085,10 @@ gst_ogg_demux_init (GstOggDemux * ogg, GstOggDemuxClass * g_class)
   ogg->stats_bisection_max_steps[0] = 0;
   ogg->stats_bisection_max_steps[1] = 0;
 
+  ogg->index_cache_dir = g_strdup (DEFAULT_INDEX_CACHE_DIR);
+  ogg->chunk_size = CHUNKSIZE;
+  ogg->chunk_end = -1;
+
   ogg->newsegment = NULL;
 }
 
@@ -2027,9 +2107,59 @@ gst_ogg_demux_finalize (GObject * object)
   if (ogg->newsegment)
     gst_event_unref (ogg->newsegment);
 
+  g_free (ogg->index_cache_dir);
+  g_free (ogg->index_cache_file);
+  gst_ogg_demux_clear_cache (ogg);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_ogg_demux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstOggDemux *ogg;
+
+  ogg = GST_OGG_DEMUX (object);
+
+  switch (prop_id) {
+    case PROP_INDEX_CACHE_DIR:
+      GST_OBJECT_LOCK (ogg);
+      g_free (ogg->index_cache_dir);
+      ogg->index_cache_dir = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (ogg);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_ogg_demux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstOggDemux *ogg;
+
+  ogg = GST_OGG_DEMUX (object);
+
+  switch (prop_id) {
+    case PROP_INDEX_CACHE_DIR:
+      GST_OBJECT_LOCK (ogg);
+      g_value_set_string (value, ogg->index_cache_dir);
+      GST_OBJECT_UNLOCK (ogg);
+      break;
+    case PROP_SEEK_PULLS:
+      GST_OBJECT_LOCK (ogg);
+      g_value_set_uint (value, ogg->stats_seek_pulls);
+      GST_OBJECT_UNLOCK (ogg);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static void
 gst_ogg_demux_reset_streams (GstOggDemux * ogg)
 {
@@ -2202,6 +2332,84 @@ gst_ogg_demux_seek (GstOggDemux * ogg, gint64 offset)
   ogg_sync_reset (&ogg->sync);
 }
 
+/* reads that continue where the previous one ended double in size, any other
+ * read (after a seek or while bisecting) starts again from CHUNKSIZE */
+static guint
+gst_ogg_demux_get_chunk_size (GstOggDemux * ogg, gint64 offset)
+{
+  if (offset == ogg->chunk_end)
+    ogg->chunk_size = MIN (ogg->chunk_size * 2, MAX_CHUNKSIZE);
+  else
+    ogg->chunk_size = CHUNKSIZE;
+
+  return ogg->chunk_size;
+}
+
+static void
+gst_ogg_demux_clear_cache (GstOggDemux * ogg)
+{
+  gint i;
+
+  for (i = 0; i < GST_OGG_DEMUX_CACHE_SIZE; i++) {
+    if (ogg->cache[i]) {
+      gst_buffer_unref (ogg->cache[i]);
+      ogg->cache[i] = NULL;
+    }
+  }
+  ogg->cache_next = 0;
+  ogg->chunk_size = CHUNKSIZE;
+  ogg->chunk_end = -1;
+}
+
+/* pull @size bytes at @offset. The last few buffers we pulled are kept so that
+ * scanning backwards for pages does not pull the same data again, when
+ * @offset is in one of them we return a subbuffer of it instead, which can be
+ * smaller than @size. */
+static GstFlowReturn
+gst_ogg_demux_pull_range (GstOggDemux * ogg, gint64 offset, guint size,
+    GstBuffer ** buffer)
+{
+  GstFlowReturn ret;
+  gint i;
+
+  for (i = 0; i < GST_OGG_DEMUX_CACHE_SIZE; i++) {
+    GstBuffer *cached = ogg->cache[i];
+    gint64 skip;
+
+    if (cached == NULL)
+      continue;
+
+    skip = offset - ogg->cache_offset[i];
+    if (skip < 0 || skip >= GST_BUFFER_SIZE (cached))
+      continue;
+
+    size = MIN (size, GST_BUFFER_SIZE (cached) - skip);
+    GST_LOG_OBJECT (ogg, "%u bytes at %" G_GINT64_FORMAT " from cache",
+        size, offset);
+    *buffer = gst_buffer_create_sub (cached, skip, size);
+    ogg->chunk_end = offset + size;
+
+    return GST_FLOW_OK;
+  }
+
+  ogg->stats_pulls++;
+  ret = gst_pad_pull_range (ogg->sinkpad, offset, size, buffer);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  if (GST_BUFFER_SIZE (*buffer) > 0) {
+    i = ogg->cache_next;
+    if (ogg->cache[i])
+      gst_buffer_unref (ogg->cache[i]);
+    ogg->cache[i] = gst_buffer_ref (*buffer);
+    ogg->cache_offset[i] = offset;
+    ogg->cache_next = (i + 1) % GST_OGG_DEMUX_CACHE_SIZE;
+  }
+  ogg->chunk_end = offset + GST_BUFFER_SIZE (*buffer);
+
+  return GST_FLOW_OK;
+}
+
 /* read more data from the current offset and submit to
  * the ogg sync layer.
  */
@@ -2210,6 +2418,7 @@ gst_ogg_demux_get_data (GstOggDemux * ogg, gint64 end_offset)
 {
   GstFlowReturn ret;
   GstBuffer *buffer;
+  guint size;
 
   GST_LOG_OBJECT (ogg,
       "get data %" G_GINT64_FORMAT " %" G_GINT64_FORMAT " %" G_GINT64_FORMAT,
@@ -2221,7 +2430,12 @@ gst_ogg_demux_get_data (GstOggDemux * ogg, gint64 end_offset)
   if (ogg->read_offset == ogg->length)
     goto eos;
 
-  ret = gst_pad_pull_range (ogg->sinkpad, ogg->read_offset, CHUNKSIZE, &buffer);
+  /* don't read much past the boundary when searching in a small range */
+  size = gst_ogg_demux_get_chunk_size (ogg, ogg->read_offset);
+  if (end_offset > 0)
+    size = MIN (size, MAX (end_offset - ogg->read_offset, CHUNKSIZE));
+
+  ret = gst_ogg_demux_pull_range (ogg, ogg->read_offset, size, &buffer);
   if (ret != GST_FLOW_OK)
     goto error;
 
@@ -2346,16 +2560,19 @@ gst_ogg_demux_get_prev_page (GstOggDemux * ogg, ogg_page * og, gint64 * offset)
   gint64 begin = ogg->offset;
   gint64 end = begin;
   gint64 cur_offset = -1;
+  gint64 step = CHUNKSIZE;
 
   GST_LOG_OBJECT (ogg, "getting page before %" G_GINT64_FORMAT, begin);
 
   while (cur_offset == -1) {
-    begin -= CHUNKSIZE;
+    begin -= step;
     if (begin < 0)
       begin = 0;
 
-    /* seek CHUNKSIZE back */
+    /* seek step bytes back, the data we already scanned comes from the
+     * cache. Go back further each time we don't find a page. */
     gst_ogg_demux_seek (ogg, begin);
+    step = MIN (step * 2, MAX_CHUNKSIZE);
 
     /* now continue reading until we run out of data, if we find a page
      * start, we save it. It might not be the final page as there could be
@@ -2614,6 +2831,130 @@ gst_ogg_demux_activate_chain (GstOggDemux * ogg, GstOggChain * chain,
   return TRUE;
 }
 
+/* remember that the page at @offset ends at @time. Pages closer than
+ * INDEX_SPACING to a page we already know are not added. */
+static void
+gst_ogg_demux_index_add (GstOggDemux * ogg, GstOggChain * chain,
+    gint64 offset, GstClockTime time)
+{
+  GstOggIndexEntry *entries = (GstOggIndexEntry *) chain->index->data;
+  GstOggIndexEntry entry;
+  guint lo = 0, hi = chain->index->len;
+
+  while (lo < hi) {
+    guint mid = (lo + hi) / 2;
+
+    if (entries[mid].offset < offset)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  if (lo > 0 && offset - entries[lo - 1].offset < INDEX_SPACING)
+    return;
+  if (lo < chain->index->len && entries[lo].offset - offset < INDEX_SPACING)
+    return;
+
+  GST_LOG_OBJECT (ogg, "indexing page at %" G_GINT64_FORMAT " with time %"
+      GST_TIME_FORMAT, offset, GST_TIME_ARGS (time));
+
+  entry.offset = offset;
+  entry.time = time;
+  g_array_insert_val (chain->index, lo, entry);
+  ogg->index_dirty = TRUE;
+}
+
+/* add a page we read while streaming to the index of @chain */
+static void
+gst_ogg_demux_index_page (GstOggDemux * ogg, GstOggChain * chain,
+    ogg_page * page, gint64 offset)
+{
+  GstOggPad *pad;
+  gint64 granulepos;
+  GstClockTime time;
+
+  if (chain == NULL || !GST_CLOCK_TIME_IS_VALID (chain->begin_time))
+    return;
+
+  granulepos = ogg_page_granulepos (page);
+  if (granulepos == -1)
+    return;
+
+  pad = gst_ogg_chain_get_stream (chain, ogg_page_serialno (page));
+  if (pad == NULL || pad->map.is_skeleton)
+    return;
+
+  time = gst_ogg_stream_get_end_time_for_granulepos (&pad->map, granulepos);
+  if (!GST_CLOCK_TIME_IS_VALID (time) || time < pad->start_time)
+    return;
+
+  gst_ogg_demux_index_add (ogg, chain, offset,
+      time - pad->start_time + chain->begin_time);
+}
+
+/* use the pages in the index to narrow down the range where a page before
+ * @target can be found. Returns TRUE when the range was changed. */
+static gboolean
+gst_ogg_chain_index_bounds (GstOggChain * chain, gint64 target,
+    gint64 * begin, gint64 * end, gint64 * begintime, gint64 * endtime)
+{
+  GstOggIndexEntry *entries = (GstOggIndexEntry *) chain->index->data;
+  GstOggIndexEntry *lo = NULL, *hi = NULL;
+  guint first, last, l, h;
+
+  /* entries are sorted on offset, find the ones inside [begin, end) */
+  l = 0;
+  h = chain->index->len;
+  while (l < h) {
+    guint mid = (l + h) / 2;
+
+    if (entries[mid].offset < *begin)
+      l = mid + 1;
+    else
+      h = mid;
+  }
+  first = l;
+
+  h = chain->index->len;
+  while (l < h) {
+    guint mid = (l + h) / 2;
+
+    if (entries[mid].offset < *end)
+      l = mid + 1;
+    else
+      h = mid;
+  }
+  last = l;
+
+  /* time grows with the offset inside a chain, find the first entry that is
+   * not before the target */
+  l = first;
+  h = last;
+  while (l < h) {
+    guint mid = (l + h) / 2;
+
+    if ((gint64) entries[mid].time < target)
+      l = mid + 1;
+    else
+      h = mid;
+  }
+
+  if (l > first)
+    lo = &entries[l - 1];
+  if (l < last)
+    hi = &entries[l];
+
+  if (lo) {
+    *begin = lo->offset;
+    *begintime = lo->time;
+  }
+  if (hi) {
+    *end = hi->offset;
+    *endtime = hi->time;
+  }
+  return lo != NULL || hi != NULL;
+}
+
 static gboolean
 do_binary_search (GstOggDemux * ogg, GstOggChain * chain, gint64 begin,
     gint64 end, gint64 begintime, gint64 endtime, gint64 target,
@@ -2623,6 +2964,12 @@ do_binary_search (GstOggDemux * ogg, GstOggChain * chain, gint64 begin,
   GstFlowReturn ret;
   gint64 result = 0;
 
+  if (gst_ogg_chain_index_bounds (chain, target, &begin, &end, &begintime,
+          &endtime)) {
+    GST_DEBUG_OBJECT (ogg, "index limits search to %" G_GINT64_FORMAT
+        "-%" G_GINT64_FORMAT, begin, end);
+  }
+
   best = begin;
 
   GST_DEBUG_OBJECT (ogg,
@@ -2712,6 +3059,8 @@ do_binary_search (GstOggDemux * ogg, GstOggChain * chain, gint64 begin,
             "found page with granule %" G_GINT64_FORMAT " and time %"
             GST_TIME_FORMAT, granulepos, GST_TIME_ARGS (granuletime));
 
+        gst_ogg_demux_index_add (ogg, chain, result, granuletime);
+
         if (granuletime < target) {
           best = result;        /* raw offset of packet with granulepos */
           begin = ogg->offset;  /* raw offset of next page */
@@ -3000,6 +3349,7 @@ gst_ogg_demux_perform_seek_pull (GstOggDemux * ogg, GstEvent * event)
   gboolean update;
   guint32 seqnum;
   GstEvent *tevent;
+  guint64 pulls;
 
   if (event) {
     GST_DEBUG_OBJECT (ogg, "seek with event");
@@ -3114,7 +3464,12 @@ gst_ogg_demux_perform_seek_pull (GstOggDemux * ogg, GstEvent * event)
   }
 
   /* for reverse we will already seek accurately */
+  pulls = ogg->stats_pulls;
   res = gst_ogg_demux_do_seek (ogg, &ogg->segment, accurate, keyframe, &chain);
+  GST_OBJECT_LOCK (ogg);
+  ogg->stats_seek_pulls = ogg->stats_pulls - pulls;
+  GST_OBJECT_UNLOCK (ogg);
+  GST_INFO_OBJECT (ogg, "seek did %u pull requests", ogg->stats_seek_pulls);
 
   /* seek failed, make sure we continue the current chain */
   if (!res) {
@@ -4139,6 +4494,14 @@ gst_ogg_demux_chain (GstPad * pad, GstBuffer * buffer)
       /* discontinuity in the pages */
       GST_DEBUG_OBJECT (ogg, "discont in page found, continuing");
     } else {
+      if (ogg->pullmode) {
+        gint64 offset;
+
+        /* the page ends where the unread data in the sync layer starts */
+        offset = ogg->offset - (ogg->sync.fill - ogg->sync.returned) -
+            page.header_len - page.body_len;
+        gst_ogg_demux_index_page (ogg, ogg->current_chain, &page, offset);
+      }
       result = gst_ogg_demux_handle_page (ogg, &page);
       if (result < 0) {
         GST_DEBUG_OBJECT (ogg, "gst_ogg_demux_handle_page returned %d", result);
@@ -4237,6 +4600,224 @@ gst_ogg_demux_check_eos (GstOggDemux * ogg)
   return eos;
 }
 
+/* make the name of the index file from the uri of the stream, its size and,
+ * for local files, its modification time. Returns NULL when the upstream
+ * element has no uri. */
+static gchar *
+gst_ogg_demux_get_index_file (GstOggDemux * ogg, const gchar * dir)
+{
+  GstQuery *query;
+  GChecksum *checksum;
+  gchar *uri = NULL, *filename, *basename, *path;
+  guint8 data[8];
+
+  query = gst_query_new_uri ();
+  if (gst_pad_peer_query (ogg->sinkpad, query)) {
+    gst_query_parse_uri (query, &uri);
+    uri = g_strdup (uri);
+  }
+  gst_query_unref (query);
+
+  if (uri == NULL)
+    return NULL;
+
+  checksum = g_checksum_new (G_CHECKSUM_MD5);
+  g_checksum_update (checksum, (const guchar *) uri, -1);
+  GST_WRITE_UINT64_BE (data, ogg->length);
+  g_checksum_update (checksum, data, 8);
+
+  if ((filename = g_filename_from_uri (uri, NULL, NULL))) {
+    struct stat st;
+
+    if (g_stat (filename, &st) == 0) {
+      GST_WRITE_UINT64_BE (data, (guint64) st.st_mtime);
+      g_checksum_update (checksum, data, 8);
+    }
+    g_free (filename);
+  }
+
+  basename = g_strconcat (g_checksum_get_string (checksum), ".oggidx", NULL);
+  path = g_build_filename (dir, basename, NULL);
+  GST_DEBUG_OBJECT (ogg, "index file of %s is %s", uri, path);
+
+  g_free (basename);
+  g_checksum_free (checksum);
+  g_free (uri);
+
+  return path;
+}
+
+static GstOggChain *
+gst_ogg_demux_find_chain_at (GstOggDemux * ogg, gint64 offset)
+{
+  gint i;
+
+  for (i = 0; i < ogg->chains->len; i++) {
+    GstOggChain *chain = g_array_index (ogg->chains, GstOggChain *, i);
+
+    if (chain->offset == offset)
+      return chain;
+  }
+  return NULL;
+}
+
+/* load the index of the stream we just found the chains of */
+static void
+gst_ogg_demux_load_index (GstOggDemux * ogg)
+{
+  gchar *dir, *contents = NULL;
+  gsize size, pos;
+  guint32 n_chains;
+  guint8 *data;
+
+  g_free (ogg->index_cache_file);
+  ogg->index_cache_file = NULL;
+  ogg->index_dirty = FALSE;
+
+  GST_OBJECT_LOCK (ogg);
+  dir = g_strdup (ogg->index_cache_dir);
+  GST_OBJECT_UNLOCK (ogg);
+
+  if (dir == NULL)
+    return;
+
+  ogg->index_cache_file = gst_ogg_demux_get_index_file (ogg, dir);
+  g_free (dir);
+
+  if (ogg->index_cache_file == NULL)
+    return;
+
+  if (!g_file_get_contents (ogg->index_cache_file, &contents, &size, NULL)) {
+    GST_DEBUG_OBJECT (ogg, "no index file");
+    return;
+  }
+
+  data = (guint8 *) contents;
+  if (size < INDEX_FILE_HEADER_SIZE || memcmp (data, "OGIX", 4) != 0 ||
+      GST_READ_UINT32_BE (data + 4) != INDEX_FILE_VERSION ||
+      GST_READ_UINT64_BE (data + 8) != ogg->length)
+    goto invalid;
+
+  n_chains = GST_READ_UINT32_BE (data + 16);
+  pos = INDEX_FILE_HEADER_SIZE;
+
+  while (n_chains--) {
+    GstOggChain *chain;
+    guint32 i, n_entries;
+    gint64 last = -1;
+
+    if (size - pos < INDEX_FILE_CHAIN_SIZE)
+      goto invalid;
+
+    chain = gst_ogg_demux_find_chain_at (ogg, GST_READ_UINT64_BE (data + pos));
+    n_entries = GST_READ_UINT32_BE (data + pos + 8);
+    pos += INDEX_FILE_CHAIN_SIZE;
+
+    if ((size - pos) / INDEX_FILE_ENTRY_SIZE < n_entries)
+      goto invalid;
+
+    for (i = 0; i < n_entries; i++) {
+      GstOggIndexEntry entry;
+
+      entry.offset = GST_READ_UINT64_BE (data + pos);
+      entry.time = GST_READ_UINT64_BE (data + pos + 8);
+      pos += INDEX_FILE_ENTRY_SIZE;
+
+      if (chain == NULL)
+        continue;
+
+      if (entry.offset <= last || entry.offset < chain->offset ||
+          entry.offset >= chain->end_offset)
+        goto invalid;
+      last = entry.offset;
+
+      g_array_append_val (chain->index, entry);
+    }
+    if (chain) {
+      GST_DEBUG_OBJECT (ogg, "loaded %u index entries for chain at %"
+          G_GINT64_FORMAT, n_entries, chain->offset);
+    }
+  }
+  g_free (contents);
+  return;
+
+  /* ERRORS */
+invalid:
+  {
+    gint i;
+
+    GST_WARNING_OBJECT (ogg, "invalid index file %s", ogg->index_cache_file);
+    for (i = 0; i < ogg->chains->len; i++) {
+      GstOggChain *chain = g_array_index (ogg->chains, GstOggChain *, i);
+
+      g_array_set_size (chain->index, 0);
+    }
+    g_free (contents);
+    return;
+  }
+}
+
+/* write the index to the index file when we learned something new */
+static void
+gst_ogg_demux_save_index (GstOggDemux * ogg)
+{
+  GError *err = NULL;
+  gchar *dir;
+  guint8 *data;
+  gsize size;
+  gint i;
+  guint j;
+
+  if (ogg->index_cache_file == NULL || !ogg->index_dirty)
+    return;
+
+  size = INDEX_FILE_HEADER_SIZE;
+  for (i = 0; i < ogg->chains->len; i++) {
+    GstOggChain *chain = g_array_index (ogg->chains, GstOggChain *, i);
+
+    size += INDEX_FILE_CHAIN_SIZE + chain->index->len * INDEX_FILE_ENTRY_SIZE;
+  }
+
+  data = g_malloc (size);
+  memcpy (data, "OGIX", 4);
+  GST_WRITE_UINT32_BE (data + 4, INDEX_FILE_VERSION);
+  GST_WRITE_UINT64_BE (data + 8, ogg->length);
+  GST_WRITE_UINT32_BE (data + 16, ogg->chains->len);
+  size = INDEX_FILE_HEADER_SIZE;
+
+  for (i = 0; i < ogg->chains->len; i++) {
+    GstOggChain *chain = g_array_index (ogg->chains, GstOggChain *, i);
+
+    GST_WRITE_UINT64_BE (data + size, chain->offset);
+    GST_WRITE_UINT32_BE (data + size + 8, chain->index->len);
+    size += INDEX_FILE_CHAIN_SIZE;
+
+    for (j = 0; j < chain->index->len; j++) {
+      GstOggIndexEntry *entry =
+          &g_array_index (chain->index, GstOggIndexEntry, j);
+
+      GST_WRITE_UINT64_BE (data + size, entry->offset);
+      GST_WRITE_UINT64_BE (data + size + 8, entry->time);
+      size += INDEX_FILE_ENTRY_SIZE;
+    }
+  }
+
+  dir = g_path_get_dirname (ogg->index_cache_file);
+  g_mkdir_with_parents (dir, 0755);
+  g_free (dir);
+
+  if (!g_file_set_contents (ogg->index_cache_file, (const gchar *) data, size,
+          &err)) {
+    GST_WARNING_OBJECT (ogg, "could not write index file: %s", err->message);
+    g_error_free (err);
+  } else {
+    GST_DEBUG_OBJECT (ogg, "wrote %" G_GSIZE_FORMAT " bytes to %s", size,
+        ogg->index_cache_file);
+    ogg->index_dirty = FALSE;
+  }
+  g_free (data);
+}
+
 static GstFlowReturn
 gst_ogg_demux_loop_forward (GstOggDemux * ogg)
 {
@@ -4251,7 +4832,8 @@ gst_ogg_demux_loop_forward (GstOggDemux * ogg)
   }
 
   GST_LOG_OBJECT (ogg, "pull data %" G_GINT64_FORMAT, ogg->offset);
-  ret = gst_pad_pull_range (ogg->sinkpad, ogg->offset, CHUNKSIZE, &buffer);
+  ret = gst_ogg_demux_pull_range (ogg, ogg->offset,
+      gst_ogg_demux_get_chunk_size (ogg, ogg->offset), &buffer);
   if (ret != GST_FLOW_OK) {
     GST_LOG_OBJECT (ogg, "Failed pull_range");
     goto done;
@@ -4309,6 +4891,8 @@ gst_ogg_demux_loop_reverse (GstOggDemux * ogg)
 
   ogg->offset = offset;
 
+  gst_ogg_demux_index_page (ogg, ogg->current_chain, &page, offset);
+
   if (G_UNLIKELY (ogg->newsegment)) {
     gst_ogg_demux_send_event (ogg, ogg->newsegment);
     ogg->newsegment = NULL;
@@ -4388,6 +4972,8 @@ gst_ogg_demux_loop (GstOggPad * pad)
     if (ret != GST_FLOW_OK)
       goto chain_read_failed;
 
+    gst_ogg_demux_load_index (ogg);
+
     ogg->need_chains = FALSE;
 
     GST_OBJECT_LOCK (ogg);
@@ -4617,7 +5203,11 @@ gst_ogg_demux_change_state (GstElement * element, GstStateChange transition)
     case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_ogg_demux_save_index (ogg);
+      g_free (ogg->index_cache_file);
+      ogg->index_cache_file = NULL;
       gst_ogg_demux_clear_chains (ogg);
+      gst_ogg_demux_clear_cache (ogg);
       GST_OBJECT_LOCK (ogg);
       ogg->running = FALSE;
       ogg->segment_running = FALSE;
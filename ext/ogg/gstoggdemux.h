@@ -47,6 +47,8 @@ typedef struct _GstOggPadClass GstOggPadClass;
 
 GType gst_ogg_demux_get_type (void);
 
+#define GST_OGG_DEMUX_CACHE_SIZE 4
+
 typedef struct _GstOggDemux GstOggDemux;
 typedef struct _GstOggDemuxClass GstOggDemuxClass;
 typedef struct _GstOggChain GstOggChain;
@@ -72,6 +74,9 @@ struct _GstOggChain
                                    the start times of all streams. */
   GstClockTime segment_stop;    /* the timestamp of the last page, this is the MAX of the
                                    streams. */
+
+  GArray *index;                /* GstOggIndexEntry of pages seen in pull mode,
+                                   sorted on offset */
 };
 
 /* different modes for the pad */
@@ -199,6 +204,21 @@ struct _GstOggDemux
   gint stats_bisection_max_steps[2];
   gint stats_nbisections;
 
+  /* pull mode seek index */
+  gchar *index_cache_dir;       /* where to keep indexes, NULL to disable */
+  gchar *index_cache_file;      /* index file of the current stream */
+  gboolean index_dirty;         /* index has entries not in the file */
+
+  guint64 stats_pulls;          /* number of pull requests done */
+  guint stats_seek_pulls;       /* number of pull requests of the last seek */
+
+  /* pull mode reading */
+  guint chunk_size;             /* size of the next sequential pull */
+  gint64 chunk_end;             /* where the last pull ended */
+  GstBuffer *cache[GST_OGG_DEMUX_CACHE_SIZE]; /* recently pulled buffers */
+  gint64 cache_offset[GST_OGG_DEMUX_CACHE_SIZE];
+  guint cache_next;             /* cache entry to replace next */
+
   /* ogg stuff */
   ogg_sync_state sync;
 };
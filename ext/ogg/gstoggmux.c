@@ -84,6 +84,8 @@ enum
 #define DEFAULT_MAX_PAGE_DELAY  G_GINT64_CONSTANT(500000000)
 #define DEFAULT_MAX_TOLERANCE   G_GINT64_CONSTANT(40000000)
 #define DEFAULT_SKELETON        FALSE
+#define DEFAULT_LOW_LATENCY     FALSE
+#define DEFAULT_BUFFER_LIST     FALSE
 
 enum
 {
@@ -91,7 +93,9 @@ enum
   ARG_MAX_DELAY,
   ARG_MAX_PAGE_DELAY,
   ARG_MAX_TOLERANCE,
-  ARG_SKELETON
+  ARG_SKELETON,
+  ARG_LOW_LATENCY,
+  ARG_BUFFER_LIST
 };
 
 static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src",
@@ -217,6 +221,34 @@ gst_ogg_mux_class_init (GstOggMuxClass * klass)
           "Whether to include a Skeleton track",
           DEFAULT_SKELETON,
           (GParamFlags) G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstOggMux:low-latency:
+   *
+   * End the page after every packet instead of filling pages, so that each
+   * packet leaves the muxer as soon as the interleaving allows. Useful for
+   * live audio streams, at the cost of a higher page overhead.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, ARG_LOW_LATENCY,
+      g_param_spec_boolean ("low-latency", "Low latency",
+          "End the page after every packet",
+          DEFAULT_LOW_LATENCY,
+          (GParamFlags) G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstOggMux:buffer-list:
+   *
+   * Collect pages until they span #GstOggMux:max-page-delay and push them
+   * downstream in one #GstBufferList, with every page in a group of its own
+   * so that it keeps its timestamp and flags.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, ARG_BUFFER_LIST,
+      g_param_spec_boolean ("buffer-list", "Buffer List",
+          "Push pages in buffer lists",
+          DEFAULT_BUFFER_LIST,
+          (GParamFlags) G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gstelement_class->change_state = gst_ogg_mux_change_state;
 
@@ -236,9 +268,19 @@ gst_ogg_mux_get_sink_event_masks (GstPad * pad)
 }
 #endif
 
+static void
+gst_ogg_mux_clear_pending (GstOggMux * ogg_mux)
+{
+  GstBuffer *buf;
+
+  while ((buf = g_queue_pop_head (ogg_mux->pending)))
+    gst_buffer_unref (buf);
+}
+
 static void
 gst_ogg_mux_clear (GstOggMux * ogg_mux)
 {
+  gst_ogg_mux_clear_pending (ogg_mux);
   ogg_mux->pulling = NULL;
   ogg_mux->need_headers = TRUE;
   ogg_mux->delta_pad = NULL;
@@ -271,6 +313,9 @@ gst_ogg_mux_init (GstOggMux * ogg_mux)
   ogg_mux->max_delay = DEFAULT_MAX_DELAY;
   ogg_mux->max_page_delay = DEFAULT_MAX_PAGE_DELAY;
   ogg_mux->max_tolerance = DEFAULT_MAX_TOLERANCE;
+  ogg_mux->low_latency = DEFAULT_LOW_LATENCY;
+  ogg_mux->buffer_list = DEFAULT_BUFFER_LIST;
+  ogg_mux->pending = g_queue_new ();
 
   gst_ogg_mux_clear (ogg_mux);
 }
@@ -287,6 +332,9 @@ gst_ogg_mux_finalize (GObject * object)
     ogg_mux->collect = NULL;
   }
 
+  gst_ogg_mux_clear_pending (ogg_mux);
+  g_queue_free (ogg_mux->pending);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -574,6 +622,31 @@ gst_ogg_mux_buffer_from_page (GstOggMux * mux, ogg_page * page, gboolean delta)
   return buffer;
 }
 
+/* push the pages collected in buffer-list mode, each page in its own group */
+static GstFlowReturn
+gst_ogg_mux_push_pending (GstOggMux * mux)
+{
+  GstBufferList *list;
+  GstBufferListIterator *it;
+  GstBuffer *buf;
+
+  if (g_queue_is_empty (mux->pending))
+    return GST_FLOW_OK;
+
+  GST_LOG_OBJECT (mux, "pushing list of %u pages",
+      g_queue_get_length (mux->pending));
+
+  list = gst_buffer_list_new ();
+  it = gst_buffer_list_iterate (list);
+  while ((buf = g_queue_pop_head (mux->pending))) {
+    gst_buffer_list_iterator_add_group (it);
+    gst_buffer_list_iterator_add (it, buf);
+  }
+  gst_buffer_list_iterator_free (it);
+
+  return gst_pad_push_list (mux->srcpad, list);
+}
+
 static GstFlowReturn
 gst_ogg_mux_push_buffer (GstOggMux * mux, GstBuffer * buffer,
     GstOggPadData * oggpad)
@@ -599,6 +672,22 @@ gst_ogg_mux_push_buffer (GstOggMux * mux, GstBuffer * buffer,
   if (caps)
     gst_caps_unref (caps);
 
+  if (mux->buffer_list) {
+    GstBuffer *first;
+
+    g_queue_push_tail (mux->pending, buffer);
+
+    /* push when the pages cover enough time */
+    first = g_queue_peek_head (mux->pending);
+    if (GST_BUFFER_TIMESTAMP_IS_VALID (first) &&
+        GST_BUFFER_TIMESTAMP_IS_VALID (buffer) &&
+        GST_BUFFER_TIMESTAMP (buffer) - GST_BUFFER_TIMESTAMP (first) >=
+        mux->max_page_delay)
+      return gst_ogg_mux_push_pending (mux);
+
+    return GST_FLOW_OK;
+  }
+
   return gst_pad_push (mux->srcpad, buffer);
 }
 
@@ -1529,9 +1618,24 @@ gst_ogg_mux_send_headers (GstOggMux * mux)
   g_list_foreach (hbufs, (GFunc) gst_mini_object_unref, NULL);
   g_list_free (hbufs);
 
+  /* don't hold back the headers in buffer-list mode */
+  if (ret == GST_FLOW_OK)
+    ret = gst_ogg_mux_push_pending (mux);
+
   return ret;
 }
 
+/* get the next complete page of @pad, in low-latency mode the page is ended
+ * after every packet */
+static gint
+gst_ogg_mux_pageout (GstOggMux * mux, GstOggPadData * pad, ogg_page * page)
+{
+  if (mux->low_latency)
+    return ogg_stream_flush (&pad->map.stream, page);
+
+  return ogg_stream_pageout (&pad->map.stream, page);
+}
+
 /* this function is called to process data on the best pending pad.
  *
  * basic idea:
@@ -1636,7 +1740,10 @@ gst_ogg_mux_process_best_pad (GstOggMux * ogg_mux, GstOggPadData * best)
           GST_TIME_FORMAT, GST_TIME_ARGS (ogg_mux->next_ts));
     } else {
       /* no pad to pull on, send EOS */
+      ret = gst_ogg_mux_push_pending (ogg_mux);
       gst_pad_push_event (ogg_mux->srcpad, gst_event_new_eos ());
+      if (ret != GST_FLOW_OK)
+        return ret;
       return GST_FLOW_WRONG_STATE;
     }
   }
@@ -1787,7 +1894,7 @@ gst_ogg_mux_process_best_pad (GstOggMux * ogg_mux, GstOggPadData * best)
 
     /* let ogg write out the pages now. The packet we got could end
      * up in more than one page so we need to write them all */
-    if (ogg_stream_pageout (&pad->map.stream, &page) > 0) {
+    if (gst_ogg_mux_pageout (ogg_mux, pad, &page) > 0) {
       /* we have a new page, so we need to timestamp it correctly.
        * if this fresh packet ends on this page, then the page's granulepos
        * comes from that packet, and we should set this buffer's timestamp */
@@ -1827,7 +1934,7 @@ gst_ogg_mux_process_best_pad (GstOggMux * ogg_mux, GstOggPadData * best)
 
       /* use an inner loop here to flush the remaining pages and
        * mark them as delta frames as well */
-      while (ogg_stream_pageout (&pad->map.stream, &page) > 0) {
+      while (gst_ogg_mux_pageout (ogg_mux, pad, &page) > 0) {
         if (ogg_page_granulepos (&page) == granulepos) {
           /* the page has taken up the new packet completely, which means
            * the packet ends the page and we can update the gp time
@@ -1924,7 +2031,13 @@ gst_ogg_mux_collected (GstCollectPads2 * pads, GstOggMux * ogg_mux)
   ret = gst_ogg_mux_process_best_pad (ogg_mux, best);
 
   if (best->eos && all_pads_eos (pads)) {
+    GstFlowReturn pending_ret;
+
+    /* report a failure to push the last pages instead of plain EOS */
+    pending_ret = gst_ogg_mux_push_pending (ogg_mux);
     gst_pad_push_event (ogg_mux->srcpad, gst_event_new_eos ());
+    if (pending_ret != GST_FLOW_OK)
+      return pending_ret;
     return GST_FLOW_UNEXPECTED;
   }
 
@@ -1952,6 +2065,12 @@ gst_ogg_mux_get_property (GObject * object,
     case ARG_SKELETON:
       g_value_set_boolean (value, ogg_mux->use_skeleton);
       break;
+    case ARG_LOW_LATENCY:
+      g_value_set_boolean (value, ogg_mux->low_latency);
+      break;
+    case ARG_BUFFER_LIST:
+      g_value_set_boolean (value, ogg_mux->buffer_list);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1979,6 +2098,12 @@ gst_ogg_mux_set_property (GObject * object,
     case ARG_SKELETON:
       ogg_mux->use_skeleton = g_value_get_boolean (value);
       break;
+    case ARG_LOW_LATENCY:
+      ogg_mux->low_latency = g_value_get_boolean (value);
+      break;
+    case ARG_BUFFER_LIST:
+      ogg_mux->buffer_list = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2077,6 +2202,7 @@ gst_ogg_mux_change_state (GstElement * element, GstStateChange transition)
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       gst_ogg_mux_clear_collectpads (ogg_mux->collect);
+      gst_ogg_mux_clear_pending (ogg_mux);
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
       break;
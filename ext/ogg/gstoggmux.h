@@ -132,6 +132,13 @@ struct _GstOggMux
 
   /* whether to create a skeleton track */
   gboolean use_skeleton;
+
+  /* end a page after every packet */
+  gboolean low_latency;
+
+  /* collect pages and push them in buffer lists */
+  gboolean buffer_list;
+  GQueue *pending;              /* pages not pushed yet in buffer-list mode */
 };
 
 struct _GstOggMuxClass
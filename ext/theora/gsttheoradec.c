@@ -107,6 +107,9 @@ static const GstEventMask *theora_get_event_masks (GstPad * pad);
 #endif
 static const GstQueryType *theora_get_query_types (GstPad * pad);
 
+static void theora_dec_stripe_decoded (void *ctx, th_ycbcr_buffer buf,
+    int yfrag0, int yfrag_end);
+
 
 static void
 gst_theora_dec_base_init (gpointer g_class)
@@ -812,6 +815,7 @@ theora_handle_type_packet (GstTheoraDec * dec, ogg_packet * packet)
   GstFlowReturn ret = GST_FLOW_OK;
   GList *walk;
   guint32 fourcc;
+  th_stripe_callback stripe_cb;
 
   GST_DEBUG_OBJECT (dec, "fps %d/%d, PAR %d/%d",
       dec->info.fps_numerator, dec->info.fps_denominator,
@@ -907,6 +911,13 @@ theora_handle_type_packet (GstTheoraDec * dec, ogg_packet * packet)
     GST_WARNING_OBJECT (dec, "Could not enable BITS mode visualisation");
   }
 
+  stripe_cb.ctx = dec;
+  stripe_cb.stripe_decoded = theora_dec_stripe_decoded;
+  if (th_decode_ctl (dec->decoder, TH_DECCTL_SET_STRIPE_CB, &stripe_cb,
+          sizeof (stripe_cb)) < 0) {
+    GST_WARNING_OBJECT (dec, "Could not set stripe callback");
+  }
+
   caps = gst_caps_new_simple ("video/x-raw-yuv",
       "format", GST_TYPE_FOURCC, fourcc,
       "framerate", GST_TYPE_FRACTION,
@@ -1047,60 +1058,105 @@ theora_dec_push_reverse (GstTheoraDec * dec, GstBuffer * buf)
   return result;
 }
 
-/* Allocate buffer and copy image data into Y444 format */
-static GstFlowReturn
-theora_handle_image (GstTheoraDec * dec, th_ycbcr_buffer buf, GstBuffer ** out)
+static GstVideoFormat
+theora_dec_get_format (GstTheoraDec * dec)
 {
-  gint width, height, stride;
-  GstFlowReturn result;
-  int i, plane;
-  GstVideoFormat format;
-  guint8 *dest, *src;
-
   switch (dec->info.pixel_fmt) {
     case TH_PF_444:
-      format = GST_VIDEO_FORMAT_Y444;
-      break;
+      return GST_VIDEO_FORMAT_Y444;
     case TH_PF_420:
-      format = GST_VIDEO_FORMAT_I420;
-      break;
+      return GST_VIDEO_FORMAT_I420;
     case TH_PF_422:
-      format = GST_VIDEO_FORMAT_Y42B;
-      break;
+      return GST_VIDEO_FORMAT_Y42B;
     default:
       g_assert_not_reached ();
   }
+  return GST_VIDEO_FORMAT_UNKNOWN;
+}
+
+static GstFlowReturn
+theora_dec_alloc_buffer (GstTheoraDec * dec, GstBuffer ** out)
+{
+  GstFlowReturn result;
 
   result =
       gst_pad_alloc_buffer_and_set_caps (dec->srcpad, GST_BUFFER_OFFSET_NONE,
-      gst_video_format_get_size (format, dec->width, dec->height),
-      GST_PAD_CAPS (dec->srcpad), out);
+      gst_video_format_get_size (theora_dec_get_format (dec), dec->width,
+          dec->height), GST_PAD_CAPS (dec->srcpad), out);
   if (G_UNLIKELY (result != GST_FLOW_OK)) {
     GST_DEBUG_OBJECT (dec, "could not get buffer, reason: %s",
         gst_flow_get_name (result));
-    return result;
   }
+  return result;
+}
+
+/* copy the part of the output picture that lies in the luma rows @y0 to @y1
+ * of the decoded frame into @out */
+static void
+theora_dec_copy_rows (GstTheoraDec * dec, th_ycbcr_buffer buf,
+    GstBuffer * out, gint y0, gint y1)
+{
+  gint width, height, stride;
+  gint plane, i, first, last, xshift, yshift;
+  GstVideoFormat format;
+  guint8 *dest, *src;
+
+  format = theora_dec_get_format (dec);
 
   for (plane = 0; plane < 3; plane++) {
     width = gst_video_format_get_component_width (format, plane, dec->width);
     height = gst_video_format_get_component_height (format, plane, dec->height);
     stride = gst_video_format_get_row_stride (format, plane, dec->width);
+    xshift = (width == dec->width) ? 0 : 1;
+    yshift = (height == dec->height) ? 0 : 1;
+
+    /* rows of the plane in the decoded frame */
+    first = MAX (y0 >> yshift, dec->offset_y >> yshift);
+    last = MIN (y1 >> yshift, (dec->offset_y >> yshift) + height);
+    if (first >= last)
+      continue;
 
     dest =
-        GST_BUFFER_DATA (*out) + gst_video_format_get_component_offset (format,
+        GST_BUFFER_DATA (out) + gst_video_format_get_component_offset (format,
         plane, dec->width, dec->height);
-    src = buf[plane].data;
-    src += ((height == dec->height) ? dec->offset_y : dec->offset_y / 2)
-        * buf[plane].stride;
-    src += (width == dec->width) ? dec->offset_x : dec->offset_x / 2;
+    dest += (first - (dec->offset_y >> yshift)) * stride;
+    src = buf[plane].data + first * buf[plane].stride;
+    src += dec->offset_x >> xshift;
 
-    for (i = 0; i < height; i++) {
+    for (i = first; i < last; i++) {
       memcpy (dest, src, width);
 
       dest += stride;
       src += buf[plane].stride;
     }
   }
+}
+
+/* called by libtheora while decoding a packet, every time a stripe of rows of
+ * the frame is done. Copying them right away, while they are still in the
+ * cache, avoids a second pass over the whole frame. */
+static void
+theora_dec_stripe_decoded (void *ctx, th_ycbcr_buffer buf, int yfrag0,
+    int yfrag_end)
+{
+  GstTheoraDec *dec = ctx;
+
+  if (dec->stripe_out)
+    theora_dec_copy_rows (dec, buf, dec->stripe_out, yfrag0 * 8,
+        yfrag_end * 8);
+}
+
+/* Allocate buffer and copy image data into Y444 format */
+static GstFlowReturn
+theora_handle_image (GstTheoraDec * dec, th_ycbcr_buffer buf, GstBuffer ** out)
+{
+  GstFlowReturn result;
+
+  result = theora_dec_alloc_buffer (dec, out);
+  if (G_UNLIKELY (result != GST_FLOW_OK))
+    return result;
+
+  theora_dec_copy_rows (dec, buf, *out, 0, dec->info.frame_height);
 
   return GST_FLOW_OK;
 }
@@ -1111,10 +1167,12 @@ theora_handle_data_packet (GstTheoraDec * dec, ogg_packet * packet,
 {
   /* normal data packet */
   th_ycbcr_buffer buf;
-  GstBuffer *out;
+  GstBuffer *out = NULL;
   gboolean keyframe;
-  GstFlowReturn result;
+  gboolean need_skip = FALSE;
+  GstFlowReturn result = GST_FLOW_OK;
   ogg_int64_t gp;
+  int ret;
 
   if (G_UNLIKELY (!dec->have_header))
     goto not_initialized;
@@ -1140,14 +1198,7 @@ theora_handle_data_packet (GstTheoraDec * dec, ogg_packet * packet,
     goto dropping;
   }
 
-  GST_DEBUG_OBJECT (dec, "parsing data packet");
-
-  /* this does the decoding */
-  if (G_UNLIKELY (th_decode_packetin (dec->decoder, packet, &gp) < 0))
-    goto decode_error;
-
   if (outtime != -1) {
-    gboolean need_skip;
     GstClockTime running_time;
     GstClockTime earliest_time;
     gdouble proportion;
@@ -1186,24 +1237,53 @@ theora_handle_data_packet (GstTheoraDec * dec, ogg_packet * packet,
       gst_message_set_qos_stats (qos_msg, GST_FORMAT_BUFFERS,
           dec->processed, dec->dropped);
       gst_element_post_message (GST_ELEMENT_CAST (dec), qos_msg);
-
-      goto dropping_qos;
     }
   }
 
-  /* this does postprocessing and set up the decoded frame
-   * pointers in our yuv variable */
-  if (G_UNLIKELY (th_decode_ycbcr_out (dec->decoder, buf) < 0))
-    goto no_yuv;
+  /* without telemetry nothing is drawn on the frame after decoding and we can
+   * copy the rows to the output buffer while they are decoded */
+  if (!need_skip && !dec->telemetry_mv && !dec->telemetry_mbmode &&
+      !dec->telemetry_qi && !dec->telemetry_bits)
+    result = theora_dec_alloc_buffer (dec, &out);
 
-  if (G_UNLIKELY ((buf[0].width != dec->info.frame_width)
-          || (buf[0].height != dec->info.frame_height)))
-    goto wrong_dimensions;
+  GST_DEBUG_OBJECT (dec, "parsing data packet");
+
+  /* this does the decoding, we need to do this even when we don't output the
+   * frame so that the following frames can be decoded */
+  dec->stripe_out = out;
+  ret = th_decode_packetin (dec->decoder, packet, &gp);
+  dec->stripe_out = NULL;
+
+  if (G_UNLIKELY (ret < 0))
+    goto decode_error;
 
-  result = theora_handle_image (dec, buf, &out);
-  if (result != GST_FLOW_OK)
+  if (G_UNLIKELY (result != GST_FLOW_OK))
     return result;
 
+  if (need_skip)
+    goto dropping_qos;
+
+  /* a duplicate frame is not decoded so the stripe callback was not called,
+   * get the frame from the decoder, which also draws the telemetry */
+  if (out == NULL || ret == TH_DUPFRAME) {
+    /* this does postprocessing and set up the decoded frame
+     * pointers in our yuv variable */
+    if (G_UNLIKELY (th_decode_ycbcr_out (dec->decoder, buf) < 0))
+      goto no_yuv;
+
+    if (G_UNLIKELY ((buf[0].width != dec->info.frame_width)
+            || (buf[0].height != dec->info.frame_height)))
+      goto wrong_dimensions;
+
+    if (out == NULL) {
+      result = theora_handle_image (dec, buf, &out);
+      if (result != GST_FLOW_OK)
+        return result;
+    } else {
+      theora_dec_copy_rows (dec, buf, out, 0, dec->info.frame_height);
+    }
+  }
+
   GST_BUFFER_OFFSET (out) = dec->frame_nr;
   if (dec->frame_nr != -1)
     dec->frame_nr++;
@@ -1244,18 +1324,24 @@ dropping_qos:
   }
 decode_error:
   {
+    if (out)
+      gst_buffer_unref (out);
     GST_ELEMENT_ERROR (GST_ELEMENT (dec), STREAM, DECODE,
         (NULL), ("theora decoder did not decode data packet"));
     return GST_FLOW_ERROR;
   }
 no_yuv:
   {
+    if (out)
+      gst_buffer_unref (out);
     GST_ELEMENT_ERROR (GST_ELEMENT (dec), STREAM, DECODE,
         (NULL), ("couldn't read out YUV image"));
     return GST_FLOW_ERROR;
   }
 wrong_dimensions:
   {
+    if (out)
+      gst_buffer_unref (out);
     GST_ELEMENT_ERROR (GST_ELEMENT (dec), STREAM, FORMAT,
         (NULL), ("dimensions of image do not match header"));
     return GST_FLOW_ERROR;
@@ -106,6 +106,10 @@ struct _GstTheoraDec
   gboolean have_par;
   gint par_num;
   gint par_den;
+
+  /* buffer the stripe callback copies decoded rows into, only set while
+   * decoding a packet */
+  GstBuffer *stripe_out;
 };
 
 struct _GstTheoraDecClass
@@ -130,6 +130,7 @@ _ilog (unsigned int v)
 #define THEORA_DEF_RATE_BUFFER          0
 #define THEORA_DEF_MULTIPASS_CACHE_FILE NULL
 #define THEORA_DEF_MULTIPASS_MODE       MULTIPASS_MODE_SINGLE_PASS
+#define THEORA_DEF_THREADS              1
 enum
 {
   PROP_0,
@@ -152,7 +153,8 @@ enum
   PROP_CAP_UNDERFLOW,
   PROP_RATE_BUFFER,
   PROP_MULTIPASS_CACHE_FILE,
-  PROP_MULTIPASS_MODE
+  PROP_MULTIPASS_MODE,
+  PROP_THREADS
       /* FILL ME */
 };
 
@@ -276,6 +278,8 @@ static void theora_enc_finalize (GObject * object);
 
 static gboolean theora_enc_write_multipass_cache (GstTheoraEnc * enc,
     gboolean begin, gboolean eos);
+static GstFlowReturn theora_enc_drain (GstTheoraEnc * enc);
+static void theora_enc_abort_gops (GstTheoraEnc * enc);
 
 static char *theora_enc_get_supported_formats (void);
 
@@ -418,6 +422,22 @@ gst_theora_enc_class_init (GstTheoraEncClass * klass)
           "Single pass or first/second pass", GST_TYPE_MULTIPASS_MODE,
           THEORA_DEF_MULTIPASS_MODE,
           (GParamFlags) G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstTheoraEnc:threads:
+   *
+   * Number of GOPs to encode in parallel. The input is split into GOPs of
+   * #GstTheoraEnc:keyframe-force frames that each start with a keyframe and
+   * are encoded by their own encoder instance, the encoded GOPs are pushed
+   * in order. Up to this many GOPs of raw frames can be queued, rate control
+   * restarts at every GOP and multipass encoding is always done serially.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_THREADS,
+      g_param_spec_int ("threads", "Threads",
+          "Number of GOPs to encode in parallel, 1 to encode serially",
+          1, 64, THEORA_DEF_THREADS,
+          (GParamFlags) G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   caps_string = g_strdup_printf ("video/x-raw-yuv, "
       "format = (fourcc) { %s }, "
@@ -466,6 +486,11 @@ gst_theora_enc_init (GstTheoraEnc * enc, GstTheoraEncClass * g_class)
 
   enc->multipass_mode = THEORA_DEF_MULTIPASS_MODE;
   enc->multipass_cache_file = THEORA_DEF_MULTIPASS_CACHE_FILE;
+
+  enc->threads = THEORA_DEF_THREADS;
+  enc->gop_lock = g_mutex_new ();
+  enc->gop_cond = g_cond_new ();
+  enc->gops = g_queue_new ();
 }
 
 static void
@@ -497,12 +522,18 @@ theora_enc_finalize (GObject * object)
 
   theora_enc_clear_multipass_cache (enc);
 
+  g_mutex_free (enc->gop_lock);
+  g_cond_free (enc->gop_cond);
+  g_queue_free (enc->gops);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
-static void
-theora_enc_reset (GstTheoraEnc * enc)
+/* allocate a new encoder for the current settings */
+static th_enc_ctx *
+theora_enc_alloc_encoder (GstTheoraEnc * enc)
 {
+  th_enc_ctx *encoder;
   ogg_uint32_t keyframe_force;
   int rate_flags;
 
@@ -519,14 +550,12 @@ theora_enc_reset (GstTheoraEnc * enc)
   enc->quality_changed = FALSE;
   GST_OBJECT_UNLOCK (enc);
 
-  if (enc->encoder)
-    th_encode_free (enc->encoder);
-  enc->encoder = th_encode_alloc (&enc->info);
+  encoder = th_encode_alloc (&enc->info);
   /* We ensure this function cannot fail. */
-  g_assert (enc->encoder != NULL);
-  th_encode_ctl (enc->encoder, TH_ENCCTL_SET_SPLEVEL, &enc->speed_level,
+  g_assert (encoder != NULL);
+  th_encode_ctl (encoder, TH_ENCCTL_SET_SPLEVEL, &enc->speed_level,
       sizeof (enc->speed_level));
-  th_encode_ctl (enc->encoder, TH_ENCCTL_SET_VP3_COMPATIBLE,
+  th_encode_ctl (encoder, TH_ENCCTL_SET_VP3_COMPATIBLE,
       &enc->vp3_compatible, sizeof (enc->vp3_compatible));
 
   rate_flags = 0;
@@ -536,11 +565,11 @@ theora_enc_reset (GstTheoraEnc * enc)
     rate_flags |= TH_RATECTL_CAP_OVERFLOW;
   if (enc->drop_frames)
     rate_flags |= TH_RATECTL_CAP_UNDERFLOW;
-  th_encode_ctl (enc->encoder, TH_ENCCTL_SET_RATE_FLAGS,
+  th_encode_ctl (encoder, TH_ENCCTL_SET_RATE_FLAGS,
       &rate_flags, sizeof (rate_flags));
 
   if (enc->rate_buffer) {
-    th_encode_ctl (enc->encoder, TH_ENCCTL_SET_RATE_BUFFER,
+    th_encode_ctl (encoder, TH_ENCCTL_SET_RATE_BUFFER,
         &enc->rate_buffer, sizeof (enc->rate_buffer));
   } else {
     /* FIXME */
@@ -548,9 +577,19 @@ theora_enc_reset (GstTheoraEnc * enc)
 
   keyframe_force = enc->keyframe_auto ?
       enc->keyframe_force : enc->keyframe_freq;
-  th_encode_ctl (enc->encoder, TH_ENCCTL_SET_KEYFRAME_FREQUENCY_FORCE,
+  th_encode_ctl (encoder, TH_ENCCTL_SET_KEYFRAME_FREQUENCY_FORCE,
       &keyframe_force, sizeof (keyframe_force));
 
+  return encoder;
+}
+
+static void
+theora_enc_reset (GstTheoraEnc * enc)
+{
+  if (enc->encoder)
+    th_encode_free (enc->encoder);
+  enc->encoder = theora_enc_alloc_encoder (enc);
+
   /* Get placeholder data */
   if (enc->multipass_cache_fd
       && enc->multipass_mode == MULTIPASS_MODE_FIRST_PASS)
@@ -564,6 +603,7 @@ theora_enc_clear (GstTheoraEnc * enc)
   enc->bytes_out = 0;
   enc->granulepos_offset = 0;
   enc->timestamp_offset = 0;
+  enc->gop_granulepos = 0;
 
   enc->next_ts = GST_CLOCK_TIME_NONE;
   enc->next_discont = FALSE;
@@ -681,6 +721,9 @@ theora_enc_sink_setcaps (GstPad * pad, GstCaps * caps)
   gst_structure_get_fraction (structure, "framerate", &fps_n, &fps_d);
   par = gst_structure_get_value (structure, "pixel-aspect-ratio");
 
+  /* the encoding threads use the old info */
+  theora_enc_drain (enc);
+
   th_info_clear (&enc->info);
   th_info_init (&enc->info);
   /* Theora has a divisible-by-sixteen restriction for the encoded video size but
@@ -747,47 +790,73 @@ granulepos_add (guint64 granulepos, guint64 addend, gint shift)
   return (iframe << shift) + pframe;
 }
 
-/* prepare a buffer for transmission by passing data through libtheora */
-static GstFlowReturn
-theora_buffer_from_packet (GstTheoraEnc * enc, ogg_packet * packet,
-    GstClockTime timestamp, GstClockTime running_time,
-    GstClockTime duration, GstBuffer ** buffer)
+/* copy a packet from libtheora into a buffer, OFFSET_END is set to the
+ * granulepos of the packet */
+static GstBuffer *
+theora_enc_buffer_new (ogg_packet * packet, GstClockTime timestamp,
+    GstClockTime duration)
 {
   GstBuffer *buf;
-  GstFlowReturn ret = GST_FLOW_OK;
 
   buf = gst_buffer_new_and_alloc (packet->bytes);
-  if (!buf) {
-    GST_WARNING_OBJECT (enc, "Could not allocate buffer");
-    ret = GST_FLOW_ERROR;
-    goto done;
-  }
+  if (!buf)
+    return NULL;
 
   memcpy (GST_BUFFER_DATA (buf), packet->packet, packet->bytes);
+  GST_BUFFER_OFFSET_END (buf) = packet->granulepos;
+
+  GST_BUFFER_TIMESTAMP (buf) = timestamp;
+  GST_BUFFER_DURATION (buf) = duration;
+
+  /* th_packet_iskeyframe returns positive for keyframes */
+  if (th_packet_iskeyframe (packet) > 0) {
+    GST_BUFFER_FLAG_UNSET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+  } else {
+    GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+  }
+
+  return buf;
+}
+
+/* set caps, granulepos and discont on a buffer from theora_enc_buffer_new()
+ * just before it is pushed */
+static void
+theora_enc_finish_buffer (GstTheoraEnc * enc, GstBuffer * buf)
+{
   gst_buffer_set_caps (buf, GST_PAD_CAPS (enc->srcpad));
   /* see ext/ogg/README; OFFSET_END takes "our" granulepos, OFFSET its
    * time representation */
   GST_BUFFER_OFFSET_END (buf) =
-      granulepos_add (packet->granulepos, enc->granulepos_offset,
+      granulepos_add (GST_BUFFER_OFFSET_END (buf), enc->granulepos_offset,
       enc->info.keyframe_granule_shift);
   GST_BUFFER_OFFSET (buf) = granulepos_to_timestamp (enc,
       GST_BUFFER_OFFSET_END (buf));
 
-  GST_BUFFER_TIMESTAMP (buf) = timestamp;
-  GST_BUFFER_DURATION (buf) = duration;
-
   if (enc->next_discont) {
     GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
     enc->next_discont = FALSE;
   }
 
-  /* th_packet_iskeyframe returns positive for keyframes */
-  if (th_packet_iskeyframe (packet) > 0) {
-    GST_BUFFER_FLAG_UNSET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
-  } else {
-    GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
-  }
   enc->packetno++;
+}
+
+/* prepare a buffer for transmission by passing data through libtheora */
+static GstFlowReturn
+theora_buffer_from_packet (GstTheoraEnc * enc, ogg_packet * packet,
+    GstClockTime timestamp, GstClockTime running_time,
+    GstClockTime duration, GstBuffer ** buffer)
+{
+  GstBuffer *buf;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  buf = theora_enc_buffer_new (packet, timestamp, duration);
+  if (!buf) {
+    GST_WARNING_OBJECT (enc, "Could not allocate buffer");
+    ret = GST_FLOW_ERROR;
+    goto done;
+  }
+
+  theora_enc_finish_buffer (enc, buf);
 
 done:
   *buffer = buf;
@@ -868,6 +937,13 @@ theora_enc_force_keyframe (GstTheoraEnc * enc)
 {
   GstClockTime next_ts;
 
+  if (enc->pool) {
+    /* the next frame starts a new GOP, push out the frames before it so that
+     * the force key unit event stays in order with the data */
+    theora_enc_drain (enc);
+    return;
+  }
+
   /* make sure timestamps increment after resetting the decoder */
   next_ts = enc->next_ts + enc->timestamp_offset;
 
@@ -887,6 +963,11 @@ theora_enc_sink_event (GstPad * pad, GstEvent * event)
 
   enc = GST_THEORA_ENC (GST_PAD_PARENT (pad));
 
+  /* push out the GOPs being encoded before serialized events */
+  if (GST_EVENT_IS_SERIALIZED (event)
+      && GST_EVENT_TYPE (event) != GST_EVENT_FLUSH_STOP)
+    theora_enc_drain (enc);
+
   switch (GST_EVENT_TYPE (event)) {
     case GST_EVENT_NEWSEGMENT:
     {
@@ -925,6 +1006,7 @@ theora_enc_sink_event (GstPad * pad, GstEvent * event)
       res = gst_pad_push_event (enc->srcpad, event);
       break;
     case GST_EVENT_FLUSH_STOP:
+      theora_enc_abort_gops (enc);
       gst_segment_init (&enc->segment, GST_FORMAT_UNDEFINED);
       res = gst_pad_push_event (enc->srcpad, event);
       break;
@@ -1226,6 +1308,254 @@ data_push:
   }
 }
 
+struct _GstTheoraEncGop
+{
+  th_enc_ctx *encoder;
+  /* raw frames to encode, terminated by pushing the GOP itself */
+  GAsyncQueue *frames;
+  guint n_frames;
+
+  guint64 granulepos_offset;
+  gboolean discont;
+
+  /* protected by the gop_lock */
+  GQueue packets;
+  gboolean done;
+  gboolean aborted;
+
+  /* only used by the encoding thread */
+  GstClockTime next_ts;
+};
+
+static GstTheoraEncGop *
+theora_enc_gop_new (GstTheoraEnc * enc)
+{
+  GstTheoraEncGop *gop;
+
+  gop = g_slice_new0 (GstTheoraEncGop);
+  gop->encoder = theora_enc_alloc_encoder (enc);
+  gop->frames = g_async_queue_new ();
+  g_queue_init (&gop->packets);
+
+  return gop;
+}
+
+static void
+theora_enc_gop_free (GstTheoraEncGop * gop)
+{
+  th_encode_free (gop->encoder);
+  g_async_queue_unref (gop->frames);
+  g_queue_foreach (&gop->packets, (GFunc) gst_mini_object_unref, NULL);
+  g_queue_clear (&gop->packets);
+  g_slice_free (GstTheoraEncGop, gop);
+}
+
+/* runs in a thread of the pool and encodes the frames of one GOP, the
+ * granulepos of the packets is relative to the start of the GOP */
+static void
+theora_enc_gop_func (gpointer data, gpointer user_data)
+{
+  GstTheoraEnc *enc = user_data;
+  GstTheoraEncGop *gop = data;
+  gpointer frame;
+
+  while ((frame = g_async_queue_pop (gop->frames)) != gop) {
+    GstBuffer *buffer = frame;
+    th_ycbcr_buffer ycbcr;
+    ogg_packet op;
+    gboolean aborted;
+    gint res;
+
+    g_mutex_lock (enc->gop_lock);
+    aborted = gop->aborted;
+    g_mutex_unlock (enc->gop_lock);
+
+    if (aborted) {
+      gst_buffer_unref (buffer);
+      continue;
+    }
+
+    theora_enc_init_buffer (ycbcr, &enc->info, GST_BUFFER_DATA (buffer));
+    res = th_encode_ycbcr_in (gop->encoder, ycbcr);
+    /* none of the failure cases can happen here */
+    g_assert (res == 0);
+
+    while (th_encode_packetout (gop->encoder, 0, &op)) {
+      GstClockTime next_time;
+      GstBuffer *buf;
+
+      next_time = th_granule_time (gop->encoder, op.granulepos) * GST_SECOND;
+      buf = theora_enc_buffer_new (&op, GST_BUFFER_TIMESTAMP (buffer),
+          next_time - gop->next_ts);
+      gop->next_ts = next_time;
+
+      g_mutex_lock (enc->gop_lock);
+      g_queue_push_tail (&gop->packets, buf);
+      g_cond_broadcast (enc->gop_cond);
+      g_mutex_unlock (enc->gop_lock);
+    }
+    gst_buffer_unref (buffer);
+  }
+
+  g_mutex_lock (enc->gop_lock);
+  gop->done = TRUE;
+  g_cond_broadcast (enc->gop_cond);
+  g_mutex_unlock (enc->gop_lock);
+}
+
+/* no more frames go into the current GOP */
+static void
+theora_enc_close_gop (GstTheoraEnc * enc)
+{
+  GstTheoraEncGop *gop = enc->cur_gop;
+
+  if (gop == NULL)
+    return;
+
+  enc->gop_granulepos = gop->granulepos_offset + gop->n_frames;
+  g_async_queue_push (gop->frames, gop);
+  enc->cur_gop = NULL;
+}
+
+/* push the packets encoded so far in stream order, waiting until no more
+ * than @max_gops GOPs are left */
+static GstFlowReturn
+theora_enc_push_gops (GstTheoraEnc * enc, guint max_gops)
+{
+  GstTheoraEncGop *gop;
+  GQueue packets;
+  GstBuffer *buf;
+  GstFlowReturn ret = GST_FLOW_OK;
+  gboolean done;
+
+  while (ret == GST_FLOW_OK) {
+    g_mutex_lock (enc->gop_lock);
+    gop = g_queue_peek_head (enc->gops);
+    if (gop == NULL) {
+      g_mutex_unlock (enc->gop_lock);
+      break;
+    }
+    while (!gop->done && g_queue_is_empty (&gop->packets)
+        && g_queue_get_length (enc->gops) > max_gops)
+      g_cond_wait (enc->gop_cond, enc->gop_lock);
+
+    packets = gop->packets;
+    g_queue_init (&gop->packets);
+    done = gop->done;
+    if (done)
+      g_queue_pop_head (enc->gops);
+    g_mutex_unlock (enc->gop_lock);
+
+    if (g_queue_is_empty (&packets) && !done)
+      break;
+
+    enc->granulepos_offset = gop->granulepos_offset;
+    while ((buf = g_queue_pop_head (&packets))) {
+      if (ret != GST_FLOW_OK) {
+        gst_buffer_unref (buf);
+        continue;
+      }
+      if (gop->discont) {
+        enc->next_discont = TRUE;
+        gop->discont = FALSE;
+      }
+      theora_enc_finish_buffer (enc, buf);
+      ret = theora_push_buffer (enc, buf);
+    }
+
+    if (done)
+      theora_enc_gop_free (gop);
+  }
+
+  return ret;
+}
+
+/* finish all GOPs and push them */
+static GstFlowReturn
+theora_enc_drain (GstTheoraEnc * enc)
+{
+  if (enc->pool == NULL)
+    return GST_FLOW_OK;
+
+  theora_enc_close_gop (enc);
+
+  return theora_enc_push_gops (enc, 0);
+}
+
+/* throw away all GOPs without pushing them */
+static void
+theora_enc_abort_gops (GstTheoraEnc * enc)
+{
+  GstTheoraEncGop *gop;
+  GList *walk;
+
+  theora_enc_close_gop (enc);
+
+  g_mutex_lock (enc->gop_lock);
+  for (walk = enc->gops->head; walk; walk = walk->next) {
+    gop = walk->data;
+    gop->aborted = TRUE;
+  }
+  while ((gop = g_queue_pop_head (enc->gops))) {
+    while (!gop->done)
+      g_cond_wait (enc->gop_cond, enc->gop_lock);
+    theora_enc_gop_free (gop);
+  }
+  g_mutex_unlock (enc->gop_lock);
+}
+
+static GstFlowReturn
+theora_enc_encode_parallel (GstTheoraEnc * enc, GstClockTime running_time,
+    GstClockTime duration, GstBuffer * buffer)
+{
+  GstTheoraEncGop *gop;
+  GstFlowReturn ret;
+  gint gop_length;
+
+  if (theora_enc_is_discontinuous (enc, running_time, duration)) {
+    theora_enc_close_gop (enc);
+    enc->gop_granulepos =
+        gst_util_uint64_scale (running_time, enc->fps_n,
+        GST_SECOND * enc->fps_d);
+    enc->next_discont = TRUE;
+  } else if (enc->next_discont) {
+    /* start a new GOP so that the discont goes on its first packet */
+    theora_enc_close_gop (enc);
+  }
+
+  if (enc->cur_gop == NULL) {
+    /* wait until there is a thread for the new GOP */
+    ret = theora_enc_push_gops (enc, enc->threads - 1);
+    if (ret != GST_FLOW_OK) {
+      gst_buffer_unref (buffer);
+      return ret;
+    }
+
+    gop = theora_enc_gop_new (enc);
+    gop->granulepos_offset = enc->gop_granulepos;
+    gop->discont = enc->next_discont;
+    enc->next_discont = FALSE;
+
+    g_mutex_lock (enc->gop_lock);
+    g_queue_push_tail (enc->gops, gop);
+    g_mutex_unlock (enc->gop_lock);
+    g_thread_pool_push (enc->pool, gop, NULL);
+
+    enc->cur_gop = gop;
+  }
+
+  g_async_queue_push (enc->cur_gop->frames, buffer);
+  enc->cur_gop->n_frames++;
+
+  /* end the GOP where the encoder would force a keyframe anyway */
+  gop_length = enc->keyframe_auto ? enc->keyframe_force : enc->keyframe_freq;
+  if (enc->cur_gop->n_frames >= gop_length)
+    theora_enc_close_gop (enc);
+
+  /* push what is ready without waiting */
+  return theora_enc_push_gops (enc, G_MAXUINT);
+}
+
 static GstFlowReturn
 theora_enc_chain (GstPad * pad, GstBuffer * buffer)
 {
@@ -1372,10 +1702,14 @@ theora_enc_chain (GstPad * pad, GstBuffer * buffer)
         GST_SECOND * enc->fps_d);
     enc->timestamp_offset = running_time;
     enc->next_ts = 0;
+    enc->gop_granulepos = enc->granulepos_offset;
   }
 
-  ret = theora_enc_encode_and_push (enc, op, timestamp, running_time, duration,
-      buffer);
+  if (enc->pool)
+    ret = theora_enc_encode_parallel (enc, running_time, duration, buffer);
+  else
+    ret = theora_enc_encode_and_push (enc, op, timestamp, running_time,
+        duration, buffer);
 
   return ret;
 
@@ -1425,6 +1759,15 @@ theora_enc_change_state (GstElement * element, GstStateChange transition)
       enc->packetno = 0;
       enc->force_keyframe = FALSE;
 
+      if (enc->threads > 1) {
+        if (enc->multipass_mode == MULTIPASS_MODE_SINGLE_PASS) {
+          enc->pool = g_thread_pool_new (theora_enc_gop_func, enc,
+              enc->threads, FALSE, NULL);
+        } else {
+          GST_WARNING_OBJECT (enc, "multipass encoding is done serially");
+        }
+      }
+
       if (enc->multipass_mode >= MULTIPASS_MODE_FIRST_PASS) {
         GError *err = NULL;
 
@@ -1465,6 +1808,11 @@ theora_enc_change_state (GstElement * element, GstStateChange transition)
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       GST_DEBUG_OBJECT (enc, "PAUSED->READY Clearing theora state");
+      theora_enc_abort_gops (enc);
+      if (enc->pool) {
+        g_thread_pool_free (enc->pool, FALSE, TRUE);
+        enc->pool = NULL;
+      }
       if (enc->encoder) {
         th_encode_free (enc->encoder);
         enc->encoder = NULL;
@@ -1557,6 +1905,9 @@ theora_enc_set_property (GObject * object, guint prop_id,
     case PROP_MULTIPASS_MODE:
       enc->multipass_mode = g_value_get_enum (value);
       break;
+    case PROP_THREADS:
+      enc->threads = g_value_get_int (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1634,6 +1985,9 @@ theora_enc_get_property (GObject * object, guint prop_id,
     case PROP_MULTIPASS_MODE:
       g_value_set_enum (value, enc->multipass_mode);
       break;
+    case PROP_THREADS:
+      g_value_set_int (value, enc->threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
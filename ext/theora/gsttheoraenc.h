@@ -39,6 +39,7 @@ G_BEGIN_DECLS
 
 typedef struct _GstTheoraEnc GstTheoraEnc;
 typedef struct _GstTheoraEncClass GstTheoraEncClass;
+typedef struct _GstTheoraEncGop GstTheoraEncGop;
 
 /**
  * GstTheoraEncBorderMode:
@@ -126,6 +127,15 @@ struct _GstTheoraEnc
   GIOChannel *multipass_cache_fd;
   GstAdapter *multipass_cache_adapter;
   gchar *multipass_cache_file;
+
+  /* parallel encoding of independent GOPs */
+  gint threads;
+  GThreadPool *pool;
+  GMutex *gop_lock;
+  GCond *gop_cond;
+  GQueue *gops;                 /* GOPs being encoded, oldest first */
+  GstTheoraEncGop *cur_gop;     /* GOP receiving the input frames */
+  guint64 gop_granulepos;       /* granulepos offset of the next GOP */
 };
 
 struct _GstTheoraEncClass
@@ -24,11 +24,13 @@
 #include "gst/tag/tag.h"
 
 #include "gstvorbisenc.h"
+#include "gstvorbismultienc.h"
 #include "gstvorbisdec.h"
 #include "gstvorbisparse.h"
 #include "gstvorbistag.h"
 
 GST_DEBUG_CATEGORY (vorbisenc_debug);
+GST_DEBUG_CATEGORY (vorbismultienc_debug);
 GST_DEBUG_CATEGORY (vorbisdec_debug);
 GST_DEBUG_CATEGORY (vorbisparse_debug);
 GST_DEBUG_CATEGORY (vorbistag_debug);
@@ -40,6 +42,10 @@ plugin_init (GstPlugin * plugin)
           GST_TYPE_VORBISENC))
     return FALSE;
 
+  if (!gst_element_register (plugin, "vorbismultienc", GST_RANK_NONE,
+          GST_TYPE_VORBIS_MULTI_ENC))
+    return FALSE;
+
   if (!gst_element_register (plugin, "vorbisdec", GST_RANK_PRIMARY,
           gst_vorbis_dec_get_type ()))
     return FALSE;
@@ -54,6 +60,8 @@ plugin_init (GstPlugin * plugin)
 
   GST_DEBUG_CATEGORY_INIT (vorbisenc_debug, "vorbisenc", 0,
       "vorbis encoding element");
+  GST_DEBUG_CATEGORY_INIT (vorbismultienc_debug, "vorbismultienc", 0,
+      "vorbis multi-quality encoding element");
   GST_DEBUG_CATEGORY_INIT (vorbisdec_debug, "vorbisdec", 0,
       "vorbis decoding element");
   GST_DEBUG_CATEGORY_INIT (vorbisparse_debug, "vorbisparse", 0,
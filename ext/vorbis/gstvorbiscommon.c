@@ -21,6 +21,8 @@
 #include "config.h"
 #endif
 
+#include <string.h>
+
 #include "gstvorbiscommon.h"
 
 /* http://www.xiph.org/vorbis/doc/Vorbis_I_spec.html#x1-800004.3.9 */
@@ -73,3 +75,99 @@ const GstAudioChannelPosition gst_vorbis_channel_positions[][8] = {
         GST_AUDIO_CHANNEL_POSITION_REAR_RIGHT,
       GST_AUDIO_CHANNEL_POSITION_LFE},
 };
+
+/* the raw audio formats accepted by the encoders, with the channel layouts
+ * defined by the spec */
+GstCaps *
+gst_vorbis_enc_generate_sink_caps (void)
+{
+  GstCaps *caps = gst_caps_new_empty ();
+  int i, c;
+
+  gst_caps_append_structure (caps, gst_structure_new ("audio/x-raw-float",
+          "rate", GST_TYPE_INT_RANGE, 1, 200000,
+          "channels", G_TYPE_INT, 1,
+          "endianness", G_TYPE_INT, G_BYTE_ORDER, "width", G_TYPE_INT, 32,
+          NULL));
+
+  gst_caps_append_structure (caps, gst_structure_new ("audio/x-raw-float",
+          "rate", GST_TYPE_INT_RANGE, 1, 200000,
+          "channels", G_TYPE_INT, 2,
+          "endianness", G_TYPE_INT, G_BYTE_ORDER, "width", G_TYPE_INT, 32,
+          NULL));
+
+  for (i = 3; i <= 8; i++) {
+    GValue chanpos = { 0 };
+    GValue pos = { 0 };
+    GstStructure *structure;
+
+    g_value_init (&chanpos, GST_TYPE_ARRAY);
+    g_value_init (&pos, GST_TYPE_AUDIO_CHANNEL_POSITION);
+
+    for (c = 0; c < i; c++) {
+      g_value_set_enum (&pos, gst_vorbis_channel_positions[i - 1][c]);
+      gst_value_array_append_value (&chanpos, &pos);
+    }
+    g_value_unset (&pos);
+
+    structure = gst_structure_new ("audio/x-raw-float",
+        "rate", GST_TYPE_INT_RANGE, 1, 200000,
+        "channels", G_TYPE_INT, i,
+        "endianness", G_TYPE_INT, G_BYTE_ORDER, "width", G_TYPE_INT, 32, NULL);
+    gst_structure_set_value (structure, "channel-positions", &chanpos);
+    g_value_unset (&chanpos);
+
+    gst_caps_append_structure (caps, structure);
+  }
+
+  gst_caps_append_structure (caps, gst_structure_new ("audio/x-raw-float",
+          "rate", GST_TYPE_INT_RANGE, 1, 200000,
+          "channels", GST_TYPE_INT_RANGE, 9, 255,
+          "endianness", G_TYPE_INT, G_BYTE_ORDER, "width", G_TYPE_INT, 32,
+          NULL));
+
+  return caps;
+}
+
+#ifndef TREMOR
+/* add the vorbis comments for @tag of @list to the vorbis_comment passed as
+ * user data, for use with gst_tag_list_foreach() */
+void
+gst_vorbis_enc_metadata_set1 (const GstTagList * list, const gchar * tag,
+    gpointer vorbis_comment)
+{
+  vorbis_comment *vc = vorbis_comment;
+  GList *vc_list, *l;
+
+  vc_list = gst_tag_to_vorbis_comments (list, tag);
+
+  for (l = vc_list; l != NULL; l = l->next) {
+    const gchar *vc_string = (const gchar *) l->data;
+    gchar *key = NULL, *val = NULL;
+
+    if (gst_tag_parse_extended_comment (vc_string, &key, NULL, &val, TRUE)) {
+      vorbis_comment_add_tag (vc, key, val);
+      g_free (key);
+      g_free (val);
+    }
+  }
+
+  g_list_foreach (vc_list, (GFunc) g_free, NULL);
+  g_list_free (vc_list);
+}
+
+/* make a buffer of a header packet, without timestamps */
+GstBuffer *
+gst_vorbis_enc_buffer_from_header_packet (ogg_packet * packet)
+{
+  GstBuffer *outbuf;
+
+  outbuf = gst_buffer_new_and_alloc (packet->bytes);
+  memcpy (GST_BUFFER_DATA (outbuf), packet->packet, packet->bytes);
+  GST_BUFFER_OFFSET_END (outbuf) = 0;
+  GST_BUFFER_TIMESTAMP (outbuf) = GST_CLOCK_TIME_NONE;
+  GST_BUFFER_DURATION (outbuf) = GST_CLOCK_TIME_NONE;
+
+  return outbuf;
+}
+#endif
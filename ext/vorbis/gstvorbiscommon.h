@@ -25,4 +25,16 @@
 
 extern const GstAudioChannelPosition gst_vorbis_channel_positions[][8];
 
+GstCaps *gst_vorbis_enc_generate_sink_caps (void);
+
+#ifndef TREMOR
+#include <vorbis/codec.h>
+#include <gst/tag/tag.h>
+
+void gst_vorbis_enc_metadata_set1 (const GstTagList * list, const gchar * tag,
+    gpointer vorbis_comment);
+
+GstBuffer *gst_vorbis_enc_buffer_from_header_packet (ogg_packet * packet);
+#endif
+
 #endif /* __GST_VORBIS_COMMON_H__ */
@@ -21,7 +21,9 @@
  * SECTION:element-vorbisdec
  * @see_also: vorbisenc, oggdemux
  *
- * This element decodes a Vorbis stream to raw float audio.
+ * This element decodes a Vorbis stream to raw float audio. If downstream
+ * only accepts 16 or 32 bit integer audio, the samples are converted
+ * while they are interleaved, without an extra audioconvert pass.
  * <ulink url="http://www.vorbis.com/">Vorbis</ulink> is a royalty-free
  * audio codec maintained by the <ulink url="http://www.xiph.org/">Xiph.org
  * Foundation</ulink>.
@@ -233,6 +235,11 @@ vorbis_handle_identification_packet (GstVorbisDec * vd)
   GstCaps *caps;
   const GstAudioChannelPosition *pos = NULL;
   gint width = GST_VORBIS_DEC_DEFAULT_SAMPLE_WIDTH;
+#ifndef TREMOR
+  gboolean integer = FALSE;
+#else
+  gboolean integer = TRUE;
+#endif
 
   switch (vd->vi.channels) {
     case 1:
@@ -271,6 +278,10 @@ vorbis_handle_identification_packet (GstVorbisDec * vd)
       s = gst_caps_get_structure (caps, 0);
       /* template ensures 16 or 32 */
       gst_structure_get_int (s, "width", &width);
+#ifndef TREMOR
+      /* convert to integers directly instead of leaving it to audioconvert */
+      integer = gst_structure_has_name (s, "audio/x-raw-int");
+#endif
 
       GST_INFO_OBJECT (vd, "using %s with %d channels and %d bit audio depth",
           gst_structure_get_name (s), vd->vi.channels, width);
@@ -281,11 +292,23 @@ vorbis_handle_identification_packet (GstVorbisDec * vd)
 
   /* select a copy_samples function, this way we can have specialized versions
    * for mono/stereo and avoid the depth switch in tremor case */
-  vd->copy_samples = get_copy_sample_func (vd->vi.channels, vd->width);
-
+  vd->copy_samples =
+      get_copy_sample_func (vd->vi.channels, vd->width, integer);
+
+#ifndef TREMOR
+  if (integer) {
+    caps = gst_caps_new_simple ("audio/x-raw-int",
+        "endianness", G_TYPE_INT, G_BYTE_ORDER,
+        "depth", G_TYPE_INT, width, "signed", G_TYPE_BOOLEAN, TRUE, NULL);
+  } else {
+    caps = gst_caps_new_simple ("audio/x-raw-float",
+        "endianness", G_TYPE_INT, G_BYTE_ORDER, NULL);
+  }
+#else
   caps =
       gst_caps_copy (gst_pad_get_pad_template_caps
       (GST_AUDIO_DECODER_SRC_PAD (vd)));
+#endif
   gst_caps_set_simple (caps, "rate", G_TYPE_INT, vd->vi.rate, "channels",
       G_TYPE_INT, vd->vi.channels, "width", G_TYPE_INT, width, NULL);
 
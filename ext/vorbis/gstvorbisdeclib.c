@@ -48,11 +48,12 @@ copy_samples_s (vorbis_sample_t * out, vorbis_sample_t ** in, guint samples,
   out += samples;
   memcpy (out, in[1], samples * sizeof (float));
 #else
-  gint j;
+  const gfloat *in0 = in[0], *in1 = in[1];
+  guint j;
 
   for (j = 0; j < samples; j++) {
-    *out++ = in[0][j];
-    *out++ = in[1][j];
+    out[2 * j] = in0[j];
+    out[2 * j + 1] = in1[j];
   }
 #endif
 }
@@ -79,23 +80,158 @@ copy_samples (vorbis_sample_t * out, vorbis_sample_t ** in, guint samples,
 #endif
 }
 
+/* Integer output is produced in the same pass as the interleaving so that
+ * downstream doesn't need an extra audioconvert pass. The conversion is
+ * inlined; the clamping and rounding are conditional expressions that most
+ * compilers turn into min/max and selects, whether the loops end up
+ * vectorized depends on the compiler and its flags. */
+static inline gint32
+float_to_s16 (gfloat x)
+{
+  gfloat v = x * 32768.0f;
+
+  v = CLAMP (v, -32768.0f, 32767.0f);
+  return (gint32) (v + (v >= 0.0f ? 0.5f : -0.5f));
+}
+
+static inline gint32
+float_to_s32 (gfloat x)
+{
+  /* doubles, 2^31 - 1 is not representable as a float */
+  gdouble v = x * 2147483648.0;
+
+  v = CLAMP (v, -2147483648.0, 2147483647.0);
+  return (gint32) (v + (v >= 0.0 ? 0.5 : -0.5));
+}
+
+static void
+copy_samples_16_m (vorbis_sample_t * _out, vorbis_sample_t ** _in,
+    guint samples, gint channels, gint width)
+{
+  gint16 *out = (gint16 *) _out;
+  const gfloat *in = _in[0];
+  guint j;
+
+  for (j = 0; j < samples; j++)
+    out[j] = float_to_s16 (in[j]);
+}
+
+static void
+copy_samples_16_s (vorbis_sample_t * _out, vorbis_sample_t ** _in,
+    guint samples, gint channels, gint width)
+{
+  gint16 *out = (gint16 *) _out;
+  const gfloat *in0 = _in[0], *in1 = _in[1];
+  guint j;
+
+  for (j = 0; j < samples; j++) {
+    out[2 * j] = float_to_s16 (in0[j]);
+    out[2 * j + 1] = float_to_s16 (in1[j]);
+  }
+}
+
+static void
+copy_samples_16 (vorbis_sample_t * _out, vorbis_sample_t ** _in,
+    guint samples, gint channels, gint width)
+{
+  gint16 *out = (gint16 *) _out;
+  guint i, j;
+
+  /* one channel at a time, walking the output with a stride */
+  for (i = 0; i < channels; i++) {
+    const gfloat *in = _in[i];
+
+    for (j = 0; j < samples; j++)
+      out[j * channels + i] = float_to_s16 (in[j]);
+  }
+}
+
+static void
+copy_samples_32_m (vorbis_sample_t * _out, vorbis_sample_t ** _in,
+    guint samples, gint channels, gint width)
+{
+  gint32 *out = (gint32 *) _out;
+  const gfloat *in = _in[0];
+  guint j;
+
+  for (j = 0; j < samples; j++)
+    out[j] = float_to_s32 (in[j]);
+}
+
+static void
+copy_samples_32_s (vorbis_sample_t * _out, vorbis_sample_t ** _in,
+    guint samples, gint channels, gint width)
+{
+  gint32 *out = (gint32 *) _out;
+  const gfloat *in0 = _in[0], *in1 = _in[1];
+  guint j;
+
+  for (j = 0; j < samples; j++) {
+    out[2 * j] = float_to_s32 (in0[j]);
+    out[2 * j + 1] = float_to_s32 (in1[j]);
+  }
+}
+
+static void
+copy_samples_32 (vorbis_sample_t * _out, vorbis_sample_t ** _in,
+    guint samples, gint channels, gint width)
+{
+  gint32 *out = (gint32 *) _out;
+  guint i, j;
+
+  for (i = 0; i < channels; i++) {
+    const gfloat *in = _in[i];
+
+    for (j = 0; j < samples; j++)
+      out[j * channels + i] = float_to_s32 (in[j]);
+  }
+}
+
 CopySampleFunc
-get_copy_sample_func (gint channels, gint width)
+get_copy_sample_func (gint channels, gint width, gboolean integer)
 {
   CopySampleFunc f = NULL;
 
-  g_assert (width == 4);
-
-  switch (channels) {
-    case 1:
-      f = copy_samples_m;
-      break;
-    case 2:
-      f = copy_samples_s;
-      break;
-    default:
-      f = copy_samples;
-      break;
+  if (!integer) {
+    g_assert (width == 4);
+
+    switch (channels) {
+      case 1:
+        f = copy_samples_m;
+        break;
+      case 2:
+        f = copy_samples_s;
+        break;
+      default:
+        f = copy_samples;
+        break;
+    }
+  } else if (width == 4) {
+    switch (channels) {
+      case 1:
+        f = copy_samples_32_m;
+        break;
+      case 2:
+        f = copy_samples_32_s;
+        break;
+      default:
+        f = copy_samples_32;
+        break;
+    }
+  } else if (width == 2) {
+    switch (channels) {
+      case 1:
+        f = copy_samples_16_m;
+        break;
+      case 2:
+        f = copy_samples_16_s;
+        break;
+      default:
+        f = copy_samples_16;
+        break;
+    }
+  } else {
+    g_assert_not_reached ();
   }
 
   return f;
@@ -215,10 +351,11 @@ copy_samples_16 (vorbis_sample_t * _out, vorbis_sample_t ** _in, guint samples,
 }
 
 CopySampleFunc
-get_copy_sample_func (gint channels, gint width)
+get_copy_sample_func (gint channels, gint width, gboolean integer)
 {
   CopySampleFunc f = NULL;
 
+  /* tremor always outputs integers */
   if (width == 4) {
     switch (channels) {
       case 1:
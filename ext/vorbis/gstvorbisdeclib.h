@@ -34,14 +34,29 @@
 typedef float                          vorbis_sample_t;
 typedef ogg_packet                     ogg_packet_wrapper;
 
-#define GST_VORBIS_DEC_DESCRIPTION "decode raw vorbis streams to float audio"
+#define GST_VORBIS_DEC_DESCRIPTION "decode raw vorbis streams to float or integer audio"
 
+/* float is preferred, the integer formats are converted while interleaving */
 #define GST_VORBIS_DEC_SRC_CAPS \
     GST_STATIC_CAPS ("audio/x-raw-float, " \
         "rate = (int) [ 1, MAX ], " \
         "channels = (int) [ 1, 256 ], " \
         "endianness = (int) BYTE_ORDER, " \
-        "width = (int) 32")
+        "width = (int) 32; " \
+        "audio/x-raw-int, " \
+        "rate = (int) [ 1, MAX ], " \
+        "channels = (int) [ 1, 256 ], " \
+        "endianness = (int) BYTE_ORDER, " \
+        "width = (int) 16, " \
+        "depth = (int) 16, " \
+        "signed = (boolean) true; " \
+        "audio/x-raw-int, " \
+        "rate = (int) [ 1, MAX ], " \
+        "channels = (int) [ 1, 256 ], " \
+        "endianness = (int) BYTE_ORDER, " \
+        "width = (int) 32, " \
+        "depth = (int) 32, " \
+        "signed = (boolean) true")
 
 #define GST_VORBIS_DEC_DEFAULT_SAMPLE_WIDTH           (32)
 
@@ -159,6 +174,7 @@ gst_ogg_packet_from_wrapper (ogg_packet_wrapper * packet)
 typedef void (*CopySampleFunc)(vorbis_sample_t *out, vorbis_sample_t **in,
                            guint samples, gint channels, gint width);
 
-CopySampleFunc get_copy_sample_func (gint channels, gint width);
+CopySampleFunc get_copy_sample_func (gint channels, gint width,
+                                     gboolean integer);
 
 #endif /* __GST_VORBIS_DEC_LIB_H__ */
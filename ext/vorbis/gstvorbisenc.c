@@ -266,57 +266,6 @@ gst_vorbis_enc_stop (GstAudioEncoder * enc)
   return TRUE;
 }
 
-static GstCaps *
-gst_vorbis_enc_generate_sink_caps (void)
-{
-  GstCaps *caps = gst_caps_new_empty ();
-  int i, c;
-
-  gst_caps_append_structure (caps, gst_structure_new ("audio/x-raw-float",
-          "rate", GST_TYPE_INT_RANGE, 1, 200000,
-          "channels", G_TYPE_INT, 1,
-          "endianness", G_TYPE_INT, G_BYTE_ORDER, "width", G_TYPE_INT, 32,
-          NULL));
-
-  gst_caps_append_structure (caps, gst_structure_new ("audio/x-raw-float",
-          "rate", GST_TYPE_INT_RANGE, 1, 200000,
-          "channels", G_TYPE_INT, 2,
-          "endianness", G_TYPE_INT, G_BYTE_ORDER, "width", G_TYPE_INT, 32,
-          NULL));
-
-  for (i = 3; i <= 8; i++) {
-    GValue chanpos = { 0 };
-    GValue pos = { 0 };
-    GstStructure *structure;
-
-    g_value_init (&chanpos, GST_TYPE_ARRAY);
-    g_value_init (&pos, GST_TYPE_AUDIO_CHANNEL_POSITION);
-
-    for (c = 0; c < i; c++) {
-      g_value_set_enum (&pos, gst_vorbis_channel_positions[i - 1][c]);
-      gst_value_array_append_value (&chanpos, &pos);
-    }
-    g_value_unset (&pos);
-
-    structure = gst_structure_new ("audio/x-raw-float",
-        "rate", GST_TYPE_INT_RANGE, 1, 200000,
-        "channels", G_TYPE_INT, i,
-        "endianness", G_TYPE_INT, G_BYTE_ORDER, "width", G_TYPE_INT, 32, NULL);
-    gst_structure_set_value (structure, "channel-positions", &chanpos);
-    g_value_unset (&chanpos);
-
-    gst_caps_append_structure (caps, structure);
-  }
-
-  gst_caps_append_structure (caps, gst_structure_new ("audio/x-raw-float",
-          "rate", GST_TYPE_INT_RANGE, 1, 200000,
-          "channels", GST_TYPE_INT_RANGE, 9, 255,
-          "endianness", G_TYPE_INT, G_BYTE_ORDER, "width", G_TYPE_INT, 32,
-          NULL));
-
-  return caps;
-}
-
 static GstCaps *
 gst_vorbis_enc_getcaps (GstAudioEncoder * enc)
 {
@@ -359,31 +308,6 @@ gst_vorbis_enc_set_format (GstAudioEncoder * enc, GstAudioInfo * info)
   return TRUE;
 }
 
-static void
-gst_vorbis_enc_metadata_set1 (const GstTagList * list, const gchar * tag,
-    gpointer vorbisenc)
-{
-  GstVorbisEnc *enc = GST_VORBISENC (vorbisenc);
-  GList *vc_list, *l;
-
-  vc_list = gst_tag_to_vorbis_comments (list, tag);
-
-  for (l = vc_list; l != NULL; l = l->next) {
-    const gchar *vc_string = (const gchar *) l->data;
-    gchar *key = NULL, *val = NULL;
-
-    GST_LOG_OBJECT (vorbisenc, "vorbis comment: %s", vc_string);
-    if (gst_tag_parse_extended_comment (vc_string, &key, NULL, &val, TRUE)) {
-      vorbis_comment_add_tag (&enc->vc, key, val);
-      g_free (key);
-      g_free (val);
-    }
-  }
-
-  g_list_foreach (vc_list, (GFunc) g_free, NULL);
-  g_list_free (vc_list);
-}
-
 static void
 gst_vorbis_enc_set_metadata (GstVorbisEnc * enc)
 {
@@ -403,7 +327,8 @@ gst_vorbis_enc_set_metadata (GstVorbisEnc * enc)
 
   if (merged_tags) {
     GST_DEBUG_OBJECT (enc, "merged   tags = %" GST_PTR_FORMAT, merged_tags);
-    gst_tag_list_foreach (merged_tags, gst_vorbis_enc_metadata_set1, enc);
+    gst_tag_list_foreach (merged_tags, gst_vorbis_enc_metadata_set1,
+        &enc->vc);
     gst_tag_list_free (merged_tags);
   }
 }
@@ -573,24 +498,6 @@ gst_vorbis_enc_clear (GstVorbisEnc * vorbisenc)
   return ret;
 }
 
-static GstBuffer *
-gst_vorbis_enc_buffer_from_header_packet (GstVorbisEnc * vorbisenc,
-    ogg_packet * packet)
-{
-  GstBuffer *outbuf;
-
-  outbuf = gst_buffer_new_and_alloc (packet->bytes);
-  memcpy (GST_BUFFER_DATA (outbuf), packet->packet, packet->bytes);
-  GST_BUFFER_OFFSET (outbuf) = vorbisenc->bytes_out;
-  GST_BUFFER_OFFSET_END (outbuf) = 0;
-  GST_BUFFER_TIMESTAMP (outbuf) = GST_CLOCK_TIME_NONE;
-  GST_BUFFER_DURATION (outbuf) = GST_CLOCK_TIME_NONE;
-
-  GST_DEBUG ("created header packet buffer, %d bytes",
-      GST_BUFFER_SIZE (outbuf));
-  return outbuf;
-}
-
 static gboolean
 gst_vorbis_enc_sink_event (GstAudioEncoder * enc, GstEvent * event)
 {
@@ -734,9 +641,12 @@ gst_vorbis_enc_handle_frame (GstAudioEncoder * enc, GstBuffer * buffer)
     vorbis_comment_clear (&vorbisenc->vc);
 
     /* create header buffers */
-    buf1 = gst_vorbis_enc_buffer_from_header_packet (vorbisenc, &header);
-    buf2 = gst_vorbis_enc_buffer_from_header_packet (vorbisenc, &header_comm);
-    buf3 = gst_vorbis_enc_buffer_from_header_packet (vorbisenc, &header_code);
+    buf1 = gst_vorbis_enc_buffer_from_header_packet (&header);
+    buf2 = gst_vorbis_enc_buffer_from_header_packet (&header_comm);
+    buf3 = gst_vorbis_enc_buffer_from_header_packet (&header_code);
+    GST_BUFFER_OFFSET (buf1) = vorbisenc->bytes_out;
+    GST_BUFFER_OFFSET (buf2) = vorbisenc->bytes_out;
+    GST_BUFFER_OFFSET (buf3) = vorbisenc->bytes_out;
 
     /* mark and put on caps */
     caps = gst_caps_new_simple ("audio/x-vorbis", NULL);
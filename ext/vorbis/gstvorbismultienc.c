@@ -0,0 +1,837 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * SECTION:element-vorbismultienc
+ * @see_also: vorbisenc, oggmux
+ *
+ * This element encodes raw float audio into several Vorbis streams of
+ * different quality at once, one on each src pad. It does the same as a tee
+ * followed by a vorbisenc for every quality, but the input is only
+ * deinterleaved once and the encoders run in parallel on their own threads.
+ *
+ * The #GstVorbisMultiEnc:qualities property sets the quality of the streams
+ * and creates a src pad for each of them, named src_0, src_1 and so on.
+ *
+ * <refsect2>
+ * <title>Example pipeline</title>
+ * |[
+ * gst-launch -v audiotestsrc num-buffers=100 ! audioconvert ! vorbismultienc name=enc qualities="0.1,0.5,0.9" \
+ *   enc.src_0 ! oggmux ! filesink location=low.ogg \
+ *   enc.src_1 ! oggmux ! filesink location=medium.ogg \
+ *   enc.src_2 ! oggmux ! filesink location=high.ogg
+ * ]| Encode a test signal to three Ogg/Vorbis files.
+ * </refsect2>
+ *
+ * Since: 0.10.37
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <vorbis/vorbisenc.h>
+
+#include <gst/tag/tag.h>
+#include <gst/audio/audio.h>
+#include "gstvorbismultienc.h"
+
+#include "gstvorbiscommon.h"
+
+GST_DEBUG_CATEGORY_EXTERN (vorbismultienc_debug);
+#define GST_CAT_DEFAULT vorbismultienc_debug
+
+static GstStaticPadTemplate vorbis_multi_enc_sink_factory =
+GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("audio/x-raw-float, "
+        "rate = (int) [ 1, 200000 ], "
+        "channels = (int) [ 1, 255 ], " "endianness = (int) BYTE_ORDER, "
+        "width = (int) 32")
+    );
+
+static GstStaticPadTemplate vorbis_multi_enc_src_factory =
+GST_STATIC_PAD_TEMPLATE ("src_%d",
+    GST_PAD_SRC,
+    GST_PAD_SOMETIMES,
+    GST_STATIC_CAPS ("audio/x-vorbis")
+    );
+
+enum
+{
+  ARG_0,
+  ARG_QUALITIES
+};
+
+#define QUALITIES_DEFAULT       "0.3"
+
+/* timestamps further than this from where the previous buffer ended are a
+ * discontinuity, like the default tolerance of GstAudioEncoder */
+#define DISCONT_TOLERANCE       (40 * GST_MSECOND)
+
+/* the state of one encoder */
+typedef struct
+{
+  GstPad *pad;
+  gfloat quality;
+
+  vorbis_info vi;
+  vorbis_dsp_state vd;
+  vorbis_block vb;
+  gboolean setup;
+
+  /* header buffers still to push */
+  GSList *headers;
+  /* encoded buffers still to push, in reverse order */
+  GList *packets;
+
+  /* time of granulepos 0, moved at discontinuities */
+  GstClockTime start_ts;
+  guint64 granulepos;
+  guint64 samples_in;
+  gboolean discont;
+  GstFlowReturn last_flow;
+} GstVorbisMultiEncStream;
+
+static GstFlowReturn gst_vorbis_multi_enc_chain (GstPad * pad,
+    GstBuffer * buffer);
+static gboolean gst_vorbis_multi_enc_sink_event (GstPad * pad,
+    GstEvent * event);
+static gboolean gst_vorbis_multi_enc_sink_setcaps (GstPad * pad,
+    GstCaps * caps);
+static GstCaps *gst_vorbis_multi_enc_sink_getcaps (GstPad * pad);
+static GstStateChangeReturn gst_vorbis_multi_enc_change_state (GstElement *
+    element, GstStateChange transition);
+
+static void gst_vorbis_multi_enc_finalize (GObject * object);
+static void gst_vorbis_multi_enc_get_property (GObject * object,
+    guint prop_id, GValue * value, GParamSpec * pspec);
+static void gst_vorbis_multi_enc_set_property (GObject * object,
+    guint prop_id, const GValue * value, GParamSpec * pspec);
+
+static void gst_vorbis_multi_enc_set_qualities (GstVorbisMultiEnc * enc,
+    const gchar * qualities);
+static void gst_vorbis_multi_enc_clear_streams (GstVorbisMultiEnc * enc);
+static void gst_vorbis_multi_enc_pool_func (gpointer data,
+    gpointer user_data);
+
+GST_BOILERPLATE (GstVorbisMultiEnc, gst_vorbis_multi_enc, GstElement,
+    GST_TYPE_ELEMENT);
+
+static void
+gst_vorbis_multi_enc_base_init (gpointer g_class)
+{
+  GstElementClass *element_class = GST_ELEMENT_CLASS (g_class);
+
+  gst_element_class_add_static_pad_template (element_class,
+      &vorbis_multi_enc_src_factory);
+  gst_element_class_add_static_pad_template (element_class,
+      &vorbis_multi_enc_sink_factory);
+
+  gst_element_class_set_details_simple (element_class,
+      "Vorbis multi-quality audio encoder", "Codec/Encoder/Audio",
+      "Encodes audio in Vorbis format at several qualities at once",
+      "GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>");
+}
+
+static void
+gst_vorbis_multi_enc_class_init (GstVorbisMultiEncClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstElementClass *gstelement_class;
+
+  gobject_class = (GObjectClass *) klass;
+  gstelement_class = (GstElementClass *) klass;
+
+  gobject_class->set_property = gst_vorbis_multi_enc_set_property;
+  gobject_class->get_property = gst_vorbis_multi_enc_get_property;
+  gobject_class->finalize = gst_vorbis_multi_enc_finalize;
+
+  /**
+   * GstVorbisMultiEnc:qualities:
+   *
+   * Comma separated list of the qualities of the streams, from -0.1 to 1.0.
+   * Setting it creates a src pad for every quality. It can only be changed
+   * in the NULL and READY states.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, ARG_QUALITIES,
+      g_param_spec_string ("qualities", "Qualities",
+          "Comma separated list of qualities, one stream is encoded for each",
+          QUALITIES_DEFAULT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gstelement_class->change_state =
+      GST_DEBUG_FUNCPTR (gst_vorbis_multi_enc_change_state);
+}
+
+static void
+gst_vorbis_multi_enc_init (GstVorbisMultiEnc * enc,
+    GstVorbisMultiEncClass * klass)
+{
+  enc->sinkpad =
+      gst_pad_new_from_static_template (&vorbis_multi_enc_sink_factory,
+      "sink");
+  gst_pad_set_chain_function (enc->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_vorbis_multi_enc_chain));
+  gst_pad_set_event_function (enc->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_vorbis_multi_enc_sink_event));
+  gst_pad_set_setcaps_function (enc->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_vorbis_multi_enc_sink_setcaps));
+  gst_pad_set_getcaps_function (enc->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_vorbis_multi_enc_sink_getcaps));
+  gst_element_add_pad (GST_ELEMENT (enc), enc->sinkpad);
+
+  enc->lock = g_mutex_new ();
+  enc->cond = g_cond_new ();
+
+  gst_vorbis_multi_enc_set_qualities (enc, QUALITIES_DEFAULT);
+}
+
+static void
+gst_vorbis_multi_enc_finalize (GObject * object)
+{
+  GstVorbisMultiEnc *enc = GST_VORBIS_MULTI_ENC (object);
+
+  gst_vorbis_multi_enc_clear_streams (enc);
+  g_list_foreach (enc->streams, (GFunc) g_free, NULL);
+  g_list_free (enc->streams);
+  g_free (enc->qualities);
+  g_free (enc->planar);
+  g_mutex_free (enc->lock);
+  g_cond_free (enc->cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+/* replace the src pads by one for each quality in @qualities */
+static void
+gst_vorbis_multi_enc_set_qualities (GstVorbisMultiEnc * enc,
+    const gchar * qualities)
+{
+  GstVorbisMultiEncStream *stream;
+  GstPadTemplate *templ;
+  gchar **values;
+  gint i;
+
+  while (enc->streams) {
+    stream = enc->streams->data;
+    gst_element_remove_pad (GST_ELEMENT (enc), stream->pad);
+    g_free (stream);
+    enc->streams = g_list_delete_link (enc->streams, enc->streams);
+  }
+
+  g_free (enc->qualities);
+  enc->qualities = g_strdup (qualities);
+  if (qualities == NULL)
+    return;
+
+  templ = gst_static_pad_template_get (&vorbis_multi_enc_src_factory);
+  values = g_strsplit (qualities, ",", -1);
+  for (i = 0; values[i]; i++) {
+    gchar *name, *end;
+    gdouble quality;
+
+    quality = g_ascii_strtod (values[i], &end);
+    if (end == values[i] || quality < -0.1 || quality > 1.0) {
+      g_warning ("Invalid quality '%s', must be between -0.1 and 1.0",
+          values[i]);
+      continue;
+    }
+
+    stream = g_new0 (GstVorbisMultiEncStream, 1);
+    stream->quality = quality;
+    stream->last_flow = GST_FLOW_OK;
+
+    name = g_strdup_printf ("src_%d", g_list_length (enc->streams));
+    stream->pad = gst_pad_new_from_template (templ, name);
+    g_free (name);
+    gst_pad_use_fixed_caps (stream->pad);
+    gst_element_add_pad (GST_ELEMENT (enc), stream->pad);
+
+    enc->streams = g_list_append (enc->streams, stream);
+  }
+  g_strfreev (values);
+  gst_object_unref (templ);
+
+  gst_element_no_more_pads (GST_ELEMENT (enc));
+}
+
+static GstCaps *
+gst_vorbis_multi_enc_sink_getcaps (GstPad * pad)
+{
+  /* the src pads all produce vorbis, so there is nothing to ask downstream */
+  return gst_vorbis_enc_generate_sink_caps ();
+}
+
+/* set up a fresh encoder for @stream and make the header buffers and the
+ * caps of its pad */
+static gboolean
+gst_vorbis_multi_enc_setup_stream (GstVorbisMultiEnc * enc,
+    GstVorbisMultiEncStream * stream, GstClockTime timestamp)
+{
+  ogg_packet header, header_comm, header_code;
+  vorbis_comment vc;
+  GValue array = { 0 };
+  GValue value = { 0 };
+  GstCaps *caps;
+  GSList *walk;
+
+  GST_DEBUG_OBJECT (stream->pad, "setup for quality %f", stream->quality);
+
+  vorbis_info_init (&stream->vi);
+  if (vorbis_encode_init_vbr (&stream->vi, enc->channels, enc->rate,
+          stream->quality) != 0) {
+    vorbis_info_clear (&stream->vi);
+    GST_ELEMENT_ERROR (enc, LIBRARY, SETTINGS, (NULL),
+        ("invalid parameters for quality %f, %d channels, rate %d",
+            stream->quality, enc->channels, enc->rate));
+    return FALSE;
+  }
+  vorbis_analysis_init (&stream->vd, &stream->vi);
+  vorbis_block_init (&stream->vd, &stream->vb);
+
+  vorbis_comment_init (&vc);
+  if (enc->tags)
+    gst_tag_list_foreach (enc->tags, gst_vorbis_enc_metadata_set1, &vc);
+  vorbis_analysis_headerout (&stream->vd, &vc, &header, &header_comm,
+      &header_code);
+  vorbis_comment_clear (&vc);
+
+  stream->headers = g_slist_append (stream->headers,
+      gst_vorbis_enc_buffer_from_header_packet (&header));
+  stream->headers = g_slist_append (stream->headers,
+      gst_vorbis_enc_buffer_from_header_packet (&header_comm));
+  stream->headers = g_slist_append (stream->headers,
+      gst_vorbis_enc_buffer_from_header_packet (&header_code));
+  for (walk = stream->headers; walk; walk = walk->next)
+    GST_BUFFER_FLAG_SET (walk->data, GST_BUFFER_FLAG_IN_CAPS);
+
+  caps = gst_caps_new_simple ("audio/x-vorbis",
+      "rate", G_TYPE_INT, enc->rate, "channels", G_TYPE_INT, enc->channels,
+      NULL);
+  g_value_init (&array, GST_TYPE_ARRAY);
+  for (walk = stream->headers; walk; walk = walk->next) {
+    GstBuffer *buf;
+
+    /* copy to avoid a refcount loop between the caps and the buffers */
+    buf = gst_buffer_copy (walk->data);
+    g_value_init (&value, GST_TYPE_BUFFER);
+    gst_value_set_buffer (&value, buf);
+    gst_buffer_unref (buf);
+    gst_value_array_append_value (&array, &value);
+    g_value_unset (&value);
+  }
+  gst_structure_set_value (gst_caps_get_structure (caps, 0), "streamheader",
+      &array);
+  g_value_unset (&array);
+
+  gst_pad_set_caps (stream->pad, caps);
+  for (walk = stream->headers; walk; walk = walk->next)
+    gst_buffer_set_caps (walk->data, caps);
+  gst_caps_unref (caps);
+
+  stream->start_ts = timestamp;
+  stream->granulepos = 0;
+  stream->samples_in = 0;
+  stream->discont = FALSE;
+  stream->setup = TRUE;
+
+  return TRUE;
+}
+
+static void
+gst_vorbis_multi_enc_clear_stream (GstVorbisMultiEncStream * stream)
+{
+  if (stream->setup) {
+    /* vorbis_info_clear() must be called last */
+    vorbis_block_clear (&stream->vb);
+    vorbis_dsp_clear (&stream->vd);
+    vorbis_info_clear (&stream->vi);
+    stream->setup = FALSE;
+  }
+
+  g_slist_foreach (stream->headers, (GFunc) gst_mini_object_unref, NULL);
+  g_slist_free (stream->headers);
+  stream->headers = NULL;
+  g_list_foreach (stream->packets, (GFunc) gst_mini_object_unref, NULL);
+  g_list_free (stream->packets);
+  stream->packets = NULL;
+
+  stream->last_flow = GST_FLOW_OK;
+}
+
+static void
+gst_vorbis_multi_enc_clear_streams (GstVorbisMultiEnc * enc)
+{
+  g_list_foreach (enc->streams, (GFunc) gst_vorbis_multi_enc_clear_stream,
+      NULL);
+}
+
+/* feed the deinterleaved input to the encoder of @stream and collect the
+ * packets, called from the thread pool */
+static void
+gst_vorbis_multi_enc_encode_stream (GstVorbisMultiEnc * enc,
+    GstVorbisMultiEncStream * stream)
+{
+  ogg_packet op;
+  gint i;
+
+  if (enc->n_samples > 0) {
+    float **vorbis_buffer;
+
+    vorbis_buffer = vorbis_analysis_buffer (&stream->vd, enc->n_samples);
+    for (i = 0; i < enc->channels; i++)
+      memcpy (vorbis_buffer[i], enc->planar + i * enc->n_samples,
+          enc->n_samples * sizeof (gfloat));
+  }
+  /* writing 0 samples marks the end of the stream */
+  vorbis_analysis_wrote (&stream->vd, enc->n_samples);
+  stream->samples_in += enc->n_samples;
+
+  while (vorbis_analysis_blockout (&stream->vd, &stream->vb) == 1) {
+    vorbis_analysis (&stream->vb, NULL);
+    vorbis_bitrate_addblock (&stream->vb);
+
+    while (vorbis_bitrate_flushpacket (&stream->vd, &op)) {
+      GstBuffer *buf;
+
+      buf = gst_buffer_new_and_alloc (op.bytes);
+      memcpy (GST_BUFFER_DATA (buf), op.packet, op.bytes);
+      GST_BUFFER_OFFSET_END (buf) = op.granulepos;
+      if (GST_CLOCK_TIME_IS_VALID (stream->start_ts)) {
+        GstClockTime end;
+
+        GST_BUFFER_TIMESTAMP (buf) = stream->start_ts +
+            gst_util_uint64_scale_int (stream->granulepos, GST_SECOND,
+            enc->rate);
+        end = stream->start_ts +
+            gst_util_uint64_scale_int (op.granulepos, GST_SECOND, enc->rate);
+        GST_BUFFER_DURATION (buf) = end - GST_BUFFER_TIMESTAMP (buf);
+      }
+      stream->granulepos = op.granulepos;
+
+      stream->packets = g_list_prepend (stream->packets, buf);
+    }
+  }
+}
+
+static void
+gst_vorbis_multi_enc_pool_func (gpointer data, gpointer user_data)
+{
+  GstVorbisMultiEnc *enc = user_data;
+
+  gst_vorbis_multi_enc_encode_stream (enc, data);
+
+  g_mutex_lock (enc->lock);
+  if (--enc->pending == 0)
+    g_cond_signal (enc->cond);
+  g_mutex_unlock (enc->lock);
+}
+
+static GstFlowReturn
+gst_vorbis_multi_enc_push_stream (GstVorbisMultiEnc * enc,
+    GstVorbisMultiEncStream * stream)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstBuffer *buf;
+
+  while (stream->headers) {
+    buf = stream->headers->data;
+    stream->headers = g_slist_delete_link (stream->headers, stream->headers);
+    if (ret == GST_FLOW_OK)
+      ret = gst_pad_push (stream->pad, buf);
+    else
+      gst_buffer_unref (buf);
+  }
+
+  stream->packets = g_list_reverse (stream->packets);
+  while (stream->packets) {
+    buf = stream->packets->data;
+    stream->packets = g_list_delete_link (stream->packets, stream->packets);
+    if (ret == GST_FLOW_OK) {
+      gst_buffer_set_caps (buf, GST_PAD_CAPS (stream->pad));
+      if (stream->discont) {
+        GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
+        stream->discont = FALSE;
+      }
+      ret = gst_pad_push (stream->pad, buf);
+    } else {
+      gst_buffer_unref (buf);
+    }
+  }
+
+  return ret;
+}
+
+/* like tee, fail when one of the streams fails and say not-linked when none
+ * of them is linked */
+static GstFlowReturn
+gst_vorbis_multi_enc_combine_flows (GstVorbisMultiEnc * enc)
+{
+  GstFlowReturn ret = GST_FLOW_NOT_LINKED;
+  GList *walk;
+
+  for (walk = enc->streams; walk; walk = walk->next) {
+    GstVorbisMultiEncStream *stream = walk->data;
+
+    if (stream->last_flow == GST_FLOW_OK)
+      ret = GST_FLOW_OK;
+    else if (stream->last_flow != GST_FLOW_NOT_LINKED)
+      return stream->last_flow;
+  }
+
+  return ret;
+}
+
+/* encode the n_samples of planar input with all the encoders, 0 samples
+ * drains them */
+static GstFlowReturn
+gst_vorbis_multi_enc_encode (GstVorbisMultiEnc * enc, GstClockTime timestamp)
+{
+  GstVorbisMultiEncStream *stream;
+  GList *walk, *active = NULL;
+
+  for (walk = enc->streams; walk; walk = walk->next) {
+    stream = walk->data;
+
+    if (!stream->setup) {
+      /* nothing to drain */
+      if (enc->n_samples == 0)
+        continue;
+      if (!gst_vorbis_multi_enc_setup_stream (enc, stream, timestamp))
+        goto setup_failed;
+    }
+    active = g_list_prepend (active, stream);
+  }
+
+  if (active && active->next) {
+    /* the deinterleaved data is only read from here on, so all the encoders
+     * can run at the same time */
+    enc->pending = g_list_length (active);
+    for (walk = active; walk; walk = walk->next)
+      g_thread_pool_push (enc->pool, walk->data, NULL);
+
+    g_mutex_lock (enc->lock);
+    while (enc->pending > 0)
+      g_cond_wait (enc->cond, enc->lock);
+    g_mutex_unlock (enc->lock);
+  } else if (active) {
+    gst_vorbis_multi_enc_encode_stream (enc, active->data);
+  }
+
+  for (walk = active; walk; walk = walk->next) {
+    stream = walk->data;
+
+    stream->last_flow = gst_vorbis_multi_enc_push_stream (enc, stream);
+    if (enc->n_samples == 0) {
+      /* a new stream starts with the next buffer */
+      gst_vorbis_multi_enc_clear_stream (stream);
+    }
+  }
+  g_list_free (active);
+
+  return gst_vorbis_multi_enc_combine_flows (enc);
+
+  /* ERRORS */
+setup_failed:
+  {
+    g_list_free (active);
+    return GST_FLOW_NOT_NEGOTIATED;
+  }
+}
+
+static GstFlowReturn
+gst_vorbis_multi_enc_drain (GstVorbisMultiEnc * enc)
+{
+  enc->n_samples = 0;
+  enc->next_ts = GST_CLOCK_TIME_NONE;
+
+  return gst_vorbis_multi_enc_encode (enc, GST_CLOCK_TIME_NONE);
+}
+
+/* the input continues at @timestamp after a gap or a DISCONT buffer. The
+ * streams go on with their granulepos, only the timestamps of their packets
+ * move. When the input jumps back before the start of the streams, they are
+ * ended and new ones start at @timestamp. */
+static GstFlowReturn
+gst_vorbis_multi_enc_resync (GstVorbisMultiEnc * enc, GstClockTime timestamp)
+{
+  GList *walk;
+
+  GST_DEBUG_OBJECT (enc, "resync to %" GST_TIME_FORMAT ", expected %"
+      GST_TIME_FORMAT, GST_TIME_ARGS (timestamp),
+      GST_TIME_ARGS (enc->next_ts));
+
+  for (walk = enc->streams; walk; walk = walk->next) {
+    GstVorbisMultiEncStream *stream = walk->data;
+    GstClockTime written;
+
+    if (!stream->setup)
+      continue;
+
+    written = gst_util_uint64_scale_int (stream->samples_in, GST_SECOND,
+        enc->rate);
+    if (!GST_CLOCK_TIME_IS_VALID (timestamp) || timestamp < written)
+      return gst_vorbis_multi_enc_drain (enc);
+  }
+
+  for (walk = enc->streams; walk; walk = walk->next) {
+    GstVorbisMultiEncStream *stream = walk->data;
+
+    if (!stream->setup)
+      continue;
+
+    stream->start_ts = timestamp -
+        gst_util_uint64_scale_int (stream->samples_in, GST_SECOND, enc->rate);
+    stream->discont = TRUE;
+  }
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_vorbis_multi_enc_chain (GstPad * pad, GstBuffer * buffer)
+{
+  GstVorbisMultiEnc *enc;
+  GstFlowReturn ret;
+  GstClockTime timestamp;
+  const gfloat *data;
+  guint size, i, j;
+  gfloat *planar;
+
+  enc = GST_VORBIS_MULTI_ENC (GST_PAD_PARENT (pad));
+
+  if (G_UNLIKELY (enc->channels <= 0))
+    goto not_negotiated;
+
+  buffer = gst_audio_buffer_clip (buffer, &enc->segment, enc->rate,
+      enc->channels * sizeof (gfloat));
+  if (buffer == NULL) {
+    GST_LOG_OBJECT (enc, "buffer outside of the segment");
+    return GST_FLOW_OK;
+  }
+
+  data = (const gfloat *) GST_BUFFER_DATA (buffer);
+  size = GST_BUFFER_SIZE (buffer) / (enc->channels * sizeof (gfloat));
+  if (size == 0) {
+    gst_buffer_unref (buffer);
+    return GST_FLOW_OK;
+  }
+
+  /* buffers without timestamp continue where the previous one ended, the
+   * first one starts at the start of the segment */
+  timestamp = GST_BUFFER_TIMESTAMP (buffer);
+  if (!GST_CLOCK_TIME_IS_VALID (timestamp)) {
+    timestamp = enc->next_ts;
+    if (!GST_CLOCK_TIME_IS_VALID (timestamp) &&
+        enc->segment.format == GST_FORMAT_TIME)
+      timestamp = enc->segment.start;
+  } else if (GST_BUFFER_IS_DISCONT (buffer) ||
+      (GST_CLOCK_TIME_IS_VALID (enc->next_ts) &&
+          (timestamp > enc->next_ts + DISCONT_TOLERANCE ||
+              timestamp + DISCONT_TOLERANCE < enc->next_ts))) {
+    ret = gst_vorbis_multi_enc_resync (enc, timestamp);
+    if (ret != GST_FLOW_OK && ret != GST_FLOW_NOT_LINKED) {
+      gst_buffer_unref (buffer);
+      return ret;
+    }
+  }
+  if (GST_CLOCK_TIME_IS_VALID (timestamp))
+    enc->next_ts = timestamp +
+        gst_util_uint64_scale_int (size, GST_SECOND, enc->rate);
+
+  if (enc->planar_size < size * enc->channels) {
+    enc->planar_size = size * enc->channels;
+    enc->planar = g_renew (gfloat, enc->planar, enc->planar_size);
+  }
+
+  /* deinterleave once for all the encoders */
+  for (i = 0; i < enc->channels; i++) {
+    planar = enc->planar + i * size;
+    for (j = 0; j < size; j++)
+      planar[j] = data[j * enc->channels + i];
+  }
+  enc->n_samples = size;
+
+  GST_LOG_OBJECT (enc, "encoding %u samples", size);
+
+  ret = gst_vorbis_multi_enc_encode (enc, timestamp);
+  gst_buffer_unref (buffer);
+
+  return ret;
+
+  /* ERRORS */
+not_negotiated:
+  {
+    GST_ELEMENT_ERROR (enc, CORE, NEGOTIATION, (NULL),
+        ("encoder not initialized (input is not audio?)"));
+    gst_buffer_unref (buffer);
+    return GST_FLOW_NOT_NEGOTIATED;
+  }
+}
+
+static gboolean
+gst_vorbis_multi_enc_sink_setcaps (GstPad * pad, GstCaps * caps)
+{
+  GstVorbisMultiEnc *enc;
+  GstStructure *structure;
+  gint channels, rate;
+
+  enc = GST_VORBIS_MULTI_ENC (GST_PAD_PARENT (pad));
+
+  structure = gst_caps_get_structure (caps, 0);
+  if (!gst_structure_get_int (structure, "channels", &channels) ||
+      !gst_structure_get_int (structure, "rate", &rate))
+    return FALSE;
+
+  if (channels != enc->channels || rate != enc->rate) {
+    /* end the current streams, new ones start with the next buffer */
+    gst_vorbis_multi_enc_drain (enc);
+    enc->channels = channels;
+    enc->rate = rate;
+  }
+
+  return TRUE;
+}
+
+static gboolean
+gst_vorbis_multi_enc_sink_event (GstPad * pad, GstEvent * event)
+{
+  GstVorbisMultiEnc *enc;
+
+  enc = GST_VORBIS_MULTI_ENC (GST_PAD_PARENT (pad));
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_NEWSEGMENT:
+    {
+      gboolean update;
+      gdouble rate, applied_rate;
+      GstFormat format;
+      gint64 start, stop, time;
+
+      gst_event_parse_new_segment_full (event, &update, &rate, &applied_rate,
+          &format, &start, &stop, &time);
+      gst_segment_set_newsegment_full (&enc->segment, update, rate,
+          applied_rate, format, start, stop, time);
+      break;
+    }
+    case GST_EVENT_TAG:
+    {
+      GstTagList *list;
+
+      gst_event_parse_tag (event, &list);
+      if (enc->tags)
+        gst_tag_list_insert (enc->tags, list, GST_TAG_MERGE_REPLACE);
+      break;
+    }
+    case GST_EVENT_EOS:
+      gst_vorbis_multi_enc_drain (enc);
+      break;
+    case GST_EVENT_FLUSH_STOP:
+      gst_vorbis_multi_enc_clear_streams (enc);
+      gst_segment_init (&enc->segment, GST_FORMAT_TIME);
+      enc->next_ts = GST_CLOCK_TIME_NONE;
+      break;
+    default:
+      break;
+  }
+
+  /* forward to all the src pads */
+  return gst_pad_event_default (pad, event);
+}
+
+static GstStateChangeReturn
+gst_vorbis_multi_enc_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstVorbisMultiEnc *enc = GST_VORBIS_MULTI_ENC (element);
+  GstStateChangeReturn ret;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      enc->tags = gst_tag_list_new ();
+      gst_segment_init (&enc->segment, GST_FORMAT_TIME);
+      enc->channels = 0;
+      enc->rate = 0;
+      enc->next_ts = GST_CLOCK_TIME_NONE;
+      enc->pool = g_thread_pool_new (gst_vorbis_multi_enc_pool_func, enc, -1,
+          FALSE, NULL);
+      break;
+    default:
+      break;
+  }
+
+  ret = parent_class->change_state (element, transition);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_vorbis_multi_enc_clear_streams (enc);
+      /* no more jobs once the streaming thread stopped */
+      g_thread_pool_free (enc->pool, FALSE, TRUE);
+      enc->pool = NULL;
+      gst_tag_list_free (enc->tags);
+      enc->tags = NULL;
+      g_free (enc->planar);
+      enc->planar = NULL;
+      enc->planar_size = 0;
+      break;
+    default:
+      break;
+  }
+
+  return ret;
+}
+
+static void
+gst_vorbis_multi_enc_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstVorbisMultiEnc *enc = GST_VORBIS_MULTI_ENC (object);
+
+  switch (prop_id) {
+    case ARG_QUALITIES:
+      g_value_set_string (value, enc->qualities);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_vorbis_multi_enc_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstVorbisMultiEnc *enc = GST_VORBIS_MULTI_ENC (object);
+
+  switch (prop_id) {
+    case ARG_QUALITIES:
+      if (GST_STATE (enc) > GST_STATE_READY) {
+        GST_WARNING_OBJECT (enc, "qualities can't be changed while running");
+        break;
+      }
+      gst_vorbis_multi_enc_set_qualities (enc, g_value_get_string (value));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
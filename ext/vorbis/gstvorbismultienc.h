@@ -0,0 +1,88 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#ifndef __GST_VORBIS_MULTI_ENC_H__
+#define __GST_VORBIS_MULTI_ENC_H__
+
+
+#include <gst/gst.h>
+
+#include <vorbis/codec.h>
+
+G_BEGIN_DECLS
+
+#define GST_TYPE_VORBIS_MULTI_ENC \
+  (gst_vorbis_multi_enc_get_type())
+#define GST_VORBIS_MULTI_ENC(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_VORBIS_MULTI_ENC,GstVorbisMultiEnc))
+#define GST_VORBIS_MULTI_ENC_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_VORBIS_MULTI_ENC,GstVorbisMultiEncClass))
+#define GST_IS_VORBIS_MULTI_ENC(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_VORBIS_MULTI_ENC))
+#define GST_IS_VORBIS_MULTI_ENC_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_VORBIS_MULTI_ENC))
+
+typedef struct _GstVorbisMultiEnc GstVorbisMultiEnc;
+typedef struct _GstVorbisMultiEncClass GstVorbisMultiEncClass;
+
+/**
+ * GstVorbisMultiEnc:
+ *
+ * Opaque data structure.
+ */
+struct _GstVorbisMultiEnc {
+  GstElement element;
+
+  GstPad *sinkpad;
+
+  /* properties */
+  gchar *qualities;
+
+  /* GstVorbisMultiEncStream, one for each src pad */
+  GList *streams;
+
+  gint channels;
+  gint rate;
+
+  GstSegment segment;
+  GstTagList *tags;
+  /* where the previous input buffer ended */
+  GstClockTime next_ts;
+
+  /* the input deinterleaved once for all the encoders */
+  gfloat *planar;
+  guint planar_size;
+  guint n_samples;
+
+  /* encoders run in parallel on these threads */
+  GThreadPool *pool;
+  GMutex *lock;
+  GCond *cond;
+  guint pending;
+};
+
+struct _GstVorbisMultiEncClass {
+  GstElementClass parent_class;
+};
+
+GType gst_vorbis_multi_enc_get_type (void);
+
+G_END_DECLS
+
+#endif /* __GST_VORBIS_MULTI_ENC_H__ */
@@ -43,14 +43,21 @@
  * from the thread that performed the push-buffer call.
  *
  * The "max-bytes" property controls how much data can be queued in appsrc
- * before appsrc considers the queue full. A filled internal queue will always
- * signal the "enough-data" signal, which signals the application that it should
- * stop pushing data into appsrc. The "block" property will cause appsrc to
- * block the push-buffer method until free data becomes available again.
+ * before appsrc considers the queue full. For timestamped data the "max-time"
+ * property can be used to limit the queue to a duration instead, which keeps
+ * the latency added by the queue constant for variable bitrate streams. A
+ * filled internal queue will always signal the "enough-data" signal, which
+ * signals the application that it should stop pushing data into appsrc. The
+ * "block" property will cause appsrc to block the push-buffer method until free
+ * data becomes available again.
  *
  * When the internal queue is running out of data, the "need-data" signal is
  * emitted, which signals the application that it should start pushing more data
- * into appsrc.
+ * into appsrc. With the "min-percent" and "min-time" properties this signal is
+ * emitted before the queue is completely empty so that live producers have time
+ * to deliver new data before an underrun happens. The current fill level of the
+ * queue can be retrieved with the "current-level-bytes" and
+ * "current-level-time" properties.
  *
  * In addition to the "need-data" and "enough-data" signals, appsrc can emit the
  * "seek-data" signal when the "stream-mode" property is set to "seekable" or
@@ -80,6 +87,14 @@
  * For the stream and seekable modes, setting this property is optional but
  * recommended.
  *
+ * Applications that push many buffers of similar size can avoid allocating a
+ * new #GstBuffer and data block for every push by getting their buffers with
+ * gst_app_src_acquire_buffer(). Such buffers return to a small pool in appsrc
+ * when their last reference is dropped and are handed out again by the next
+ * acquire call. The "max-pool-buffers" property limits how many idle buffers
+ * are kept around and gst_app_src_get_pool_stats() reports how often a request
+ * could be served from the pool.
+ *
  * When the application is finished pushing data into appsrc, it should call
  * gst_app_src_end_of_stream() or emit the end-of-stream action signal. After
  * this call, no more buffers can be pushed into appsrc until a flushing seek
@@ -104,6 +119,8 @@
 
 #include "gst/glib-compat-private.h"
 
+typedef struct _GstAppSrcPool GstAppSrcPool;
+
 struct _GstAppSrcPrivate
 {
   GCond *cond;
@@ -114,6 +131,7 @@ struct _GstAppSrcPrivate
   gint64 size;
   GstAppStreamType stream_type;
   guint64 max_bytes;
+  guint64 max_time;
   GstFormat format;
   gboolean block;
 
@@ -121,6 +139,9 @@ struct _GstAppSrcPrivate
   gboolean started;
   gboolean is_eos;
   guint64 queued_bytes;
+  guint64 queued_time;
+  GstClockTime last_in_time;
+  GstClockTime last_out_time;
   guint64 offset;
   GstAppStreamType current_type;
 
@@ -128,12 +149,41 @@ struct _GstAppSrcPrivate
   guint64 max_latency;
   gboolean emit_signals;
   guint min_percent;
+  guint64 min_time;
 
   GstAppSrcCallbacks callbacks;
   gpointer user_data;
   GDestroyNotify notify;
+
+  GstAppSrcPool *pool;
+};
+
+/* The pool is refcounted separately from appsrc because the buffers it hands
+ * out can outlive the element. Every buffer that was ever allocated from the
+ * pool holds a ref until it is really freed. */
+struct _GstAppSrcPool
+{
+  gint refcount;
+  GMutex *lock;
+  gboolean active;
+  GSList *buffers;
+  guint n_buffers;
+  guint max_buffers;
+  guint64 hits;
+  guint64 misses;
 };
 
+#define GST_TYPE_APP_SRC_POOL_BUFFER (gst_app_src_pool_buffer_get_type())
+#define GST_APP_SRC_POOL_BUFFER_CAST(obj) ((GstAppSrcPoolBuffer *)(obj))
+
+typedef struct
+{
+  GstBuffer buffer;
+
+  GstAppSrcPool *pool;
+  guint alloc_size;
+} GstAppSrcPoolBuffer;
+
 GST_DEBUG_CATEGORY_STATIC (app_src_debug);
 #define GST_CAT_DEFAULT app_src_debug
 
@@ -154,6 +204,7 @@ enum
 #define DEFAULT_PROP_SIZE          -1
 #define DEFAULT_PROP_STREAM_TYPE   GST_APP_STREAM_TYPE_STREAM
 #define DEFAULT_PROP_MAX_BYTES     200000
+#define DEFAULT_PROP_MAX_TIME      0
 #define DEFAULT_PROP_FORMAT        GST_FORMAT_BYTES
 #define DEFAULT_PROP_BLOCK         FALSE
 #define DEFAULT_PROP_IS_LIVE       FALSE
@@ -161,6 +212,8 @@ enum
 #define DEFAULT_PROP_MAX_LATENCY   -1
 #define DEFAULT_PROP_EMIT_SIGNALS  TRUE
 #define DEFAULT_PROP_MIN_PERCENT   0
+#define DEFAULT_PROP_MIN_TIME      0
+#define DEFAULT_PROP_MAX_POOL_BUFFERS 16
 
 enum
 {
@@ -176,6 +229,11 @@ enum
   PROP_MAX_LATENCY,
   PROP_EMIT_SIGNALS,
   PROP_MIN_PERCENT,
+  PROP_MAX_POOL_BUFFERS,
+  PROP_MAX_TIME,
+  PROP_MIN_TIME,
+  PROP_CURRENT_LEVEL_BYTES,
+  PROP_CURRENT_LEVEL_TIME,
   PROP_LAST
 };
 
@@ -205,6 +263,187 @@ gst_app_stream_type_get_type (void)
   return (GType) stream_type_type;
 }
 
+/*** BUFFER POOL *************************************************************/
+
+static GstBufferClass *pool_buffer_parent_class = NULL;
+
+static GstAppSrcPool *
+gst_app_src_pool_new (guint max_buffers)
+{
+  GstAppSrcPool *pool;
+
+  pool = g_slice_new0 (GstAppSrcPool);
+  pool->refcount = 1;
+  pool->lock = g_mutex_new ();
+  pool->active = TRUE;
+  pool->max_buffers = max_buffers;
+
+  return pool;
+}
+
+static GstAppSrcPool *
+gst_app_src_pool_ref (GstAppSrcPool * pool)
+{
+  g_atomic_int_inc (&pool->refcount);
+
+  return pool;
+}
+
+static void
+gst_app_src_pool_unref (GstAppSrcPool * pool)
+{
+  if (g_atomic_int_dec_and_test (&pool->refcount)) {
+    g_assert (pool->buffers == NULL);
+    g_mutex_free (pool->lock);
+    g_slice_free (GstAppSrcPool, pool);
+  }
+}
+
+/* must be called with the pool lock, returns the idle buffers so that they
+ * can be unreffed without the lock */
+static GSList *
+gst_app_src_pool_steal_buffers (GstAppSrcPool * pool)
+{
+  GSList *buffers;
+
+  buffers = pool->buffers;
+  pool->buffers = NULL;
+  pool->n_buffers = 0;
+
+  return buffers;
+}
+
+static void
+gst_app_src_pool_free_buffers (GSList * buffers)
+{
+  /* the buffers are not recycled anymore because they were removed from the
+   * pool with the lock held and the pool is either inactive or full */
+  g_slist_foreach (buffers, (GFunc) gst_mini_object_unref, NULL);
+  g_slist_free (buffers);
+}
+
+/* See the comments in ximagesink about the finalize method of a
+ * GstMiniObject: when we take a new ref here, the buffer is resurrected and
+ * not freed by gst_mini_object_unref(). */
+static void
+gst_app_src_pool_buffer_finalize (GstAppSrcPoolBuffer * pbuf)
+{
+  GstAppSrcPool *pool = pbuf->pool;
+  GstBuffer *buffer = GST_BUFFER_CAST (pbuf);
+
+  g_mutex_lock (pool->lock);
+  if (pool->active && pool->n_buffers < pool->max_buffers &&
+      GST_BUFFER_MALLOCDATA (buffer) != NULL) {
+    /* reset what could be left behind by the previous user and put the buffer
+     * back into the pool */
+    if (GST_BUFFER_CAPS (buffer)) {
+      gst_caps_unref (GST_BUFFER_CAPS (buffer));
+      GST_BUFFER_CAPS (buffer) = NULL;
+    }
+    GST_BUFFER_FLAGS (buffer) = 0;
+
+    gst_buffer_ref (buffer);
+    pool->buffers = g_slist_prepend (pool->buffers, buffer);
+    pool->n_buffers++;
+    g_mutex_unlock (pool->lock);
+    return;
+  }
+  g_mutex_unlock (pool->lock);
+
+  gst_app_src_pool_unref (pool);
+  pbuf->pool = NULL;
+
+  GST_MINI_OBJECT_CLASS (pool_buffer_parent_class)->finalize
+      (GST_MINI_OBJECT_CAST (buffer));
+}
+
+static void
+gst_app_src_pool_buffer_class_init (gpointer g_class, gpointer class_data)
+{
+  GstMiniObjectClass *mini_object_class = GST_MINI_OBJECT_CLASS (g_class);
+
+  pool_buffer_parent_class = g_type_class_peek_parent (g_class);
+
+  mini_object_class->finalize = (GstMiniObjectFinalizeFunction)
+      gst_app_src_pool_buffer_finalize;
+}
+
+static GType
+gst_app_src_pool_buffer_get_type (void)
+{
+  static volatile gsize pool_buffer_type = 0;
+
+  if (g_once_init_enter (&pool_buffer_type)) {
+    static const GTypeInfo pool_buffer_info = {
+      sizeof (GstBufferClass),
+      NULL,
+      NULL,
+      gst_app_src_pool_buffer_class_init,
+      NULL,
+      NULL,
+      sizeof (GstAppSrcPoolBuffer),
+      0,
+      NULL,
+      NULL
+    };
+    GType tmp = g_type_register_static (GST_TYPE_BUFFER, "GstAppSrcPoolBuffer",
+        &pool_buffer_info, 0);
+    g_once_init_leave (&pool_buffer_type, tmp);
+  }
+
+  return (GType) pool_buffer_type;
+}
+
+/* take an idle buffer that can hold @size bytes from the pool or allocate a
+ * new one */
+static GstBuffer *
+gst_app_src_pool_acquire (GstAppSrcPool * pool, guint size)
+{
+  GstAppSrcPoolBuffer *pbuf = NULL;
+  GstBuffer *buffer;
+  GSList *walk, *prev = NULL;
+
+  g_mutex_lock (pool->lock);
+  for (walk = pool->buffers; walk; prev = walk, walk = g_slist_next (walk)) {
+    GstAppSrcPoolBuffer *cand = walk->data;
+
+    if (cand->alloc_size >= size) {
+      pbuf = cand;
+      if (prev)
+        prev->next = walk->next;
+      else
+        pool->buffers = walk->next;
+      g_slist_free_1 (walk);
+      pool->n_buffers--;
+      break;
+    }
+  }
+  if (pbuf)
+    pool->hits++;
+  else
+    pool->misses++;
+  g_mutex_unlock (pool->lock);
+
+  if (pbuf == NULL) {
+    pbuf = (GstAppSrcPoolBuffer *)
+        gst_mini_object_new (GST_TYPE_APP_SRC_POOL_BUFFER);
+    pbuf->pool = gst_app_src_pool_ref (pool);
+    pbuf->alloc_size = size;
+    if (G_LIKELY (size))
+      GST_BUFFER_MALLOCDATA (pbuf) = g_malloc (size);
+  }
+
+  buffer = GST_BUFFER_CAST (pbuf);
+  GST_BUFFER_DATA (buffer) = GST_BUFFER_MALLOCDATA (buffer);
+  GST_BUFFER_SIZE (buffer) = size;
+  GST_BUFFER_TIMESTAMP (buffer) = GST_CLOCK_TIME_NONE;
+  GST_BUFFER_DURATION (buffer) = GST_CLOCK_TIME_NONE;
+  GST_BUFFER_OFFSET (buffer) = GST_BUFFER_OFFSET_NONE;
+  GST_BUFFER_OFFSET_END (buffer) = GST_BUFFER_OFFSET_NONE;
+
+  return buffer;
+}
+
 static void gst_app_src_uri_handler_init (gpointer g_iface,
     gpointer iface_data);
 
@@ -407,6 +646,78 @@ gst_app_src_class_init (GstAppSrcClass * klass)
           0, 100, DEFAULT_PROP_MIN_PERCENT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstAppSrc::max-pool-buffers
+   *
+   * The maximum number of idle buffers that are kept for recycling by
+   * gst_app_src_acquire_buffer(). Buffers that are released when the pool is
+   * full are freed. 0 disables recycling.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_POOL_BUFFERS,
+      g_param_spec_uint ("max-pool-buffers", "Max pool buffers",
+          "The maximum number of idle buffers kept for recycling "
+          "(0 = no recycling)", 0, G_MAXUINT, DEFAULT_PROP_MAX_POOL_BUFFERS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAppSrc::max-time
+   *
+   * The maximum amount of time that can be queued internally, measured as
+   * the difference in running time between the last queued buffer and the
+   * last buffer that was pushed downstream. After the maximum amount of time
+   * is queued, appsrc will emit the "enough-data" signal. This requires
+   * timestamped buffers.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_TIME,
+      g_param_spec_uint64 ("max-time", "Max time",
+          "The maximum amount of time to queue internally (0 = unlimited)",
+          0, G_MAXUINT64, DEFAULT_PROP_MAX_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAppSrc::min-time
+   *
+   * Make appsrc emit the "need-data" signal when the amount of queued time
+   * drops below this value. Buffers without timestamps are not taken into
+   * account; without timestamps "need-data" is only emitted when the queue
+   * runs empty or drops below "min-percent".
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_MIN_TIME,
+      g_param_spec_uint64 ("min-time", "Min time",
+          "Emit need-data when the queued time drops below this value "
+          "(0 = disabled)", 0, G_MAXUINT64, DEFAULT_PROP_MIN_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAppSrc::current-level-bytes
+   *
+   * The number of bytes that are currently queued.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_CURRENT_LEVEL_BYTES,
+      g_param_spec_uint64 ("current-level-bytes", "Current level bytes",
+          "The number of currently queued bytes", 0, G_MAXUINT64, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstAppSrc::current-level-time
+   *
+   * The amount of time that is currently queued.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_CURRENT_LEVEL_TIME,
+      g_param_spec_uint64 ("current-level-time", "Current level time",
+          "The amount of currently queued time", 0, G_MAXUINT64, 0,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   /**
    * GstAppSrc::need-data:
    * @appsrc: the appsrc element that emitted the signal
@@ -520,12 +831,17 @@ gst_app_src_init (GstAppSrc * appsrc, GstAppSrcClass * klass)
   priv->size = DEFAULT_PROP_SIZE;
   priv->stream_type = DEFAULT_PROP_STREAM_TYPE;
   priv->max_bytes = DEFAULT_PROP_MAX_BYTES;
+  priv->max_time = DEFAULT_PROP_MAX_TIME;
   priv->format = DEFAULT_PROP_FORMAT;
   priv->block = DEFAULT_PROP_BLOCK;
   priv->min_latency = DEFAULT_PROP_MIN_LATENCY;
   priv->max_latency = DEFAULT_PROP_MAX_LATENCY;
   priv->emit_signals = DEFAULT_PROP_EMIT_SIGNALS;
   priv->min_percent = DEFAULT_PROP_MIN_PERCENT;
+  priv->min_time = DEFAULT_PROP_MIN_TIME;
+  priv->last_in_time = GST_CLOCK_TIME_NONE;
+  priv->last_out_time = GST_CLOCK_TIME_NONE;
+  priv->pool = gst_app_src_pool_new (DEFAULT_PROP_MAX_POOL_BUFFERS);
 
   gst_base_src_set_live (GST_BASE_SRC (appsrc), DEFAULT_PROP_IS_LIVE);
 }
@@ -539,6 +855,97 @@ gst_app_src_flush_queued (GstAppSrc * src)
   while ((buf = g_queue_pop_head (priv->queue)))
     gst_buffer_unref (buf);
   priv->queued_bytes = 0;
+  priv->queued_time = 0;
+  priv->last_in_time = GST_CLOCK_TIME_NONE;
+  priv->last_out_time = GST_CLOCK_TIME_NONE;
+}
+
+/* convert the timestamp of @buffer to running time. When @end is %TRUE, the
+ * duration of the buffer is added when it is known. Returns
+ * GST_CLOCK_TIME_NONE when the buffer has no timestamp. */
+static GstClockTime
+gst_app_src_buffer_running_time (GstAppSrc * appsrc, GstBuffer * buffer,
+    gboolean end)
+{
+  GstBaseSrc *bsrc = GST_BASE_SRC_CAST (appsrc);
+  GstClockTime time;
+
+  time = GST_BUFFER_TIMESTAMP (buffer);
+  if (!GST_CLOCK_TIME_IS_VALID (time))
+    return GST_CLOCK_TIME_NONE;
+
+  if (end && GST_BUFFER_DURATION_IS_VALID (buffer))
+    time += GST_BUFFER_DURATION (buffer);
+
+  GST_OBJECT_LOCK (appsrc);
+  if (bsrc->segment.format == GST_FORMAT_TIME) {
+    gint64 rtime;
+
+    rtime = gst_segment_to_running_time (&bsrc->segment, GST_FORMAT_TIME, time);
+    /* clip to the segment start */
+    time = rtime == -1 ? 0 : rtime;
+  }
+  GST_OBJECT_UNLOCK (appsrc);
+
+  return time;
+}
+
+/* must be called with the appsrc mutex */
+static void
+gst_app_src_update_queued_time (GstAppSrc * appsrc)
+{
+  GstAppSrcPrivate *priv = appsrc->priv;
+
+  if (GST_CLOCK_TIME_IS_VALID (priv->last_in_time) &&
+      GST_CLOCK_TIME_IS_VALID (priv->last_out_time) &&
+      priv->last_in_time > priv->last_out_time)
+    priv->queued_time = priv->last_in_time - priv->last_out_time;
+  else
+    priv->queued_time = 0;
+
+  GST_LOG_OBJECT (appsrc, "queued time now %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (priv->queued_time));
+}
+
+/* must be called with the appsrc mutex */
+static gboolean
+gst_app_src_is_full (GstAppSrc * appsrc)
+{
+  GstAppSrcPrivate *priv = appsrc->priv;
+
+  if (priv->max_bytes && priv->queued_bytes >= priv->max_bytes) {
+    GST_DEBUG_OBJECT (appsrc,
+        "queue filled (%" G_GUINT64_FORMAT " >= %" G_GUINT64_FORMAT ")",
+        priv->queued_bytes, priv->max_bytes);
+    return TRUE;
+  }
+  if (priv->max_time && priv->queued_time >= priv->max_time) {
+    GST_DEBUG_OBJECT (appsrc,
+        "queue filled (%" GST_TIME_FORMAT " >= %" GST_TIME_FORMAT ")",
+        GST_TIME_ARGS (priv->queued_time), GST_TIME_ARGS (priv->max_time));
+    return TRUE;
+  }
+  return FALSE;
+}
+
+/* must be called with the appsrc mutex */
+static gboolean
+gst_app_src_is_low (GstAppSrc * appsrc)
+{
+  GstAppSrcPrivate *priv = appsrc->priv;
+
+  /* see if we go lower than the empty-percent */
+  if (priv->min_percent && priv->max_bytes) {
+    if (priv->queued_bytes * 100 / priv->max_bytes <= priv->min_percent)
+      return TRUE;
+  }
+  /* the queued time is only known with timestamps, without them we rely on
+   * the byte limit or on the queue running empty */
+  if (priv->min_time && GST_CLOCK_TIME_IS_VALID (priv->last_in_time) &&
+      priv->queued_time <= priv->min_time)
+    return TRUE;
+
+  return FALSE;
 }
 
 static void
@@ -561,11 +968,20 @@ gst_app_src_finalize (GObject * obj)
 {
   GstAppSrc *appsrc = GST_APP_SRC_CAST (obj);
   GstAppSrcPrivate *priv = appsrc->priv;
+  GSList *buffers;
 
   g_mutex_free (priv->mutex);
   g_cond_free (priv->cond);
   g_queue_free (priv->queue);
 
+  /* buffers that are still in use are freed when they are released */
+  g_mutex_lock (priv->pool->lock);
+  priv->pool->active = FALSE;
+  buffers = gst_app_src_pool_steal_buffers (priv->pool);
+  g_mutex_unlock (priv->pool->lock);
+  gst_app_src_pool_free_buffers (buffers);
+  gst_app_src_pool_unref (priv->pool);
+
   G_OBJECT_CLASS (parent_class)->finalize (obj);
 }
 
@@ -619,6 +1035,17 @@ gst_app_src_set_property (GObject * object, guint prop_id,
     case PROP_MIN_PERCENT:
       priv->min_percent = g_value_get_uint (value);
       break;
+    case PROP_MAX_POOL_BUFFERS:
+      gst_app_src_set_max_pool_buffers (appsrc, g_value_get_uint (value));
+      break;
+    case PROP_MAX_TIME:
+      gst_app_src_set_max_time (appsrc, g_value_get_uint64 (value));
+      break;
+    case PROP_MIN_TIME:
+      g_mutex_lock (priv->mutex);
+      priv->min_time = g_value_get_uint64 (value);
+      g_mutex_unlock (priv->mutex);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -684,6 +1111,23 @@ gst_app_src_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_MIN_PERCENT:
       g_value_set_uint (value, priv->min_percent);
       break;
+    case PROP_MAX_POOL_BUFFERS:
+      g_value_set_uint (value, gst_app_src_get_max_pool_buffers (appsrc));
+      break;
+    case PROP_MAX_TIME:
+      g_value_set_uint64 (value, gst_app_src_get_max_time (appsrc));
+      break;
+    case PROP_MIN_TIME:
+      g_mutex_lock (priv->mutex);
+      g_value_set_uint64 (value, priv->min_time);
+      g_mutex_unlock (priv->mutex);
+      break;
+    case PROP_CURRENT_LEVEL_BYTES:
+      g_value_set_uint64 (value, gst_app_src_get_current_level_bytes (appsrc));
+      break;
+    case PROP_CURRENT_LEVEL_TIME:
+      g_value_set_uint64 (value, gst_app_src_get_current_level_time (appsrc));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -989,6 +1433,18 @@ gst_app_src_create (GstBaseSrc * bsrc, guint64 offset, guint size,
 
       priv->queued_bytes -= buf_size;
 
+      if (g_queue_is_empty (priv->queue)) {
+        /* nothing is queued anymore, also not in time */
+        priv->last_out_time = priv->last_in_time;
+      } else {
+        GstClockTime time;
+
+        time = gst_app_src_buffer_running_time (appsrc, *buf, TRUE);
+        if (GST_CLOCK_TIME_IS_VALID (time))
+          priv->last_out_time = time;
+      }
+      gst_app_src_update_queued_time (appsrc);
+
       /* only update the offset when in random_access mode */
       if (priv->stream_type == GST_APP_STREAM_TYPE_RANDOM_ACCESS)
         priv->offset += buf_size;
@@ -1000,13 +1456,11 @@ gst_app_src_create (GstBaseSrc * bsrc, guint64 offset, guint size,
       /* signal that we removed an item */
       g_cond_broadcast (priv->cond);
 
-      /* see if we go lower than the empty-percent */
-      if (priv->min_percent && priv->max_bytes) {
-        if (priv->queued_bytes * 100 / priv->max_bytes <= priv->min_percent)
-          /* ignore flushing state, we got a buffer and we will return it now.
-           * Errors will be handled in the next round */
-          gst_app_src_emit_need_data (appsrc, size);
-      }
+      /* see if we go lower than the low watermarks */
+      if (gst_app_src_is_low (appsrc))
+        /* ignore flushing state, we got a buffer and we will return it now.
+         * Errors will be handled in the next round */
+        gst_app_src_emit_need_data (appsrc, size);
       ret = GST_FLOW_OK;
       break;
     } else {
@@ -1301,6 +1755,121 @@ gst_app_src_get_max_bytes (GstAppSrc * appsrc)
   return result;
 }
 
+/**
+ * gst_app_src_set_max_time:
+ * @appsrc: a #GstAppSrc
+ * @max: the maximum amount of time to queue
+ *
+ * Set the maximum amount of time, in running time, that can be queued in
+ * @appsrc. After the maximum amount of time is queued, @appsrc will emit the
+ * "enough-data" signal. A value of 0 means that no time limit is used.
+ *
+ * Since: 0.10.37
+ */
+void
+gst_app_src_set_max_time (GstAppSrc * appsrc, GstClockTime max)
+{
+  GstAppSrcPrivate *priv;
+
+  g_return_if_fail (GST_IS_APP_SRC (appsrc));
+
+  priv = appsrc->priv;
+
+  g_mutex_lock (priv->mutex);
+  if (max != priv->max_time) {
+    GST_DEBUG_OBJECT (appsrc, "setting max-time to %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (max));
+    priv->max_time = max;
+    /* signal the change */
+    g_cond_broadcast (priv->cond);
+  }
+  g_mutex_unlock (priv->mutex);
+}
+
+/**
+ * gst_app_src_get_max_time:
+ * @appsrc: a #GstAppSrc
+ *
+ * Get the maximum amount of time that can be queued in @appsrc.
+ *
+ * Returns: The maximum amount of time that can be queued.
+ *
+ * Since: 0.10.37
+ */
+GstClockTime
+gst_app_src_get_max_time (GstAppSrc * appsrc)
+{
+  GstClockTime result;
+  GstAppSrcPrivate *priv;
+
+  g_return_val_if_fail (GST_IS_APP_SRC (appsrc), 0);
+
+  priv = appsrc->priv;
+
+  g_mutex_lock (priv->mutex);
+  result = priv->max_time;
+  GST_DEBUG_OBJECT (appsrc, "getting max-time of %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (result));
+  g_mutex_unlock (priv->mutex);
+
+  return result;
+}
+
+/**
+ * gst_app_src_get_current_level_bytes:
+ * @appsrc: a #GstAppSrc
+ *
+ * Get the number of currently queued bytes inside @appsrc.
+ *
+ * Returns: The number of currently queued bytes.
+ *
+ * Since: 0.10.37
+ */
+guint64
+gst_app_src_get_current_level_bytes (GstAppSrc * appsrc)
+{
+  guint64 result;
+  GstAppSrcPrivate *priv;
+
+  g_return_val_if_fail (GST_IS_APP_SRC (appsrc), 0);
+
+  priv = appsrc->priv;
+
+  g_mutex_lock (priv->mutex);
+  result = priv->queued_bytes;
+  g_mutex_unlock (priv->mutex);
+
+  return result;
+}
+
+/**
+ * gst_app_src_get_current_level_time:
+ * @appsrc: a #GstAppSrc
+ *
+ * Get the amount of currently queued time inside @appsrc. This is only known
+ * when the pushed buffers are timestamped.
+ *
+ * Returns: The amount of currently queued time.
+ *
+ * Since: 0.10.37
+ */
+GstClockTime
+gst_app_src_get_current_level_time (GstAppSrc * appsrc)
+{
+  GstClockTime result;
+  GstAppSrcPrivate *priv;
+
+  g_return_val_if_fail (GST_IS_APP_SRC (appsrc), 0);
+
+  priv = appsrc->priv;
+
+  g_mutex_lock (priv->mutex);
+  result = priv->queued_time;
+  g_mutex_unlock (priv->mutex);
+
+  return result;
+}
+
 static void
 gst_app_src_set_latencies (GstAppSrc * appsrc, gboolean do_min, guint64 min,
     gboolean do_max, guint64 max)
@@ -1423,12 +1992,141 @@ gst_app_src_get_emit_signals (GstAppSrc * appsrc)
   return result;
 }
 
+/**
+ * gst_app_src_acquire_buffer:
+ * @appsrc: a #GstAppSrc
+ * @size: the size of the buffer
+ *
+ * Get a writable buffer with @size bytes of data from the buffer pool of
+ * @appsrc. The application should fill the data and then push the buffer with
+ * gst_app_src_push_buffer() as usual.
+ *
+ * When the last reference to the buffer is dropped, it is returned to the pool
+ * and can be handed out again by a later call to this function, which avoids
+ * allocating a new buffer and data block for every push. Idle buffers are
+ * reused for any @size that fits in their memory so it is most efficient to
+ * use this function for buffers of similar sizes.
+ *
+ * The returned buffer has no timestamps, offsets, flags or caps set.
+ *
+ * Returns: a new #GstBuffer. gst_buffer_unref() after usage when it was not
+ * pushed into @appsrc.
+ *
+ * Since: 0.10.37
+ */
+GstBuffer *
+gst_app_src_acquire_buffer (GstAppSrc * appsrc, guint size)
+{
+  GstBuffer *buffer;
+
+  g_return_val_if_fail (GST_IS_APP_SRC (appsrc), NULL);
+
+  buffer = gst_app_src_pool_acquire (appsrc->priv->pool, size);
+
+  GST_LOG_OBJECT (appsrc, "acquired buffer %p of size %u", buffer, size);
+
+  return buffer;
+}
+
+/**
+ * gst_app_src_set_max_pool_buffers:
+ * @appsrc: a #GstAppSrc
+ * @max: the maximum number of idle buffers to keep
+ *
+ * Set the maximum amount of idle buffers that @appsrc keeps in its pool for
+ * recycling. When the pool is full, released buffers are freed. Setting this
+ * to 0 disables recycling.
+ *
+ * Since: 0.10.37
+ */
+void
+gst_app_src_set_max_pool_buffers (GstAppSrc * appsrc, guint max)
+{
+  GstAppSrcPool *pool;
+  GSList *buffers = NULL;
+
+  g_return_if_fail (GST_IS_APP_SRC (appsrc));
+
+  pool = appsrc->priv->pool;
+
+  g_mutex_lock (pool->lock);
+  GST_DEBUG_OBJECT (appsrc, "setting max-pool-buffers to %u", max);
+  pool->max_buffers = max;
+  /* drop the idle buffers that don't fit anymore */
+  while (pool->n_buffers > max) {
+    buffers = g_slist_prepend (buffers, pool->buffers->data);
+    pool->buffers = g_slist_delete_link (pool->buffers, pool->buffers);
+    pool->n_buffers--;
+  }
+  g_mutex_unlock (pool->lock);
+
+  gst_app_src_pool_free_buffers (buffers);
+}
+
+/**
+ * gst_app_src_get_max_pool_buffers:
+ * @appsrc: a #GstAppSrc
+ *
+ * Get the maximum amount of idle buffers that @appsrc keeps for recycling.
+ *
+ * Returns: the maximum number of idle buffers in the pool.
+ *
+ * Since: 0.10.37
+ */
+guint
+gst_app_src_get_max_pool_buffers (GstAppSrc * appsrc)
+{
+  GstAppSrcPool *pool;
+  guint result;
+
+  g_return_val_if_fail (GST_IS_APP_SRC (appsrc), 0);
+
+  pool = appsrc->priv->pool;
+
+  g_mutex_lock (pool->lock);
+  result = pool->max_buffers;
+  g_mutex_unlock (pool->lock);
+
+  return result;
+}
+
+/**
+ * gst_app_src_get_pool_stats:
+ * @appsrc: a #GstAppSrc
+ * @hits: (out) (allow-none): the number of recycled buffers
+ * @misses: (out) (allow-none): the number of newly allocated buffers
+ *
+ * Retrieve how many calls to gst_app_src_acquire_buffer() were served with a
+ * recycled buffer from the pool in @hits and how many needed a new allocation
+ * in @misses.
+ *
+ * Since: 0.10.37
+ */
+void
+gst_app_src_get_pool_stats (GstAppSrc * appsrc, guint64 * hits,
+    guint64 * misses)
+{
+  GstAppSrcPool *pool;
+
+  g_return_if_fail (GST_IS_APP_SRC (appsrc));
+
+  pool = appsrc->priv->pool;
+
+  g_mutex_lock (pool->lock);
+  if (hits)
+    *hits = pool->hits;
+  if (misses)
+    *misses = pool->misses;
+  g_mutex_unlock (pool->lock);
+}
+
 static GstFlowReturn
 gst_app_src_push_buffer_full (GstAppSrc * appsrc, GstBuffer * buffer,
     gboolean steal_ref)
 {
   gboolean first = TRUE;
   GstAppSrcPrivate *priv;
+  GstClockTime time;
 
   g_return_val_if_fail (GST_IS_APP_SRC (appsrc), GST_FLOW_ERROR);
   g_return_val_if_fail (GST_IS_BUFFER (buffer), GST_FLOW_ERROR);
@@ -1445,11 +2143,7 @@ gst_app_src_push_buffer_full (GstAppSrc * appsrc, GstBuffer * buffer,
     if (priv->is_eos)
       goto eos;
 
-    if (priv->max_bytes && priv->queued_bytes >= priv->max_bytes) {
-      GST_DEBUG_OBJECT (appsrc,
-          "queue filled (%" G_GUINT64_FORMAT " >= %" G_GUINT64_FORMAT ")",
-          priv->queued_bytes, priv->max_bytes);
-
+    if (gst_app_src_is_full (appsrc)) {
       if (first) {
         gboolean emit;
 
@@ -1488,6 +2182,16 @@ gst_app_src_push_buffer_full (GstAppSrc * appsrc, GstBuffer * buffer,
     gst_buffer_ref (buffer);
   g_queue_push_tail (priv->queue, buffer);
   priv->queued_bytes += GST_BUFFER_SIZE (buffer);
+
+  time = gst_app_src_buffer_running_time (appsrc, buffer, TRUE);
+  if (GST_CLOCK_TIME_IS_VALID (time)) {
+    /* the queue starts at the first timestamp we see after it was empty */
+    if (!GST_CLOCK_TIME_IS_VALID (priv->last_out_time))
+      priv->last_out_time = gst_app_src_buffer_running_time (appsrc, buffer,
+          FALSE);
+    priv->last_in_time = time;
+    gst_app_src_update_queued_time (appsrc);
+  }
   g_cond_broadcast (priv->cond);
   g_mutex_unlock (priv->mutex);
 
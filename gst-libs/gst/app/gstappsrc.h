@@ -133,12 +133,25 @@ GstAppStreamType gst_app_src_get_stream_type  (GstAppSrc *appsrc);
 void             gst_app_src_set_max_bytes    (GstAppSrc *appsrc, guint64 max);
 guint64          gst_app_src_get_max_bytes    (GstAppSrc *appsrc);
 
+void             gst_app_src_set_max_time     (GstAppSrc *appsrc, GstClockTime max);
+GstClockTime     gst_app_src_get_max_time     (GstAppSrc *appsrc);
+
+guint64          gst_app_src_get_current_level_bytes (GstAppSrc *appsrc);
+GstClockTime     gst_app_src_get_current_level_time  (GstAppSrc *appsrc);
+
 void             gst_app_src_set_latency      (GstAppSrc *appsrc, guint64 min, guint64 max);
 void             gst_app_src_get_latency      (GstAppSrc *appsrc, guint64 *min, guint64 *max);
 
 void             gst_app_src_set_emit_signals (GstAppSrc *appsrc, gboolean emit);
 gboolean         gst_app_src_get_emit_signals (GstAppSrc *appsrc);
 
+void             gst_app_src_set_max_pool_buffers (GstAppSrc *appsrc, guint max);
+guint            gst_app_src_get_max_pool_buffers (GstAppSrc *appsrc);
+
+void             gst_app_src_get_pool_stats   (GstAppSrc *appsrc, guint64 *hits, guint64 *misses);
+
+GstBuffer*       gst_app_src_acquire_buffer   (GstAppSrc *appsrc, guint size);
+
 GstFlowReturn    gst_app_src_push_buffer      (GstAppSrc *appsrc, GstBuffer *buffer);
 GstFlowReturn    gst_app_src_end_of_stream    (GstAppSrc *appsrc);
 
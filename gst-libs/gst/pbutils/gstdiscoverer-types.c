@@ -22,6 +22,8 @@
 #include "config.h"
 #endif
 
+#include <string.h>
+
 #include "pbutils.h"
 #include "pbutils-private.h"
 
@@ -419,6 +421,364 @@ gst_discoverer_info_class_init (GstMiniObjectClass * klass)
   klass->copy = (GstMiniObjectCopyFunction) gst_discoverer_info_copy;
 }
 
+/* Serialization into a GKeyFile, used by the discoverer cache */
+
+#define DISCOVERER_INFO_GROUP "discoverer-info"
+#define DISCOVERER_STREAM_GROUP "stream-%u"
+
+static void
+key_file_set_structure (GKeyFile * kf, const gchar * group, const gchar * key,
+    const GstStructure * s)
+{
+  gchar *str;
+
+  if (s == NULL)
+    return;
+
+  str = gst_structure_to_string (s);
+  g_key_file_set_string (kf, group, key, str);
+  g_free (str);
+}
+
+static GstStructure *
+key_file_get_structure (GKeyFile * kf, const gchar * group, const gchar * key)
+{
+  GstStructure *s = NULL;
+  gchar *str;
+
+  str = g_key_file_get_string (kf, group, key, NULL);
+  if (str) {
+    s = gst_structure_from_string (str, NULL);
+    g_free (str);
+  }
+  return s;
+}
+
+/* assigns an index to all stream infos reachable from @info */
+static void
+collect_stream_infos (GstDiscovererStreamInfo * info, GHashTable * index_map,
+    GPtrArray * streams)
+{
+  GList *tmp;
+
+  for (; info; info = info->next) {
+    if (g_hash_table_lookup (index_map, info))
+      continue;
+
+    g_ptr_array_add (streams, info);
+    /* store index + 1 so that 0 means not found */
+    g_hash_table_insert (index_map, info, GUINT_TO_POINTER (streams->len));
+
+    if (GST_IS_DISCOVERER_CONTAINER_INFO (info)) {
+      for (tmp = ((GstDiscovererContainerInfo *) info)->streams; tmp;
+          tmp = tmp->next)
+        collect_stream_infos (tmp->data, index_map, streams);
+    }
+  }
+}
+
+static gint
+stream_info_index (GHashTable * index_map, GstDiscovererStreamInfo * info)
+{
+  return (gint) GPOINTER_TO_UINT (g_hash_table_lookup (index_map, info)) - 1;
+}
+
+static void
+stream_info_to_key_file (GstDiscovererStreamInfo * info, GKeyFile * kf,
+    const gchar * group, GHashTable * index_map)
+{
+  if (info->next)
+    g_key_file_set_integer (kf, group, "next",
+        stream_info_index (index_map, info->next));
+  if (info->caps) {
+    gchar *caps = gst_caps_to_string (info->caps);
+
+    g_key_file_set_string (kf, group, "caps", caps);
+    g_free (caps);
+  }
+  key_file_set_structure (kf, group, "tags", info->tags);
+  key_file_set_structure (kf, group, "misc", info->misc);
+
+  if (GST_IS_DISCOVERER_CONTAINER_INFO (info)) {
+    GstDiscovererContainerInfo *cinfo = (GstDiscovererContainerInfo *) info;
+    GList *tmp;
+    gint *children;
+    gsize i, len;
+
+    g_key_file_set_string (kf, group, "type", "container");
+    len = g_list_length (cinfo->streams);
+    children = g_new (gint, len);
+    for (tmp = cinfo->streams, i = 0; tmp; tmp = tmp->next, i++)
+      children[i] = stream_info_index (index_map, tmp->data);
+    g_key_file_set_integer_list (kf, group, "streams", children, len);
+    g_free (children);
+  } else if (GST_IS_DISCOVERER_AUDIO_INFO (info)) {
+    GstDiscovererAudioInfo *ainfo = (GstDiscovererAudioInfo *) info;
+
+    g_key_file_set_string (kf, group, "type", "audio");
+    g_key_file_set_integer (kf, group, "channels", ainfo->channels);
+    g_key_file_set_integer (kf, group, "sample-rate", ainfo->sample_rate);
+    g_key_file_set_integer (kf, group, "depth", ainfo->depth);
+    g_key_file_set_integer (kf, group, "bitrate", ainfo->bitrate);
+    g_key_file_set_integer (kf, group, "max-bitrate", ainfo->max_bitrate);
+    if (ainfo->language)
+      g_key_file_set_string (kf, group, "language", ainfo->language);
+  } else if (GST_IS_DISCOVERER_VIDEO_INFO (info)) {
+    GstDiscovererVideoInfo *vinfo = (GstDiscovererVideoInfo *) info;
+
+    g_key_file_set_string (kf, group, "type", "video");
+    g_key_file_set_integer (kf, group, "width", vinfo->width);
+    g_key_file_set_integer (kf, group, "height", vinfo->height);
+    g_key_file_set_integer (kf, group, "depth", vinfo->depth);
+    g_key_file_set_integer (kf, group, "framerate-num", vinfo->framerate_num);
+    g_key_file_set_integer (kf, group, "framerate-denom",
+        vinfo->framerate_denom);
+    g_key_file_set_integer (kf, group, "par-num", vinfo->par_num);
+    g_key_file_set_integer (kf, group, "par-denom", vinfo->par_denom);
+    g_key_file_set_boolean (kf, group, "interlaced", vinfo->interlaced);
+    g_key_file_set_integer (kf, group, "bitrate", vinfo->bitrate);
+    g_key_file_set_integer (kf, group, "max-bitrate", vinfo->max_bitrate);
+    g_key_file_set_boolean (kf, group, "is-image", vinfo->is_image);
+  } else if (GST_IS_DISCOVERER_SUBTITLE_INFO (info)) {
+    GstDiscovererSubtitleInfo *sinfo = (GstDiscovererSubtitleInfo *) info;
+
+    g_key_file_set_string (kf, group, "type", "subtitle");
+    if (sinfo->language)
+      g_key_file_set_string (kf, group, "language", sinfo->language);
+  } else {
+    g_key_file_set_string (kf, group, "type", "unknown");
+  }
+}
+
+/* Stores everything the discoverer found out about a URI in @kf */
+void
+discoverer_info_to_key_file (GstDiscovererInfo * info, GKeyFile * kf)
+{
+  GHashTable *index_map;
+  GPtrArray *streams;
+  GList *tmp;
+  gint *list;
+  gsize i, len;
+  gchar *str;
+
+  index_map = g_hash_table_new (g_direct_hash, NULL);
+  streams = g_ptr_array_new ();
+  if (info->stream_info)
+    collect_stream_infos (info->stream_info, index_map, streams);
+
+  g_key_file_set_string (kf, DISCOVERER_INFO_GROUP, "uri", info->uri);
+  g_key_file_set_integer (kf, DISCOVERER_INFO_GROUP, "result", info->result);
+  str = g_strdup_printf ("%" G_GUINT64_FORMAT, info->duration);
+  g_key_file_set_value (kf, DISCOVERER_INFO_GROUP, "duration", str);
+  g_free (str);
+  g_key_file_set_boolean (kf, DISCOVERER_INFO_GROUP, "seekable",
+      info->seekable);
+  key_file_set_structure (kf, DISCOVERER_INFO_GROUP, "tags", info->tags);
+  key_file_set_structure (kf, DISCOVERER_INFO_GROUP, "misc", info->misc);
+
+  g_key_file_set_integer (kf, DISCOVERER_INFO_GROUP, "n-streams",
+      streams->len);
+  if (info->stream_info)
+    g_key_file_set_integer (kf, DISCOVERER_INFO_GROUP, "stream-info",
+        stream_info_index (index_map, info->stream_info));
+
+  len = g_list_length (info->stream_list);
+  list = g_new (gint, len);
+  for (tmp = info->stream_list, i = 0; tmp; tmp = tmp->next, i++)
+    list[i] = stream_info_index (index_map, tmp->data);
+  g_key_file_set_integer_list (kf, DISCOVERER_INFO_GROUP, "stream-list", list,
+      len);
+  g_free (list);
+
+  for (i = 0; i < streams->len; i++) {
+    gchar *group = g_strdup_printf (DISCOVERER_STREAM_GROUP, (guint) i);
+
+    stream_info_to_key_file (g_ptr_array_index (streams, i), kf, group,
+        index_map);
+    g_free (group);
+  }
+
+  g_ptr_array_free (streams, TRUE);
+  g_hash_table_destroy (index_map);
+}
+
+static GstDiscovererStreamInfo *
+stream_info_new_from_key_file (GKeyFile * kf, const gchar * group)
+{
+  GstDiscovererStreamInfo *info;
+  gchar *type, *str;
+
+  type = g_key_file_get_string (kf, group, "type", NULL);
+  if (type == NULL)
+    return NULL;
+
+  if (!strcmp (type, "container")) {
+    info = (GstDiscovererStreamInfo *) gst_discoverer_container_info_new ();
+  } else if (!strcmp (type, "audio")) {
+    GstDiscovererAudioInfo *ainfo = gst_discoverer_audio_info_new ();
+
+    ainfo->channels = g_key_file_get_integer (kf, group, "channels", NULL);
+    ainfo->sample_rate =
+        g_key_file_get_integer (kf, group, "sample-rate", NULL);
+    ainfo->depth = g_key_file_get_integer (kf, group, "depth", NULL);
+    ainfo->bitrate = g_key_file_get_integer (kf, group, "bitrate", NULL);
+    ainfo->max_bitrate =
+        g_key_file_get_integer (kf, group, "max-bitrate", NULL);
+    ainfo->language = g_key_file_get_string (kf, group, "language", NULL);
+    info = (GstDiscovererStreamInfo *) ainfo;
+  } else if (!strcmp (type, "video")) {
+    GstDiscovererVideoInfo *vinfo = gst_discoverer_video_info_new ();
+
+    vinfo->width = g_key_file_get_integer (kf, group, "width", NULL);
+    vinfo->height = g_key_file_get_integer (kf, group, "height", NULL);
+    vinfo->depth = g_key_file_get_integer (kf, group, "depth", NULL);
+    vinfo->framerate_num =
+        g_key_file_get_integer (kf, group, "framerate-num", NULL);
+    vinfo->framerate_denom =
+        g_key_file_get_integer (kf, group, "framerate-denom", NULL);
+    vinfo->par_num = g_key_file_get_integer (kf, group, "par-num", NULL);
+    vinfo->par_denom = g_key_file_get_integer (kf, group, "par-denom", NULL);
+    vinfo->interlaced =
+        g_key_file_get_boolean (kf, group, "interlaced", NULL);
+    vinfo->bitrate = g_key_file_get_integer (kf, group, "bitrate", NULL);
+    vinfo->max_bitrate =
+        g_key_file_get_integer (kf, group, "max-bitrate", NULL);
+    vinfo->is_image = g_key_file_get_boolean (kf, group, "is-image", NULL);
+    info = (GstDiscovererStreamInfo *) vinfo;
+  } else if (!strcmp (type, "subtitle")) {
+    GstDiscovererSubtitleInfo *sinfo = gst_discoverer_subtitle_info_new ();
+
+    sinfo->language = g_key_file_get_string (kf, group, "language", NULL);
+    info = (GstDiscovererStreamInfo *) sinfo;
+  } else {
+    info = gst_discoverer_stream_info_new ();
+  }
+  g_free (type);
+
+  str = g_key_file_get_string (kf, group, "caps", NULL);
+  if (str) {
+    info->caps = gst_caps_from_string (str);
+    g_free (str);
+  }
+  info->tags = (GstTagList *) key_file_get_structure (kf, group, "tags");
+  info->misc = key_file_get_structure (kf, group, "misc");
+
+  return info;
+}
+
+/* Recreates a #GstDiscovererInfo stored with discoverer_info_to_key_file(),
+ * returns %NULL if @kf does not contain a valid one */
+GstDiscovererInfo *
+discoverer_info_from_key_file (GKeyFile * kf)
+{
+  GstDiscovererInfo *info = NULL;
+  GstDiscovererStreamInfo **streams = NULL;
+  GError *err = NULL;
+  gint n_streams, idx, *list = NULL;
+  gsize i, len = 0;
+  gchar *group, *str;
+
+  n_streams = g_key_file_get_integer (kf, DISCOVERER_INFO_GROUP, "n-streams",
+      &err);
+  if (err || n_streams < 0)
+    goto invalid;
+
+  info = gst_discoverer_info_new ();
+  info->uri = g_key_file_get_string (kf, DISCOVERER_INFO_GROUP, "uri", NULL);
+  info->result = g_key_file_get_integer (kf, DISCOVERER_INFO_GROUP, "result",
+      NULL);
+  str = g_key_file_get_value (kf, DISCOVERER_INFO_GROUP, "duration", NULL);
+  if (str) {
+    info->duration = g_ascii_strtoull (str, NULL, 10);
+    g_free (str);
+  }
+  info->seekable = g_key_file_get_boolean (kf, DISCOVERER_INFO_GROUP,
+      "seekable", NULL);
+  info->tags = (GstTagList *) key_file_get_structure (kf,
+      DISCOVERER_INFO_GROUP, "tags");
+  info->misc = key_file_get_structure (kf, DISCOVERER_INFO_GROUP, "misc");
+  if (info->uri == NULL)
+    goto invalid;
+
+  /* create all streams first, then link them up */
+  streams = g_new0 (GstDiscovererStreamInfo *, n_streams);
+  for (idx = 0; idx < n_streams; idx++) {
+    group = g_strdup_printf (DISCOVERER_STREAM_GROUP, (guint) idx);
+    streams[idx] = stream_info_new_from_key_file (kf, group);
+    g_free (group);
+    if (streams[idx] == NULL)
+      goto invalid;
+  }
+
+#define VALID_INDEX(i) ((i) >= 0 && (i) < n_streams)
+
+  for (idx = 0; idx < n_streams; idx++) {
+    GstDiscovererStreamInfo *sinfo = streams[idx];
+    gint next;
+
+    group = g_strdup_printf (DISCOVERER_STREAM_GROUP, (guint) idx);
+    if (g_key_file_has_key (kf, group, "next", NULL)) {
+      next = g_key_file_get_integer (kf, group, "next", NULL);
+      if (VALID_INDEX (next) && next != idx) {
+        sinfo->next = gst_discoverer_stream_info_ref (streams[next]);
+        streams[next]->previous = sinfo;
+      }
+    }
+    if (GST_IS_DISCOVERER_CONTAINER_INFO (sinfo)) {
+      GstDiscovererContainerInfo *cinfo = (GstDiscovererContainerInfo *) sinfo;
+
+      list = g_key_file_get_integer_list (kf, group, "streams", &len, NULL);
+      for (i = 0; list && i < len; i++) {
+        if (!VALID_INDEX (list[i]) || list[i] == idx)
+          continue;
+        streams[list[i]]->previous = sinfo;
+        cinfo->streams = g_list_append (cinfo->streams,
+            gst_discoverer_stream_info_ref (streams[list[i]]));
+      }
+      g_free (list);
+      list = NULL;
+    }
+    g_free (group);
+  }
+
+  idx = g_key_file_get_integer (kf, DISCOVERER_INFO_GROUP, "stream-info", &err);
+  if (err == NULL && VALID_INDEX (idx))
+    info->stream_info = gst_discoverer_stream_info_ref (streams[idx]);
+  g_clear_error (&err);
+
+  /* the stream list does not hold references */
+  list = g_key_file_get_integer_list (kf, DISCOVERER_INFO_GROUP, "stream-list",
+      &len, NULL);
+  for (i = 0; list && i < len; i++) {
+    if (VALID_INDEX (list[i]))
+      info->stream_list = g_list_append (info->stream_list, streams[list[i]]);
+  }
+  g_free (list);
+
+#undef VALID_INDEX
+
+  /* the tree now holds the references */
+  for (idx = 0; idx < n_streams; idx++)
+    gst_discoverer_stream_info_unref (streams[idx]);
+  g_free (streams);
+
+  return info;
+
+invalid:
+  {
+    g_clear_error (&err);
+    if (streams) {
+      for (idx = 0; idx < n_streams; idx++)
+        if (streams[idx])
+          gst_discoverer_stream_info_unref (streams[idx]);
+      g_free (streams);
+    }
+    if (info)
+      gst_discoverer_info_unref (info);
+    return NULL;
+  }
+}
+
 /**
  * gst_discoverer_stream_info_list_free:
  * @infos: a #GList of #GstDiscovererStreamInfo
@@ -37,6 +37,17 @@
  *
  * All the information is returned in a #GstDiscovererInfo structure.
  *
+ * In non-blocking mode several URIs can be discovered at the same time by
+ * setting the #GstDiscoverer:max-parallel property before calling
+ * gst_discoverer_start(). Each URI is then handled by one of a pool of
+ * discovery pipelines. By default the #GstDiscoverer::discovered signal is
+ * still emitted in the order in which the URIs were added, this can be
+ * disabled with the #GstDiscoverer:ordered property.
+ *
+ * Results for local files can be kept in an on-disk cache by setting the
+ * #GstDiscoverer:use-cache property. A cached result is used as long as the
+ * modification time, size and inode of the file did not change.
+ *
  * Since: 0.10.31
  */
 
@@ -50,6 +61,11 @@
 
 #include "gst/glib-compat-private.h"
 
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
+
 GST_DEBUG_CATEGORY_STATIC (discoverer_debug);
 #define GST_CAT_DEFAULT discoverer_debug
 
@@ -69,6 +85,37 @@ typedef struct
   GstTagList *tags;
 } PrivateStream;
 
+/* On-disk cache of the results for local files, shared with the workers */
+typedef struct
+{
+  gint refcount;
+  GMutex *lock;
+  gchar *dir;
+  guint64 max_size;
+  gint64 size;                  /* size of all entries, -1 if not known yet */
+} DiscovererCache;
+
+/* A discovery pipeline of the worker pool, used in async mode when more than
+ * one URI is discovered at a time */
+typedef struct
+{
+  GstDiscoverer *dc;            /* the pool owner */
+  GstDiscoverer *worker;        /* discovers one URI at a time */
+  guint64 seqnum;               /* order of the URI being discovered */
+  gboolean busy;
+  gulong discovered_id;
+  gulong finished_id;
+} DiscovererWorker;
+
+/* A result that waits until the results of the URIs that were added before it
+ * have been emitted */
+typedef struct
+{
+  guint64 seqnum;
+  GstDiscovererInfo *info;
+  GError *error;
+} DiscovererResult;
+
 struct _GstDiscovererPrivate
 {
   gboolean async;
@@ -115,6 +162,22 @@ struct _GstDiscovererPrivate
   gulong pad_remove_id;
   gulong element_added_id;
   gulong bus_cb_id;
+
+  /* worker pool, only used in async mode with max-parallel > 1 */
+  guint max_parallel;
+  gboolean ordered;
+  GList *workers;
+  guint64 next_seqnum;          /* for the next URI given to a worker */
+  guint64 emit_seqnum;          /* next result to emit when ordered */
+  GList *results;               /* DiscovererResult waiting to be emitted */
+
+  /* result cache */
+  gboolean use_cache;
+  gchar *cache_dir;
+  guint64 cache_max_size;
+  DiscovererCache *cache;
+  gboolean is_worker;           /* only store results, the pool owner looks
+                                 * them up */
 };
 
 #define DISCO_LOCK(dc) g_mutex_lock (dc->priv->lock);
@@ -144,11 +207,25 @@ enum
 };
 
 #define DEFAULT_PROP_TIMEOUT 15 * GST_SECOND
+#define DEFAULT_PROP_MAX_PARALLEL 1
+#define DEFAULT_PROP_ORDERED TRUE
+#define DEFAULT_PROP_USE_CACHE FALSE
+#define DEFAULT_PROP_CACHE_DIRECTORY NULL
+#define DEFAULT_PROP_CACHE_MAX_SIZE (64 * 1024 * 1024)
+
+#define CACHE_DIRECTORY "discoverer-cache"
+#define CACHE_GROUP "discoverer-cache"
+#define CACHE_VERSION 1
 
 enum
 {
   PROP_0,
-  PROP_TIMEOUT
+  PROP_TIMEOUT,
+  PROP_MAX_PARALLEL,
+  PROP_ORDERED,
+  PROP_USE_CACHE,
+  PROP_CACHE_DIRECTORY,
+  PROP_CACHE_MAX_SIZE
 };
 
 static guint gst_discoverer_signals[LAST_SIGNAL] = { 0 };
@@ -164,6 +241,9 @@ static void uridecodebin_pad_added_cb (GstElement * uridecodebin, GstPad * pad,
 static void uridecodebin_pad_removed_cb (GstElement * uridecodebin,
     GstPad * pad, GstDiscoverer * dc);
 
+static void discoverer_cache_unref (DiscovererCache * cache);
+static void discoverer_reset_cache_locked (GstDiscoverer * dc);
+
 static void gst_discoverer_dispose (GObject * dc);
 static void gst_discoverer_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
@@ -197,6 +277,82 @@ gst_discoverer_class_init (GstDiscovererClass * klass)
           GST_SECOND, 3600 * GST_SECOND, DEFAULT_PROP_TIMEOUT,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstDiscoverer:max-parallel
+   *
+   * The maximum number of URIs that are discovered at the same time in
+   * asynchronous mode. Each of them uses its own discovery pipeline. The
+   * value is used the next time gst_discoverer_start() is called.
+   *
+   * Synchronous discovery with gst_discoverer_discover_uri() always handles
+   * one URI at a time.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_MAX_PARALLEL,
+      g_param_spec_uint ("max-parallel", "Max parallel",
+          "Maximum number of URIs discovered at the same time in "
+          "asynchronous mode", 1, 256, DEFAULT_PROP_MAX_PARALLEL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstDiscoverer:ordered
+   *
+   * Whether the #GstDiscoverer::discovered signal is emitted in the order in
+   * which the URIs were added when #GstDiscoverer:max-parallel is bigger than
+   * 1. If %FALSE, results are emitted as soon as they are available.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_ORDERED,
+      g_param_spec_boolean ("ordered", "Ordered",
+          "Emit the results in the order in which the URIs were added",
+          DEFAULT_PROP_ORDERED, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstDiscoverer:use-cache
+   *
+   * Whether to store the results for local files in an on-disk cache and to
+   * use them instead of discovering the file again. An entry is only used if
+   * the modification time (with sub-second precision where the platform
+   * provides it), size and inode of the file are unchanged, else it is
+   * removed. Only successful results are cached.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_USE_CACHE,
+      g_param_spec_boolean ("use-cache", "Use cache",
+          "Cache the results for local files on disk",
+          DEFAULT_PROP_USE_CACHE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstDiscoverer:cache-directory
+   *
+   * The directory of the result cache. If %NULL, a directory in the
+   * GStreamer user directory is used.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_CACHE_DIRECTORY,
+      g_param_spec_string ("cache-directory", "Cache directory",
+          "Directory of the result cache (NULL = default)",
+          DEFAULT_PROP_CACHE_DIRECTORY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstDiscoverer:cache-max-size
+   *
+   * The maximum size in bytes of the result cache. When it grows bigger, the
+   * least recently used entries are removed. 0 means unlimited.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_CACHE_MAX_SIZE,
+      g_param_spec_uint64 ("cache-max-size", "Cache max size",
+          "Maximum size of the result cache in bytes (0 = unlimited)",
+          0, G_MAXUINT64, DEFAULT_PROP_CACHE_MAX_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /* signals */
   /**
    * GstDiscoverer::finished:
@@ -259,6 +415,11 @@ gst_discoverer_init (GstDiscoverer * dc)
 
   dc->priv->timeout = DEFAULT_PROP_TIMEOUT;
   dc->priv->async = FALSE;
+  dc->priv->max_parallel = DEFAULT_PROP_MAX_PARALLEL;
+  dc->priv->ordered = DEFAULT_PROP_ORDERED;
+  dc->priv->use_cache = DEFAULT_PROP_USE_CACHE;
+  dc->priv->cache_dir = g_strdup (DEFAULT_PROP_CACHE_DIRECTORY);
+  dc->priv->cache_max_size = DEFAULT_PROP_CACHE_MAX_SIZE;
 
   dc->priv->lock = g_mutex_new ();
 
@@ -362,6 +523,13 @@ gst_discoverer_dispose (GObject * obj)
     dc->priv->seeking_query = NULL;
   }
 
+  if (dc->priv->cache) {
+    discoverer_cache_unref (dc->priv->cache);
+    dc->priv->cache = NULL;
+  }
+  g_free (dc->priv->cache_dir);
+  dc->priv->cache_dir = NULL;
+
   G_OBJECT_CLASS (gst_discoverer_parent_class)->dispose (obj);
 }
 
@@ -375,6 +543,35 @@ gst_discoverer_set_property (GObject * object, guint prop_id,
     case PROP_TIMEOUT:
       gst_discoverer_set_timeout (dc, g_value_get_uint64 (value));
       break;
+    case PROP_MAX_PARALLEL:
+      DISCO_LOCK (dc);
+      dc->priv->max_parallel = g_value_get_uint (value);
+      DISCO_UNLOCK (dc);
+      break;
+    case PROP_ORDERED:
+      DISCO_LOCK (dc);
+      dc->priv->ordered = g_value_get_boolean (value);
+      DISCO_UNLOCK (dc);
+      break;
+    case PROP_USE_CACHE:
+      DISCO_LOCK (dc);
+      dc->priv->use_cache = g_value_get_boolean (value);
+      discoverer_reset_cache_locked (dc);
+      DISCO_UNLOCK (dc);
+      break;
+    case PROP_CACHE_DIRECTORY:
+      DISCO_LOCK (dc);
+      g_free (dc->priv->cache_dir);
+      dc->priv->cache_dir = g_value_dup_string (value);
+      discoverer_reset_cache_locked (dc);
+      DISCO_UNLOCK (dc);
+      break;
+    case PROP_CACHE_MAX_SIZE:
+      DISCO_LOCK (dc);
+      dc->priv->cache_max_size = g_value_get_uint64 (value);
+      discoverer_reset_cache_locked (dc);
+      DISCO_UNLOCK (dc);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -393,6 +590,31 @@ gst_discoverer_get_property (GObject * object, guint prop_id,
       g_value_set_uint64 (value, dc->priv->timeout);
       DISCO_UNLOCK (dc);
       break;
+    case PROP_MAX_PARALLEL:
+      DISCO_LOCK (dc);
+      g_value_set_uint (value, dc->priv->max_parallel);
+      DISCO_UNLOCK (dc);
+      break;
+    case PROP_ORDERED:
+      DISCO_LOCK (dc);
+      g_value_set_boolean (value, dc->priv->ordered);
+      DISCO_UNLOCK (dc);
+      break;
+    case PROP_USE_CACHE:
+      DISCO_LOCK (dc);
+      g_value_set_boolean (value, dc->priv->use_cache);
+      DISCO_UNLOCK (dc);
+      break;
+    case PROP_CACHE_DIRECTORY:
+      DISCO_LOCK (dc);
+      g_value_set_string (value, dc->priv->cache_dir);
+      DISCO_UNLOCK (dc);
+      break;
+    case PROP_CACHE_MAX_SIZE:
+      DISCO_LOCK (dc);
+      g_value_set_uint64 (value, dc->priv->cache_max_size);
+      DISCO_UNLOCK (dc);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1000,10 +1222,431 @@ parse_stream_topology (GstDiscoverer * dc, const GstStructure * topology,
   return res;
 }
 
+/* Result cache */
+
+typedef struct
+{
+  gchar *path;
+  time_t mtime;
+  goffset size;
+} DiscovererCacheEntry;
+
+/* identity of a cached file */
+typedef struct
+{
+  gint64 mtime;
+  gint64 mtime_nsec;
+  gint64 size;
+  guint64 inode;
+} DiscovererFileId;
+
+static DiscovererCache *
+discoverer_cache_new (const gchar * dir, guint64 max_size)
+{
+  DiscovererCache *cache;
+
+  cache = g_slice_new (DiscovererCache);
+  cache->refcount = 1;
+  cache->lock = g_mutex_new ();
+  if (dir)
+    cache->dir = g_strdup (dir);
+  else
+    cache->dir = g_build_filename (g_get_home_dir (), ".gstreamer-"
+        GST_MAJORMINOR, CACHE_DIRECTORY, NULL);
+  cache->max_size = max_size;
+  cache->size = -1;
+
+  GST_DEBUG ("cache in %s, max size %" G_GUINT64_FORMAT, cache->dir,
+      max_size);
+
+  return cache;
+}
+
+static DiscovererCache *
+discoverer_cache_ref (DiscovererCache * cache)
+{
+  g_atomic_int_inc (&cache->refcount);
+  return cache;
+}
+
+static void
+discoverer_cache_unref (DiscovererCache * cache)
+{
+  if (g_atomic_int_dec_and_test (&cache->refcount)) {
+    g_mutex_free (cache->lock);
+    g_free (cache->dir);
+    g_slice_free (DiscovererCache, cache);
+  }
+}
+
+/* the settings changed, the cache is created again when it is needed.
+ * must be called with the DISCO_LOCK */
+static void
+discoverer_reset_cache_locked (GstDiscoverer * dc)
+{
+  if (dc->priv->cache) {
+    discoverer_cache_unref (dc->priv->cache);
+    dc->priv->cache = NULL;
+  }
+}
+
+/* must be called with the DISCO_LOCK */
+static DiscovererCache *
+discoverer_get_cache_locked (GstDiscoverer * dc)
+{
+  if (dc->priv->cache == NULL && dc->priv->use_cache)
+    dc->priv->cache =
+        discoverer_cache_new (dc->priv->cache_dir, dc->priv->cache_max_size);
+
+  return dc->priv->cache;
+}
+
+/* identity of the file @uri refers to, only local files can be cached */
+static gboolean
+discoverer_cache_stat_uri (const gchar * uri, DiscovererFileId * id)
+{
+  struct stat st;
+  gchar *filename;
+  gboolean ret;
+
+  filename = g_filename_from_uri (uri, NULL, NULL);
+  if (filename == NULL)
+    return FALSE;
+
+  ret = (g_stat (filename, &st) == 0 && S_ISREG (st.st_mode));
+  if (ret) {
+    id->mtime = st.st_mtime;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
+    id->mtime_nsec = st.st_mtim.tv_nsec;
+#else
+    id->mtime_nsec = 0;
+#endif
+    id->size = st.st_size;
+    id->inode = st.st_ino;
+  }
+  g_free (filename);
+
+  return ret;
+}
+
+static const gchar *file_id_keys[] =
+    { "mtime", "mtime-nsec", "size", "inode" };
+
+static void
+discoverer_file_id_get_values (const DiscovererFileId * id, guint64 * values)
+{
+  values[0] = id->mtime;
+  values[1] = id->mtime_nsec;
+  values[2] = id->size;
+  values[3] = id->inode;
+}
+
+static void
+discoverer_file_id_to_key_file (const DiscovererFileId * id, GKeyFile * kf)
+{
+  guint64 values[4];
+  gchar *value;
+  guint i;
+
+  discoverer_file_id_get_values (id, values);
+  for (i = 0; i < G_N_ELEMENTS (values); i++) {
+    value = g_strdup_printf ("%" G_GUINT64_FORMAT, values[i]);
+    g_key_file_set_value (kf, CACHE_GROUP, file_id_keys[i], value);
+    g_free (value);
+  }
+}
+
+/* whether the entry in @kf was stored for the file identified by @id */
+static gboolean
+discoverer_file_id_matches_key_file (const DiscovererFileId * id,
+    GKeyFile * kf)
+{
+  guint64 values[4];
+  gchar *value;
+  gboolean ret = TRUE;
+  guint i;
+
+  discoverer_file_id_get_values (id, values);
+  for (i = 0; ret && i < G_N_ELEMENTS (values); i++) {
+    value = g_key_file_get_value (kf, CACHE_GROUP, file_id_keys[i], NULL);
+    ret = value && g_ascii_strtoull (value, NULL, 10) == values[i];
+    g_free (value);
+  }
+
+  return ret;
+}
+
+static gchar *
+discoverer_cache_entry_path (DiscovererCache * cache, const gchar * uri)
+{
+  gchar *hash, *subdir, *path;
+
+  /* spread the entries over 256 subdirectories */
+  hash = g_compute_checksum_for_string (G_CHECKSUM_SHA1, uri, -1);
+  subdir = g_strndup (hash, 2);
+  path = g_build_filename (cache->dir, subdir, hash, NULL);
+  g_free (subdir);
+  g_free (hash);
+
+  return path;
+}
+
+static void
+discoverer_cache_entry_free (DiscovererCacheEntry * entry)
+{
+  g_free (entry->path);
+  g_slice_free (DiscovererCacheEntry, entry);
+}
+
+static gint
+discoverer_cache_entry_compare (const DiscovererCacheEntry * a,
+    const DiscovererCacheEntry * b)
+{
+  if (a->mtime < b->mtime)
+    return -1;
+  return a->mtime > b->mtime;
+}
+
+/* Returns the size of all entries in the cache and, if @entries is not
+ * NULL, a list of all of them */
+static gint64
+discoverer_cache_scan (DiscovererCache * cache, GList ** entries)
+{
+  GDir *dir, *subdir;
+  const gchar *name, *entry_name;
+  gint64 total = 0;
+
+  dir = g_dir_open (cache->dir, 0, NULL);
+  if (dir == NULL)
+    return 0;
+
+  while ((name = g_dir_read_name (dir))) {
+    gchar *subpath = g_build_filename (cache->dir, name, NULL);
+
+    subdir = g_dir_open (subpath, 0, NULL);
+    if (subdir) {
+      while ((entry_name = g_dir_read_name (subdir))) {
+        gchar *path = g_build_filename (subpath, entry_name, NULL);
+        struct stat st;
+
+        if (g_stat (path, &st) == 0 && S_ISREG (st.st_mode)) {
+          total += st.st_size;
+          if (entries) {
+            DiscovererCacheEntry *entry = g_slice_new (DiscovererCacheEntry);
+
+            entry->path = path;
+            entry->mtime = st.st_mtime;
+            entry->size = st.st_size;
+            *entries = g_list_prepend (*entries, entry);
+            continue;
+          }
+        }
+        g_free (path);
+      }
+      g_dir_close (subdir);
+    }
+    g_free (subpath);
+  }
+  g_dir_close (dir);
+
+  return total;
+}
+
+/* removes the least recently used entries until the cache uses less than 3/4
+ * of its maximum size. Entries are touched when they are used, so their
+ * modification time is the time of their last use. must be called with the
+ * cache lock */
+static void
+discoverer_cache_prune_locked (DiscovererCache * cache)
+{
+  GList *entries = NULL, *tmp;
+  gint64 target = cache->max_size / 4 * 3;
+
+  cache->size = discoverer_cache_scan (cache, &entries);
+  entries = g_list_sort (entries, (GCompareFunc) discoverer_cache_entry_compare);
+
+  for (tmp = entries; tmp && cache->size > target; tmp = tmp->next) {
+    DiscovererCacheEntry *entry = (DiscovererCacheEntry *) tmp->data;
+
+    if (g_unlink (entry->path) == 0)
+      cache->size -= entry->size;
+  }
+  GST_DEBUG ("pruned cache to %" G_GINT64_FORMAT " bytes", cache->size);
+
+  g_list_foreach (entries, (GFunc) discoverer_cache_entry_free, NULL);
+  g_list_free (entries);
+}
+
+/* forget about an entry that is not valid anymore */
+static void
+discoverer_cache_remove (DiscovererCache * cache, const gchar * path,
+    gsize size)
+{
+  if (g_unlink (path) != 0)
+    return;
+
+  g_mutex_lock (cache->lock);
+  if (cache->size >= (gint64) size)
+    cache->size -= size;
+  g_mutex_unlock (cache->lock);
+}
+
+/* Returns the cached result for @uri, or NULL if there is none or the file
+ * changed since it was stored */
+static GstDiscovererInfo *
+discoverer_cache_lookup (DiscovererCache * cache, const gchar * uri)
+{
+  GstDiscovererInfo *info = NULL;
+  GKeyFile *kf;
+  gchar *path, *data = NULL;
+  gsize length;
+  DiscovererFileId id;
+  gboolean valid;
+
+  if (!discoverer_cache_stat_uri (uri, &id))
+    return NULL;
+
+  path = discoverer_cache_entry_path (cache, uri);
+  if (!g_file_get_contents (path, &data, &length, NULL)) {
+    g_free (path);
+    return NULL;
+  }
+
+  kf = g_key_file_new ();
+  valid = g_key_file_load_from_data (kf, data, length, G_KEY_FILE_NONE, NULL)
+      && g_key_file_get_integer (kf, CACHE_GROUP, "version", NULL) ==
+      CACHE_VERSION;
+
+  /* the file must be unchanged */
+  if (valid)
+    valid = discoverer_file_id_matches_key_file (&id, kf);
+  if (valid) {
+    info = discoverer_info_from_key_file (kf);
+    /* protect against hash collisions */
+    if (info && g_strcmp0 (info->uri, uri) != 0) {
+      gst_discoverer_info_unref (info);
+      info = NULL;
+    }
+  }
+
+  if (info == NULL) {
+    GST_DEBUG ("removing outdated cache entry for %s", uri);
+    discoverer_cache_remove (cache, path, length);
+  } else {
+    GST_DEBUG ("using cached result for %s", uri);
+    /* for pruning the least recently used entries */
+    g_utime (path, NULL);
+  }
+
+  g_key_file_free (kf);
+  g_free (data);
+  g_free (path);
+
+  return info;
+}
+
+static void
+discoverer_cache_store (DiscovererCache * cache, GstDiscovererInfo * info)
+{
+  GKeyFile *kf;
+  gchar *path, *dirname, *data;
+  gsize length;
+  DiscovererFileId id;
+  struct stat st;
+  gint64 old_size = 0;
+
+  if (info->result != GST_DISCOVERER_OK || info->uri == NULL)
+    return;
+
+  if (!discoverer_cache_stat_uri (info->uri, &id))
+    return;
+
+  kf = g_key_file_new ();
+  g_key_file_set_integer (kf, CACHE_GROUP, "version", CACHE_VERSION);
+  discoverer_file_id_to_key_file (&id, kf);
+  discoverer_info_to_key_file (info, kf);
+  data = g_key_file_to_data (kf, &length, NULL);
+  g_key_file_free (kf);
+
+  path = discoverer_cache_entry_path (cache, info->uri);
+  if (g_stat (path, &st) == 0)
+    old_size = st.st_size;
+
+  dirname = g_path_get_dirname (path);
+  if (g_mkdir_with_parents (dirname, 0755) != 0
+      || !g_file_set_contents (path, data, length, NULL)) {
+    GST_WARNING ("could not write cache entry %s", path);
+    length = 0;
+  }
+  g_free (dirname);
+  g_free (data);
+  g_free (path);
+
+  if (length == 0)
+    return;
+
+  g_mutex_lock (cache->lock);
+  if (cache->size == -1)
+    cache->size = discoverer_cache_scan (cache, NULL);
+  else
+    cache->size += length - old_size;
+
+  if (cache->max_size > 0 && cache->size > (gint64) cache->max_size)
+    discoverer_cache_prune_locked (cache);
+  g_mutex_unlock (cache->lock);
+}
+
+/* Emits the cached results of the URIs at the start of the pending list.
+ * must be called with the DISCO_LOCK, which is released while reading the
+ * cache and while emitting */
+static void
+discoverer_emit_cached_locked (GstDiscoverer * dc)
+{
+  DiscovererCache *cache;
+  GstDiscovererInfo *info;
+
+  if (dc->priv->is_worker || !(cache = discoverer_get_cache_locked (dc)))
+    return;
+
+  cache = discoverer_cache_ref (cache);
+  while (dc->priv->running && dc->priv->pending_uris &&
+      dc->priv->current_info == NULL) {
+    gchar *uri = (gchar *) dc->priv->pending_uris->data;
+
+    dc->priv->pending_uris =
+        g_list_delete_link (dc->priv->pending_uris, dc->priv->pending_uris);
+
+    /* don't block the other threads on the disk */
+    DISCO_UNLOCK (dc);
+    info = discoverer_cache_lookup (cache, uri);
+    DISCO_LOCK (dc);
+
+    if (info == NULL) {
+      /* discover it normally, unless we were stopped in the meantime */
+      if (dc->priv->running)
+        dc->priv->pending_uris = g_list_prepend (dc->priv->pending_uris, uri);
+      else
+        g_free (uri);
+      break;
+    }
+    g_free (uri);
+
+    DISCO_UNLOCK (dc);
+    GST_DEBUG ("Emitting 'discovered' from cache");
+    g_signal_emit (dc, gst_discoverer_signals[SIGNAL_DISCOVERED], 0, info,
+        NULL);
+    gst_discoverer_info_unref (info);
+    DISCO_LOCK (dc);
+  }
+  discoverer_cache_unref (cache);
+}
+
 /* Called when pipeline is pre-rolled */
 static void
 discoverer_collect (GstDiscoverer * dc)
 {
+  DiscovererCache *cache;
+
   GST_DEBUG ("Collecting information");
 
   /* Stop the timeout handler if present */
@@ -1093,6 +1736,19 @@ discoverer_collect (GstDiscoverer * dc)
     }
   }
 
+  DISCO_LOCK (dc);
+  cache = discoverer_get_cache_locked (dc);
+  if (cache && dc->priv->current_error == NULL)
+    cache = discoverer_cache_ref (cache);
+  else
+    cache = NULL;
+  DISCO_UNLOCK (dc);
+
+  if (cache) {
+    discoverer_cache_store (cache, dc->priv->current_info);
+    discoverer_cache_unref (cache);
+  }
+
   if (dc->priv->async) {
     GST_DEBUG ("Emitting 'discoverered'");
     g_signal_emit (dc, gst_discoverer_signals[SIGNAL_DISCOVERED], 0,
@@ -1311,7 +1967,11 @@ discoverer_cleanup (GstDiscoverer * dc)
 
   /* Try popping the next uri */
   if (dc->priv->async) {
-    if (dc->priv->pending_uris != NULL) {
+    discoverer_emit_cached_locked (dc);
+    if (dc->priv->current_info != NULL) {
+      /* a URI added from a signal handler is already being processed */
+      DISCO_UNLOCK (dc);
+    } else if (dc->priv->pending_uris != NULL) {
       _setup_locked (dc);
       DISCO_UNLOCK (dc);
       /* Start timeout */
@@ -1387,6 +2047,20 @@ start_discovering (GstDiscoverer * dc)
 
   g_signal_emit (dc, gst_discoverer_signals[SIGNAL_STARTING], 0);
 
+  if (dc->priv->async) {
+    discoverer_emit_cached_locked (dc);
+    if (dc->priv->current_info != NULL) {
+      DISCO_UNLOCK (dc);
+      goto beach;
+    }
+    if (dc->priv->pending_uris == NULL) {
+      /* everything came from the cache */
+      DISCO_UNLOCK (dc);
+      g_signal_emit (dc, gst_discoverer_signals[SIGNAL_FINISHED], 0);
+      goto beach;
+    }
+  }
+
   _setup_locked (dc);
 
   DISCO_UNLOCK (dc);
@@ -1400,6 +2074,254 @@ beach:
   return res;
 }
 
+/* Worker pool */
+
+static void
+discoverer_result_free (DiscovererResult * result)
+{
+  gst_discoverer_info_unref (result->info);
+  if (result->error)
+    g_error_free (result->error);
+  g_slice_free (DiscovererResult, result);
+}
+
+static gint
+discoverer_result_compare (const DiscovererResult * a,
+    const DiscovererResult * b)
+{
+  if (a->seqnum < b->seqnum)
+    return -1;
+  return a->seqnum > b->seqnum;
+}
+
+/* Emits the result for the URI with @seqnum, or keeps it until the results
+ * before it were emitted. Takes ownership of @info and @err */
+static void
+workers_push_result (GstDiscoverer * dc, guint64 seqnum,
+    GstDiscovererInfo * info, GError * err)
+{
+  DiscovererResult *result;
+  GList *ready = NULL, *tmp;
+
+  result = g_slice_new (DiscovererResult);
+  result->seqnum = seqnum;
+  result->info = info;
+  result->error = err;
+
+  DISCO_LOCK (dc);
+  if (!dc->priv->ordered) {
+    ready = g_list_append (ready, result);
+  } else {
+    dc->priv->results = g_list_insert_sorted (dc->priv->results, result,
+        (GCompareFunc) discoverer_result_compare);
+
+    /* take all results that can be emitted now */
+    while (dc->priv->results) {
+      result = (DiscovererResult *) dc->priv->results->data;
+      if (result->seqnum != dc->priv->emit_seqnum)
+        break;
+      dc->priv->results =
+          g_list_delete_link (dc->priv->results, dc->priv->results);
+      ready = g_list_append (ready, result);
+      dc->priv->emit_seqnum++;
+    }
+  }
+  DISCO_UNLOCK (dc);
+
+  for (tmp = ready; tmp; tmp = tmp->next) {
+    result = (DiscovererResult *) tmp->data;
+    GST_DEBUG ("Emitting 'discovered' for %" G_GUINT64_FORMAT, result->seqnum);
+    g_signal_emit (dc, gst_discoverer_signals[SIGNAL_DISCOVERED], 0,
+        result->info, result->error);
+    discoverer_result_free (result);
+  }
+  g_list_free (ready);
+}
+
+/* Hands pending URIs to idle workers, URIs that are in the cache don't need
+ * one. Emits finished when there is nothing left to do. */
+static void
+workers_dispatch (GstDiscoverer * dc)
+{
+  GList *tmp, *todo = NULL, *cached = NULL;
+  DiscovererCache *cache;
+  gboolean idle = TRUE, finished;
+
+  DISCO_LOCK (dc);
+  if (!dc->priv->running) {
+    DISCO_UNLOCK (dc);
+    return;
+  }
+
+  cache = discoverer_get_cache_locked (dc);
+  if (cache)
+    cache = discoverer_cache_ref (cache);
+
+  /* the workers are only added and removed from this thread */
+  for (tmp = dc->priv->workers; tmp; tmp = tmp->next) {
+    DiscovererWorker *w = (DiscovererWorker *) tmp->data;
+
+    while (!w->busy && dc->priv->pending_uris && dc->priv->running) {
+      gchar *uri = (gchar *) dc->priv->pending_uris->data;
+      GstDiscovererInfo *info = NULL;
+      guint64 seqnum;
+
+      dc->priv->pending_uris =
+          g_list_delete_link (dc->priv->pending_uris, dc->priv->pending_uris);
+      seqnum = dc->priv->next_seqnum++;
+
+      if (cache) {
+        /* reserve the worker and don't block the other threads on the disk */
+        w->busy = TRUE;
+        DISCO_UNLOCK (dc);
+        info = discoverer_cache_lookup (cache, uri);
+        DISCO_LOCK (dc);
+        w->busy = FALSE;
+      }
+
+      if (info == NULL && !dc->priv->running) {
+        g_free (uri);
+        break;
+      }
+
+      if (info) {
+        DiscovererResult *result = g_slice_new0 (DiscovererResult);
+
+        result->seqnum = seqnum;
+        result->info = info;
+        cached = g_list_append (cached, result);
+        g_free (uri);
+        continue;
+      }
+
+      w->busy = TRUE;
+      w->seqnum = seqnum;
+
+      GST_DEBUG_OBJECT (dc, "worker %p discovers %s (%" G_GUINT64_FORMAT ")",
+          w->worker, uri, w->seqnum);
+      /* keep the uri and worker together, the worker is only freed from
+       * gst_discoverer_stop() in this thread */
+      todo = g_list_prepend (todo, uri);
+      todo = g_list_prepend (todo, w);
+    }
+    idle = idle && !w->busy;
+  }
+  DISCO_UNLOCK (dc);
+
+  if (cache)
+    discoverer_cache_unref (cache);
+
+  for (tmp = cached; tmp; tmp = tmp->next) {
+    DiscovererResult *result = (DiscovererResult *) tmp->data;
+
+    workers_push_result (dc, result->seqnum, result->info, NULL);
+    g_slice_free (DiscovererResult, result);
+  }
+  g_list_free (cached);
+
+  for (tmp = todo; tmp; tmp = tmp->next->next) {
+    DiscovererWorker *w = (DiscovererWorker *) tmp->data;
+    gchar *uri = (gchar *) tmp->next->data;
+
+    gst_discoverer_discover_uri_async (w->worker, uri);
+    g_free (uri);
+  }
+  g_list_free (todo);
+
+  DISCO_LOCK (dc);
+  finished = idle && dc->priv->pending_uris == NULL &&
+      dc->priv->results == NULL && dc->priv->running;
+  DISCO_UNLOCK (dc);
+
+  if (finished) {
+    GST_DEBUG_OBJECT (dc, "all workers are idle, we're done");
+    g_signal_emit (dc, gst_discoverer_signals[SIGNAL_FINISHED], 0);
+  }
+}
+
+static void
+worker_discovered_cb (GstDiscoverer * worker, GstDiscovererInfo * info,
+    GError * err, DiscovererWorker * w)
+{
+  workers_push_result (w->dc, w->seqnum, gst_discoverer_info_ref (info),
+      err ? g_error_copy (err) : NULL);
+}
+
+/* the worker is done with its URI and idle again */
+static void
+worker_finished_cb (GstDiscoverer * worker, DiscovererWorker * w)
+{
+  GstDiscoverer *dc = w->dc;
+
+  DISCO_LOCK (dc);
+  w->busy = FALSE;
+  DISCO_UNLOCK (dc);
+
+  workers_dispatch (dc);
+}
+
+static void
+workers_start (GstDiscoverer * dc, guint n_workers)
+{
+  guint i;
+
+  GST_DEBUG_OBJECT (dc, "starting %u workers", n_workers);
+
+  dc->priv->next_seqnum = 0;
+  dc->priv->emit_seqnum = 0;
+
+  for (i = 0; i < n_workers; i++) {
+    DiscovererWorker *w;
+    GstDiscoverer *worker;
+
+    worker = gst_discoverer_new (dc->priv->timeout, NULL);
+    if (worker == NULL)
+      break;
+
+    /* the workers only store results, we look them up before handing out
+     * URIs */
+    worker->priv->is_worker = TRUE;
+    DISCO_LOCK (dc);
+    if (discoverer_get_cache_locked (dc))
+      worker->priv->cache = discoverer_cache_ref (dc->priv->cache);
+    DISCO_UNLOCK (dc);
+
+    w = g_slice_new0 (DiscovererWorker);
+    w->dc = dc;
+    w->worker = worker;
+    w->discovered_id = g_signal_connect (worker, "discovered",
+        G_CALLBACK (worker_discovered_cb), w);
+    w->finished_id = g_signal_connect (worker, "finished",
+        G_CALLBACK (worker_finished_cb), w);
+
+    /* uses the same main context as we do */
+    gst_discoverer_start (worker);
+
+    dc->priv->workers = g_list_append (dc->priv->workers, w);
+  }
+}
+
+static void
+workers_stop (GstDiscoverer * dc)
+{
+  GList *tmp;
+
+  for (tmp = dc->priv->workers; tmp; tmp = tmp->next) {
+    DiscovererWorker *w = (DiscovererWorker *) tmp->data;
+
+    DISCONNECT_SIGNAL (w->worker, w->discovered_id);
+    DISCONNECT_SIGNAL (w->worker, w->finished_id);
+    gst_discoverer_stop (w->worker);
+    g_object_unref (w->worker);
+    g_slice_free (DiscovererWorker, w);
+  }
+  g_list_free (dc->priv->workers);
+  dc->priv->workers = NULL;
+
+  g_list_foreach (dc->priv->results, (GFunc) discoverer_result_free, NULL);
+  g_list_free (dc->priv->results);
+  dc->priv->results = NULL;
+}
 
 /**
  * gst_discoverer_start:
@@ -1440,7 +2362,15 @@ gst_discoverer_start (GstDiscoverer * discoverer)
   g_source_unref (source);
   discoverer->priv->ctx = g_main_context_ref (ctx);
 
-  start_discovering (discoverer);
+  if (discoverer->priv->max_parallel > 1) {
+    workers_start (discoverer, discoverer->priv->max_parallel);
+    if (discoverer->priv->pending_uris) {
+      g_signal_emit (discoverer, gst_discoverer_signals[SIGNAL_STARTING], 0);
+      workers_dispatch (discoverer);
+    }
+  } else {
+    start_discovering (discoverer);
+  }
   GST_DEBUG_OBJECT (discoverer, "Started");
 }
 
@@ -1478,6 +2408,8 @@ gst_discoverer_stop (GstDiscoverer * discoverer)
   discoverer->priv->running = FALSE;
   DISCO_UNLOCK (discoverer);
 
+  workers_stop (discoverer);
+
   /* Remove timeout handler */
   if (discoverer->priv->timeoutid) {
     g_source_remove (discoverer->priv->timeoutid);
@@ -1521,17 +2453,27 @@ gboolean
 gst_discoverer_discover_uri_async (GstDiscoverer * discoverer,
     const gchar * uri)
 {
-  gboolean can_run;
+  gboolean can_run, pool, idle = TRUE;
+  GList *tmp;
 
   GST_DEBUG_OBJECT (discoverer, "uri : %s", uri);
 
   DISCO_LOCK (discoverer);
   can_run = (discoverer->priv->pending_uris == NULL);
+  pool = (discoverer->priv->workers != NULL);
+  if (pool) {
+    for (tmp = discoverer->priv->workers; tmp && idle; tmp = tmp->next)
+      idle = !((DiscovererWorker *) tmp->data)->busy;
+  }
   discoverer->priv->pending_uris =
       g_list_append (discoverer->priv->pending_uris, g_strdup (uri));
   DISCO_UNLOCK (discoverer);
 
-  if (can_run)
+  if (pool) {
+    if (can_run && idle)
+      g_signal_emit (discoverer, gst_discoverer_signals[SIGNAL_STARTING], 0);
+    workers_dispatch (discoverer);
+  } else if (can_run)
     start_discovering (discoverer);
 
   return TRUE;
@@ -1561,6 +2503,7 @@ gst_discoverer_discover_uri (GstDiscoverer * discoverer, const gchar * uri,
 {
   GstDiscovererResult res = 0;
   GstDiscovererInfo *info;
+  DiscovererCache *cache;
 
   GST_DEBUG_OBJECT (discoverer, "uri:%s", uri);
 
@@ -1571,6 +2514,20 @@ gst_discoverer_discover_uri (GstDiscoverer * discoverer, const gchar * uri,
     return NULL;
   }
 
+  cache = discoverer_get_cache_locked (discoverer);
+  if (cache) {
+    cache = discoverer_cache_ref (cache);
+    DISCO_UNLOCK (discoverer);
+    info = discoverer_cache_lookup (cache, uri);
+    discoverer_cache_unref (cache);
+    if (info) {
+      if (err)
+        *err = NULL;
+      return info;
+    }
+    DISCO_LOCK (discoverer);
+  }
+
   discoverer->priv->pending_uris =
       g_list_append (discoverer->priv->pending_uris, g_strdup (uri));
   DISCO_UNLOCK (discoverer);
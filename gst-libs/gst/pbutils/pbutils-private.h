@@ -92,3 +92,8 @@ struct _GstDiscovererInfo {
 /* missing-plugins.c */
 
 GstCaps *copy_and_clean_caps (const GstCaps * caps);
+
+/* gstdiscoverer-types.c */
+
+void discoverer_info_to_key_file (GstDiscovererInfo * info, GKeyFile * kf);
+GstDiscovererInfo *discoverer_info_from_key_file (GKeyFile * kf);
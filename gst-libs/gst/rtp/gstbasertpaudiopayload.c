@@ -538,6 +538,57 @@ gst_base_rtp_audio_payload_push_buffer (GstBaseRTPAudioPayload *
   return ret;
 }
 
+/* calculate the timestamp of the first byte in the adapter */
+static GstClockTime
+gst_base_rtp_audio_payload_adapter_timestamp (GstBaseRTPAudioPayload *
+    baseaudiopayload)
+{
+  GstClockTime timestamp;
+  guint64 distance;
+
+  timestamp = gst_adapter_prev_timestamp (baseaudiopayload->priv->adapter,
+      &distance);
+
+  GST_LOG_OBJECT (baseaudiopayload,
+      "last timestamp %" GST_TIME_FORMAT ", distance %" G_GUINT64_FORMAT,
+      GST_TIME_ARGS (timestamp), distance);
+
+  if (GST_CLOCK_TIME_IS_VALID (timestamp) && distance > 0) {
+    /* convert the number of bytes since the last timestamp to time and add to
+     * the last seen timestamp */
+    timestamp += baseaudiopayload->priv->bytes_to_time (baseaudiopayload,
+        distance);
+  }
+  return timestamp;
+}
+
+/* take @payload_len bytes out of the adapter and add them to the group
+ * of @it as an RTP header and a payload buffer. The payload is a subbuffer of
+ * the input when it does not span input buffers. */
+static void
+gst_base_rtp_audio_payload_take_to_list (GstBaseRTPAudioPayload *
+    baseaudiopayload, GstBufferListIterator * it, guint payload_len)
+{
+  GstBuffer *outbuf, *buffer;
+  GstClockTime timestamp;
+
+  timestamp = gst_base_rtp_audio_payload_adapter_timestamp (baseaudiopayload);
+  buffer = gst_adapter_take_buffer (baseaudiopayload->priv->adapter,
+      payload_len);
+
+  GST_DEBUG_OBJECT (baseaudiopayload, "Adding %d bytes ts %" GST_TIME_FORMAT,
+      payload_len, GST_TIME_ARGS (timestamp));
+
+  /* create just the RTP header buffer */
+  outbuf = gst_rtp_buffer_new_allocate (0, 0, 0);
+  gst_base_rtp_audio_payload_set_meta (baseaudiopayload, outbuf, payload_len,
+      timestamp);
+
+  gst_buffer_list_iterator_add_group (it);
+  gst_buffer_list_iterator_add (it, outbuf);
+  gst_buffer_list_iterator_add (it, buffer);
+}
+
 /**
  * gst_base_rtp_audio_payload_flush:
  * @baseaudiopayload: a #GstBaseRTPPayload
@@ -565,7 +616,6 @@ gst_base_rtp_audio_payload_flush (GstBaseRTPAudioPayload * baseaudiopayload,
   guint8 *payload;
   GstFlowReturn ret;
   GstAdapter *adapter;
-  guint64 distance;
 
   priv = baseaudiopayload->priv;
   adapter = priv->adapter;
@@ -579,20 +629,8 @@ gst_base_rtp_audio_payload_flush (GstBaseRTPAudioPayload * baseaudiopayload,
   if (payload_len == 0)
     return GST_FLOW_OK;
 
-  if (timestamp == -1) {
-    /* calculate the timestamp */
-    timestamp = gst_adapter_prev_timestamp (adapter, &distance);
-
-    GST_LOG_OBJECT (baseaudiopayload,
-        "last timestamp %" GST_TIME_FORMAT ", distance %" G_GUINT64_FORMAT,
-        GST_TIME_ARGS (timestamp), distance);
-
-    if (GST_CLOCK_TIME_IS_VALID (timestamp) && distance > 0) {
-      /* convert the number of bytes since the last timestamp to time and add to
-       * the last seen timestamp */
-      timestamp += priv->bytes_to_time (baseaudiopayload, distance);
-    }
-  }
+  if (timestamp == -1)
+    timestamp = gst_base_rtp_audio_payload_adapter_timestamp (baseaudiopayload);
 
   GST_DEBUG_OBJECT (baseaudiopayload, "Pushing %d bytes ts %" GST_TIME_FORMAT,
       payload_len, GST_TIME_ARGS (timestamp));
@@ -883,6 +921,30 @@ gst_base_rtp_audio_payload_handle_buffer (GstBaseRTPPayload *
 
     GST_DEBUG_OBJECT (payload, "available now %u", available);
 
+    if (priv->buffer_list && available >= min_payload_len) {
+      GstBufferList *list;
+      GstBufferListIterator *it;
+
+      /* put all packets in one list, so that they are pushed with one call
+       * and the payloads are subbuffers of the input where possible */
+      list = gst_buffer_list_new ();
+      it = gst_buffer_list_iterate (list);
+
+      while (available >= min_payload_len) {
+        payload_len = MIN (max_payload_len, available);
+        payload_len = ALIGN_DOWN (payload_len, align);
+
+        gst_base_rtp_audio_payload_take_to_list (payload, it, payload_len);
+
+        available -= payload_len;
+      }
+      gst_buffer_list_iterator_free (it);
+
+      GST_DEBUG_OBJECT (payload, "Pushing list %p, available after push %u",
+          list, available);
+      ret = gst_basertppayload_push_list (basepayload, list);
+    }
+
     /* as long as we have full frames */
     while (available >= min_payload_len) {
       /* get multiple of alignment */
@@ -42,6 +42,10 @@ GST_DEBUG_CATEGORY_STATIC (basertpdepayload_debug);
 #define GST_BASE_RTP_DEPAYLOAD_GET_PRIVATE(obj)  \
    (G_TYPE_INSTANCE_GET_PRIVATE ((obj), GST_TYPE_BASE_RTP_DEPAYLOAD, GstBaseRTPDepayloadPrivate))
 
+/* packets of the reorder window are kept in a ring indexed by seqnum */
+#define REORDER_RING_SIZE 64
+#define REORDER_SLOT(seqnum) ((seqnum) & (REORDER_RING_SIZE - 1))
+
 struct _GstBaseRTPDepayloadPrivate
 {
   GstClockTime npt_start;
@@ -56,6 +60,13 @@ struct _GstBaseRTPDepayloadPrivate
   guint32 next_seqnum;
 
   gboolean negotiated;
+
+  /* reorder window */
+  guint reorder_window;
+  GstClockTime reorder_time;
+  GstBuffer *reorder_ring[REORDER_RING_SIZE];
+  guint reorder_held;
+  guint32 reorder_next;
 };
 
 /* Filter signals and args */
@@ -66,11 +77,15 @@ enum
 };
 
 #define DEFAULT_QUEUE_DELAY	0
+#define DEFAULT_REORDER_WINDOW	0
+#define DEFAULT_REORDER_TIME	20
 
 enum
 {
   PROP_0,
   PROP_QUEUE_DELAY,
+  PROP_REORDER_WINDOW,
+  PROP_REORDER_TIME,
   PROP_LAST
 };
 
@@ -96,6 +111,11 @@ static gboolean gst_base_rtp_depayload_packet_lost (GstBaseRTPDepayload *
 static gboolean gst_base_rtp_depayload_handle_event (GstBaseRTPDepayload *
     filter, GstEvent * event);
 
+static GstFlowReturn gst_base_rtp_depayload_reorder_flush (GstBaseRTPDepayload
+    * filter, guint count, gboolean stop_at_gap);
+static void gst_base_rtp_depayload_reorder_clear (GstBaseRTPDepayload *
+    filter);
+
 GST_BOILERPLATE (GstBaseRTPDepayload, gst_base_rtp_depayload, GstElement,
     GST_TYPE_ELEMENT);
 
@@ -136,6 +156,41 @@ gst_base_rtp_depayload_class_init (GstBaseRTPDepayloadClass * klass)
           DEFAULT_QUEUE_DELAY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 #endif
 
+  /**
+   * GstBaseRTPDepayload:reorder-window
+   *
+   * Maximum distance in packets over which out of order packets are put back
+   * in order before they are depayloaded. 0 disables reordering. This is
+   * meant for setups without a jitterbuffer, packets are only held until the
+   * missing packets arrive, the window is exceeded or #reorder-time expires.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_REORDER_WINDOW,
+      g_param_spec_uint ("reorder-window", "Reorder Window",
+          "Maximum number of packets to reorder (0 = disabled)", 0,
+          REORDER_RING_SIZE - 1, DEFAULT_REORDER_WINDOW,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstBaseRTPDepayload:reorder-time
+   *
+   * Maximum time in milliseconds that a packet is held to wait for missing
+   * packets before it, measured with the timestamps of the incoming packets.
+   * 0 waits for the window to fill up.
+   *
+   * The time is only checked when a packet arrives, there is no timer. When
+   * the stream stalls, held packets stay until the next packet or EOS pushes
+   * them out, or a flush drops them.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_REORDER_TIME,
+      g_param_spec_uint ("reorder-time", "Reorder Time",
+          "Maximum time in ms to hold a packet for reordering (0 = unlimited)",
+          0, G_MAXUINT, DEFAULT_REORDER_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state = gst_base_rtp_depayload_change_state;
 
   klass->set_gst_timestamp = gst_base_rtp_depayload_set_gst_timestamp;
@@ -179,6 +234,10 @@ gst_base_rtp_depayload_init (GstBaseRTPDepayload * filter,
   filter->queue = g_queue_new ();
   filter->queue_delay = DEFAULT_QUEUE_DELAY;
 
+  priv->reorder_window = DEFAULT_REORDER_WINDOW;
+  priv->reorder_time = DEFAULT_REORDER_TIME * GST_MSECOND;
+  priv->reorder_next = -1;
+
   gst_segment_init (&filter->segment, GST_FORMAT_UNDEFINED);
 }
 
@@ -187,6 +246,7 @@ gst_base_rtp_depayload_finalize (GObject * object)
 {
   GstBaseRTPDepayload *filter = GST_BASE_RTP_DEPAYLOAD (object);
 
+  gst_base_rtp_depayload_reorder_clear (filter);
   g_queue_free (filter->queue);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
@@ -256,10 +316,10 @@ gst_base_rtp_depayload_setcaps (GstPad * pad, GstCaps * caps)
   return res;
 }
 
+/* depayload a packet, @in is a valid RTP packet */
 static GstFlowReturn
-gst_base_rtp_depayload_chain (GstPad * pad, GstBuffer * in)
+gst_base_rtp_depayload_process (GstBaseRTPDepayload * filter, GstBuffer * in)
 {
-  GstBaseRTPDepayload *filter;
   GstBaseRTPDepayloadPrivate *priv;
   GstBaseRTPDepayloadClass *bclass;
   GstFlowReturn ret = GST_FLOW_OK;
@@ -270,18 +330,8 @@ gst_base_rtp_depayload_chain (GstPad * pad, GstBuffer * in)
   gboolean discont;
   gint gap;
 
-  filter = GST_BASE_RTP_DEPAYLOAD (GST_OBJECT_PARENT (pad));
   priv = filter->priv;
 
-  /* we must have a setcaps first */
-  if (G_UNLIKELY (!priv->negotiated))
-    goto not_negotiated;
-
-  /* we must validate, it's possible that this element is plugged right after a
-   * network receiver and we don't want to operate on invalid data */
-  if (G_UNLIKELY (!gst_rtp_buffer_validate (in)))
-    goto invalid_buffer;
-
   if (!priv->discont)
     priv->discont = GST_BUFFER_IS_DISCONT (in);
 
@@ -357,6 +407,190 @@ gst_base_rtp_depayload_chain (GstPad * pad, GstBuffer * in)
 
   return ret;
 
+  /* ERRORS */
+dropping:
+  {
+    GST_WARNING_OBJECT (filter, "%d <= 100, dropping old packet", gap);
+    gst_buffer_unref (in);
+    return GST_FLOW_OK;
+  }
+no_process:
+  {
+    /* this is not fatal but should be filtered earlier */
+    GST_ELEMENT_ERROR (filter, STREAM, NOT_IMPLEMENTED, (NULL),
+        ("The subclass does not have a process method"));
+    gst_buffer_unref (in);
+    return GST_FLOW_ERROR;
+  }
+}
+
+/* process the packets in the reorder window in seqnum order, starting with
+ * the one we wait for. Missing packets are skipped unless @stop_at_gap is
+ * set. At most @count positions are processed. */
+static GstFlowReturn
+gst_base_rtp_depayload_reorder_flush (GstBaseRTPDepayload * filter,
+    guint count, gboolean stop_at_gap)
+{
+  GstBaseRTPDepayloadPrivate *priv = filter->priv;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  while (priv->reorder_held > 0 && count-- > 0) {
+    guint slot = REORDER_SLOT (priv->reorder_next);
+    GstBuffer *buf = priv->reorder_ring[slot];
+
+    if (buf == NULL && stop_at_gap)
+      break;
+
+    priv->reorder_next = (priv->reorder_next + 1) & 0xffff;
+    if (buf) {
+      GstFlowReturn res;
+
+      priv->reorder_ring[slot] = NULL;
+      priv->reorder_held--;
+
+      res = gst_base_rtp_depayload_process (filter, buf);
+      if (ret == GST_FLOW_OK)
+        ret = res;
+    }
+  }
+  return ret;
+}
+
+static void
+gst_base_rtp_depayload_reorder_clear (GstBaseRTPDepayload * filter)
+{
+  GstBaseRTPDepayloadPrivate *priv = filter->priv;
+  guint i;
+
+  for (i = 0; i < REORDER_RING_SIZE; i++) {
+    if (priv->reorder_ring[i]) {
+      gst_buffer_unref (priv->reorder_ring[i]);
+      priv->reorder_ring[i] = NULL;
+    }
+  }
+  priv->reorder_held = 0;
+  priv->reorder_next = -1;
+}
+
+/* put @in in the reorder window and process the packets that are in order
+ * now. Packets are held until the missing packets before them arrive, they
+ * are more than @window packets behind the newest packet or they were held
+ * longer than @max_time. */
+static GstFlowReturn
+gst_base_rtp_depayload_reorder (GstBaseRTPDepayload * filter, GstBuffer * in,
+    guint window, GstClockTime max_time)
+{
+  GstBaseRTPDepayloadPrivate *priv = filter->priv;
+  GstFlowReturn ret = GST_FLOW_OK, res;
+  GstClockTime timestamp;
+  guint16 seqnum;
+  gint gap;
+  guint slot;
+
+  seqnum = gst_rtp_buffer_get_seq (in);
+  timestamp = GST_BUFFER_TIMESTAMP (in);
+
+  if (G_UNLIKELY (priv->reorder_next == -1 || GST_BUFFER_IS_DISCONT (in))) {
+    /* nothing to compare with or a restart, release what we have */
+    ret = gst_base_rtp_depayload_reorder_flush (filter, REORDER_RING_SIZE,
+        FALSE);
+    priv->reorder_next = seqnum;
+  }
+
+  gap = gst_rtp_buffer_compare_seqnum (priv->reorder_next, seqnum);
+  if (G_UNLIKELY (gap < 0)) {
+    /* older than the packet we wait for, the normal seqnum checks will
+     * drop it or mark a discont */
+    GST_LOG_OBJECT (filter, "packet %u before window at %u", seqnum,
+        priv->reorder_next);
+    res = gst_base_rtp_depayload_process (filter, in);
+    return ret == GST_FLOW_OK ? res : ret;
+  }
+
+  if (G_UNLIKELY (gap >= window)) {
+    /* too far ahead, give up on the missing packets until it fits */
+    GST_LOG_OBJECT (filter, "packet %u beyond window at %u, skipping", seqnum,
+        priv->reorder_next);
+    res = gst_base_rtp_depayload_reorder_flush (filter, gap - window + 1,
+        FALSE);
+    if (ret == GST_FLOW_OK)
+      ret = res;
+    priv->reorder_next = (seqnum - window + 1) & 0xffff;
+  }
+
+  slot = REORDER_SLOT (seqnum);
+  if (G_UNLIKELY (priv->reorder_ring[slot] != NULL)) {
+    GST_LOG_OBJECT (filter, "dropping duplicate packet %u", seqnum);
+    gst_buffer_unref (in);
+  } else {
+    priv->reorder_ring[slot] = in;
+    priv->reorder_held++;
+  }
+
+  /* process everything that is in order now */
+  res = gst_base_rtp_depayload_reorder_flush (filter, REORDER_RING_SIZE, TRUE);
+  if (ret == GST_FLOW_OK)
+    ret = res;
+
+  /* stop waiting for missing packets when the oldest held packet is too old */
+  while (priv->reorder_held > 0 && max_time != 0 &&
+      GST_CLOCK_TIME_IS_VALID (timestamp)) {
+    GstBuffer *oldest = NULL;
+    guint i;
+
+    for (i = 1; i < REORDER_RING_SIZE && oldest == NULL; i++)
+      oldest = priv->reorder_ring[REORDER_SLOT (priv->reorder_next + i)];
+
+    if (oldest == NULL || !GST_BUFFER_TIMESTAMP_IS_VALID (oldest) ||
+        timestamp < GST_BUFFER_TIMESTAMP (oldest) + max_time)
+      break;
+
+    GST_LOG_OBJECT (filter, "held packet %u too long, skipping missing",
+        gst_rtp_buffer_get_seq (oldest));
+    priv->reorder_next = gst_rtp_buffer_get_seq (oldest);
+    res = gst_base_rtp_depayload_reorder_flush (filter, REORDER_RING_SIZE,
+        TRUE);
+    if (ret == GST_FLOW_OK)
+      ret = res;
+  }
+  return ret;
+}
+
+static GstFlowReturn
+gst_base_rtp_depayload_chain (GstPad * pad, GstBuffer * in)
+{
+  GstBaseRTPDepayload *filter;
+  GstBaseRTPDepayloadPrivate *priv;
+  GstClockTime max_time;
+  guint window;
+
+  filter = GST_BASE_RTP_DEPAYLOAD (GST_OBJECT_PARENT (pad));
+  priv = filter->priv;
+
+  /* we must have a setcaps first */
+  if (G_UNLIKELY (!priv->negotiated))
+    goto not_negotiated;
+
+  /* we must validate, it's possible that this element is plugged right after a
+   * network receiver and we don't want to operate on invalid data */
+  if (G_UNLIKELY (!gst_rtp_buffer_validate (in)))
+    goto invalid_buffer;
+
+  GST_OBJECT_LOCK (filter);
+  window = priv->reorder_window;
+  max_time = priv->reorder_time;
+  GST_OBJECT_UNLOCK (filter);
+
+  if (window > 0)
+    return gst_base_rtp_depayload_reorder (filter, in, window, max_time);
+
+  /* reordering was disabled, release what is still held first */
+  if (G_UNLIKELY (priv->reorder_held > 0))
+    gst_base_rtp_depayload_reorder_flush (filter, REORDER_RING_SIZE, FALSE);
+  priv->reorder_next = -1;
+
+  return gst_base_rtp_depayload_process (filter, in);
+
   /* ERRORS */
 not_negotiated:
   {
@@ -388,20 +622,6 @@ invalid_buffer:
     gst_buffer_unref (in);
     return GST_FLOW_OK;
   }
-dropping:
-  {
-    GST_WARNING_OBJECT (filter, "%d <= 100, dropping old packet", gap);
-    gst_buffer_unref (in);
-    return GST_FLOW_OK;
-  }
-no_process:
-  {
-    /* this is not fatal but should be filtered earlier */
-    GST_ELEMENT_ERROR (filter, STREAM, NOT_IMPLEMENTED, (NULL),
-        ("The subclass does not have a process method"));
-    gst_buffer_unref (in);
-    return GST_FLOW_ERROR;
-  }
 }
 
 static gboolean
@@ -483,6 +703,18 @@ gst_base_rtp_depayload_handle_sink_event (GstPad * pad, GstEvent * event)
     return FALSE;
   }
 
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_EOS:
+      /* push out the packets that are still waiting for reordering */
+      gst_base_rtp_depayload_reorder_flush (filter, REORDER_RING_SIZE, FALSE);
+      break;
+    case GST_EVENT_FLUSH_STOP:
+      gst_base_rtp_depayload_reorder_clear (filter);
+      break;
+    default:
+      break;
+  }
+
   bclass = GST_BASE_RTP_DEPAYLOAD_GET_CLASS (filter);
   if (bclass->handle_event)
     res = bclass->handle_event (filter, event);
@@ -756,6 +988,7 @@ gst_base_rtp_depayload_change_state (GstElement * element,
     case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
+      gst_base_rtp_depayload_reorder_clear (filter);
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
       break;
@@ -777,6 +1010,16 @@ gst_base_rtp_depayload_set_property (GObject * object, guint prop_id,
     case PROP_QUEUE_DELAY:
       filter->queue_delay = g_value_get_uint (value);
       break;
+    case PROP_REORDER_WINDOW:
+      GST_OBJECT_LOCK (filter);
+      filter->priv->reorder_window = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (filter);
+      break;
+    case PROP_REORDER_TIME:
+      GST_OBJECT_LOCK (filter);
+      filter->priv->reorder_time = g_value_get_uint (value) * GST_MSECOND;
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -795,6 +1038,16 @@ gst_base_rtp_depayload_get_property (GObject * object, guint prop_id,
     case PROP_QUEUE_DELAY:
       g_value_set_uint (value, filter->queue_delay);
       break;
+    case PROP_REORDER_WINDOW:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_uint (value, filter->priv->reorder_window);
+      GST_OBJECT_UNLOCK (filter);
+      break;
+    case PROP_REORDER_TIME:
+      GST_OBJECT_LOCK (filter);
+      g_value_set_uint (value, filter->priv->reorder_time / GST_MSECOND);
+      GST_OBJECT_UNLOCK (filter);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
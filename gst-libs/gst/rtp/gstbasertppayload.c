@@ -731,9 +731,70 @@ find_timestamp (GstBuffer ** buffer, guint group, guint idx, HeaderData * data)
     return GST_BUFFER_LIST_CONTINUE;
 }
 
+/* convert @timestamp or @offset to an RTP timestamp, @prev_rtptime is used when
+ * neither is valid */
+static guint32
+gst_basertppayload_get_rtptime (GstBaseRTPPayload * payload,
+    GstClockTime timestamp, guint64 offset, guint32 prev_rtptime)
+{
+  GstBaseRTPPayloadPrivate *priv = payload->priv;
+  guint32 rtptime;
+
+  if (priv->perfect_rtptime && offset != GST_BUFFER_OFFSET_NONE &&
+      priv->base_offset != GST_BUFFER_OFFSET_NONE) {
+    /* if we have an offset, use that for making an RTP timestamp */
+    rtptime = payload->ts_base + priv->base_rtime + offset - priv->base_offset;
+    GST_LOG_OBJECT (payload,
+        "Using offset %" G_GUINT64_FORMAT " for RTP timestamp", offset);
+  } else if (GST_CLOCK_TIME_IS_VALID (timestamp)) {
+    gint64 rtime;
+
+    /* no offset, use the gstreamer timestamp */
+    rtime = gst_segment_to_running_time (&payload->segment, GST_FORMAT_TIME,
+        timestamp);
+
+    if (rtime == -1) {
+      GST_LOG_OBJECT (payload, "Clipped timestamp, using base RTP timestamp");
+      rtime = 0;
+    } else {
+      GST_LOG_OBJECT (payload,
+          "Using running_time %" GST_TIME_FORMAT " for RTP timestamp",
+          GST_TIME_ARGS (rtime));
+      rtime =
+          gst_util_uint64_scale_int (rtime, payload->clock_rate, GST_SECOND);
+      priv->base_offset = offset;
+      priv->base_rtime = rtime;
+    }
+    /* add running_time in clock-rate units to the base timestamp */
+    rtptime = payload->ts_base + rtime;
+  } else {
+    GST_LOG_OBJECT (payload,
+        "Using previous RTP timestamp %" G_GUINT32_FORMAT, prev_rtptime);
+    /* no timestamp to convert, take previous timestamp */
+    rtptime = prev_rtptime;
+  }
+
+  return rtptime;
+}
+
 static GstBufferListItem
 set_headers (GstBuffer ** buffer, guint group, guint idx, HeaderData * data)
 {
+  /* only groups that carry their own timing get their own RTP timestamp, all
+   * other groups share the RTP timestamp of the first timestamped buffer */
+  if (group > 0) {
+    GstClockTime timestamp = GST_BUFFER_TIMESTAMP (*buffer);
+    guint64 offset = GST_BUFFER_OFFSET (*buffer);
+
+    if ((GST_CLOCK_TIME_IS_VALID (timestamp) && timestamp != data->timestamp)
+        || (offset != GST_BUFFER_OFFSET_NONE && offset != data->offset)) {
+      data->rtptime = gst_basertppayload_get_rtptime (data->payload,
+          timestamp, offset, data->rtptime);
+      data->timestamp = timestamp;
+      data->offset = offset;
+    }
+  }
+
   gst_rtp_buffer_set_ssrc (*buffer, data->ssrc);
   gst_rtp_buffer_set_payload_type (*buffer, data->pt);
   gst_rtp_buffer_set_seq (*buffer, data->seqnum);
@@ -781,41 +842,8 @@ gst_basertppayload_prepare_push (GstBaseRTPPayload * payload,
     data.offset = GST_BUFFER_OFFSET (GST_BUFFER_CAST (obj));
   }
 
-  /* convert to RTP time */
-  if (priv->perfect_rtptime && data.offset != GST_BUFFER_OFFSET_NONE &&
-      priv->base_offset != GST_BUFFER_OFFSET_NONE) {
-    /* if we have an offset, use that for making an RTP timestamp */
-    data.rtptime = payload->ts_base + priv->base_rtime +
-        data.offset - priv->base_offset;
-    GST_LOG_OBJECT (payload,
-        "Using offset %" G_GUINT64_FORMAT " for RTP timestamp", data.offset);
-  } else if (GST_CLOCK_TIME_IS_VALID (data.timestamp)) {
-    gint64 rtime;
-
-    /* no offset, use the gstreamer timestamp */
-    rtime = gst_segment_to_running_time (&payload->segment, GST_FORMAT_TIME,
-        data.timestamp);
-
-    if (rtime == -1) {
-      GST_LOG_OBJECT (payload, "Clipped timestamp, using base RTP timestamp");
-      rtime = 0;
-    } else {
-      GST_LOG_OBJECT (payload,
-          "Using running_time %" GST_TIME_FORMAT " for RTP timestamp",
-          GST_TIME_ARGS (rtime));
-      rtime =
-          gst_util_uint64_scale_int (rtime, payload->clock_rate, GST_SECOND);
-      priv->base_offset = data.offset;
-      priv->base_rtime = rtime;
-    }
-    /* add running_time in clock-rate units to the base timestamp */
-    data.rtptime = payload->ts_base + rtime;
-  } else {
-    GST_LOG_OBJECT (payload,
-        "Using previous RTP timestamp %" G_GUINT32_FORMAT, payload->timestamp);
-    /* no timestamp to convert, take previous timestamp */
-    data.rtptime = payload->timestamp;
-  }
+  data.rtptime = gst_basertppayload_get_rtptime (payload, data.timestamp,
+      data.offset, payload->timestamp);
 
   /* set ssrc, payload type, seq number, caps and rtptime */
   if (is_list) {
@@ -39,6 +39,14 @@
  * into the RTCP buffer; you can move to the next packet with
  * gst_rtcp_packet_move_to_next().
  * </para>
+ * <para>
+ * When many small compound packets are parsed or generated, #GstRTCPReader and
+ * #GstRTCPWriter operate directly on memory owned by the caller. The reader
+ * validates the compound packet once in gst_rtcp_reader_init() and then steps
+ * through the packets without checking them again. The writer appends packets
+ * and finishes with gst_rtcp_writer_end(), which returns the final size, so no
+ * buffer of the maximum size has to be allocated and shrunk afterwards.
+ * </para>
  * </refsect2>
  *
  * Last reviewed on 2007-03-26 (0.10.13)
@@ -95,20 +103,12 @@ gst_rtcp_buffer_new_copy_data (gpointer data, guint len)
   return gst_rtcp_buffer_new_take_data (g_memdup (data, len), len);
 }
 
-/**
- * gst_rtcp_buffer_validate_data:
- * @data: the data to validate
- * @len: the length of @data to validate
- *
- * Check if the @data and @size point to the data of a valid RTCP (compound)
- * packet. 
- * Use this function to validate a packet before using the other functions in
- * this module.
- *
- * Returns: TRUE if the data points to a valid RTCP packet.
- */
-gboolean
-gst_rtcp_buffer_validate_data (guint8 * data, guint len)
+/* walk the compound packet in @data once, checking the same rules as
+ * gst_rtcp_buffer_validate_data(). When valid, @n_packets is set to the number
+ * of packets and @end to the offset where the trailing padding starts. */
+static gboolean
+validate_compound (const guint8 * data, guint len, guint * n_packets,
+    guint * end)
 {
   guint16 header_mask;
   guint header_len;
@@ -116,8 +116,7 @@ gst_rtcp_buffer_validate_data (guint8 * data, guint len)
   guint data_len;
   gboolean padding;
   guint8 pad_bytes;
-
-  g_return_val_if_fail (data != NULL, FALSE);
+  guint count;
 
   /* we need 4 bytes for the type and length */
   if (G_UNLIKELY (len < 4))
@@ -133,6 +132,7 @@ gst_rtcp_buffer_validate_data (guint8 * data, guint len)
 
   /* store len */
   data_len = len;
+  count = 0;
 
   while (TRUE) {
     /* get packet length */
@@ -143,6 +143,7 @@ gst_rtcp_buffer_validate_data (guint8 * data, guint len)
     /* move to next compount packet */
     data += header_len;
     data_len -= header_len;
+    count++;
 
     /* we are at the end now */
     if (data_len < 4)
@@ -167,6 +168,11 @@ gst_rtcp_buffer_validate_data (guint8 * data, guint len)
     if (data_len != pad_bytes)
       goto wrong_padding;
   }
+  if (n_packets)
+    *n_packets = count;
+  if (end)
+    *end = len - data_len;
+
   return TRUE;
 
   /* ERRORS */
@@ -193,6 +199,26 @@ wrong_padding:
   }
 }
 
+/**
+ * gst_rtcp_buffer_validate_data:
+ * @data: the data to validate
+ * @len: the length of @data to validate
+ *
+ * Check if the @data and @size point to the data of a valid RTCP (compound)
+ * packet. 
+ * Use this function to validate a packet before using the other functions in
+ * this module.
+ *
+ * Returns: TRUE if the data points to a valid RTCP packet.
+ */
+gboolean
+gst_rtcp_buffer_validate_data (guint8 * data, guint len)
+{
+  g_return_val_if_fail (data != NULL, FALSE);
+
+  return validate_compound (data, len, NULL, NULL);
+}
+
 /**
  * gst_rtcp_buffer_validate:
  * @buffer: the buffer to validate
@@ -739,6 +765,61 @@ gst_rtcp_packet_get_rb_count (GstRTCPPacket * packet)
   return packet->count;
 }
 
+/* parse the 24 bytes of the report block at @data */
+static void
+read_rb (const guint8 * data, guint32 * ssrc, guint8 * fractionlost,
+    gint32 * packetslost, guint32 * exthighestseq, guint32 * jitter,
+    guint32 * lsr, guint32 * dlsr)
+{
+  guint32 tmp;
+
+  if (ssrc)
+    *ssrc = GST_READ_UINT32_BE (data);
+  data += 4;
+  tmp = GST_READ_UINT32_BE (data);
+  if (fractionlost)
+    *fractionlost = (tmp >> 24);
+  if (packetslost) {
+    /* sign extend */
+    if (tmp & 0x00800000)
+      tmp |= 0xff000000;
+    else
+      tmp &= 0x00ffffff;
+    *packetslost = (gint32) tmp;
+  }
+  data += 4;
+  if (exthighestseq)
+    *exthighestseq = GST_READ_UINT32_BE (data);
+  data += 4;
+  if (jitter)
+    *jitter = GST_READ_UINT32_BE (data);
+  data += 4;
+  if (lsr)
+    *lsr = GST_READ_UINT32_BE (data);
+  data += 4;
+  if (dlsr)
+    *dlsr = GST_READ_UINT32_BE (data);
+}
+
+/* write a report block of 24 bytes at @data */
+static void
+write_rb (guint8 * data, guint32 ssrc, guint8 fractionlost,
+    gint32 packetslost, guint32 exthighestseq, guint32 jitter, guint32 lsr,
+    guint32 dlsr)
+{
+  GST_WRITE_UINT32_BE (data, ssrc);
+  data += 4;
+  GST_WRITE_UINT32_BE (data, (fractionlost << 24) | (packetslost & 0xffffff));
+  data += 4;
+  GST_WRITE_UINT32_BE (data, exthighestseq);
+  data += 4;
+  GST_WRITE_UINT32_BE (data, jitter);
+  data += 4;
+  GST_WRITE_UINT32_BE (data, lsr);
+  data += 4;
+  GST_WRITE_UINT32_BE (data, dlsr);
+}
+
 /**
  * gst_rtcp_packet_get_rb:
  * @packet: a valid SR or RR #GstRTCPPacket
@@ -760,7 +841,6 @@ gst_rtcp_packet_get_rb (GstRTCPPacket * packet, guint nth, guint32 * ssrc,
     guint32 * jitter, guint32 * lsr, guint32 * dlsr)
 {
   guint8 *data;
-  guint32 tmp;
 
   g_return_if_fail (packet != NULL);
   g_return_if_fail (packet->type == GST_RTCP_TYPE_RR ||
@@ -779,32 +859,8 @@ gst_rtcp_packet_get_rb (GstRTCPPacket * packet, guint nth, guint32 * ssrc,
   /* move to requested index */
   data += (nth * 24);
 
-  if (ssrc)
-    *ssrc = GST_READ_UINT32_BE (data);
-  data += 4;
-  tmp = GST_READ_UINT32_BE (data);
-  if (fractionlost)
-    *fractionlost = (tmp >> 24);
-  if (packetslost) {
-    /* sign extend */
-    if (tmp & 0x00800000)
-      tmp |= 0xff000000;
-    else
-      tmp &= 0x00ffffff;
-    *packetslost = (gint32) tmp;
-  }
-  data += 4;
-  if (exthighestseq)
-    *exthighestseq = GST_READ_UINT32_BE (data);
-  data += 4;
-  if (jitter)
-    *jitter = GST_READ_UINT32_BE (data);
-  data += 4;
-  if (lsr)
-    *lsr = GST_READ_UINT32_BE (data);
-  data += 4;
-  if (dlsr)
-    *dlsr = GST_READ_UINT32_BE (data);
+  read_rb (data, ssrc, fractionlost, packetslost, exthighestseq, jitter, lsr,
+      dlsr);
 }
 
 /**
@@ -865,19 +921,8 @@ gst_rtcp_packet_add_rb (GstRTCPPacket * packet, guint32 ssrc,
   data[packet->offset + 3] = (packet->length) & 0xff;
 
   /* move to new report block offset */
-  data += offset;
-
-  GST_WRITE_UINT32_BE (data, ssrc);
-  data += 4;
-  GST_WRITE_UINT32_BE (data, (fractionlost << 24) | (packetslost & 0xffffff));
-  data += 4;
-  GST_WRITE_UINT32_BE (data, exthighestseq);
-  data += 4;
-  GST_WRITE_UINT32_BE (data, jitter);
-  data += 4;
-  GST_WRITE_UINT32_BE (data, lsr);
-  data += 4;
-  GST_WRITE_UINT32_BE (data, dlsr);
+  write_rb (data + offset, ssrc, fractionlost, packetslost, exthighestseq,
+      jitter, lsr, dlsr);
 
   return TRUE;
 
@@ -2029,3 +2074,739 @@ gst_rtcp_packet_fb_get_fci (GstRTCPPacket * packet)
 
   return data + 12;
 }
+
+/**
+ * gst_rtcp_reader_init:
+ * @reader: a #GstRTCPReader
+ * @data: the data of a compound RTCP packet
+ * @size: the size of @data
+ *
+ * Initialize @reader to read the packets in @data. @data is validated with the
+ * same rules as gst_rtcp_buffer_validate_data() in a single pass, and the
+ * reader is positioned before the first packet. @data is not copied and must
+ * stay valid while @reader is used.
+ *
+ * Returns: %TRUE if @data contains a valid compound RTCP packet. When %FALSE
+ * is returned, gst_rtcp_reader_next() will not return any packet.
+ *
+ * Since: 0.10.37
+ */
+gboolean
+gst_rtcp_reader_init (GstRTCPReader * reader, const guint8 * data, guint size)
+{
+  g_return_val_if_fail (reader != NULL, FALSE);
+  g_return_val_if_fail (data != NULL || size == 0, FALSE);
+
+  reader->data = data;
+  reader->size = size;
+  reader->offset = G_MAXUINT;
+  reader->next = 0;
+
+  if (!validate_compound (data, size, &reader->n_packets, &reader->end)) {
+    reader->n_packets = 0;
+    reader->end = 0;
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/**
+ * gst_rtcp_reader_get_packet_count:
+ * @reader: a #GstRTCPReader
+ *
+ * Get the number of packets found when @reader was initialized.
+ *
+ * Returns: the number of RTCP packets in the data of @reader.
+ *
+ * Since: 0.10.37
+ */
+guint
+gst_rtcp_reader_get_packet_count (GstRTCPReader * reader)
+{
+  g_return_val_if_fail (reader != NULL, 0);
+
+  return reader->n_packets;
+}
+
+/**
+ * gst_rtcp_reader_next:
+ * @reader: a #GstRTCPReader
+ *
+ * Move @reader to the next packet. The first call after gst_rtcp_reader_init()
+ * or gst_rtcp_reader_rewind() moves to the first packet.
+ *
+ * Returns: %TRUE if @reader points to a packet after calling this function.
+ *
+ * Since: 0.10.37
+ */
+gboolean
+gst_rtcp_reader_next (GstRTCPReader * reader)
+{
+  const guint8 *data;
+
+  g_return_val_if_fail (reader != NULL, FALSE);
+
+  if (reader->next >= reader->end) {
+    reader->offset = G_MAXUINT;
+    return FALSE;
+  }
+
+  /* the lengths were checked in gst_rtcp_reader_init() */
+  reader->offset = reader->next;
+  data = reader->data + reader->offset;
+  reader->next += (((data[2] << 8) | data[3]) + 1) << 2;
+
+  return TRUE;
+}
+
+/**
+ * gst_rtcp_reader_rewind:
+ * @reader: a #GstRTCPReader
+ *
+ * Position @reader before the first packet again.
+ *
+ * Since: 0.10.37
+ */
+void
+gst_rtcp_reader_rewind (GstRTCPReader * reader)
+{
+  g_return_if_fail (reader != NULL);
+
+  reader->offset = G_MAXUINT;
+  reader->next = 0;
+}
+
+/**
+ * gst_rtcp_reader_get_type:
+ * @reader: a #GstRTCPReader pointing to a packet
+ *
+ * Get the packet type of the current packet of @reader.
+ *
+ * Returns: The packet type of the current packet.
+ *
+ * Since: 0.10.37
+ */
+GstRTCPType
+gst_rtcp_reader_get_type (GstRTCPReader * reader)
+{
+  g_return_val_if_fail (reader != NULL, GST_RTCP_TYPE_INVALID);
+  g_return_val_if_fail (reader->offset < reader->end, GST_RTCP_TYPE_INVALID);
+
+  return reader->data[reader->offset + 1];
+}
+
+/**
+ * gst_rtcp_reader_get_count:
+ * @reader: a #GstRTCPReader pointing to a packet
+ *
+ * Get the count field of the current packet of @reader.
+ *
+ * Returns: The count field of the current packet.
+ *
+ * Since: 0.10.37
+ */
+guint8
+gst_rtcp_reader_get_count (GstRTCPReader * reader)
+{
+  g_return_val_if_fail (reader != NULL, 0);
+  g_return_val_if_fail (reader->offset < reader->end, 0);
+
+  return reader->data[reader->offset] & 0x1f;
+}
+
+/**
+ * gst_rtcp_reader_get_length:
+ * @reader: a #GstRTCPReader pointing to a packet
+ *
+ * Get the length field of the current packet of @reader. This is the length of
+ * the packet in 32-bit words minus one.
+ *
+ * Returns: The length field of the current packet.
+ *
+ * Since: 0.10.37
+ */
+guint16
+gst_rtcp_reader_get_length (GstRTCPReader * reader)
+{
+  g_return_val_if_fail (reader != NULL, 0);
+  g_return_val_if_fail (reader->offset < reader->end, 0);
+
+  return GST_READ_UINT16_BE (reader->data + reader->offset + 2);
+}
+
+/**
+ * gst_rtcp_reader_get_payload:
+ * @reader: a #GstRTCPReader pointing to a packet
+ * @len: result location for the length of the payload
+ *
+ * Get the data of the current packet of @reader after the 4 byte header.
+ *
+ * Returns: a pointer into the data of @reader.
+ *
+ * Since: 0.10.37
+ */
+const guint8 *
+gst_rtcp_reader_get_payload (GstRTCPReader * reader, guint * len)
+{
+  const guint8 *data;
+
+  g_return_val_if_fail (reader != NULL, NULL);
+  g_return_val_if_fail (reader->offset < reader->end, NULL);
+
+  data = reader->data + reader->offset;
+  if (len)
+    *len = GST_READ_UINT16_BE (data + 2) << 2;
+
+  return data + 4;
+}
+
+/**
+ * gst_rtcp_reader_get_ssrc:
+ * @reader: a #GstRTCPReader pointing to a packet
+ *
+ * Get the first SSRC of the current packet of @reader. This is the sender SSRC
+ * of SR, RR, APP and feedback packets, the SSRC of the first item of an SDES
+ * packet and the first SSRC of a BYE packet.
+ *
+ * Returns: the first SSRC of the current packet or 0 when the packet is too
+ * small to contain one.
+ *
+ * Since: 0.10.37
+ */
+guint32
+gst_rtcp_reader_get_ssrc (GstRTCPReader * reader)
+{
+  const guint8 *data;
+
+  g_return_val_if_fail (reader != NULL, 0);
+  g_return_val_if_fail (reader->offset < reader->end, 0);
+
+  data = reader->data + reader->offset;
+  if (GST_READ_UINT16_BE (data + 2) < 1)
+    return 0;
+
+  return GST_READ_UINT32_BE (data + 4);
+}
+
+/**
+ * gst_rtcp_reader_get_sender_info:
+ * @reader: a #GstRTCPReader pointing to an SR packet
+ * @ssrc: result SSRC
+ * @ntptime: result NTP time
+ * @rtptime: result RTP time
+ * @packet_count: result packet count
+ * @octet_count: result octet count
+ *
+ * Parse the sender info of the current SR packet of @reader.
+ *
+ * Returns: %TRUE if the current packet is an SR packet that is large enough to
+ * hold the sender info.
+ *
+ * Since: 0.10.37
+ */
+gboolean
+gst_rtcp_reader_get_sender_info (GstRTCPReader * reader, guint32 * ssrc,
+    guint64 * ntptime, guint32 * rtptime, guint32 * packet_count,
+    guint32 * octet_count)
+{
+  const guint8 *data;
+
+  g_return_val_if_fail (reader != NULL, FALSE);
+  g_return_val_if_fail (reader->offset < reader->end, FALSE);
+
+  data = reader->data + reader->offset;
+  if (data[1] != GST_RTCP_TYPE_SR || GST_READ_UINT16_BE (data + 2) < 6)
+    return FALSE;
+
+  /* skip header */
+  data += 4;
+  if (ssrc)
+    *ssrc = GST_READ_UINT32_BE (data);
+  data += 4;
+  if (ntptime)
+    *ntptime = GST_READ_UINT64_BE (data);
+  data += 8;
+  if (rtptime)
+    *rtptime = GST_READ_UINT32_BE (data);
+  data += 4;
+  if (packet_count)
+    *packet_count = GST_READ_UINT32_BE (data);
+  data += 4;
+  if (octet_count)
+    *octet_count = GST_READ_UINT32_BE (data);
+
+  return TRUE;
+}
+
+/**
+ * gst_rtcp_reader_get_rb:
+ * @reader: a #GstRTCPReader pointing to an SR or RR packet
+ * @nth: the nth report block in the current packet
+ * @ssrc: result for data source being reported
+ * @fractionlost: result for fraction lost since last SR/RR
+ * @packetslost: result for the cumululative number of packets lost
+ * @exthighestseq: result for the extended last sequence number received
+ * @jitter: result for the interarrival jitter
+ * @lsr: result for the last SR packet from this source
+ * @dlsr: result for the delay since last SR packet
+ *
+ * Parse the values of the @nth report block in the current packet of @reader.
+ *
+ * Returns: %TRUE if the current packet is an SR or RR packet that contains
+ * report block @nth.
+ *
+ * Since: 0.10.37
+ */
+gboolean
+gst_rtcp_reader_get_rb (GstRTCPReader * reader, guint nth, guint32 * ssrc,
+    guint8 * fractionlost, gint32 * packetslost, guint32 * exthighestseq,
+    guint32 * jitter, guint32 * lsr, guint32 * dlsr)
+{
+  const guint8 *data;
+  guint offset, size;
+
+  g_return_val_if_fail (reader != NULL, FALSE);
+  g_return_val_if_fail (reader->offset < reader->end, FALSE);
+
+  data = reader->data + reader->offset;
+  if (data[1] == GST_RTCP_TYPE_RR)
+    offset = 8;
+  else if (data[1] == GST_RTCP_TYPE_SR)
+    offset = 28;
+  else
+    return FALSE;
+
+  if (nth >= (data[0] & 0x1f))
+    return FALSE;
+
+  offset += nth * 24;
+  size = (GST_READ_UINT16_BE (data + 2) + 1) << 2;
+  if (offset + 24 > size)
+    return FALSE;
+
+  read_rb (data + offset, ssrc, fractionlost, packetslost, exthighestseq,
+      jitter, lsr, dlsr);
+
+  return TRUE;
+}
+
+/* pad the open SDES item of @writer with a null octet and zeros up to the
+ * next 32-bit word. The space was reserved when the item or entry was added. */
+static void
+writer_close_item (GstRTCPWriter * writer)
+{
+  guint padded;
+
+  if (writer->item == G_MAXUINT)
+    return;
+
+  padded = (writer->offset + 1 + 3) & ~3;
+  memset (writer->data + writer->offset, 0, padded - writer->offset);
+  writer->offset = padded;
+  writer->item = G_MAXUINT;
+}
+
+/* pad the open packet of @writer to a 32-bit word and write its length */
+static void
+writer_close_packet (GstRTCPWriter * writer)
+{
+  guint8 *data;
+  guint padded, len;
+
+  if (writer->packet == G_MAXUINT)
+    return;
+
+  writer_close_item (writer);
+
+  padded = (writer->offset + 3) & ~3;
+  memset (writer->data + writer->offset, 0, padded - writer->offset);
+  writer->offset = padded;
+
+  data = writer->data + writer->packet;
+  len = ((writer->offset - writer->packet) >> 2) - 1;
+  data[2] = len >> 8;
+  data[3] = len & 0xff;
+
+  writer->packet = G_MAXUINT;
+}
+
+/* close the open packet and start a new one with @len bytes of fixed fields
+ * after the header. The fixed fields are left to the caller. */
+static guint8 *
+writer_begin (GstRTCPWriter * writer, GstRTCPType type, guint8 count, guint len)
+{
+  guint8 *data;
+
+  writer_close_packet (writer);
+
+  if (writer->offset + 4 + len > writer->size)
+    return NULL;
+
+  data = writer->data + writer->offset;
+  data[0] = (GST_RTCP_VERSION << 6) | count;
+  data[1] = type;
+  data[2] = 0;
+  data[3] = 0;
+
+  writer->packet = writer->offset;
+  writer->type = type;
+  writer->offset += 4 + len;
+
+  return data + 4;
+}
+
+/* add one to the count field of the open packet when below the maximum */
+static gboolean
+writer_inc_count (GstRTCPWriter * writer)
+{
+  guint8 *data = writer->data + writer->packet;
+
+  if ((data[0] & 0x1f) >= 31)
+    return FALSE;
+
+  data[0]++;
+  return TRUE;
+}
+
+/**
+ * gst_rtcp_writer_init:
+ * @writer: a #GstRTCPWriter
+ * @data: memory for the compound RTCP packet
+ * @size: the size of @data
+ *
+ * Initialize @writer to build a compound RTCP packet in @data. No packet is
+ * written beyond @size bytes. @data must stay valid while @writer is used.
+ *
+ * Since: 0.10.37
+ */
+void
+gst_rtcp_writer_init (GstRTCPWriter * writer, guint8 * data, guint size)
+{
+  g_return_if_fail (writer != NULL);
+  g_return_if_fail (data != NULL || size == 0);
+
+  writer->data = data;
+  writer->size = size;
+  writer->offset = 0;
+  writer->packet = G_MAXUINT;
+  writer->item = G_MAXUINT;
+  writer->type = GST_RTCP_TYPE_INVALID;
+}
+
+/**
+ * gst_rtcp_writer_begin_packet:
+ * @writer: a #GstRTCPWriter
+ * @type: the #GstRTCPType of the new packet
+ * @count: the count field of the new packet
+ *
+ * Finish the current packet of @writer and start a new packet of @type with
+ * an empty body. The body can be filled with gst_rtcp_writer_put_data() or
+ * one of the type specific functions.
+ *
+ * Returns: %TRUE if the packet header fits in the memory of @writer.
+ *
+ * Since: 0.10.37
+ */
+gboolean
+gst_rtcp_writer_begin_packet (GstRTCPWriter * writer, GstRTCPType type,
+    guint8 count)
+{
+  g_return_val_if_fail (writer != NULL, FALSE);
+  g_return_val_if_fail (type != GST_RTCP_TYPE_INVALID, FALSE);
+  g_return_val_if_fail (count <= 31, FALSE);
+
+  return writer_begin (writer, type, count, 0) != NULL;
+}
+
+/**
+ * gst_rtcp_writer_put_data:
+ * @writer: a #GstRTCPWriter with an open packet
+ * @data: the data to append
+ * @len: the length of @data
+ *
+ * Append @len bytes of @data to the body of the current packet of @writer. The
+ * packet is padded with zeros to a multiple of 32 bits when it is finished.
+ *
+ * Returns: %TRUE if the data and its padding fit in the memory of @writer.
+ *
+ * Since: 0.10.37
+ */
+gboolean
+gst_rtcp_writer_put_data (GstRTCPWriter * writer, const guint8 * data,
+    guint len)
+{
+  g_return_val_if_fail (writer != NULL, FALSE);
+  g_return_val_if_fail (writer->packet != G_MAXUINT, FALSE);
+  g_return_val_if_fail (writer->item == G_MAXUINT, FALSE);
+  g_return_val_if_fail (data != NULL || len == 0, FALSE);
+
+  if (((writer->offset + len + 3) & ~3) > writer->size)
+    return FALSE;
+
+  memcpy (writer->data + writer->offset, data, len);
+  writer->offset += len;
+
+  return TRUE;
+}
+
+/**
+ * gst_rtcp_writer_add_sr:
+ * @writer: a #GstRTCPWriter
+ * @ssrc: the SSRC
+ * @ntptime: the NTP time
+ * @rtptime: the RTP time
+ * @packet_count: the packet count
+ * @octet_count: the octet count
+ *
+ * Finish the current packet of @writer and start an SR packet with the given
+ * sender info. Report blocks can be added with gst_rtcp_writer_add_rb().
+ *
+ * Returns: %TRUE if the packet fits in the memory of @writer.
+ *
+ * Since: 0.10.37
+ */
+gboolean
+gst_rtcp_writer_add_sr (GstRTCPWriter * writer, guint32 ssrc,
+    guint64 ntptime, guint32 rtptime, guint32 packet_count, guint32 octet_count)
+{
+  guint8 *data;
+
+  g_return_val_if_fail (writer != NULL, FALSE);
+
+  if (!(data = writer_begin (writer, GST_RTCP_TYPE_SR, 0, 24)))
+    return FALSE;
+
+  GST_WRITE_UINT32_BE (data, ssrc);
+  GST_WRITE_UINT64_BE (data + 4, ntptime);
+  GST_WRITE_UINT32_BE (data + 12, rtptime);
+  GST_WRITE_UINT32_BE (data + 16, packet_count);
+  GST_WRITE_UINT32_BE (data + 20, octet_count);
+
+  return TRUE;
+}
+
+/**
+ * gst_rtcp_writer_add_rr:
+ * @writer: a #GstRTCPWriter
+ * @ssrc: the SSRC of the sender of the report
+ *
+ * Finish the current packet of @writer and start an RR packet. Report blocks
+ * can be added with gst_rtcp_writer_add_rb().
+ *
+ * Returns: %TRUE if the packet fits in the memory of @writer.
+ *
+ * Since: 0.10.37
+ */
+gboolean
+gst_rtcp_writer_add_rr (GstRTCPWriter * writer, guint32 ssrc)
+{
+  guint8 *data;
+
+  g_return_val_if_fail (writer != NULL, FALSE);
+
+  if (!(data = writer_begin (writer, GST_RTCP_TYPE_RR, 0, 4)))
+    return FALSE;
+
+  GST_WRITE_UINT32_BE (data, ssrc);
+
+  return TRUE;
+}
+
+/**
+ * gst_rtcp_writer_add_rb:
+ * @writer: a #GstRTCPWriter with an open SR or RR packet
+ * @ssrc: data source being reported
+ * @fractionlost: fraction lost since last SR/RR
+ * @packetslost: the cumululative number of packets lost
+ * @exthighestseq: the extended last sequence number received
+ * @jitter: the interarrival jitter
+ * @lsr: the last SR packet from this source
+ * @dlsr: the delay since last SR packet
+ *
+ * Append a report block to the current SR or RR packet of @writer.
+ *
+ * Returns: %TRUE if the report block was added. This function returns %FALSE
+ * when the memory of @writer is full or the packet already has
+ * #GST_RTCP_MAX_RB_COUNT report blocks.
+ *
+ * Since: 0.10.37
+ */
+gboolean
+gst_rtcp_writer_add_rb (GstRTCPWriter * writer, guint32 ssrc,
+    guint8 fractionlost, gint32 packetslost, guint32 exthighestseq,
+    guint32 jitter, guint32 lsr, guint32 dlsr)
+{
+  g_return_val_if_fail (writer != NULL, FALSE);
+  g_return_val_if_fail (writer->packet != G_MAXUINT, FALSE);
+  g_return_val_if_fail (writer->type == GST_RTCP_TYPE_SR ||
+      writer->type == GST_RTCP_TYPE_RR, FALSE);
+
+  if (writer->offset + 24 > writer->size)
+    return FALSE;
+  if (!writer_inc_count (writer))
+    return FALSE;
+
+  write_rb (writer->data + writer->offset, ssrc, fractionlost, packetslost,
+      exthighestseq, jitter, lsr, dlsr);
+  writer->offset += 24;
+
+  return TRUE;
+}
+
+/**
+ * gst_rtcp_writer_add_sdes_item:
+ * @writer: a #GstRTCPWriter with an open SDES packet
+ * @ssrc: the SSRC of the new item
+ *
+ * Finish the current item of the SDES packet of @writer and start a new item
+ * for @ssrc. Entries can be added with gst_rtcp_writer_add_sdes_entry().
+ *
+ * Returns: %TRUE if the item was added. This function returns %FALSE when the
+ * memory of @writer is full or the packet already has
+ * #GST_RTCP_MAX_SDES_ITEM_COUNT items.
+ *
+ * Since: 0.10.37
+ */
+gboolean
+gst_rtcp_writer_add_sdes_item (GstRTCPWriter * writer, guint32 ssrc)
+{
+  g_return_val_if_fail (writer != NULL, FALSE);
+  g_return_val_if_fail (writer->packet != G_MAXUINT, FALSE);
+  g_return_val_if_fail (writer->type == GST_RTCP_TYPE_SDES, FALSE);
+
+  writer_close_item (writer);
+
+  /* we need the SSRC and a word for the terminating null octet */
+  if (writer->offset + 8 > writer->size)
+    return FALSE;
+  if (!writer_inc_count (writer))
+    return FALSE;
+
+  GST_WRITE_UINT32_BE (writer->data + writer->offset, ssrc);
+  writer->offset += 4;
+  writer->item = writer->offset;
+
+  return TRUE;
+}
+
+/**
+ * gst_rtcp_writer_add_sdes_entry:
+ * @writer: a #GstRTCPWriter with an open SDES item
+ * @type: the #GstRTCPSDESType of the SDES entry
+ * @len: the data length
+ * @data: the data
+ *
+ * Append an SDES entry to the current item of @writer.
+ *
+ * Returns: %TRUE if the entry fits in the memory of @writer.
+ *
+ * Since: 0.10.37
+ */
+gboolean
+gst_rtcp_writer_add_sdes_entry (GstRTCPWriter * writer, GstRTCPSDESType type,
+    guint8 len, const guint8 * data)
+{
+  guint8 *bdata;
+
+  g_return_val_if_fail (writer != NULL, FALSE);
+  g_return_val_if_fail (writer->item != G_MAXUINT, FALSE);
+  g_return_val_if_fail (data != NULL || len == 0, FALSE);
+
+  /* type, len, data and the null octet ending the item, padded */
+  if (((writer->offset + 2 + len + 1 + 3) & ~3) > writer->size)
+    return FALSE;
+
+  bdata = writer->data + writer->offset;
+  bdata[0] = type;
+  bdata[1] = len;
+  memcpy (bdata + 2, data, len);
+  writer->offset += 2 + len;
+
+  return TRUE;
+}
+
+/**
+ * gst_rtcp_writer_add_bye_ssrc:
+ * @writer: a #GstRTCPWriter with an open BYE packet
+ * @ssrc: the SSRC to add
+ *
+ * Append @ssrc to the current BYE packet of @writer.
+ *
+ * Returns: %TRUE if the SSRC was added. This function returns %FALSE when the
+ * memory of @writer is full or the packet already has
+ * #GST_RTCP_MAX_BYE_SSRC_COUNT SSRCs.
+ *
+ * Since: 0.10.37
+ */
+gboolean
+gst_rtcp_writer_add_bye_ssrc (GstRTCPWriter * writer, guint32 ssrc)
+{
+  g_return_val_if_fail (writer != NULL, FALSE);
+  g_return_val_if_fail (writer->packet != G_MAXUINT, FALSE);
+  g_return_val_if_fail (writer->type == GST_RTCP_TYPE_BYE, FALSE);
+
+  if (writer->offset + 4 > writer->size)
+    return FALSE;
+  if (!writer_inc_count (writer))
+    return FALSE;
+
+  GST_WRITE_UINT32_BE (writer->data + writer->offset, ssrc);
+  writer->offset += 4;
+
+  return TRUE;
+}
+
+/**
+ * gst_rtcp_writer_add_fb:
+ * @writer: a #GstRTCPWriter
+ * @type: %GST_RTCP_TYPE_RTPFB or %GST_RTCP_TYPE_PSFB
+ * @fbtype: the feedback message type
+ * @sender_ssrc: the sender SSRC
+ * @media_ssrc: the media SSRC
+ *
+ * Finish the current packet of @writer and start a feedback packet. The
+ * Feedback Control Information can be appended with gst_rtcp_writer_put_data().
+ *
+ * Returns: %TRUE if the packet fits in the memory of @writer.
+ *
+ * Since: 0.10.37
+ */
+gboolean
+gst_rtcp_writer_add_fb (GstRTCPWriter * writer, GstRTCPType type,
+    GstRTCPFBType fbtype, guint32 sender_ssrc, guint32 media_ssrc)
+{
+  guint8 *data;
+
+  g_return_val_if_fail (writer != NULL, FALSE);
+  g_return_val_if_fail (type == GST_RTCP_TYPE_RTPFB ||
+      type == GST_RTCP_TYPE_PSFB, FALSE);
+  g_return_val_if_fail (fbtype <= 31, FALSE);
+
+  if (!(data = writer_begin (writer, type, fbtype, 8)))
+    return FALSE;
+
+  GST_WRITE_UINT32_BE (data, sender_ssrc);
+  GST_WRITE_UINT32_BE (data + 4, media_ssrc);
+
+  return TRUE;
+}
+
+/**
+ * gst_rtcp_writer_end:
+ * @writer: a #GstRTCPWriter
+ *
+ * Finish the current packet of @writer.
+ *
+ * Returns: the size of the compound RTCP packet in the memory of @writer.
+ *
+ * Since: 0.10.37
+ */
+guint
+gst_rtcp_writer_end (GstRTCPWriter * writer)
+{
+  g_return_val_if_fail (writer != NULL, 0);
+
+  writer_close_packet (writer);
+
+  return writer->offset;
+}
@@ -197,6 +197,62 @@ struct _GstRTCPPacket
   guint        entry_offset; /* current entry offset for navigating SDES items */
 };
 
+typedef struct _GstRTCPReader GstRTCPReader;
+
+/**
+ * GstRTCPReader:
+ * @data: the compound RTCP packet being read
+ * @size: the size of @data
+ *
+ * A cursor over the packets of a compound RTCP packet in memory. It is
+ * initialized with gst_rtcp_reader_init(), which validates @data once so that
+ * moving to the next packet does not need to check it again.
+ * The size of the structure is made public to allow stack allocations.
+ *
+ * Since: 0.10.37
+ */
+struct _GstRTCPReader
+{
+  const guint8 *data;
+  guint         size;
+
+  /*< private >*/
+  guint         end;         /* end of the validated packets */
+  guint         n_packets;   /* number of validated packets */
+  guint         offset;      /* offset of the current packet */
+  guint         next;        /* offset of the next packet */
+
+  gpointer _gst_reserved[GST_PADDING];
+};
+
+typedef struct _GstRTCPWriter GstRTCPWriter;
+
+/**
+ * GstRTCPWriter:
+ * @data: the memory the compound RTCP packet is written to
+ * @size: the size of @data
+ *
+ * A cursor that appends RTCP packets to caller-provided memory. It is
+ * initialized with gst_rtcp_writer_init() and finished with
+ * gst_rtcp_writer_end(), which returns the size of the compound packet.
+ * The size of the structure is made public to allow stack allocations.
+ *
+ * Since: 0.10.37
+ */
+struct _GstRTCPWriter
+{
+  guint8       *data;
+  guint         size;
+
+  /*< private >*/
+  guint         offset;      /* end of the written data */
+  guint         packet;      /* offset of the open packet or G_MAXUINT */
+  guint         item;        /* offset of the open SDES item or G_MAXUINT */
+  guint8        type;        /* type of the open packet */
+
+  gpointer _gst_reserved[GST_PADDING];
+};
+
 /* creating buffers */
 GstBuffer*      gst_rtcp_buffer_new_take_data     (gpointer data, guint len);
 GstBuffer*      gst_rtcp_buffer_new_copy_data     (gpointer data, guint len);
@@ -288,6 +344,48 @@ guint16         gst_rtcp_packet_fb_get_fci_length     (GstRTCPPacket *packet);
 gboolean        gst_rtcp_packet_fb_set_fci_length     (GstRTCPPacket *packet, guint16 wordlen);
 guint8 *        gst_rtcp_packet_fb_get_fci            (GstRTCPPacket *packet);
 
+/* reading compound packets from memory */
+gboolean        gst_rtcp_reader_init                  (GstRTCPReader *reader, const guint8 *data,
+                                                       guint size);
+guint           gst_rtcp_reader_get_packet_count      (GstRTCPReader *reader);
+gboolean        gst_rtcp_reader_next                  (GstRTCPReader *reader);
+void            gst_rtcp_reader_rewind                (GstRTCPReader *reader);
+GstRTCPType     gst_rtcp_reader_get_type              (GstRTCPReader *reader);
+guint8          gst_rtcp_reader_get_count             (GstRTCPReader *reader);
+guint16         gst_rtcp_reader_get_length            (GstRTCPReader *reader);
+const guint8 *  gst_rtcp_reader_get_payload           (GstRTCPReader *reader, guint *len);
+guint32         gst_rtcp_reader_get_ssrc              (GstRTCPReader *reader);
+gboolean        gst_rtcp_reader_get_sender_info       (GstRTCPReader *reader, guint32 *ssrc,
+                                                       guint64 *ntptime, guint32 *rtptime,
+                                                       guint32 *packet_count, guint32 *octet_count);
+gboolean        gst_rtcp_reader_get_rb                (GstRTCPReader *reader, guint nth, guint32 *ssrc,
+                                                       guint8 *fractionlost, gint32 *packetslost,
+                                                       guint32 *exthighestseq, guint32 *jitter,
+                                                       guint32 *lsr, guint32 *dlsr);
+
+/* writing compound packets to memory */
+void            gst_rtcp_writer_init                  (GstRTCPWriter *writer, guint8 *data, guint size);
+gboolean        gst_rtcp_writer_begin_packet          (GstRTCPWriter *writer, GstRTCPType type,
+                                                       guint8 count);
+gboolean        gst_rtcp_writer_put_data              (GstRTCPWriter *writer, const guint8 *data,
+                                                       guint len);
+gboolean        gst_rtcp_writer_add_sr                (GstRTCPWriter *writer, guint32 ssrc,
+                                                       guint64 ntptime, guint32 rtptime,
+                                                       guint32 packet_count, guint32 octet_count);
+gboolean        gst_rtcp_writer_add_rr                (GstRTCPWriter *writer, guint32 ssrc);
+gboolean        gst_rtcp_writer_add_rb                (GstRTCPWriter *writer, guint32 ssrc,
+                                                       guint8 fractionlost, gint32 packetslost,
+                                                       guint32 exthighestseq, guint32 jitter,
+                                                       guint32 lsr, guint32 dlsr);
+gboolean        gst_rtcp_writer_add_sdes_item         (GstRTCPWriter *writer, guint32 ssrc);
+gboolean        gst_rtcp_writer_add_sdes_entry        (GstRTCPWriter *writer, GstRTCPSDESType type,
+                                                       guint8 len, const guint8 *data);
+gboolean        gst_rtcp_writer_add_bye_ssrc          (GstRTCPWriter *writer, guint32 ssrc);
+gboolean        gst_rtcp_writer_add_fb                (GstRTCPWriter *writer, GstRTCPType type,
+                                                       GstRTCPFBType fbtype, guint32 sender_ssrc,
+                                                       guint32 media_ssrc);
+guint           gst_rtcp_writer_end                   (GstRTCPWriter *writer);
+
 /* helper functions */
 guint64         gst_rtcp_ntp_to_unix                  (guint64 ntptime);
 guint64         gst_rtcp_unix_to_ntp                  (guint64 unixtime);
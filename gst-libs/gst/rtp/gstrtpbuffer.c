@@ -1283,6 +1283,152 @@ gst_rtp_buffer_list_get_payload_len (GstBufferList * list)
   return len;
 }
 
+/* the rewrite spec prepared for a pass over many headers. Offsets that are not
+ * selected are 0 and the payload type is merged in with a mask, so that every
+ * header is changed with the same few word operations. */
+typedef struct
+{
+  guint32 keep;                 /* bits of the first word that are kept */
+  guint32 set;                  /* bits or-ed into the first word */
+  guint16 seq_offset;
+  guint32 ts_offset;
+  const guint32 *ssrc_map;
+  guint n_ssrc;
+  guint last;                   /* last matched pair in ssrc_map */
+  guint count;
+} RewriteState;
+
+static void
+rewrite_state_init (RewriteState * state, const GstRTPRewrite * rewrite)
+{
+  state->keep = 0xffffffff;
+  state->set = 0;
+  state->seq_offset = 0;
+  state->ts_offset = 0;
+  state->ssrc_map = NULL;
+  state->n_ssrc = 0;
+  state->last = 0;
+  state->count = 0;
+
+  if (rewrite->flags & GST_RTP_REWRITE_SEQ)
+    state->seq_offset = rewrite->seq_offset;
+  if (rewrite->flags & GST_RTP_REWRITE_TIMESTAMP)
+    state->ts_offset = rewrite->ts_offset;
+  if (rewrite->flags & GST_RTP_REWRITE_PAYLOAD_TYPE) {
+    state->keep = 0xff80ffff;
+    state->set = (rewrite->payload_type & 0x7f) << 16;
+  }
+  if (rewrite->flags & GST_RTP_REWRITE_SSRC) {
+    state->ssrc_map = rewrite->ssrc_map;
+    state->n_ssrc = rewrite->n_ssrc;
+  }
+}
+
+static gboolean
+rewrite_header (guint8 * data, guint size, RewriteState * state)
+{
+  guint32 word, ssrc;
+  guint i;
+
+  if (G_UNLIKELY (size < 12))
+    return FALSE;
+
+  /* version, flags, payload type and seqnum */
+  word = GST_READ_UINT32_BE (data);
+  word = (word & state->keep & 0xffff0000) | state->set |
+      ((word + state->seq_offset) & 0xffff);
+  GST_WRITE_UINT32_BE (data, word);
+
+  word = GST_READ_UINT32_BE (data + 4);
+  GST_WRITE_UINT32_BE (data + 4, word + state->ts_offset);
+
+  if (state->n_ssrc) {
+    ssrc = GST_READ_UINT32_BE (data + 8);
+    /* a relay usually sees runs of the same SSRC, try the last match first */
+    i = state->last;
+    if (state->ssrc_map[2 * i] != ssrc) {
+      for (i = 0; i < state->n_ssrc; i++)
+        if (state->ssrc_map[2 * i] == ssrc)
+          break;
+    }
+    if (i < state->n_ssrc) {
+      GST_WRITE_UINT32_BE (data + 8, state->ssrc_map[2 * i + 1]);
+      state->last = i;
+    }
+  }
+  state->count++;
+
+  return TRUE;
+}
+
+/**
+ * gst_rtp_buffer_rewrite:
+ * @buffer: the buffer
+ * @rewrite: the changes to make
+ *
+ * Change the header of the RTP packet in @buffer as described by @rewrite.
+ *
+ * Returns: %TRUE if @buffer was large enough to hold an RTP header.
+ *
+ * Since: 0.10.37
+ */
+gboolean
+gst_rtp_buffer_rewrite (GstBuffer * buffer, const GstRTPRewrite * rewrite)
+{
+  RewriteState state;
+
+  g_return_val_if_fail (GST_IS_BUFFER (buffer), FALSE);
+  g_return_val_if_fail (rewrite != NULL, FALSE);
+  g_return_val_if_fail (rewrite->n_ssrc == 0 || rewrite->ssrc_map != NULL,
+      FALSE);
+
+  rewrite_state_init (&state, rewrite);
+
+  return rewrite_header (GST_BUFFER_DATA (buffer), GST_BUFFER_SIZE (buffer),
+      &state);
+}
+
+static GstBufferListItem
+rewrite_group_header (GstBuffer ** buffer, guint group, guint idx,
+    RewriteState * state)
+{
+  rewrite_header (GST_BUFFER_DATA (*buffer), GST_BUFFER_SIZE (*buffer), state);
+  return GST_BUFFER_LIST_SKIP_GROUP;
+}
+
+/**
+ * gst_rtp_buffer_list_rewrite:
+ * @list: the buffer list
+ * @rewrite: the changes to make
+ *
+ * Change the header of each RTP packet in @list as described by @rewrite.
+ * All fields selected in @rewrite are changed in a single pass over @list,
+ * which is cheaper than calling gst_rtp_buffer_list_set_seq(),
+ * gst_rtp_buffer_list_set_timestamp() and gst_rtp_buffer_list_set_ssrc() one
+ * after the other.
+ *
+ * Returns: the number of packets that were changed.
+ *
+ * Since: 0.10.37
+ */
+guint
+gst_rtp_buffer_list_rewrite (GstBufferList * list,
+    const GstRTPRewrite * rewrite)
+{
+  RewriteState state;
+
+  g_return_val_if_fail (GST_IS_BUFFER_LIST (list), 0);
+  g_return_val_if_fail (rewrite != NULL, 0);
+  g_return_val_if_fail (rewrite->n_ssrc == 0 || rewrite->ssrc_map != NULL, 0);
+
+  rewrite_state_init (&state, rewrite);
+
+  gst_buffer_list_foreach (list, (GstBufferListFunc) rewrite_group_header,
+      &state);
+
+  return state.count;
+}
+
 /**
  * gst_rtp_buffer_get_payload:
  * @buffer: the buffer
@@ -36,6 +36,56 @@ G_BEGIN_DECLS
  */
 #define GST_RTP_VERSION 2
 
+/**
+ * GstRTPRewriteFlags:
+ * @GST_RTP_REWRITE_SEQ: add @seq_offset to the sequence number
+ * @GST_RTP_REWRITE_TIMESTAMP: add @ts_offset to the timestamp
+ * @GST_RTP_REWRITE_PAYLOAD_TYPE: replace the payload type with @payload_type
+ * @GST_RTP_REWRITE_SSRC: replace the SSRC using @ssrc_map
+ *
+ * The header fields changed by a #GstRTPRewrite.
+ *
+ * Since: 0.10.37
+ */
+typedef enum
+{
+  GST_RTP_REWRITE_SEQ          = (1 << 0),
+  GST_RTP_REWRITE_TIMESTAMP    = (1 << 1),
+  GST_RTP_REWRITE_PAYLOAD_TYPE = (1 << 2),
+  GST_RTP_REWRITE_SSRC         = (1 << 3)
+} GstRTPRewriteFlags;
+
+typedef struct _GstRTPRewrite GstRTPRewrite;
+
+/**
+ * GstRTPRewrite:
+ * @flags: the #GstRTPRewriteFlags selecting the fields to change
+ * @seq_offset: the value added to the sequence numbers
+ * @ts_offset: the value added to the timestamps
+ * @payload_type: the new payload type
+ * @ssrc_map: @n_ssrc pairs of an original SSRC followed by its new SSRC
+ * @n_ssrc: the number of pairs in @ssrc_map
+ *
+ * A description of the changes gst_rtp_buffer_rewrite() and
+ * gst_rtp_buffer_list_rewrite() make to RTP headers. The offsets wrap around
+ * like the fields they are added to. Packets with an SSRC that is not in
+ * @ssrc_map keep their SSRC.
+ *
+ * Since: 0.10.37
+ */
+struct _GstRTPRewrite
+{
+  GstRTPRewriteFlags  flags;
+  guint16             seq_offset;
+  guint32             ts_offset;
+  guint8              payload_type;
+  const guint32      *ssrc_map;
+  guint               n_ssrc;
+
+  /*< private >*/
+  gpointer _gst_reserved[GST_PADDING];
+};
+
 /* creating buffers */
 void            gst_rtp_buffer_allocate_data         (GstBuffer *buffer, guint payload_len, 
                                                       guint8 pad_len, guint8 csrc_count);
@@ -106,6 +156,9 @@ GstBuffer* 	gst_rtp_buffer_get_payload_subbuffer (GstBuffer *buffer, guint offse
 
 guint           gst_rtp_buffer_get_payload_len       (GstBuffer *buffer);
 guint           gst_rtp_buffer_list_get_payload_len  (GstBufferList *list);
+
+gboolean        gst_rtp_buffer_rewrite               (GstBuffer *buffer, const GstRTPRewrite *rewrite);
+guint           gst_rtp_buffer_list_rewrite          (GstBufferList *list, const GstRTPRewrite *rewrite);
 gpointer        gst_rtp_buffer_get_payload           (GstBuffer *buffer);
 
 /* some helpers */
@@ -82,6 +82,7 @@
 #include <sys/ioctl.h>
 #include <netdb.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <fcntl.h>
 #include <netinet/in.h>
 #endif
@@ -164,6 +165,11 @@ typedef enum
 
 #define TUNNELID_LEN   24
 
+/* size of the read buffer of a connection, interleaved data frames that fit
+ * in it are handed out without copying */
+#define READ_BUFFER_SIZE 65536
+#define READ_BUFFER_AVAIL(conn) ((conn)->rbuf_len - (conn)->rbuf_off)
+
 struct _GstRTSPConnection
 {
   /*< private > */
@@ -191,6 +197,10 @@ struct _GstRTSPConnection
   gchar *initial_buffer;
   gsize initial_buffer_offset;
 
+  GstBuffer *rbuf;
+  guint rbuf_off;
+  guint rbuf_len;
+
   /* Session state */
   gint cseq;                    /* sequence number */
   gchar session_id[512];        /* session id */
@@ -238,13 +248,22 @@ typedef struct
   guint line;
   guint8 *body_data;
   glong body_len;
+
+  /* return data messages as subbuffers in body_buffer */
+  gboolean use_buffers;
+  GstBuffer *body_buffer;
 } GstRTSPBuilder;
 
 static void
 build_reset (GstRTSPBuilder * builder)
 {
+  gboolean use_buffers = builder->use_buffers;
+
   g_free (builder->body_data);
+  if (builder->body_buffer)
+    gst_buffer_unref (builder->body_buffer);
   memset (builder, 0, sizeof (GstRTSPBuilder));
+  builder->use_buffers = use_buffers;
 }
 
 /**
@@ -1079,6 +1098,40 @@ write_bytes (gint fd, const guint8 * buffer, guint * idx, guint size)
   return GST_RTSP_OK;
 }
 
+/* read more data from the socket into the read buffer while keeping the bytes
+ * that were not consumed yet. A new buffer is used when subbuffers of the
+ * current one are still in use. */
+static gint
+read_buffer_fill (GstRTSPConnection * conn)
+{
+  guint left = READ_BUFFER_AVAIL (conn);
+  gint r;
+
+  if (conn->rbuf == NULL || !gst_buffer_is_writable (conn->rbuf)) {
+    GstBuffer *rbuf;
+
+    rbuf = gst_buffer_new_and_alloc (READ_BUFFER_SIZE);
+    if (left > 0)
+      memcpy (GST_BUFFER_DATA (rbuf),
+          GST_BUFFER_DATA (conn->rbuf) + conn->rbuf_off, left);
+    if (conn->rbuf)
+      gst_buffer_unref (conn->rbuf);
+    conn->rbuf = rbuf;
+  } else if (left > 0 && conn->rbuf_off > 0) {
+    memmove (GST_BUFFER_DATA (conn->rbuf),
+        GST_BUFFER_DATA (conn->rbuf) + conn->rbuf_off, left);
+  }
+  conn->rbuf_off = 0;
+  conn->rbuf_len = left;
+
+  r = READ_SOCKET (conn->readfd->fd, GST_BUFFER_DATA (conn->rbuf) + left,
+      READ_BUFFER_SIZE - left);
+  if (r > 0)
+    conn->rbuf_len += r;
+
+  return r;
+}
+
 static gint
 fill_raw_bytes (GstRTSPConnection * conn, guint8 * buffer, guint size)
 {
@@ -1099,14 +1152,24 @@ fill_raw_bytes (GstRTSPConnection * conn, guint8 * buffer, guint size)
   }
 
   if (G_LIKELY (size > (guint) out)) {
-    gint r;
+    guint avail = READ_BUFFER_AVAIL (conn);
 
-    r = READ_SOCKET (conn->readfd->fd, &buffer[out], size - out);
-    if (r <= 0) {
-      if (out == 0)
-        out = r;
-    } else
-      out += r;
+    if (avail == 0) {
+      gint r;
+
+      r = read_buffer_fill (conn);
+      if (r <= 0) {
+        if (out == 0)
+          out = r;
+        return out;
+      }
+      avail = r;
+    }
+    avail = MIN (avail, size - out);
+    memcpy (&buffer[out], GST_BUFFER_DATA (conn->rbuf) + conn->rbuf_off,
+        avail);
+    conn->rbuf_off += avail;
+    out += avail;
   }
 
   return out;
@@ -1183,6 +1246,52 @@ read_bytes (GstRTSPConnection * conn, guint8 * buffer, guint * idx, guint size)
   return GST_RTSP_OK;
 }
 
+/* get the next interleaved data frame when it is completely in the read
+ * buffer, reading more data when needed. @data points into the read buffer
+ * and is valid until the next read. Returns GST_RTSP_EINVAL when the next
+ * bytes are not a data frame that fits in the read buffer, the generic
+ * parser must be used then. */
+static GstRTSPResult
+read_data_frame (GstRTSPConnection * conn, guint8 * channel, guint8 ** data,
+    guint * size)
+{
+  while (TRUE) {
+    guint avail = READ_BUFFER_AVAIL (conn);
+    gint r;
+
+    if (avail > 0) {
+      guint8 *frame = GST_BUFFER_DATA (conn->rbuf) + conn->rbuf_off;
+      guint len;
+
+      if (frame[0] != '$')
+        return GST_RTSP_EINVAL;
+
+      if (avail >= 4) {
+        len = GST_READ_UINT16_BE (frame + 2);
+        if (avail >= len + 4) {
+          *channel = frame[1];
+          *data = frame + 4;
+          *size = len;
+          conn->rbuf_off += len + 4;
+          return GST_RTSP_OK;
+        }
+        if (len + 4 > READ_BUFFER_SIZE)
+          return GST_RTSP_EINVAL;
+      }
+    }
+
+    r = read_buffer_fill (conn);
+    if (G_UNLIKELY (r == 0)) {
+      return GST_RTSP_EEOF;
+    } else if (G_UNLIKELY (r < 0)) {
+      if (ERRNO_IS_EAGAIN)
+        return GST_RTSP_EINTR;
+      if (!ERRNO_IS_EINTR)
+        return GST_RTSP_ESYS;
+    }
+  }
+}
+
 /* The code below tries to handle clients using \r, \n or \r\n to indicate the
  * end of a line. It even does its best to handle clients which mix them (even
  * though this is a really stupid idea (tm).) It also handles Line White Space
@@ -1862,6 +1971,32 @@ build_next (GstRTSPBuilder * builder, GstRTSPMessage * message,
       {
         guint8 c;
 
+        /* fast path for interleaved data, complete frames are taken from the
+         * read buffer in one go */
+        if (conn->ctxp == NULL && conn->initial_buffer == NULL) {
+          guint8 channel, *data;
+          guint size;
+
+          res = read_data_frame (conn, &channel, &data, &size);
+          if (res == GST_RTSP_OK) {
+            gst_rtsp_message_init_data (message, channel);
+            if (builder->use_buffers) {
+              builder->body_buffer = gst_buffer_create_sub (conn->rbuf,
+                  data - GST_BUFFER_DATA (conn->rbuf), size);
+            } else {
+              builder->body_data = g_malloc (size + 1);
+              memcpy (builder->body_data, data, size);
+              builder->body_data[size] = '\0';
+              gst_rtsp_message_take_body (message, builder->body_data,
+                  size + 1);
+              builder->body_data = NULL;
+            }
+            builder->state = STATE_END;
+            break;
+          } else if (res != GST_RTSP_EINVAL)
+            goto done;
+        }
+
         builder->offset = 0;
         res =
             read_bytes (conn, (guint8 *) builder->buffer, &builder->offset, 1);
@@ -2183,23 +2318,9 @@ no_message:
   }
 }
 
-/**
- * gst_rtsp_connection_receive:
- * @conn: a #GstRTSPConnection
- * @message: the message to read
- * @timeout: a timeout value or #NULL
- *
- * Attempt to read into @message from the connected @conn, blocking up to
- * the specified @timeout. @timeout can be #NULL, in which case this function
- * might block forever.
- * 
- * This function can be cancelled with gst_rtsp_connection_flush().
- *
- * Returns: #GST_RTSP_OK on success.
- */
-GstRTSPResult
-gst_rtsp_connection_receive (GstRTSPConnection * conn, GstRTSPMessage * message,
-    GTimeVal * timeout)
+static GstRTSPResult
+receive_message (GstRTSPConnection * conn, GstRTSPMessage * message,
+    GstBuffer ** buffer, GTimeVal * timeout)
 {
   GstRTSPResult res;
   GstRTSPBuilder builder;
@@ -2218,6 +2339,7 @@ gst_rtsp_connection_receive (GstRTSPConnection * conn, GstRTSPMessage * message,
   gst_poll_fd_ctl_read (conn->fdset, conn->readfd, TRUE);
 
   memset (&builder, 0, sizeof (GstRTSPBuilder));
+  builder.use_buffers = (buffer != NULL);
   while (TRUE) {
     res = build_next (&builder, message, conn);
     if (G_UNLIKELY (res == GST_RTSP_EEOF))
@@ -2285,6 +2407,10 @@ gst_rtsp_connection_receive (GstRTSPConnection * conn, GstRTSPMessage * message,
   }
 
   /* we have a message here */
+  if (buffer) {
+    *buffer = builder.body_buffer;
+    builder.body_buffer = NULL;
+  }
   build_reset (&builder);
 
   return GST_RTSP_OK;
@@ -2324,6 +2450,56 @@ cleanup:
   }
 }
 
+
+/**
+ * gst_rtsp_connection_receive:
+ * @conn: a #GstRTSPConnection
+ * @message: the message to read
+ * @timeout: a timeout value or #NULL
+ *
+ * Attempt to read into @message from the connected @conn, blocking up to
+ * the specified @timeout. @timeout can be #NULL, in which case this function
+ * might block forever.
+ * 
+ * This function can be cancelled with gst_rtsp_connection_flush().
+ *
+ * Returns: #GST_RTSP_OK on success.
+ */
+GstRTSPResult
+gst_rtsp_connection_receive (GstRTSPConnection * conn, GstRTSPMessage * message,
+    GTimeVal * timeout)
+{
+  return receive_message (conn, message, NULL, timeout);
+}
+
+/**
+ * gst_rtsp_connection_receive_buffer:
+ * @conn: a #GstRTSPConnection
+ * @message: the message to read
+ * @buffer: (out): location for the data of an interleaved data message
+ * @timeout: a timeout value or #NULL
+ *
+ * Like gst_rtsp_connection_receive(), but when an interleaved data message is
+ * received, its data is returned in @buffer without copying and the body of
+ * @message is left empty. @buffer is set to %NULL for other messages and for
+ * data messages that had to be copied. Free @buffer with gst_buffer_unref()
+ * after usage.
+ *
+ * Returns: #GST_RTSP_OK on success.
+ *
+ * Since: 0.10.37
+ */
+GstRTSPResult
+gst_rtsp_connection_receive_buffer (GstRTSPConnection * conn,
+    GstRTSPMessage * message, GstBuffer ** buffer, GTimeVal * timeout)
+{
+  g_return_val_if_fail (buffer != NULL, GST_RTSP_EINVAL);
+
+  *buffer = NULL;
+
+  return receive_message (conn, message, buffer, timeout);
+}
+
 /**
  * gst_rtsp_connection_close:
  * @conn: a #GstRTSPConnection
@@ -2347,6 +2523,9 @@ gst_rtsp_connection_close (GstRTSPConnection * conn)
   conn->initial_buffer = NULL;
   conn->initial_buffer_offset = 0;
 
+  conn->rbuf_off = 0;
+  conn->rbuf_len = 0;
+
   REMOVE_POLLFD (conn->fdset, &conn->fd0);
   REMOVE_POLLFD (conn->fdset, &conn->fd1);
   conn->writefd = NULL;
@@ -2382,6 +2561,8 @@ gst_rtsp_connection_free (GstRTSPConnection * conn)
   g_return_val_if_fail (conn != NULL, GST_RTSP_EINVAL);
 
   res = gst_rtsp_connection_close (conn);
+  if (conn->rbuf)
+    gst_buffer_unref (conn->rbuf);
   gst_poll_free (conn->fdset);
   g_timer_destroy (conn->timer);
   gst_rtsp_url_free (conn->url);
@@ -2436,6 +2617,13 @@ gst_rtsp_connection_poll (GstRTSPConnection * conn, GstRTSPEvent events,
   /* add fd to reader set when asked to */
   gst_poll_fd_ctl_read (conn->fdset, conn->readfd, events & GST_RTSP_EV_READ);
 
+  /* data that was already read can be read without waiting */
+  if ((events & GST_RTSP_EV_READ) &&
+      (conn->initial_buffer != NULL || READ_BUFFER_AVAIL (conn) > 0)) {
+    *revents = GST_RTSP_EV_READ;
+    return GST_RTSP_OK;
+  }
+
   /* configure timeout if any */
   to = timeout ? GST_TIMEVAL_TO_TIME (*timeout) : GST_CLOCK_TIME_NONE;
 
@@ -3012,6 +3200,31 @@ gst_rtsp_connection_do_tunnel (GstRTSPConnection * conn,
      * socket from conn2 and set it as the socket in conn */
     conn->fd1 = conn2->fd0;
 
+    /* data that was already read from the socket of conn2 must be read
+     * first. What is left in the read buffer of conn came from the old read
+     * socket and is discarded. */
+    if (conn2->initial_buffer != NULL || READ_BUFFER_AVAIL (conn2) > 0) {
+      GString *str = g_string_new (NULL);
+
+      if (conn2->initial_buffer != NULL)
+        g_string_append (str,
+            &conn2->initial_buffer[conn2->initial_buffer_offset]);
+      if (READ_BUFFER_AVAIL (conn2) > 0)
+        g_string_append_len (str,
+            (gchar *) GST_BUFFER_DATA (conn2->rbuf) + conn2->rbuf_off,
+            READ_BUFFER_AVAIL (conn2));
+
+      g_free (conn->initial_buffer);
+      conn->initial_buffer = g_string_free (str, FALSE);
+      conn->initial_buffer_offset = 0;
+
+      g_free (conn2->initial_buffer);
+      conn2->initial_buffer = NULL;
+      conn2->initial_buffer_offset = 0;
+    }
+    conn->rbuf_off = conn->rbuf_len = 0;
+    conn2->rbuf_off = conn2->rbuf_len = 0;
+
     /* clean up some of the state of conn2 */
     gst_poll_remove_fd (conn2->fdset, &conn2->fd0);
     conn2->fd0.fd = -1;
@@ -3039,11 +3252,17 @@ gst_rtsp_connection_do_tunnel (GstRTSPConnection * conn,
 #define WRITE_ERR   (G_IO_HUP | G_IO_ERR | G_IO_NVAL)
 #define WRITE_COND  (G_IO_OUT | WRITE_ERR)
 
+/* maximum number of queued records written with one sendmsg() call */
+#define WATCH_MAX_IOV 16
+
 typedef struct
 {
   guint8 *data;
+  guint off;
   guint size;
   guint id;
+  /* interleaved data, may be dropped when the backlog is full */
+  gboolean is_data;
 } GstRTSPRec;
 
 /* async functions */
@@ -3059,27 +3278,164 @@ struct _GstRTSPWatch
   GPollFD readfd;
   GPollFD writefd;
 
+  /* the read buffer contains more messages */
+  gboolean read_pending;
+
   /* queued message for transmission */
   guint id;
   GMutex *mutex;
   GQueue *messages;
-  guint8 *write_data;
-  guint write_off;
-  guint write_size;
+  gsize messages_bytes;
   guint write_id;
 
+  /* send backlog limits, 0 is unlimited */
+  gsize max_bytes;
+  guint max_messages;
+  guint64 dropped_messages;
+  guint64 dropped_bytes;
+
   GstRTSPWatchFuncs funcs;
 
   gpointer user_data;
   GDestroyNotify notify;
 };
 
+static void
+gst_rtsp_rec_free (gpointer data)
+{
+  GstRTSPRec *rec = data;
+
+  g_free (rec->data);
+  g_slice_free (GstRTSPRec, rec);
+}
+
+/* write as many queued records as the socket accepts. Completely written
+ * records are moved to @sent so that the message_sent callback can be called
+ * without holding the lock. Must be called with watch->mutex. */
+static GstRTSPResult
+gst_rtsp_watch_flush (GstRTSPWatch * watch, GQueue * sent)
+{
+  GstRTSPRec *rec;
+
+  while ((rec = g_queue_peek_head (watch->messages))) {
+#ifndef G_OS_WIN32
+    struct iovec iov[WATCH_MAX_IOV];
+    struct msghdr msg;
+    GList *walk;
+    gssize r;
+    gint n = 0;
+
+    for (walk = watch->messages->head; walk && n < WATCH_MAX_IOV;
+        walk = walk->next) {
+      GstRTSPRec *q = walk->data;
+
+      iov[n].iov_base = q->data + q->off;
+      iov[n].iov_len = q->size - q->off;
+      n++;
+    }
+
+    memset (&msg, 0, sizeof (msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = n;
+
+    r = sendmsg (watch->writefd.fd, &msg, SEND_FLAGS);
+    if (G_UNLIKELY (r == 0)) {
+      return GST_RTSP_EINTR;
+    } else if (G_UNLIKELY (r < 0)) {
+      if (ERRNO_IS_EAGAIN)
+        return GST_RTSP_EINTR;
+      if (!ERRNO_IS_EINTR)
+        return GST_RTSP_ESYS;
+      continue;
+    }
+
+    /* retire the records that were written completely */
+    while (r > 0) {
+      guint left;
+
+      rec = g_queue_peek_head (watch->messages);
+      left = rec->size - rec->off;
+      if (r < left) {
+        rec->off += r;
+        watch->messages_bytes -= r;
+        break;
+      }
+      r -= left;
+      watch->messages_bytes -= left;
+      g_queue_push_tail (sent, g_queue_pop_head (watch->messages));
+    }
+#else
+    GstRTSPResult res;
+    guint off = rec->off;
+
+    res = write_bytes (watch->writefd.fd, rec->data, &rec->off, rec->size);
+    watch->messages_bytes -= rec->off - off;
+    if (res != GST_RTSP_OK)
+      return res;
+
+    g_queue_push_tail (sent, g_queue_pop_head (watch->messages));
+#endif
+  }
+  return GST_RTSP_OK;
+}
+
+#define BACKLOG_FULL(w,s) \
+  (((w)->max_bytes && (w)->messages_bytes + (s) > (w)->max_bytes) || \
+   ((w)->max_messages && (w)->messages->length + 1 > (w)->max_messages))
+
+/* add @rec to the send queue, making room according to the backlog limits.
+ * Only interleaved data records that have not been partially written are
+ * dropped, starting with the oldest one. Returns FALSE when @rec itself had
+ * to be dropped, in which case it was freed. Must be called with
+ * watch->mutex. */
+static gboolean
+gst_rtsp_watch_queue_rec (GstRTSPWatch * watch, GstRTSPRec * rec)
+{
+  guint size = rec->size - rec->off;
+
+  if (G_UNLIKELY (BACKLOG_FULL (watch, size))) {
+    GList *walk, *next;
+
+    for (walk = watch->messages->head; walk && BACKLOG_FULL (watch, size);
+        walk = next) {
+      GstRTSPRec *old = walk->data;
+
+      next = walk->next;
+      if (!old->is_data || old->off != 0)
+        continue;
+
+      watch->messages_bytes -= old->size;
+      watch->dropped_messages++;
+      watch->dropped_bytes += old->size;
+      g_queue_delete_link (watch->messages, walk);
+      gst_rtsp_rec_free (old);
+    }
+
+    if (rec->is_data && rec->off == 0 && BACKLOG_FULL (watch, size)) {
+      watch->dropped_messages++;
+      watch->dropped_bytes += rec->size;
+      gst_rtsp_rec_free (rec);
+      return FALSE;
+    }
+  }
+
+  do {
+    /* make sure rec->id is never 0 */
+    rec->id = ++watch->id;
+  } while (G_UNLIKELY (rec->id == 0));
+
+  g_queue_push_tail (watch->messages, rec);
+  watch->messages_bytes += size;
+
+  return TRUE;
+}
+
 static gboolean
 gst_rtsp_source_prepare (GSource * source, gint * timeout)
 {
   GstRTSPWatch *watch = (GstRTSPWatch *) source;
 
-  if (watch->conn->initial_buffer != NULL)
+  if (watch->conn->initial_buffer != NULL || watch->read_pending)
     return TRUE;
 
   *timeout = (watch->conn->timeout * 1000);
@@ -3110,7 +3466,8 @@ gst_rtsp_source_dispatch (GSource * source, GSourceFunc callback G_GNUC_UNUSED,
   gboolean keep_running = TRUE;
 
   /* first read as much as we can */
-  if (watch->readfd.revents & READ_COND || watch->conn->initial_buffer != NULL) {
+  if (watch->readfd.revents & READ_COND || watch->conn->initial_buffer != NULL
+      || watch->read_pending) {
     do {
       if (watch->readfd.revents & READ_ERR)
         goto read_error;
@@ -3187,7 +3544,11 @@ gst_rtsp_source_dispatch (GSource * source, GSourceFunc callback G_GNUC_UNUSED,
       }
 
       if (G_LIKELY (res == GST_RTSP_OK)) {
-        if (watch->funcs.message_received)
+        if (watch->builder.body_buffer != NULL)
+          watch->funcs.data_received (watch,
+              watch->message.type_data.data.channel,
+              watch->builder.body_buffer, watch->user_data);
+        else if (watch->funcs.message_received)
           watch->funcs.message_received (watch, &watch->message,
               watch->user_data);
       } else {
@@ -3198,51 +3559,38 @@ gst_rtsp_source_dispatch (GSource * source, GSourceFunc callback G_GNUC_UNUSED,
       gst_rtsp_message_unset (&watch->message);
       build_reset (&watch->builder);
     } while (FALSE);
+
+    /* dispatch again when the read buffer holds more data, the socket might
+     * not become readable for it */
+    watch->read_pending = (res != GST_RTSP_EINTR &&
+        READ_BUFFER_AVAIL (watch->conn) > 0);
   }
 
   if (watch->writefd.revents & WRITE_COND) {
+    GQueue sent = G_QUEUE_INIT;
+    GstRTSPRec *rec;
+
     if (watch->writefd.revents & WRITE_ERR)
       goto write_error;
 
     g_mutex_lock (watch->mutex);
-    do {
-      if (watch->write_data == NULL) {
-        GstRTSPRec *rec;
-
-        /* get a new message from the queue */
-        rec = g_queue_pop_tail (watch->messages);
-        if (rec == NULL)
-          break;
-
-        watch->write_off = 0;
-        watch->write_data = rec->data;
-        watch->write_size = rec->size;
-        watch->write_id = rec->id;
-
-        g_slice_free (GstRTSPRec, rec);
-      }
-
-      res = write_bytes (watch->writefd.fd, watch->write_data,
-          &watch->write_off, watch->write_size);
-      g_mutex_unlock (watch->mutex);
-
-      if (res == GST_RTSP_EINTR)
-        goto write_blocked;
-      else if (G_LIKELY (res == GST_RTSP_OK)) {
-        if (watch->funcs.message_sent)
-          watch->funcs.message_sent (watch, watch->write_id, watch->user_data);
-      } else {
-        goto write_error;
-      }
-      g_mutex_lock (watch->mutex);
-
-      g_free (watch->write_data);
-      watch->write_data = NULL;
-    } while (TRUE);
+    res = gst_rtsp_watch_flush (watch, &sent);
+    if (res == GST_RTSP_OK) {
+      watch->writefd.events = WRITE_ERR;
+    } else if (res != GST_RTSP_EINTR) {
+      rec = g_queue_peek_head (watch->messages);
+      watch->write_id = rec ? rec->id : 0;
+    }
+    g_mutex_unlock (watch->mutex);
 
-    watch->writefd.events = WRITE_ERR;
+    while ((rec = g_queue_pop_head (&sent))) {
+      if (watch->funcs.message_sent)
+        watch->funcs.message_sent (watch, rec->id, watch->user_data);
+      gst_rtsp_rec_free (rec);
+    }
 
-    g_mutex_unlock (watch->mutex);
+    if (G_UNLIKELY (res != GST_RTSP_OK && res != GST_RTSP_EINTR))
+      goto write_error;
   }
 
 write_blocked:
@@ -3298,15 +3646,6 @@ error:
   }
 }
 
-static void
-gst_rtsp_rec_free (gpointer data)
-{
-  GstRTSPRec *rec = data;
-
-  g_free (rec->data);
-  g_slice_free (GstRTSPRec, rec);
-}
-
 static void
 gst_rtsp_source_finalize (GSource * source)
 {
@@ -3318,7 +3657,6 @@ gst_rtsp_source_finalize (GSource * source)
   g_queue_foreach (watch->messages, (GFunc) gst_rtsp_rec_free, NULL);
   g_queue_free (watch->messages);
   watch->messages = NULL;
-  g_free (watch->write_data);
 
   g_mutex_free (watch->mutex);
 
@@ -3371,6 +3709,7 @@ gst_rtsp_watch_new (GstRTSPConnection * conn,
 
   result->conn = conn;
   result->builder.state = STATE_START;
+  result->builder.use_buffers = (funcs->data_received != NULL);
 
   result->mutex = g_mutex_new ();
   result->messages = g_queue_new ();
@@ -3470,6 +3809,13 @@ gst_rtsp_watch_unref (GstRTSPWatch * watch)
  *
  * This function will take ownership of @data and g_free() it after use.
  *
+ * When a send backlog was configured with gst_rtsp_watch_set_send_backlog()
+ * and @data is interleaved data, @data or older queued interleaved data might
+ * be dropped to stay within the limits. When @data itself is dropped this
+ * function still returns #GST_RTSP_OK and @id is set to 0, just like when
+ * @data was sent immediately, and no message_sent callback will be called
+ * for it. Dropped data can be detected with gst_rtsp_watch_get_send_stats().
+ *
  * Returns: #GST_RTSP_OK on success.
  *
  * Since: 0.10.25
@@ -3490,7 +3836,7 @@ gst_rtsp_watch_write_data (GstRTSPWatch * watch, const guint8 * data,
   g_mutex_lock (watch->mutex);
 
   /* try to send the message synchronously first */
-  if (watch->messages->length == 0 && watch->write_data == NULL) {
+  if (watch->messages->length == 0) {
     res = write_bytes (watch->writefd.fd, data, &off, size);
     if (res != GST_RTSP_EINTR) {
       if (id != NULL)
@@ -3500,25 +3846,23 @@ gst_rtsp_watch_write_data (GstRTSPWatch * watch, const guint8 * data,
     }
   }
 
-  /* make a record with the data and id for sending async */
+  /* make a record with the data and id for sending async, the part that was
+   * already written is skipped with the offset */
   rec = g_slice_new (GstRTSPRec);
-  if (off == 0) {
-    rec->data = (guint8 *) data;
-    rec->size = size;
-  } else {
-    rec->data = g_memdup (data + off, size - off);
-    rec->size = size - off;
-    g_free ((gpointer) data);
+  rec->data = (guint8 *) data;
+  rec->off = off;
+  rec->size = size;
+  rec->is_data = (size > 0 && data[0] == '$');
+
+  /* add the record to a queue, a data record that does not fit in the backlog
+   * is dropped and reported as sent */
+  if (!gst_rtsp_watch_queue_rec (watch, rec)) {
+    if (id != NULL)
+      *id = 0;
+    res = GST_RTSP_OK;
+    goto done;
   }
 
-  do {
-    /* make sure rec->id is never 0 */
-    rec->id = ++watch->id;
-  } while (G_UNLIKELY (rec->id == 0));
-
-  /* add the record to a queue. FIXME we would like to have an upper limit here */
-  g_queue_push_head (watch->messages, rec);
-
   /* make sure the main context will now also check for writability on the
    * socket */
   if (watch->writefd.events != WRITE_COND) {
@@ -3573,6 +3917,92 @@ gst_rtsp_watch_send_message (GstRTSPWatch * watch, GstRTSPMessage * message,
       (guint8 *) g_string_free (str, FALSE), size, id);
 }
 
+/**
+ * gst_rtsp_watch_set_send_backlog:
+ * @watch: a #GstRTSPWatch
+ * @bytes: maximum bytes in the send queue, 0 for unlimited
+ * @messages: maximum messages in the send queue, 0 for unlimited
+ *
+ * Limit the amount of data that is queued in @watch for transmission. When
+ * a new message would make the queue exceed the limits, the oldest queued
+ * interleaved data packets are dropped. RTSP control messages are never
+ * dropped and are always queued, even when this exceeds the limits. An
+ * interleaved data packet that does not fit after dropping is discarded
+ * itself.
+ *
+ * The new limits are applied when the next message is queued.
+ *
+ * Since: 0.10.37
+ */
+void
+gst_rtsp_watch_set_send_backlog (GstRTSPWatch * watch, gsize bytes,
+    guint messages)
+{
+  g_return_if_fail (watch != NULL);
+
+  g_mutex_lock (watch->mutex);
+  watch->max_bytes = bytes;
+  watch->max_messages = messages;
+  g_mutex_unlock (watch->mutex);
+}
+
+/**
+ * gst_rtsp_watch_get_send_backlog:
+ * @watch: a #GstRTSPWatch
+ * @bytes: (out) (allow-none): maximum bytes in the send queue
+ * @messages: (out) (allow-none): maximum messages in the send queue
+ *
+ * Get the limits of the send queue of @watch as configured with
+ * gst_rtsp_watch_set_send_backlog().
+ *
+ * Since: 0.10.37
+ */
+void
+gst_rtsp_watch_get_send_backlog (GstRTSPWatch * watch, gsize * bytes,
+    guint * messages)
+{
+  g_return_if_fail (watch != NULL);
+
+  g_mutex_lock (watch->mutex);
+  if (bytes)
+    *bytes = watch->max_bytes;
+  if (messages)
+    *messages = watch->max_messages;
+  g_mutex_unlock (watch->mutex);
+}
+
+/**
+ * gst_rtsp_watch_get_send_stats:
+ * @watch: a #GstRTSPWatch
+ * @queued_bytes: (out) (allow-none): bytes waiting in the send queue
+ * @queued_messages: (out) (allow-none): messages waiting in the send queue
+ * @dropped_bytes: (out) (allow-none): total bytes of dropped data packets
+ * @dropped_messages: (out) (allow-none): total number of dropped data packets
+ *
+ * Get the current level of the send queue of @watch and the amount of
+ * interleaved data that was dropped because of the send backlog limits.
+ *
+ * Since: 0.10.37
+ */
+void
+gst_rtsp_watch_get_send_stats (GstRTSPWatch * watch, gsize * queued_bytes,
+    guint * queued_messages, guint64 * dropped_bytes,
+    guint64 * dropped_messages)
+{
+  g_return_if_fail (watch != NULL);
+
+  g_mutex_lock (watch->mutex);
+  if (queued_bytes)
+    *queued_bytes = watch->messages_bytes;
+  if (queued_messages)
+    *queued_messages = watch->messages->length;
+  if (dropped_bytes)
+    *dropped_bytes = watch->dropped_bytes;
+  if (dropped_messages)
+    *dropped_messages = watch->dropped_messages;
+  g_mutex_unlock (watch->mutex);
+}
+
 /**
  * gst_rtsp_watch_queue_data:
  * @watch: a #GstRTSPWatch
@@ -3585,7 +4015,8 @@ gst_rtsp_watch_send_message (GstRTSPWatch * watch, GstRTSPMessage * message,
  * This function will take ownership of @data and g_free() it after use.
  *
  * The return value of this function will be used as the id argument in the
- * message_sent callback.
+ * message_sent callback. When @data was dropped because of the send backlog
+ * limits, 0 is returned and no message_sent callback will be called.
  *
  * Deprecated: Use gst_rtsp_watch_write_data()
  *
@@ -3605,6 +4036,7 @@ gst_rtsp_watch_queue_data (GstRTSPWatch * watch, const guint8 * data,
 {
   GstRTSPRec *rec;
   GMainContext *context = NULL;
+  guint id;
 
   g_return_val_if_fail (watch != NULL, GST_RTSP_EINVAL);
   g_return_val_if_fail (data != NULL, GST_RTSP_EINVAL);
@@ -3615,14 +4047,15 @@ gst_rtsp_watch_queue_data (GstRTSPWatch * watch, const guint8 * data,
   /* make a record with the data and id */
   rec = g_slice_new (GstRTSPRec);
   rec->data = (guint8 *) data;
+  rec->off = 0;
   rec->size = size;
-  do {
-    /* make sure rec->id is never 0 */
-    rec->id = ++watch->id;
-  } while (G_UNLIKELY (rec->id == 0));
+  rec->is_data = (size > 0 && data[0] == '$');
 
-  /* add the record to a queue. FIXME we would like to have an upper limit here */
-  g_queue_push_head (watch->messages, rec);
+  /* add the record to a queue */
+  if (gst_rtsp_watch_queue_rec (watch, rec))
+    id = rec->id;
+  else
+    id = 0;
 
   /* make sure the main context will now also check for writability on the
    * socket */
@@ -3635,7 +4068,7 @@ gst_rtsp_watch_queue_data (GstRTSPWatch * watch, const guint8 * data,
   if (context)
     g_main_context_wakeup (context);
 
-  return rec->id;
+  return id;
 }
 #endif /* GST_REMOVE_DEPRECATED */
 
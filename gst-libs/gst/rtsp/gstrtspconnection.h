@@ -46,6 +46,7 @@
 #include <glib.h>
 
 #include <gst/gstconfig.h>
+#include <gst/gstbuffer.h>
 #include <gst/rtsp/gstrtspdefs.h>
 #include <gst/rtsp/gstrtspurl.h>
 #include <gst/rtsp/gstrtspmessage.h>
@@ -83,6 +84,10 @@ GstRTSPResult      gst_rtsp_connection_send          (GstRTSPConnection *conn, G
                                                       GTimeVal *timeout);
 GstRTSPResult      gst_rtsp_connection_receive       (GstRTSPConnection *conn, GstRTSPMessage *message,
                                                       GTimeVal *timeout);
+GstRTSPResult      gst_rtsp_connection_receive_buffer (GstRTSPConnection *conn,
+                                                       GstRTSPMessage *message,
+                                                       GstBuffer **buffer,
+                                                       GTimeVal *timeout);
 
 /* status management */
 GstRTSPResult      gst_rtsp_connection_poll          (GstRTSPConnection *conn, GstRTSPEvent events,
@@ -155,6 +160,10 @@ typedef struct _GstRTSPWatch GstRTSPWatch;
  *   the @error callback. Since 0.10.25
  * @tunnel_lost: callback when the post connection of a tunnel is closed.
  *   Since 0.10.29
+ * @data_received: callback when interleaved data was received. When set,
+ *   data messages are passed as a #GstBuffer that shares the memory of the
+ *   read buffer of the connection instead of calling @message_received. Take
+ *   a reference to keep the buffer after the callback. Since 0.10.37
  *
  * Callback functions from a #GstRTSPWatch.
  *
@@ -174,9 +183,11 @@ typedef struct {
                                          GstRTSPMessage *message, guint id,
                                          gpointer user_data);
   GstRTSPResult     (*tunnel_lost)      (GstRTSPWatch *watch, gpointer user_data);
+  GstRTSPResult     (*data_received)    (GstRTSPWatch *watch, guint8 channel,
+                                         GstBuffer *buffer, gpointer user_data);
 
   /*< private >*/
-  gpointer _gst_reserved[GST_PADDING - 2];
+  gpointer _gst_reserved[GST_PADDING - 3];
 } GstRTSPWatchFuncs;
 
 GstRTSPWatch *     gst_rtsp_watch_new                (GstRTSPConnection *conn,
@@ -196,6 +207,16 @@ GstRTSPResult      gst_rtsp_watch_send_message       (GstRTSPWatch *watch,
                                                       GstRTSPMessage *message,
                                                       guint *id);
 
+void               gst_rtsp_watch_set_send_backlog   (GstRTSPWatch *watch,
+                                                      gsize bytes, guint messages);
+void               gst_rtsp_watch_get_send_backlog   (GstRTSPWatch *watch,
+                                                      gsize *bytes, guint *messages);
+void               gst_rtsp_watch_get_send_stats     (GstRTSPWatch *watch,
+                                                      gsize *queued_bytes,
+                                                      guint *queued_messages,
+                                                      guint64 *dropped_bytes,
+                                                      guint64 *dropped_messages);
+
 #ifndef GST_DISABLE_DEPRECATED
 guint              gst_rtsp_watch_queue_data         (GstRTSPWatch * watch,
                                                       const guint8 * data,
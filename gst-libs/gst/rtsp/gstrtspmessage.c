@@ -62,6 +62,64 @@ typedef struct _RTSPKeyValue
   gchar *value;
 } RTSPKeyValue;
 
+/* Index of the headers of a message. Because GstRTSPMessage has no room for
+ * it, the index is stored in the first elements of the hdr_fields array and
+ * the headers follow it.
+ *
+ * present has a bit for every field that has at least one header and first
+ * contains the position + 1 of the first header of a field, or 0 when the
+ * position is too large, in which case the headers are scanned from the
+ * start. */
+typedef struct
+{
+  guint32 present[(GST_RTSP_HDR_LAST + 31) / 32];
+  guint8 first[GST_RTSP_HDR_LAST];
+} RTSPHeaderIndex;
+
+#define HDR_INDEX_SIZE \
+  ((sizeof (RTSPHeaderIndex) + sizeof (RTSPKeyValue) - 1) / sizeof (RTSPKeyValue))
+#define HDR_INDEX(array) ((RTSPHeaderIndex *) (array)->data)
+#define HDR_N_FIELDS(array) ((array)->len - HDR_INDEX_SIZE)
+#define HDR_FIELD(array,i) \
+  (&g_array_index ((array), RTSPKeyValue, HDR_INDEX_SIZE + (i)))
+
+#define HDR_IS_INDEXED(field) ((field) > 0 && (field) < GST_RTSP_HDR_LAST)
+#define HDR_IS_PRESENT(idx,field) \
+  (((idx)->present[(field) / 32] & (1U << ((field) % 32))) != 0)
+
+static GArray *
+header_array_new (void)
+{
+  GArray *array;
+
+  array = g_array_sized_new (FALSE, TRUE, sizeof (RTSPKeyValue),
+      HDR_INDEX_SIZE + 8);
+  g_array_set_size (array, HDR_INDEX_SIZE);
+
+  return array;
+}
+
+static void
+header_index_add (RTSPHeaderIndex * idx, GstRTSPHeaderField field, guint pos)
+{
+  if (!HDR_IS_INDEXED (field) || HDR_IS_PRESENT (idx, field))
+    return;
+
+  idx->present[field / 32] |= 1U << (field % 32);
+  idx->first[field] = pos < G_MAXUINT8 ? pos + 1 : 0;
+}
+
+static void
+header_index_rebuild (GArray * array)
+{
+  RTSPHeaderIndex *idx = HDR_INDEX (array);
+  guint i;
+
+  memset (idx, 0, sizeof (RTSPHeaderIndex));
+  for (i = 0; i < HDR_N_FIELDS (array); i++)
+    header_index_add (idx, HDR_FIELD (array, i)->field, i);
+}
+
 static void
 key_value_foreach (GArray * array, GFunc func, gpointer user_data)
 {
@@ -69,8 +127,8 @@ key_value_foreach (GArray * array, GFunc func, gpointer user_data)
 
   g_return_if_fail (array != NULL);
 
-  for (i = 0; i < array->len; i++) {
-    (*func) (&g_array_index (array, RTSPKeyValue, i), user_data);
+  for (i = 0; i < HDR_N_FIELDS (array); i++) {
+    (*func) (HDR_FIELD (array, i), user_data);
   }
 }
 
@@ -113,7 +171,7 @@ gst_rtsp_message_init (GstRTSPMessage * msg)
   gst_rtsp_message_unset (msg);
 
   msg->type = GST_RTSP_MESSAGE_INVALID;
-  msg->hdr_fields = g_array_new (FALSE, FALSE, sizeof (RTSPKeyValue));
+  msg->hdr_fields = header_array_new ();
 
   return GST_RTSP_OK;
 }
@@ -185,7 +243,7 @@ gst_rtsp_message_init_request (GstRTSPMessage * msg, GstRTSPMethod method,
   msg->type_data.request.method = method;
   msg->type_data.request.uri = g_strdup (uri);
   msg->type_data.request.version = GST_RTSP_VERSION_1_0;
-  msg->hdr_fields = g_array_new (FALSE, FALSE, sizeof (RTSPKeyValue));
+  msg->hdr_fields = header_array_new ();
 
   return GST_RTSP_OK;
 }
@@ -286,7 +344,7 @@ gst_rtsp_message_init_response (GstRTSPMessage * msg, GstRTSPStatusCode code,
   msg->type_data.response.code = code;
   msg->type_data.response.reason = g_strdup (reason);
   msg->type_data.response.version = GST_RTSP_VERSION_1_0;
-  msg->hdr_fields = g_array_new (FALSE, FALSE, sizeof (RTSPKeyValue));
+  msg->hdr_fields = header_array_new ();
 
   if (request) {
     if (request->type == GST_RTSP_MESSAGE_HTTP_REQUEST) {
@@ -460,8 +518,8 @@ gst_rtsp_message_unset (GstRTSPMessage * msg)
   if (msg->hdr_fields != NULL) {
     guint i;
 
-    for (i = 0; i < msg->hdr_fields->len; i++) {
-      RTSPKeyValue *keyval = &g_array_index (msg->hdr_fields, RTSPKeyValue, i);
+    for (i = 0; i < HDR_N_FIELDS (msg->hdr_fields); i++) {
+      RTSPKeyValue *keyval = HDR_FIELD (msg->hdr_fields, i);
 
       g_free (keyval->value);
     }
@@ -521,6 +579,8 @@ gst_rtsp_message_take_header (GstRTSPMessage * msg, GstRTSPHeaderField field,
   key_value.field = field;
   key_value.value = value;
 
+  header_index_add (HDR_INDEX (msg->hdr_fields), field,
+      HDR_N_FIELDS (msg->hdr_fields));
   g_array_append_val (msg->hdr_fields, key_value);
 
   return GST_RTSP_OK;
@@ -565,12 +625,16 @@ gst_rtsp_message_remove_header (GstRTSPMessage * msg, GstRTSPHeaderField field,
 
   g_return_val_if_fail (msg != NULL, GST_RTSP_EINVAL);
 
-  while (i < msg->hdr_fields->len) {
-    RTSPKeyValue *key_value = &g_array_index (msg->hdr_fields, RTSPKeyValue, i);
+  if (HDR_IS_INDEXED (field) &&
+      !HDR_IS_PRESENT (HDR_INDEX (msg->hdr_fields), field))
+    return res;
+
+  while (i < HDR_N_FIELDS (msg->hdr_fields)) {
+    RTSPKeyValue *key_value = HDR_FIELD (msg->hdr_fields, i);
 
     if (key_value->field == field && (indx == -1 || cnt++ == indx)) {
       g_free (key_value->value);
-      g_array_remove_index (msg->hdr_fields, i);
+      g_array_remove_index (msg->hdr_fields, HDR_INDEX_SIZE + i);
       res = GST_RTSP_OK;
       if (indx != -1)
         break;
@@ -578,6 +642,11 @@ gst_rtsp_message_remove_header (GstRTSPMessage * msg, GstRTSPHeaderField field,
       i++;
     }
   }
+
+  /* positions have changed */
+  if (res == GST_RTSP_OK)
+    header_index_rebuild (msg->hdr_fields);
+
   return res;
 }
 
@@ -598,7 +667,7 @@ GstRTSPResult
 gst_rtsp_message_get_header (const GstRTSPMessage * msg,
     GstRTSPHeaderField field, gchar ** value, gint indx)
 {
-  guint i;
+  guint i = 0;
   gint cnt = 0;
 
   g_return_val_if_fail (msg != NULL, GST_RTSP_EINVAL);
@@ -607,8 +676,19 @@ gst_rtsp_message_get_header (const GstRTSPMessage * msg,
   if (msg->hdr_fields == NULL)
     return GST_RTSP_ENOTIMPL;
 
-  for (i = 0; i < msg->hdr_fields->len; i++) {
-    RTSPKeyValue *key_value = &g_array_index (msg->hdr_fields, RTSPKeyValue, i);
+  if (HDR_IS_INDEXED (field)) {
+    RTSPHeaderIndex *idx = HDR_INDEX (msg->hdr_fields);
+
+    if (!HDR_IS_PRESENT (idx, field))
+      return GST_RTSP_ENOTIMPL;
+
+    /* start at the first header with this field */
+    if (idx->first[field] != 0)
+      i = idx->first[field] - 1;
+  }
+
+  for (; i < HDR_N_FIELDS (msg->hdr_fields); i++) {
+    RTSPKeyValue *key_value = HDR_FIELD (msg->hdr_fields, i);
 
     if (key_value->field == field && cnt++ == indx) {
       if (value)
@@ -633,19 +713,46 @@ gst_rtsp_message_get_header (const GstRTSPMessage * msg,
 GstRTSPResult
 gst_rtsp_message_append_headers (const GstRTSPMessage * msg, GString * str)
 {
-  guint i;
+  guint i, n_fields;
+  gsize len, size = 0;
+  gchar *dest;
 
   g_return_val_if_fail (msg != NULL, GST_RTSP_EINVAL);
   g_return_val_if_fail (str != NULL, GST_RTSP_EINVAL);
 
-  for (i = 0; i < msg->hdr_fields->len; i++) {
-    RTSPKeyValue *key_value;
-    const gchar *keystr;
+  n_fields = HDR_N_FIELDS (msg->hdr_fields);
+
+  /* first calculate the size so that the string is only grown once */
+  for (i = 0; i < n_fields; i++) {
+    RTSPKeyValue *key_value = HDR_FIELD (msg->hdr_fields, i);
+    const gchar *keystr = gst_rtsp_header_as_text (key_value->field);
 
-    key_value = &g_array_index (msg->hdr_fields, RTSPKeyValue, i);
-    keystr = gst_rtsp_header_as_text (key_value->field);
+    if (G_UNLIKELY (keystr == NULL))
+      keystr = "(null)";
+    size += strlen (keystr) + strlen (key_value->value) + 4;
+  }
 
-    g_string_append_printf (str, "%s: %s\r\n", keystr, key_value->value);
+  len = str->len;
+  g_string_set_size (str, len + size);
+  dest = str->str + len;
+
+  for (i = 0; i < n_fields; i++) {
+    RTSPKeyValue *key_value = HDR_FIELD (msg->hdr_fields, i);
+    const gchar *keystr = gst_rtsp_header_as_text (key_value->field);
+
+    if (G_UNLIKELY (keystr == NULL))
+      keystr = "(null)";
+
+    len = strlen (keystr);
+    memcpy (dest, keystr, len);
+    dest += len;
+    *dest++ = ':';
+    *dest++ = ' ';
+    len = strlen (key_value->value);
+    memcpy (dest, key_value->value, len);
+    dest += len;
+    *dest++ = '\r';
+    *dest++ = '\n';
   }
   return GST_RTSP_OK;
 }
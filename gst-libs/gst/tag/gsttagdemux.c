@@ -65,6 +65,13 @@
  *  </para></listitem>
  * </itemizedlist>
  * </para>
+ * <para>
+ * Subclasses may implement the parse_tag_lazy and load_deferred_tags vfuncs
+ * to support the #GstTagDemux:lazy-tags property. With the property set, the
+ * start tag is handed to parse_tag_lazy, which may leave out large parts
+ * such as attached pictures and only remember where they are. Applications
+ * can load those later with gst_tag_demux_load_deferred_tags().
+ * </para>
  * </refsect2>
  */
 
@@ -73,6 +80,7 @@
 #endif
 
 #include "gsttagdemux.h"
+#include "tag.h"
 
 #include <gst/base/gsttypefindhelper.h>
 #include <gst/gst-i18n-plugin.h>
@@ -113,8 +121,18 @@ struct _GstTagDemuxPrivate
   gboolean newseg_update;
 
   GList *pending_events;
+
+  gboolean lazy_tags;
 };
 
+enum
+{
+  PROP_0,
+  PROP_LAZY_TAGS
+};
+
+#define DEFAULT_LAZY_TAGS FALSE
+
 /* Require at least 8kB of data before we attempt typefind. 
  * Seems a decent value based on test files
  * 40kB is massive overkill for the maximum, I think, but it 
@@ -133,6 +151,10 @@ static GstStaticPadTemplate src_factory = GST_STATIC_PAD_TEMPLATE ("src",
     );
 
 static void gst_tag_demux_dispose (GObject * object);
+static void gst_tag_demux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_tag_demux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 static GstFlowReturn gst_tag_demux_chain (GstPad * pad, GstBuffer * buf);
 static gboolean gst_tag_demux_sink_event (GstPad * pad, GstEvent * event);
@@ -230,6 +252,25 @@ gst_tag_demux_class_init (gpointer klass, gpointer d)
   parent_class = g_type_class_peek_parent (klass);
 
   gobject_class->dispose = gst_tag_demux_dispose;
+  gobject_class->set_property = gst_tag_demux_set_property;
+  gobject_class->get_property = gst_tag_demux_get_property;
+
+  /**
+   * GstTagDemux:lazy-tags:
+   *
+   * Only remember the position of large parts of the start tag, such as
+   * attached pictures, instead of reading and parsing them before the source
+   * pad is added. Use gst_tag_demux_load_deferred_tags() to load them later.
+   * This only has an effect when upstream supports pull mode and the
+   * subclass implements the parse_tag_lazy vfunc.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_LAZY_TAGS,
+      g_param_spec_boolean ("lazy-tags", "Lazy tags",
+          "Index large binary parts of the start tag (such as pictures) "
+          "instead of parsing them", DEFAULT_LAZY_TAGS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   element_class->change_state = GST_DEBUG_FUNCPTR (gst_tag_demux_change_state);
 
@@ -285,6 +326,8 @@ gst_tag_demux_init (GstTagDemux * demux, GstTagDemuxClass * gclass)
   demux->priv = g_type_instance_get_private ((GTypeInstance *) demux,
       GST_TYPE_TAG_DEMUX);
 
+  demux->priv->lazy_tags = DEFAULT_LAZY_TAGS;
+
   tmpl = gst_element_class_get_pad_template (element_klass, "sink");
   if (tmpl) {
     demux->priv->sinkpad = gst_pad_new_from_template (tmpl, "sink");
@@ -311,6 +354,42 @@ gst_tag_demux_dispose (GObject * object)
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
 
+static void
+gst_tag_demux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstTagDemux *demux = GST_TAG_DEMUX (object);
+
+  switch (prop_id) {
+    case PROP_LAZY_TAGS:
+      GST_OBJECT_LOCK (demux);
+      demux->priv->lazy_tags = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (demux);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_tag_demux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstTagDemux *demux = GST_TAG_DEMUX (object);
+
+  switch (prop_id) {
+    case PROP_LAZY_TAGS:
+      GST_OBJECT_LOCK (demux);
+      g_value_set_boolean (value, demux->priv->lazy_tags);
+      GST_OBJECT_UNLOCK (demux);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 static gboolean
 gst_tag_demux_add_srcpad (GstTagDemux * tagdemux, GstCaps * new_caps)
 {
@@ -1001,6 +1080,34 @@ done:
   return res;
 }
 
+/* let the subclass parse the start tag without the parts it defers,
+ * returns FALSE if the complete tag has to be read instead */
+static gboolean
+gst_tag_demux_pull_start_tag_lazy (GstTagDemux * demux, GstBuffer * start,
+    guint tagsize, GstTagList ** tags)
+{
+  GstTagDemuxClass *klass = GST_TAG_DEMUX_CLASS (G_OBJECT_GET_CLASS (demux));
+  GstTagDemuxResult parse_ret;
+  GstTagList *new_tags = NULL;
+
+  if (klass->parse_tag_lazy == NULL)
+    return FALSE;
+
+  parse_ret = klass->parse_tag_lazy (demux, start, tagsize, &new_tags);
+  if (parse_ret != GST_TAG_DEMUX_RESULT_OK) {
+    GST_DEBUG_OBJECT (demux, "could not parse the start tag lazily");
+    if (new_tags)
+      gst_tag_list_free (new_tags);
+    return FALSE;
+  }
+
+  /* the subclass did not read all of the tag, but it is skipped anyway */
+  demux->priv->strip_start = tagsize;
+  *tags = new_tags;
+
+  return TRUE;
+}
+
 /* Read and interpret any tag at the start when activating in
  * pull_range. Returns FALSE if pad activation should fail. */
 static gboolean
@@ -1011,7 +1118,7 @@ gst_tag_demux_pull_start_tag (GstTagDemux * demux, GstTagList ** tags)
   GstFlowReturn flow_ret;
   GstTagList *new_tags = NULL;
   GstBuffer *buffer = NULL;
-  gboolean have_tag;
+  gboolean have_tag, lazy_tags;
   gboolean res = FALSE;
   guint req, tagsize;
 
@@ -1052,6 +1159,16 @@ gst_tag_demux_pull_start_tag (GstTagDemux * demux, GstTagList ** tags)
 
   GST_DEBUG_OBJECT (demux, "Identified start tag, size = %u bytes", tagsize);
 
+  GST_OBJECT_LOCK (demux);
+  lazy_tags = demux->priv->lazy_tags;
+  GST_OBJECT_UNLOCK (demux);
+
+  if (lazy_tags &&
+      gst_tag_demux_pull_start_tag_lazy (demux, buffer, tagsize, tags)) {
+    res = TRUE;
+    goto done;
+  }
+
   do {
     guint newsize, saved_size;
 
@@ -1534,3 +1651,42 @@ gst_tag_demux_send_new_segment (GstTagDemux * tagdemux)
       seg->rate, seg->applied_rate, seg->format, start, stop, position);
   return gst_pad_push_event (tagdemux->priv->srcpad, event);
 }
+
+/**
+ * gst_tag_demux_load_deferred_tags:
+ * @demux: a #GstTagDemux
+ *
+ * Reads and parses the parts of the start tag that were skipped because
+ * the #GstTagDemux:lazy-tags property was set, such as attached pictures.
+ * This calls the load_deferred_tags vfunc, subclasses that don't implement
+ * it never defer anything and this function returns NULL for them.
+ *
+ * This reads from upstream and only works while @demux operates in pull
+ * mode. It is safe to call from the application thread.
+ *
+ * Returns: a new #GstTagList with the deferred tags, or NULL if nothing was
+ *     deferred or the tags could not be read. Free with gst_tag_list_free()
+ *     when done.
+ *
+ * Since: 0.10.37
+ */
+GstTagList *
+gst_tag_demux_load_deferred_tags (GstTagDemux * demux)
+{
+  GstTagDemuxClass *klass;
+
+  g_return_val_if_fail (GST_IS_TAG_DEMUX (demux), NULL);
+
+  klass = GST_TAG_DEMUX_CLASS (G_OBJECT_GET_CLASS (demux));
+  if (klass->load_deferred_tags == NULL) {
+    GST_DEBUG_OBJECT (demux, "subclass does not defer tags");
+    return NULL;
+  }
+
+  if (GST_PAD_ACTIVATE_MODE (demux->priv->sinkpad) != GST_ACTIVATE_PULL) {
+    GST_DEBUG_OBJECT (demux, "can't read deferred tags in push mode");
+    return NULL;
+  }
+
+  return klass->load_deferred_tags (demux);
+}
@@ -94,6 +94,15 @@ struct _GstTagDemux
  * vfunc to allow prioritising of start or end tag according to user
  * preference.  Note that both start_tags and end_tags may be NULL. By default
  * start tags are prefered over end tags.
+ * @parse_tag_lazy: parse the start tag without reading its large parts, such
+ * as attached pictures, and remember where they are (optional). The buffer
+ * holds at least the first min_start_size bytes of the tag, which is
+ * tag_size bytes long; further data can be pulled from the sink pad. Return
+ * anything but GST_TAG_DEMUX_RESULT_OK to have the complete tag read and
+ * passed to parse_tag instead. Since: 0.10.37
+ * @load_deferred_tags: read and parse the parts of the start tag that were
+ * left out by parse_tag_lazy, only called in pull mode and possibly from
+ * another thread (optional). Since: 0.10.37
  *
  * The #GstTagDemuxClass structure.  See documentation at beginning of section
  * for details about what subclasses need to override and do.
@@ -132,12 +141,23 @@ struct _GstTagDemuxClass
                                            const GstTagList * start_tags,
                                            const GstTagList * end_tags);
 
+  /* parse the start tag without its large parts (optional) */
+  GstTagDemuxResult      (*parse_tag_lazy)     (GstTagDemux * demux,
+                                                GstBuffer   * buffer,
+                                                guint         tag_size,
+                                                GstTagList ** tags);
+
+  /* load the parts left out by parse_tag_lazy (optional) */
+  GstTagList *           (*load_deferred_tags) (GstTagDemux * demux);
+
   /*< private >*/
-  gpointer               reserved[GST_PADDING];
+  gpointer               reserved[GST_PADDING - 2];
 };
 
 GType     gst_tag_demux_get_type (void);
 
+GstTagList * gst_tag_demux_load_deferred_tags (GstTagDemux * demux);
+
 G_END_DECLS
 
 #endif /* __GST_TAG_DEMUX_H__ */
@@ -130,30 +130,53 @@ gst_tag_get_id3v2_tag_size (GstBuffer * buffer)
 }
 
 guint8 *
-id3v2_ununsync_data (const guint8 * unsync_data, guint32 * size)
+id3v2_get_scratch (ID3TagsWorking * work, guint slot, guint size)
 {
-  const guint8 *end;
+  g_assert (slot < ID3V2_N_SCRATCH);
+
+  /* the arena only grows, so that it can be reused for all frames */
+  if (size > work->scratch_size[slot]) {
+    g_free (work->scratch[slot]);
+    work->scratch[slot] = g_malloc (size);
+    work->scratch_size[slot] = size;
+  }
+  return work->scratch[slot];
+}
+
+guint8 *
+id3v2_ununsync_frame (ID3TagsWorking * work, guint8 * data, guint * size)
+{
+  const guint8 *p, *end, *ff;
   guint8 *out, *uu;
-  guint out_size;
 
-  uu = out = g_malloc (*size);
+  /* most frames don't contain any 0xff bytes, nothing to do then */
+  if (memchr (data, 0xff, *size) == NULL)
+    return data;
 
-  for (end = unsync_data + *size; unsync_data < end - 1; ++unsync_data, ++uu) {
-    *uu = *unsync_data;
-    if (G_UNLIKELY (*unsync_data == 0xff && *(unsync_data + 1) == 0x00))
-      ++unsync_data;
-  }
+  uu = out = id3v2_get_scratch (work, ID3V2_SCRATCH_UNSYNC, *size);
+  p = data;
+  end = data + *size;
 
-  /* take care of last byte (if last two bytes weren't 0xff 0x00) */
-  if (unsync_data < end) {
-    *uu = *unsync_data;
-    ++uu;
+  while (p < end) {
+    ff = memchr (p, 0xff, end - p);
+    if (ff == NULL) {
+      memcpy (uu, p, end - p);
+      uu += end - p;
+      break;
+    }
+    memcpy (uu, p, ff - p + 1);
+    uu += ff - p + 1;
+    p = ff + 1;
+
+    /* skip the 0x00 that follows a 0xff */
+    if (p < end && *p == 0x00)
+      ++p;
   }
 
-  out_size = uu - out;
-  GST_DEBUG ("size after un-unsyncing: %u (before: %u)", out_size, *size);
+  GST_DEBUG ("size after un-unsyncing: %u (before: %u)", (guint) (uu - out),
+      *size);
 
-  *size = out_size;
+  *size = uu - out;
   return out;
 }
 
@@ -172,8 +195,8 @@ id3v2_ununsync_data (const guint8 * unsync_data, guint32 * size)
 GstTagList *
 gst_tag_list_from_id3v2_tag (GstBuffer * buffer)
 {
-  guint8 *data, *uu_data = NULL;
-  guint read_size;
+  guint8 *data;
+  guint read_size, i;
   ID3TagsWorking work;
   guint8 flags;
   guint16 version;
@@ -233,18 +256,17 @@ gst_tag_list_from_id3v2_tag (GstBuffer * buffer)
 
   /* in v2.3 the frame sizes are not syncsafe, so the entire tag had to be
    * unsynced. In v2.4 the frame sizes are syncsafe so it's just the frame
-   * data that needs un-unsyncing, but not the frame headers. */
+   * data that needs un-unsyncing, but not the frame headers. The entire tag
+   * is not un-unsynced up front but frame by frame while scanning it. */
   if ((flags & ID3V2_HDR_FLAG_UNSYNC) != 0 && ID3V2_VER_MAJOR (version) <= 3) {
     GST_DEBUG ("Un-unsyncing entire tag");
-    uu_data = id3v2_ununsync_data (work.hdr.frame_data,
-        &work.hdr.frame_data_size);
-    work.hdr.frame_data = uu_data;
-    GST_MEMDUMP ("ID3v2 tag (un-unsyced)", uu_data, work.hdr.frame_data_size);
+    work.unsync = TRUE;
   }
 
   id3v2_frames_to_tag_list (&work, work.hdr.frame_data_size);
 
-  g_free (uu_data);
+  for (i = 0; i < ID3V2_N_SCRATCH; i++)
+    g_free (work.scratch[i]);
 
   return work.tags;
 }
@@ -367,7 +389,7 @@ id3v2_add_id3v2_frame_blob_to_taglist (ID3TagsWorking * work, guint size)
   GstBuffer *blob;
   GstCaps *caps;
   guint8 *frame_data;
-  gchar *media_type;
+  gchar *media_type, id[4];
   guint frame_size, header_size;
   guint i;
 
@@ -390,15 +412,17 @@ id3v2_add_id3v2_frame_blob_to_taglist (ID3TagsWorking * work, guint size)
   blob = gst_buffer_new_and_alloc (frame_size);
   memcpy (GST_BUFFER_DATA (blob), frame_data, frame_size);
 
-  /* Sanitize frame id */
+  /* Sanitize frame id, the frame data may be the tag buffer itself */
   for (i = 0; i < 4; i++) {
-    if (!g_ascii_isalnum (frame_data[i]))
-      frame_data[i] = '_';
+    if (g_ascii_isalnum (frame_data[i]))
+      id[i] = frame_data[i];
+    else
+      id[i] = '_';
   }
 
   media_type = g_strdup_printf ("application/x-gst-id3v2-%c%c%c%c-frame",
-      g_ascii_tolower (frame_data[0]), g_ascii_tolower (frame_data[1]),
-      g_ascii_tolower (frame_data[2]), g_ascii_tolower (frame_data[3]));
+      g_ascii_tolower (id[0]), g_ascii_tolower (id[1]),
+      g_ascii_tolower (id[2]), g_ascii_tolower (id[3]));
   caps = gst_caps_new_simple (media_type, "version", G_TYPE_INT,
       (gint) ID3V2_VER_MAJOR (work->hdr.version), NULL);
   gst_buffer_set_caps (blob, caps);
@@ -412,81 +436,146 @@ id3v2_add_id3v2_frame_blob_to_taglist (ID3TagsWorking * work, guint size)
   gst_buffer_unref (blob);
 }
 
+/* Reads @size bytes of frame data from @data, which has @avail bytes left,
+ * into @out (if not NULL). Unsynchronisation of the whole tag is undone on
+ * the way. The number of bytes consumed from @data is stored in @consumed.
+ * Returns FALSE if there is not enough data. */
+static gboolean
+id3v2_read_frame_data (ID3TagsWorking * work, const guint8 * data, guint avail,
+    guint8 * out, guint size, guint * consumed)
+{
+  const guint8 *p = data, *end = data + avail;
+
+  if (!work->unsync) {
+    if (size > avail)
+      return FALSE;
+    if (out)
+      memcpy (out, data, size);
+    *consumed = size;
+    return TRUE;
+  }
+
+  while (size > 0) {
+    const guint8 *ff;
+    guint n;
+
+    n = MIN (size, end - p);
+    if (n == 0)
+      return FALSE;
+
+    ff = memchr (p, 0xff, n);
+    if (ff != NULL)
+      n = ff - p + 1;
+    if (out) {
+      memcpy (out, p, n);
+      out += n;
+    }
+    p += n;
+    size -= n;
+
+    /* skip the 0x00 that follows a 0xff */
+    if (ff != NULL && p < end && *p == 0x00)
+      ++p;
+  }
+
+  *consumed = p - data;
+  return TRUE;
+}
+
 static gboolean
 id3v2_frames_to_tag_list (ID3TagsWorking * work, guint size)
 {
-  guint frame_hdr_size;
-  guint8 *start;
+  guint frame_hdr_size, avail, consumed;
+  guint8 *start, *data;
+
+  /* Raw frame data, un-unsynced frame by frame when needed */
+  data = work->hdr.frame_data;
+  avail = work->hdr.frame_data_size;
 
   /* Extended header if present */
   if (work->hdr.flags & ID3V2_HDR_FLAG_EXTHDR) {
-    work->hdr.ext_hdr_size = id3v2_read_synch_uint (work->hdr.frame_data, 4);
-    if (work->hdr.ext_hdr_size < 6 ||
-        (work->hdr.ext_hdr_size) > work->hdr.frame_data_size) {
+    guint8 ext_hdr[5];
+
+    if (!id3v2_read_frame_data (work, data, avail, ext_hdr, 5, &consumed)) {
       GST_DEBUG ("Invalid extended header. Broken tag");
       return FALSE;
     }
-    work->hdr.ext_flag_bytes = work->hdr.frame_data[4];
-    if (5 + work->hdr.ext_flag_bytes > work->hdr.frame_data_size) {
+    work->hdr.ext_hdr_size = id3v2_read_synch_uint (ext_hdr, 4);
+    if (work->hdr.ext_hdr_size < 6 || (work->hdr.ext_hdr_size) > avail) {
+      GST_DEBUG ("Invalid extended header. Broken tag");
+      return FALSE;
+    }
+    work->hdr.ext_flag_bytes = ext_hdr[4];
+    if (5 + work->hdr.ext_flag_bytes > avail) {
       GST_DEBUG
           ("Tag claims extended header, but doesn't have enough bytes. Broken tag");
       return FALSE;
     }
 
-    work->hdr.ext_flag_data = work->hdr.frame_data + 5;
-    work->hdr.frame_data += work->hdr.ext_hdr_size;
-    work->hdr.frame_data_size -= work->hdr.ext_hdr_size;
+    work->hdr.ext_flag_data = data + consumed;
+    if (!id3v2_read_frame_data (work, data, avail, NULL,
+            work->hdr.ext_hdr_size, &consumed)) {
+      GST_DEBUG ("Invalid extended header. Broken tag");
+      return FALSE;
+    }
+    data += consumed;
+    avail -= consumed;
   }
 
   start = GST_BUFFER_DATA (work->buffer);
   frame_hdr_size = id3v2_frame_hdr_size (work->hdr.version);
-  if (work->hdr.frame_data_size <= frame_hdr_size) {
+  if (avail <= frame_hdr_size) {
     GST_DEBUG ("Tag has no data frames. Broken tag");
     return FALSE;               /* Must have at least one frame */
   }
 
   work->tags = gst_tag_list_new ();
 
-  while (work->hdr.frame_data_size > frame_hdr_size) {
+  while (avail > frame_hdr_size) {
     guint frame_size = 0;
     gchar frame_id[5] = "";
     guint16 frame_flags = 0x0;
     gboolean obsolete_id = FALSE;
     gboolean read_synch_size = TRUE;
+    guint8 frame_hdr[10], *frame;
+    guint hdr_consumed, body_consumed;
     guint i;
 
+    if (!id3v2_read_frame_data (work, data, avail, frame_hdr, frame_hdr_size,
+            &hdr_consumed))
+      break;
+
     /* Read the header */
     switch (ID3V2_VER_MAJOR (work->hdr.version)) {
       case 0:
       case 1:
       case 2:
-        frame_id[0] = work->hdr.frame_data[0];
-        frame_id[1] = work->hdr.frame_data[1];
-        frame_id[2] = work->hdr.frame_data[2];
+        frame_id[0] = frame_hdr[0];
+        frame_id[1] = frame_hdr[1];
+        frame_id[2] = frame_hdr[2];
         frame_id[3] = 0;
         frame_id[4] = 0;
         obsolete_id = convert_fid_to_v240 (frame_id);
 
         /* 3 byte non-synchsafe size */
-        frame_size = work->hdr.frame_data[3] << 16 |
-            work->hdr.frame_data[4] << 8 | work->hdr.frame_data[5];
+        frame_size = frame_hdr[3] << 16 | frame_hdr[4] << 8 | frame_hdr[5];
         frame_flags = 0;
         break;
       case 3:
         read_synch_size = FALSE;        /* 2.3 frame size is not synch-safe */
       case 4:
       default:
-        frame_id[0] = work->hdr.frame_data[0];
-        frame_id[1] = work->hdr.frame_data[1];
-        frame_id[2] = work->hdr.frame_data[2];
-        frame_id[3] = work->hdr.frame_data[3];
+        frame_id[0] = frame_hdr[0];
+        frame_id[1] = frame_hdr[1];
+        frame_id[2] = frame_hdr[2];
+        frame_id[3] = frame_hdr[3];
         frame_id[4] = 0;
         if (read_synch_size)
-          frame_size = id3v2_read_synch_uint (work->hdr.frame_data + 4, 4);
+          frame_size = id3v2_read_synch_uint (frame_hdr + 4, 4);
         else
-          frame_size = GST_READ_UINT32_BE (work->hdr.frame_data + 4);
+          frame_size = GST_READ_UINT32_BE (frame_hdr + 4);
 
-        frame_flags = GST_READ_UINT16_BE (work->hdr.frame_data + 8);
+        frame_flags = GST_READ_UINT16_BE (frame_hdr + 8);
 
         if (ID3V2_VER_MAJOR (work->hdr.version) == 3) {
           frame_flags &= ID3V2_3_FRAME_FLAGS_MASK;
@@ -497,12 +586,34 @@ id3v2_frames_to_tag_list (ID3TagsWorking * work, guint size)
         break;
     }
 
-    work->hdr.frame_data += frame_hdr_size;
-    work->hdr.frame_data_size -= frame_hdr_size;
-
-    if (frame_size > work->hdr.frame_data_size || strcmp (frame_id, "") == 0)
+    if (strcmp (frame_id, "") == 0)
       break;                    /* No more frames to read */
 
+    if (obsolete_id) {
+      /* just skip over it */
+      frame = NULL;
+      if (!id3v2_read_frame_data (work, data + hdr_consumed,
+              avail - hdr_consumed, NULL, frame_size, &body_consumed))
+        break;
+    } else if (!work->unsync || (hdr_consumed == frame_hdr_size &&
+            frame_size <= avail - hdr_consumed &&
+            memchr (data + hdr_consumed, 0xff, frame_size) == NULL)) {
+      /* nothing to un-unsync, use the frame in place */
+      if (frame_size > avail - hdr_consumed)
+        break;
+      frame = data;
+      body_consumed = frame_size;
+    } else {
+      /* un-unsync header and data into the scratch buffer */
+      frame = id3v2_get_scratch (work, ID3V2_SCRATCH_FRAME,
+          frame_hdr_size + frame_size);
+      memcpy (frame, frame_hdr, frame_hdr_size);
+      if (!id3v2_read_frame_data (work, data + hdr_consumed,
+              avail - hdr_consumed, frame + frame_hdr_size, frame_size,
+              &body_consumed))
+        break;
+    }
+
     /* Sanitize frame id */
     switch (ID3V2_VER_MAJOR (work->hdr.version)) {
       case 0:
@@ -522,11 +633,9 @@ id3v2_frames_to_tag_list (ID3TagsWorking * work, guint size)
 #if 1
     GST_LOG
         ("Frame @ %ld (0x%02lx) id %s size %u, next=%ld (0x%02lx) obsolete=%d",
-        (glong) (work->hdr.frame_data - start),
-        (glong) (work->hdr.frame_data - start), frame_id, frame_size,
-        (glong) (work->hdr.frame_data + frame_hdr_size + frame_size - start),
-        (glong) (work->hdr.frame_data + frame_hdr_size + frame_size - start),
-        obsolete_id);
+        (glong) (data - start), (glong) (data - start), frame_id, frame_size,
+        (glong) (data + hdr_consumed + body_consumed - start),
+        (glong) (data + hdr_consumed + body_consumed - start), obsolete_id);
 #define flag_string(flag,str) \
         ((frame_flags & (flag)) ? (str) : "")
     GST_LOG ("Frame header flags: 0x%04x %s %s %s %s %s %s %s", frame_flags,
@@ -543,6 +652,8 @@ id3v2_frames_to_tag_list (ID3TagsWorking * work, guint size)
     if (!obsolete_id) {
       /* Now, read, decompress etc the contents of the frame
        * into a TagList entry */
+      work->hdr.frame_data = frame + frame_hdr_size;
+      work->hdr.frame_data_size = frame_size;
       work->cur_frame_size = frame_size;
       work->frame_id = frame_id;
       work->frame_flags = frame_flags;
@@ -554,8 +665,9 @@ id3v2_frames_to_tag_list (ID3TagsWorking * work, guint size)
         id3v2_add_id3v2_frame_blob_to_taglist (work, frame_size);
       }
     }
-    work->hdr.frame_data += frame_size;
-    work->hdr.frame_data_size -= frame_size;
+
+    data += hdr_consumed + body_consumed;
+    avail -= hdr_consumed + body_consumed;
   }
 
   if (gst_structure_n_fields (GST_STRUCTURE (work->tags)) == 0) {
@@ -47,6 +47,14 @@ typedef struct {
   guint8 *ext_flag_data;  
 } ID3v2Header;
 
+/* Reusable scratch buffers, see id3v2_get_scratch() */
+enum {
+  ID3V2_SCRATCH_FRAME,    /* frame un-unsynced with the whole tag */
+  ID3V2_SCRATCH_UNSYNC,   /* frame data un-unsynced by itself (v2.4) */
+  ID3V2_SCRATCH_INFLATE,  /* decompressed frame data */
+  ID3V2_N_SCRATCH
+};
+
 typedef struct {
   ID3v2Header hdr;
   
@@ -64,6 +72,12 @@ typedef struct {
   /* To collect day/month from obsolete TDAT frame if it exists */
   guint pending_month;
   guint pending_day;
+
+  /* v2.3 and older: the entire tag is unsynced */
+  gboolean unsync;
+
+  guint8 *scratch[ID3V2_N_SCRATCH];
+  guint scratch_size[ID3V2_N_SCRATCH];
 } ID3TagsWorking;
 
 enum {
@@ -111,7 +125,9 @@ enum {
 /* From id3v2frames.c */
 gboolean id3v2_parse_frame (ID3TagsWorking *work);
 
-guint8 * id3v2_ununsync_data (const guint8 * unsync_data, guint32 * size);
+guint8 * id3v2_get_scratch (ID3TagsWorking *work, guint slot, guint size);
+
+guint8 * id3v2_ununsync_frame (ID3TagsWorking *work, guint8 *data, guint *size);
 
 GstDebugCategory * id3v2_ensure_debug_category (void);
 
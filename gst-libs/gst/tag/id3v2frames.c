@@ -75,11 +75,6 @@ id3v2_parse_frame (ID3TagsWorking * work)
   guint frame_data_size = work->cur_frame_size;
   gchar *tag_str = NULL;
   GArray *tag_fields = NULL;
-  guint8 *uu_data = NULL;
-
-#ifdef HAVE_ZLIB
-  guint8 *uncompressed_data = NULL;
-#endif
 
   /* Check that the frame id is valid */
   for (i = 0; i < 5 && work->frame_id[i] != '\0'; i++) {
@@ -108,7 +103,7 @@ id3v2_parse_frame (ID3TagsWorking * work)
 
   if (work->frame_flags & (ID3V2_FRAME_FORMAT_COMPRESSION |
           ID3V2_FRAME_FORMAT_DATA_LENGTH_INDICATOR)) {
-    if (work->hdr.frame_data_size <= 4)
+    if (frame_data_size <= 4)
       return FALSE;
     if (ID3V2_VER_MAJOR (work->hdr.version) == 3) {
       work->parse_size = GST_READ_UINT32_BE (frame_data);
@@ -133,8 +128,7 @@ id3v2_parse_frame (ID3TagsWorking * work)
     if ((work->hdr.flags & ID3V2_HDR_FLAG_UNSYNC) != 0 ||
         ((work->frame_flags & ID3V2_FRAME_FORMAT_UNSYNCHRONISATION) != 0)) {
       GST_DEBUG ("Un-unsyncing frame %s", work->frame_id);
-      uu_data = id3v2_ununsync_data (frame_data, &frame_data_size);
-      frame_data = uu_data;
+      frame_data = id3v2_ununsync_frame (work, frame_data, &frame_data_size);
       GST_MEMDUMP ("ID3v2 frame (un-unsyced)", frame_data, frame_data_size);
     }
   }
@@ -146,29 +140,22 @@ id3v2_parse_frame (ID3TagsWorking * work)
     uLongf destSize = work->parse_size;
     Bytef *dest, *src;
 
-    uncompressed_data = g_malloc (work->parse_size);
-
-    dest = (Bytef *) uncompressed_data;
+    dest = (Bytef *) id3v2_get_scratch (work, ID3V2_SCRATCH_INFLATE,
+        work->parse_size);
     src = (Bytef *) frame_data;
 
-    if (uncompress (dest, &destSize, src, frame_data_size) != Z_OK) {
-      g_free (uncompressed_data);
-      g_free (uu_data);
+    if (uncompress (dest, &destSize, src, frame_data_size) != Z_OK)
       return FALSE;
-    }
     if (destSize != work->parse_size) {
       GST_WARNING
           ("Decompressing ID3v2 frame %s did not produce expected size %d bytes (got %lu)",
           tag_name, work->parse_size, destSize);
-      g_free (uncompressed_data);
-      g_free (uu_data);
       return FALSE;
     }
-    work->parse_data = uncompressed_data;
+    work->parse_data = (guint8 *) dest;
 #else
     GST_WARNING ("Compressed ID3v2 tag frame could not be decompressed, because"
         " libgsttag-" GST_MAJORMINOR " was compiled without zlib support");
-    g_free (uu_data);
     return FALSE;
 #endif
   } else {
@@ -202,13 +189,8 @@ id3v2_parse_frame (ID3TagsWorking * work)
     /* Unique file identifier */
     tag_str = parse_unique_file_identifier (work, &tag_name);
   }
-#ifdef HAVE_ZLIB
-  if (work->frame_flags & ID3V2_FRAME_FORMAT_COMPRESSION) {
-    g_free (uncompressed_data);
-    uncompressed_data = NULL;
+  if (work->frame_flags & ID3V2_FRAME_FORMAT_COMPRESSION)
     work->parse_data = frame_data;
-  }
-#endif
 
   if (tag_str != NULL) {
     /* g_print ("Tag %s value %s\n", tag_name, tag_str); */
@@ -231,8 +213,6 @@ id3v2_parse_frame (ID3TagsWorking * work)
     free_tag_strings (tag_fields);
   }
 
-  g_free (uu_data);
-
   return result;
 }
 
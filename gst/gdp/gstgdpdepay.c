@@ -30,6 +30,11 @@
  * ]| This pipeline plays back a serialized video stream as created in the
  * example for gdppay.
  * </refsect2>
+ *
+ * Buffer payloads are pushed as subbuffers of the incoming data whenever a
+ * payload is contained in a single incoming buffer. Set
+ * #GstGDPDepay:validate-crc to %FALSE to skip the checksum checks when the
+ * transport already guarantees the integrity of the data.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -42,9 +47,12 @@
 
 #include "gstgdpdepay.h"
 
+#define DEFAULT_VALIDATE_CRC TRUE
+
 enum
 {
   PROP_0,
+  PROP_VALIDATE_CRC,
 };
 
 static GstStaticPadTemplate gdp_depay_sink_template =
@@ -77,6 +85,11 @@ static GstFlowReturn gst_gdp_depay_chain (GstPad * pad, GstBuffer * buffer);
 static GstStateChangeReturn gst_gdp_depay_change_state (GstElement *
     element, GstStateChange transition);
 
+static void gst_gdp_depay_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_gdp_depay_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
 static void gst_gdp_depay_finalize (GObject * object);
 
 static void
@@ -104,6 +117,21 @@ gst_gdp_depay_class_init (GstGDPDepayClass * klass)
   gobject_class = (GObjectClass *) klass;
   gstelement_class = (GstElementClass *) klass;
 
+  gobject_class->set_property = gst_gdp_depay_set_property;
+  gobject_class->get_property = gst_gdp_depay_get_property;
+
+  /**
+   * GstGDPDepay:validate-crc:
+   *
+   * Verify the header and payload checksums of packets that carry them.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_VALIDATE_CRC,
+      g_param_spec_boolean ("validate-crc", "Validate CRC",
+          "Verify the header and payload checksums of the packets",
+          DEFAULT_VALIDATE_CRC, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_gdp_depay_change_state);
   gobject_class->finalize = gst_gdp_depay_finalize;
@@ -129,6 +157,7 @@ gst_gdp_depay_init (GstGDPDepay * gdpdepay, GstGDPDepayClass * g_class)
   gst_element_add_pad (GST_ELEMENT (gdpdepay), gdpdepay->srcpad);
 
   gdpdepay->adapter = gst_adapter_new ();
+  gdpdepay->validate_crc = DEFAULT_VALIDATE_CRC;
 }
 
 static void
@@ -139,13 +168,72 @@ gst_gdp_depay_finalize (GObject * gobject)
   this = GST_GDP_DEPAY (gobject);
   if (this->caps)
     gst_caps_unref (this->caps);
-  g_free (this->header);
   gst_adapter_clear (this->adapter);
   g_object_unref (this->adapter);
 
   GST_CALL_PARENT (G_OBJECT_CLASS, finalize, (gobject));
 }
 
+static void
+gst_gdp_depay_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstGDPDepay *this = GST_GDP_DEPAY (object);
+
+  switch (prop_id) {
+    case PROP_VALIDATE_CRC:
+      this->validate_crc = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_gdp_depay_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstGDPDepay *this = GST_GDP_DEPAY (object);
+
+  switch (prop_id) {
+    case PROP_VALIDATE_CRC:
+      g_value_set_boolean (value, this->validate_crc);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+/* make a buffer of the payload in the adapter and set its metadata from the
+ * header. The payload is a subbuffer of the incoming data when it is not
+ * spread over several incoming buffers. */
+static GstBuffer *
+gst_gdp_depay_buffer_from_payload (GstGDPDepay * this)
+{
+  const guint8 *header = this->header;
+  GstBuffer *buf;
+
+  if (this->payload_length > 0)
+    buf = gst_adapter_take_buffer (this->adapter, this->payload_length);
+  else
+    buf = gst_buffer_new ();
+  if (!buf)
+    return NULL;
+
+  /* the fields gst_dp_buffer_from_header() reads */
+  GST_BUFFER_TIMESTAMP (buf) = GST_READ_UINT64_BE (header + 10);
+  GST_BUFFER_DURATION (buf) = GST_READ_UINT64_BE (header + 18);
+  GST_BUFFER_OFFSET (buf) = GST_READ_UINT64_BE (header + 26);
+  GST_BUFFER_OFFSET_END (buf) = GST_READ_UINT64_BE (header + 34);
+  GST_BUFFER_FLAGS (buf) =
+      (GST_BUFFER_FLAGS (buf) & GST_MINI_OBJECT_FLAG_READONLY) |
+      GST_READ_UINT16_BE (header + 42);
+
+  return buf;
+}
+
 static gboolean
 gst_gdp_depay_sink_event (GstPad * pad, GstEvent * event)
 {
@@ -241,20 +329,19 @@ gst_gdp_depay_chain (GstPad * pad, GstBuffer * buffer)
         if (available < GST_DP_HEADER_LENGTH)
           goto done;
 
+        /* copy the header into our own storage, we need it to make the
+         * payload */
         GST_LOG_OBJECT (this, "reading GDP header from adapter");
-        header = gst_adapter_take (this->adapter, GST_DP_HEADER_LENGTH);
-        if (!gst_dp_validate_header (GST_DP_HEADER_LENGTH, header)) {
-          g_free (header);
+        header = this->header;
+        gst_adapter_copy (this->adapter, header, 0, GST_DP_HEADER_LENGTH);
+        gst_adapter_flush (this->adapter, GST_DP_HEADER_LENGTH);
+        if (this->validate_crc &&
+            !gst_dp_validate_header (GST_DP_HEADER_LENGTH, header))
           goto header_validate_error;
-        }
 
-        /* store types and payload length. Also store the header, which we need
-         * to make the payload. */
+        /* store types and payload length */
         this->payload_length = gst_dp_header_payload_length (header);
         this->payload_type = gst_dp_header_payload_type (header);
-        /* free previous header and store new one. */
-        g_free (this->header);
-        this->header = header;
 
         GST_LOG_OBJECT (this,
             "read GDP header, payload size %d, payload type %d, switching to state PAYLOAD",
@@ -285,7 +372,7 @@ gst_gdp_depay_chain (GstPad * pad, GstBuffer * buffer)
           goto wrong_type;
         }
 
-        if (this->payload_length
+        if (this->validate_crc && this->payload_length
             && (!gst_dp_validate_payload (GST_DP_HEADER_LENGTH, this->header,
                     gst_adapter_peek (this->adapter, this->payload_length)))) {
           goto payload_validate_error;
@@ -301,19 +388,10 @@ gst_gdp_depay_chain (GstPad * pad, GstBuffer * buffer)
           goto no_caps;
 
         GST_LOG_OBJECT (this, "reading GDP buffer from adapter");
-        buf = gst_dp_buffer_from_header (GST_DP_HEADER_LENGTH, this->header);
+        buf = gst_gdp_depay_buffer_from_payload (this);
         if (!buf)
           goto buffer_failed;
 
-        /* now take the payload if there is any */
-        if (this->payload_length > 0) {
-          guint8 *payload;
-
-          payload = gst_adapter_take (this->adapter, this->payload_length);
-          memcpy (GST_BUFFER_DATA (buf), payload, this->payload_length);
-          g_free (payload);
-        }
-
         /* set caps and push */
         gst_buffer_set_caps (buf, this->caps);
         GST_LOG_OBJECT (this, "deserialized buffer %p, pushing, timestamp %"
@@ -335,14 +413,14 @@ gst_gdp_depay_chain (GstPad * pad, GstBuffer * buffer)
       }
       case GST_GDP_DEPAY_STATE_CAPS:
       {
-        guint8 *payload;
+        const guint8 *payload;
 
-        /* take the payload of the caps */
+        /* parse the payload of the caps in place */
         GST_LOG_OBJECT (this, "reading GDP caps from adapter");
-        payload = gst_adapter_take (this->adapter, this->payload_length);
+        payload = gst_adapter_peek (this->adapter, this->payload_length);
         caps = gst_dp_caps_from_packet (GST_DP_HEADER_LENGTH, this->header,
             payload);
-        g_free (payload);
+        gst_adapter_flush (this->adapter, this->payload_length);
         if (!caps)
           goto caps_failed;
 
@@ -358,18 +436,19 @@ gst_gdp_depay_chain (GstPad * pad, GstBuffer * buffer)
       }
       case GST_GDP_DEPAY_STATE_EVENT:
       {
-        guint8 *payload;
+        const guint8 *payload;
 
         GST_LOG_OBJECT (this, "reading GDP event from adapter");
 
         /* adapter doesn't like 0 length payload */
         if (this->payload_length > 0)
-          payload = gst_adapter_take (this->adapter, this->payload_length);
+          payload = gst_adapter_peek (this->adapter, this->payload_length);
         else
           payload = NULL;
         event = gst_dp_event_from_packet (GST_DP_HEADER_LENGTH, this->header,
             payload);
-        g_free (payload);
+        if (this->payload_length > 0)
+          gst_adapter_flush (this->adapter, this->payload_length);
         if (!event)
           goto event_failed;
 
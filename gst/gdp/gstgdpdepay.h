@@ -63,9 +63,11 @@ struct _GstGDPDepay
   GstGDPDepayState state;
   GstCaps *caps;
 
-  guint8 *header;
+  guint8 header[GST_DP_HEADER_LENGTH];
   guint32 payload_length;
   GstDPPayloadType payload_type;
+
+  gboolean validate_crc;
 };
 
 struct _GstGDPDepayClass
@@ -30,12 +30,18 @@
  * ]| This pipeline creates a serialized video stream that can be played back
  * with the example shown in gdpdepay.
  * </refsect2>
+ *
+ * With #GstGDPPay:buffer-list enabled, the GDP header and the payload of a
+ * buffer are pushed as one group of a #GstBufferList instead of being copied
+ * into a single buffer.
  */
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
 
+#include <string.h>
+
 #include <gst/dataprotocol/dataprotocol.h>
 
 #include "gstgdppay.h"
@@ -58,6 +64,19 @@ GST_DEBUG_CATEGORY_STATIC (gst_gdp_pay_debug);
 #define DEFAULT_CRC_HEADER TRUE
 #define DEFAULT_CRC_PAYLOAD FALSE
 #define DEFAULT_VERSION GST_DP_VERSION_1_0
+#define DEFAULT_BUFFER_LIST FALSE
+
+/* number of buffer headers allocated at once */
+#define HEADER_POOL_SIZE 64
+
+/* the buffer flags the GDP header carries */
+#define HEADER_FLAGS_MASK (GST_BUFFER_FLAG_PREROLL | GST_BUFFER_FLAG_DISCONT | \
+    GST_BUFFER_FLAG_IN_CAPS | GST_BUFFER_FLAG_GAP | GST_BUFFER_FLAG_DELTA_UNIT)
+
+/* fields up to this offset are the same for all buffer headers */
+#define HEADER_CONST_LEN 6
+/* the header CRC covers everything but the two CRCs */
+#define HEADER_CRC_LEN 58
 
 enum
 {
@@ -65,8 +84,12 @@ enum
   PROP_CRC_HEADER,
   PROP_CRC_PAYLOAD,
   PROP_VERSION,
+  PROP_BUFFER_LIST,
 };
 
+/* table for the CRC-16/CCITT of gst_dp_crc(), filled in class_init */
+static guint16 gdp_crc_table[256];
+
 #define _do_init(x) \
     GST_DEBUG_CATEGORY_INIT (gst_gdp_pay_debug, "gdppay", 0, \
     "GDP payloader");
@@ -92,6 +115,31 @@ static void gst_gdp_pay_get_property (GObject * object, guint prop_id,
 
 static void gst_gdp_pay_finalize (GObject * gobject);
 
+static void
+gdp_crc_table_init (void)
+{
+  guint i, j;
+  guint16 crc;
+
+  for (i = 0; i < 256; i++) {
+    crc = i << 8;
+    for (j = 0; j < 8; j++)
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    gdp_crc_table[i] = crc;
+  }
+}
+
+/* continue the CRC in @crc over @length bytes; start with 0xffff and xor the
+ * result with 0xffff to get the value gst_dp_crc() computes */
+static inline guint16
+gdp_crc_update (guint16 crc, const guint8 * data, guint length)
+{
+  while (length--)
+    crc = (crc << 8) ^ gdp_crc_table[(crc >> 8) ^ *data++];
+
+  return crc;
+}
+
 static void
 gst_gdp_pay_base_init (gpointer g_class)
 {
@@ -135,6 +183,20 @@ gst_gdp_pay_class_init (GstGDPPayClass * klass)
           "Version of the GStreamer Data Protocol",
           GST_TYPE_DP_VERSION, DEFAULT_VERSION,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstGDPPay:buffer-list:
+   *
+   * Push the GDP header and the payload of a buffer as a group of a
+   * #GstBufferList, so that the payload does not have to be copied.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_class, PROP_BUFFER_LIST,
+      g_param_spec_boolean ("buffer-list", "Buffer List",
+          "Push the header and the payload of buffers in buffer lists",
+          DEFAULT_BUFFER_LIST, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gdp_crc_table_init ();
 
   gstelement_class->change_state = GST_DEBUG_FUNCPTR (gst_gdp_pay_change_state);
 }
@@ -160,6 +222,7 @@ gst_gdp_pay_init (GstGDPPay * gdppay, GstGDPPayClass * g_class)
   gdppay->crc_payload = DEFAULT_CRC_PAYLOAD;
   gdppay->header_flag = gdppay->crc_header | gdppay->crc_payload;
   gdppay->version = DEFAULT_VERSION;
+  gdppay->buffer_list = DEFAULT_BUFFER_LIST;
   gdppay->offset = 0;
 
   gdppay->packetizer = gst_dp_packetizer_new (gdppay->version);
@@ -207,6 +270,11 @@ gst_gdp_pay_reset (GstGDPPay * this)
     gst_buffer_unref (this->new_segment_buf);
     this->new_segment_buf = NULL;
   }
+  if (this->header_pool) {
+    gst_buffer_unref (this->header_pool);
+    this->header_pool = NULL;
+  }
+  this->have_template = FALSE;
   this->sent_streamheader = FALSE;
   this->offset = 0;
 }
@@ -255,23 +323,108 @@ packet_failed:
   }
 }
 
+/* fill the fields that are the same for all buffer headers from a header
+ * made by the packetizer */
+static gboolean
+gst_gdp_pay_make_template (GstGDPPay * this)
+{
+  GstBuffer *empty;
+  guint8 *header;
+  guint len;
+  gboolean ret;
+
+  empty = gst_buffer_new ();
+  ret = this->packetizer->header_from_buffer (empty, this->header_flag, &len,
+      &header);
+  gst_buffer_unref (empty);
+  if (!ret)
+    return FALSE;
+
+  if (len != GST_DP_HEADER_LENGTH) {
+    g_free (header);
+    return FALSE;
+  }
+
+  memcpy (this->header_template, header, GST_DP_HEADER_LENGTH);
+  g_free (header);
+
+  this->template_crc = gdp_crc_update (0xffff, this->header_template,
+      HEADER_CONST_LEN);
+  this->have_template = TRUE;
+
+  return TRUE;
+}
+
+/* make the GDP header of @buffer in the next free slot of the header pool.
+ * Only the fields that change between buffers are written over a copy of the
+ * template. */
 static GstBuffer *
-gst_gdp_pay_buffer_from_buffer (GstGDPPay * this, GstBuffer * buffer)
+gst_gdp_pay_header_from_buffer (GstGDPPay * this, GstBuffer * buffer)
 {
   GstBuffer *headerbuf;
+  guint8 *h;
+  guint16 crc;
+
+  if (G_UNLIKELY (!this->have_template) && !gst_gdp_pay_make_template (this))
+    goto no_template;
+
+  if (this->header_pool == NULL ||
+      this->header_pool_offset + GST_DP_HEADER_LENGTH >
+      GST_BUFFER_SIZE (this->header_pool)) {
+    if (this->header_pool)
+      gst_buffer_unref (this->header_pool);
+    this->header_pool =
+        gst_buffer_new_and_alloc (HEADER_POOL_SIZE * GST_DP_HEADER_LENGTH);
+    this->header_pool_offset = 0;
+  }
 
-  guint8 *header;
+  h = GST_BUFFER_DATA (this->header_pool) + this->header_pool_offset;
+  memcpy (h, this->header_template, GST_DP_HEADER_LENGTH);
 
-  guint len;
+  GST_WRITE_UINT32_BE (h + 6, GST_BUFFER_SIZE (buffer));
+  GST_WRITE_UINT64_BE (h + 10, GST_BUFFER_TIMESTAMP (buffer));
+  GST_WRITE_UINT64_BE (h + 18, GST_BUFFER_DURATION (buffer));
+  GST_WRITE_UINT64_BE (h + 26, GST_BUFFER_OFFSET (buffer));
+  GST_WRITE_UINT64_BE (h + 34, GST_BUFFER_OFFSET_END (buffer));
+  GST_WRITE_UINT16_BE (h + 42, GST_BUFFER_FLAGS (buffer) & HEADER_FLAGS_MASK);
+
+  crc = 0;
+  if (this->header_flag & GST_DP_HEADER_FLAG_CRC_HEADER)
+    crc = 0xffff ^ gdp_crc_update (this->template_crc, h + HEADER_CONST_LEN,
+        HEADER_CRC_LEN - HEADER_CONST_LEN);
+  GST_WRITE_UINT16_BE (h + 58, crc);
+
+  crc = 0;
+  if (GST_BUFFER_SIZE (buffer) &&
+      (this->header_flag & GST_DP_HEADER_FLAG_CRC_PAYLOAD))
+    crc = 0xffff ^ gdp_crc_update (0xffff, GST_BUFFER_DATA (buffer),
+        GST_BUFFER_SIZE (buffer));
+  GST_WRITE_UINT16_BE (h + 60, crc);
+
+  headerbuf = gst_buffer_create_sub (this->header_pool,
+      this->header_pool_offset, GST_DP_HEADER_LENGTH);
+  this->header_pool_offset += GST_DP_HEADER_LENGTH;
 
-  if (!this->packetizer->header_from_buffer (buffer, this->header_flag, &len,
-          &header))
+  return headerbuf;
+
+  /* ERRORS */
+no_template:
+  {
+    GST_WARNING_OBJECT (this, "could not create GDP header template");
+    return NULL;
+  }
+}
+
+static GstBuffer *
+gst_gdp_pay_buffer_from_buffer (GstGDPPay * this, GstBuffer * buffer)
+{
+  GstBuffer *headerbuf;
+
+  headerbuf = gst_gdp_pay_header_from_buffer (this, buffer);
+  if (!headerbuf)
     goto no_buffer;
 
   GST_LOG_OBJECT (this, "creating GDP header and payload buffer from buffer");
-  headerbuf = gst_buffer_new ();
-  gst_buffer_set_data (headerbuf, header, len);
-  GST_BUFFER_MALLOCDATA (headerbuf) = header;
 
   /* we do not want to lose the ref on the incoming buffer */
   gst_buffer_ref (buffer);
@@ -286,6 +439,50 @@ no_buffer:
   }
 }
 
+/* push the header and payload of @buffer as one group of a buffer list. The
+ * metadata of the group is set on the header buffer. */
+static GstFlowReturn
+gst_gdp_pay_push_list (GstGDPPay * this, GstBuffer * buffer)
+{
+  GstBufferList *list;
+  GstBufferListIterator *it;
+  GstBuffer *headerbuf;
+
+  headerbuf = gst_gdp_pay_header_from_buffer (this, buffer);
+  if (!headerbuf)
+    goto no_buffer;
+
+  if (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_IN_CAPS))
+    GST_BUFFER_FLAG_SET (headerbuf, GST_BUFFER_FLAG_IN_CAPS);
+
+  GST_BUFFER_OFFSET (headerbuf) = this->offset;
+  GST_BUFFER_OFFSET_END (headerbuf) =
+      this->offset + GST_DP_HEADER_LENGTH + GST_BUFFER_SIZE (buffer);
+  this->offset = GST_BUFFER_OFFSET_END (headerbuf);
+  GST_BUFFER_TIMESTAMP (headerbuf) = GST_BUFFER_TIMESTAMP (buffer);
+  GST_BUFFER_DURATION (headerbuf) = GST_BUFFER_DURATION (buffer);
+  gst_buffer_set_caps (headerbuf, GST_PAD_CAPS (this->srcpad));
+
+  list = gst_buffer_list_new ();
+  it = gst_buffer_list_iterate (list);
+  gst_buffer_list_iterator_add_group (it);
+  gst_buffer_list_iterator_add (it, headerbuf);
+  gst_buffer_list_iterator_add (it, gst_buffer_ref (buffer));
+  gst_buffer_list_iterator_free (it);
+
+  GST_LOG_OBJECT (this, "Pushing GDP buffer list for buffer %p", buffer);
+
+  return gst_pad_push_list (this->srcpad, list);
+
+  /* ERRORS */
+no_buffer:
+  {
+    GST_ELEMENT_ERROR (this, STREAM, ENCODE, (NULL),
+        ("Could not create GDP buffer from buffer"));
+    return GST_FLOW_ERROR;
+  }
+}
+
 static GstBuffer *
 gst_gdp_buffer_from_event (GstGDPPay * this, GstEvent * event)
 {
@@ -639,6 +836,13 @@ gst_gdp_pay_chain (GstPad * pad, GstBuffer * buffer)
   if (caps)
     gst_caps_unref (caps);
 
+  /* once the streamheaders are out, the header and the payload can go out as
+   * a buffer list without being copied together */
+  if (this->buffer_list && this->sent_streamheader) {
+    ret = gst_gdp_pay_push_list (this, buffer);
+    goto done;
+  }
+
   /* create a GDP header packet,
    * then create a GST buffer of the header packet and the buffer contents */
   outbuffer = gst_gdp_pay_buffer_from_buffer (this, buffer);
@@ -821,14 +1025,20 @@ gst_gdp_pay_set_property (GObject * object, guint prop_id,
       this->crc_header =
           g_value_get_boolean (value) ? GST_DP_HEADER_FLAG_CRC_HEADER : 0;
       this->header_flag = this->crc_header | this->crc_payload;
+      this->have_template = FALSE;
       break;
     case PROP_CRC_PAYLOAD:
       this->crc_payload =
           g_value_get_boolean (value) ? GST_DP_HEADER_FLAG_CRC_PAYLOAD : 0;
       this->header_flag = this->crc_header | this->crc_payload;
+      this->have_template = FALSE;
       break;
     case PROP_VERSION:
       this->version = g_value_get_enum (value);
+      this->have_template = FALSE;
+      break;
+    case PROP_BUFFER_LIST:
+      this->buffer_list = g_value_get_boolean (value);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -855,6 +1065,9 @@ gst_gdp_pay_get_property (GObject * object, guint prop_id,
     case PROP_VERSION:
       g_value_set_enum (value, this->version);
       break;
+    case PROP_BUFFER_LIST:
+      g_value_set_boolean (value, this->buffer_list);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -65,6 +65,17 @@ struct _GstGDPPay
   GstDPHeaderFlag header_flag;
   GstDPVersion version;
   GstDPPacketizer *packetizer;
+
+  gboolean buffer_list;
+
+  /* constant part of the buffer headers, made on the first buffer */
+  gboolean have_template;
+  guint8 header_template[GST_DP_HEADER_LENGTH];
+  guint16 template_crc; /* CRC state after the constant leading fields */
+
+  /* buffer headers are subbuffers of this block */
+  GstBuffer *header_pool;
+  guint header_pool_offset;
 };
 
 struct _GstGDPPayClass
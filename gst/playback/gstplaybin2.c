@@ -272,6 +272,7 @@ struct _GstSourceSelect
                                  */
   GstEvent *sinkpad_delayed_event;
   gulong sinkpad_data_probe;
+  gulong srcpad_preroll_probe;  /* checks when to preroll the next group */
 };
 
 #define GST_SOURCE_GROUP_GET_LOCK(group) (((GstSourceGroup*)(group))->lock)
@@ -296,6 +297,16 @@ struct _GstSourceGroup
 
   gboolean valid;               /* the group has valid info to start playback */
   gboolean active;              /* the group is active */
+  gboolean standby;             /* the group was activated ahead of time and
+                                 * waits with blocked selectors until the
+                                 * current group is drained */
+  gboolean configure_pending;   /* all pads of the standby group are known,
+                                 * the output is configured on the switch */
+
+  /* for prerolling the next group ahead of time */
+  gint about_to_finish;         /* about-to-finish was emitted, atomic */
+  gint64 duration;              /* cached duration of the uridecodebin */
+  GstClockTime duration_query_ts;       /* timestamp of the last query */
 
   /* properties */
   gchar *uri;
@@ -417,6 +428,8 @@ struct _GstPlayBin
   } duration[5];                /* cached durations */
 
   guint64 ring_buffer_max_size; /* 0 means disabled */
+
+  guint64 gapless_preroll_time; /* 0 means disabled */
 };
 
 struct _GstPlayBinClass
@@ -476,6 +489,7 @@ struct _GstPlayBinClass
 #define DEFAULT_BUFFER_DURATION   -1
 #define DEFAULT_BUFFER_SIZE       -1
 #define DEFAULT_RING_BUFFER_MAX_SIZE 0
+#define DEFAULT_GAPLESS_PREROLL_TIME 0
 
 enum
 {
@@ -504,6 +518,7 @@ enum
   PROP_BUFFER_DURATION,
   PROP_AV_OFFSET,
   PROP_RING_BUFFER_MAX_SIZE,
+  PROP_GAPLESS_PREROLL_TIME,
   PROP_LAST
 };
 
@@ -558,6 +573,7 @@ static GstPad *gst_play_bin_get_audio_pad (GstPlayBin * playbin, gint stream);
 static GstPad *gst_play_bin_get_text_pad (GstPlayBin * playbin, gint stream);
 
 static gboolean setup_next_source (GstPlayBin * playbin, GstState target);
+static void cancel_standby_group (GstPlayBin * playbin, GstSourceGroup * group);
 
 static void no_more_pads_cb (GstElement * decodebin, GstSourceGroup * group);
 static void pad_removed_cb (GstElement * decodebin, GstPad * pad,
@@ -825,6 +841,28 @@ gst_play_bin_class_init (GstPlayBinClass * klass)
           0, G_MAXUINT, DEFAULT_RING_BUFFER_MAX_SIZE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstPlayBin2:gapless-preroll-time
+   *
+   * When the decoded data of the current uri gets closer than this amount of
+   * time to the end of the stream, the about-to-finish signal is emitted and
+   * the uri that is set from the signal handler is decoded and prerolled
+   * right away. The prerolled group waits until the current uri is completely
+   * drained and then takes over without having to build and preroll the
+   * decoding pipeline first. If set to 0, the next uri is only prepared when
+   * the current uri is drained. Default 0.
+   *
+   * The value is applied to uris that start playing after it was set.
+   *
+   * Since: 0.10.37
+   */
+  g_object_class_install_property (gobject_klass, PROP_GAPLESS_PREROLL_TIME,
+      g_param_spec_uint64 ("gapless-preroll-time", "Gapless preroll time",
+          "Time before the end of the current uri at which the next uri is "
+          "prerolled (0 = when drained)", 0, G_MAXUINT64,
+          DEFAULT_GAPLESS_PREROLL_TIME,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /**
    * GstPlayBin2::about-to-finish
    * @playbin: a #GstPlayBin2
@@ -832,6 +870,10 @@ gst_play_bin_class_init (GstPlayBinClass * klass)
    * This signal is emitted when the current uri is about to finish. You can
    * set the uri and suburi to make sure that playback continues.
    *
+   * When #GstPlayBin2:gapless-preroll-time is set, this signal is emitted
+   * that amount of time before the end of the current uri. If no uri is set at
+   * that moment, it is emitted again when the current uri is drained.
+   *
    * This signal is emitted from the context of a GStreamer streaming thread.
    */
   gst_play_bin_signals[SIGNAL_ABOUT_TO_FINISH] =
@@ -1158,6 +1200,7 @@ init_group (GstPlayBin * playbin, GstSourceGroup * group)
     GstSourceSelect *select = &group->selector[n];
     select->sinkpad_delayed_event = NULL;
     select->sinkpad_data_probe = 0;
+    select->srcpad_preroll_probe = 0;
   }
 }
 
@@ -1273,6 +1316,7 @@ gst_play_bin_init (GstPlayBin * playbin)
   playbin->buffer_duration = DEFAULT_BUFFER_DURATION;
   playbin->buffer_size = DEFAULT_BUFFER_SIZE;
   playbin->ring_buffer_max_size = DEFAULT_RING_BUFFER_MAX_SIZE;
+  playbin->gapless_preroll_time = DEFAULT_GAPLESS_PREROLL_TIME;
 }
 
 static void
@@ -1362,6 +1406,9 @@ gst_play_bin_set_uri (GstPlayBin * playbin, const gchar * uri)
   GST_PLAY_BIN_LOCK (playbin);
   group = playbin->next_group;
 
+  /* the old uri might already be prerolling, throw it away */
+  cancel_standby_group (playbin, group);
+
   GST_SOURCE_GROUP_LOCK (group);
   /* store the uri in the next group we will play */
   g_free (group->uri);
@@ -1381,6 +1428,8 @@ gst_play_bin_set_suburi (GstPlayBin * playbin, const gchar * suburi)
   GST_PLAY_BIN_LOCK (playbin);
   group = playbin->next_group;
 
+  cancel_standby_group (playbin, group);
+
   GST_SOURCE_GROUP_LOCK (group);
   g_free (group->suburi);
   group->suburi = g_strdup (suburi);
@@ -1959,6 +2008,16 @@ gst_play_bin_set_property (GObject * object, guint prop_id,
     case PROP_RING_BUFFER_MAX_SIZE:
       playbin->ring_buffer_max_size = g_value_get_uint64 (value);
       break;
+    case PROP_GAPLESS_PREROLL_TIME:
+    {
+      guint64 preroll_time = g_value_get_uint64 (value);
+
+      GST_OBJECT_LOCK (playbin);
+      playbin->gapless_preroll_time = preroll_time;
+      GST_OBJECT_UNLOCK (playbin);
+      gst_play_sink_set_gapless (playbin->playsink, preroll_time > 0);
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2134,6 +2193,11 @@ gst_play_bin_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_RING_BUFFER_MAX_SIZE:
       g_value_set_uint64 (value, playbin->ring_buffer_max_size);
       break;
+    case PROP_GAPLESS_PREROLL_TIME:
+      GST_OBJECT_LOCK (playbin);
+      g_value_set_uint64 (value, playbin->gapless_preroll_time);
+      GST_OBJECT_UNLOCK (playbin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2252,6 +2316,17 @@ static const gchar *blacklisted_mimes[] = {
   NULL
 };
 
+static gboolean
+is_group_decodebin (GstSourceGroup * group, GstObject * src)
+{
+  if (group == NULL)
+    return FALSE;
+
+  return (group->uridecodebin && src == GST_OBJECT_CAST (group->uridecodebin))
+      || (group->suburidecodebin
+      && src == GST_OBJECT_CAST (group->suburidecodebin));
+}
+
 static void
 gst_play_bin_handle_message (GstBin * bin, GstMessage * msg)
 {
@@ -2306,12 +2381,11 @@ gst_play_bin_handle_message (GstBin * bin, GstMessage * msg)
     GstObject *src = GST_OBJECT_CAST (msg->src);
 
     /* Ignore async state changes from the uridecodebin children,
-     * see bug #602000. */
-    group = playbin->curr_group;
-    if (src && (group = playbin->curr_group) &&
-        ((group->uridecodebin && src == GST_OBJECT_CAST (group->uridecodebin))
-            || (group->suburidecodebin
-                && src == GST_OBJECT_CAST (group->suburidecodebin)))) {
+     * see bug #602000. The same goes for a group that is prerolling ahead of
+     * time, it must not make the pipeline lose its state. */
+    if (src && (is_group_decodebin (playbin->curr_group, src) ||
+            (playbin->next_group && playbin->next_group->standby &&
+                is_group_decodebin (playbin->next_group, src)))) {
       GST_DEBUG_OBJECT (playbin,
           "Ignoring async state change of uridecodebin: %s",
           GST_OBJECT_NAME (src));
@@ -2809,21 +2883,14 @@ no_selector:
  * audio/video and subtitle streams. This allows us to see if we need
  * visualisation, video or/and audio.
  */
+/* link the selectors of @group to the sink.
+ * must be called with the group lock */
 static void
-no_more_pads_cb (GstElement * decodebin, GstSourceGroup * group)
+link_group_to_sink (GstPlayBin * playbin, GstSourceGroup * group)
 {
-  GstPlayBin *playbin;
   GstPadLinkReturn res;
   gint i;
-  gboolean configure;
-
-  playbin = group->playbin;
-
-  GST_DEBUG_OBJECT (playbin, "no more pads in group %p", group);
-
-  GST_PLAY_BIN_SHUTDOWN_LOCK (playbin, shutdown);
 
-  GST_SOURCE_GROUP_LOCK (group);
   for (i = 0; i < PLAYBIN_STREAM_LAST; i++) {
     GstSourceSelect *select = &group->selector[i];
 
@@ -2846,109 +2913,162 @@ no_more_pads_cb (GstElement * decodebin, GstSourceGroup * group)
       }
     }
   }
-  GST_DEBUG_OBJECT (playbin, "pending %d > %d", group->pending,
-      group->pending - 1);
+}
 
-  if (group->pending > 0)
-    group->pending--;
+static gboolean gapless_preroll_probe (GstPad * pad, GstMiniObject * object,
+    GstSourceGroup * group);
 
-  if (group->suburidecodebin == decodebin)
-    group->sub_pending = FALSE;
+/* configure the custom sinks and unblock the selectors of @group after all of
+ * its pads were linked to the sink. */
+static void
+configure_group_output (GstPlayBin * playbin, GstSourceGroup * group)
+{
+  gint i;
+  guint64 preroll_time;
 
-  if (group->pending == 0) {
-    /* we are the last group to complete, we will configure the output and then
-     * signal the other waiters. */
-    GST_LOG_OBJECT (playbin, "last group complete");
-    configure = TRUE;
-  } else {
-    GST_LOG_OBJECT (playbin, "have more pending groups");
-    configure = FALSE;
+  GST_OBJECT_LOCK (playbin);
+  preroll_time = playbin->gapless_preroll_time;
+  GST_OBJECT_UNLOCK (playbin);
+
+  /* if we have custom sinks, configure them now */
+  GST_SOURCE_GROUP_LOCK (group);
+
+  if (group->audio_sink) {
+    GST_INFO_OBJECT (playbin, "setting custom audio sink %" GST_PTR_FORMAT,
+        group->audio_sink);
+    gst_play_sink_set_sink (playbin->playsink, GST_PLAY_SINK_TYPE_AUDIO,
+        group->audio_sink);
+  }
+
+  if (group->video_sink) {
+    GST_INFO_OBJECT (playbin, "setting custom video sink %" GST_PTR_FORMAT,
+        group->video_sink);
+    gst_play_sink_set_sink (playbin->playsink, GST_PLAY_SINK_TYPE_VIDEO,
+        group->video_sink);
   }
+
+  if (playbin->text_sink) {
+    GST_INFO_OBJECT (playbin, "setting custom text sink %" GST_PTR_FORMAT,
+        playbin->text_sink);
+    gst_play_sink_set_sink (playbin->playsink, GST_PLAY_SINK_TYPE_TEXT,
+        playbin->text_sink);
+  }
+
   GST_SOURCE_GROUP_UNLOCK (group);
 
-  if (configure) {
-    /* if we have custom sinks, configure them now */
-    GST_SOURCE_GROUP_LOCK (group);
+  /* signal the other decodebins that they can continue now. */
+  GST_SOURCE_GROUP_LOCK (group);
+  /* unblock all selectors */
+  for (i = 0; i < PLAYBIN_STREAM_LAST; i++) {
+    GstSourceSelect *select = &group->selector[i];
 
-    if (group->audio_sink) {
-      GST_INFO_OBJECT (playbin, "setting custom audio sink %" GST_PTR_FORMAT,
-          group->audio_sink);
-      gst_play_sink_set_sink (playbin->playsink, GST_PLAY_SINK_TYPE_AUDIO,
-          group->audio_sink);
-    }
+    /* All streamsynchronizer streams should see stream-changed message,
+     * to arrange for blocking unblocking. */
+    if (select->sinkpad) {
+      GstStructure *s;
+      GstMessage *msg;
+      GstEvent *event;
+      guint32 seqnum;
+
+      s = gst_structure_new ("playbin2-stream-changed", "uri", G_TYPE_STRING,
+          group->uri, NULL);
+      if (group->suburi)
+        gst_structure_set (s, "suburi", G_TYPE_STRING, group->suburi, NULL);
+      msg = gst_message_new_element (GST_OBJECT_CAST (playbin), s);
+      seqnum = gst_message_get_seqnum (msg);
+      event = gst_event_new_sink_message (msg);
+      g_mutex_lock (group->stream_changed_pending_lock);
+      group->stream_changed_pending =
+          g_list_prepend (group->stream_changed_pending,
+          GUINT_TO_POINTER (seqnum));
+
+      /* remove any data probe we might have, and replace */
+      if (select->sinkpad_delayed_event)
+        gst_event_unref (select->sinkpad_delayed_event);
+      select->sinkpad_delayed_event = event;
+      if (select->sinkpad_data_probe)
+        gst_pad_remove_data_probe (select->sinkpad,
+            select->sinkpad_data_probe);
+
+      /* we go to the trouble of setting a probe on the pad to send
+         the playbin2-stream-changed event as sending it here might
+         find that the pad is blocked, so we'd block here, and the
+         pad might not be linked yet. Additionally, sending it here
+         apparently would be on the wrong thread */
+      select->sinkpad_data_probe =
+          gst_pad_add_data_probe (select->sinkpad,
+          (GCallback) stream_changed_data_probe, (gpointer) select);
 
-    if (group->video_sink) {
-      GST_INFO_OBJECT (playbin, "setting custom video sink %" GST_PTR_FORMAT,
-          group->video_sink);
-      gst_play_sink_set_sink (playbin->playsink, GST_PLAY_SINK_TYPE_VIDEO,
-          group->video_sink);
+      g_mutex_unlock (group->stream_changed_pending_lock);
+      gst_message_unref (msg);
     }
 
-    if (playbin->text_sink) {
-      GST_INFO_OBJECT (playbin, "setting custom text sink %" GST_PTR_FORMAT,
-          playbin->text_sink);
-      gst_play_sink_set_sink (playbin->playsink, GST_PLAY_SINK_TYPE_TEXT,
-          playbin->text_sink);
+    if (select->srcpad) {
+      /* watch the decoded data to find out when to preroll the next
+       * group */
+      if (preroll_time > 0 && select->srcpad_preroll_probe == 0)
+        select->srcpad_preroll_probe =
+            gst_pad_add_data_probe (select->srcpad,
+            (GCallback) gapless_preroll_probe, group);
+
+      GST_DEBUG_OBJECT (playbin, "unblocking %" GST_PTR_FORMAT,
+          select->srcpad);
+      gst_pad_set_blocked_async (select->srcpad, FALSE, selector_blocked,
+          NULL);
     }
+  }
+  GST_SOURCE_GROUP_UNLOCK (group);
+}
 
-    GST_SOURCE_GROUP_UNLOCK (group);
+static void
+no_more_pads_cb (GstElement * decodebin, GstSourceGroup * group)
+{
+  GstPlayBin *playbin;
+  GstPadLinkReturn res;
+  gint i;
+  gboolean configure;
 
-    /* signal the other decodebins that they can continue now. */
-    GST_SOURCE_GROUP_LOCK (group);
-    /* unblock all selectors */
-    for (i = 0; i < PLAYBIN_STREAM_LAST; i++) {
-      GstSourceSelect *select = &group->selector[i];
+  playbin = group->playbin;
 
-      /* All streamsynchronizer streams should see stream-changed message,
-       * to arrange for blocking unblocking. */
-      if (select->sinkpad) {
-        GstStructure *s;
-        GstMessage *msg;
-        GstEvent *event;
-        guint32 seqnum;
-
-        s = gst_structure_new ("playbin2-stream-changed", "uri", G_TYPE_STRING,
-            group->uri, NULL);
-        if (group->suburi)
-          gst_structure_set (s, "suburi", G_TYPE_STRING, group->suburi, NULL);
-        msg = gst_message_new_element (GST_OBJECT_CAST (playbin), s);
-        seqnum = gst_message_get_seqnum (msg);
-        event = gst_event_new_sink_message (msg);
-        g_mutex_lock (group->stream_changed_pending_lock);
-        group->stream_changed_pending =
-            g_list_prepend (group->stream_changed_pending,
-            GUINT_TO_POINTER (seqnum));
-
-        /* remove any data probe we might have, and replace */
-        if (select->sinkpad_delayed_event)
-          gst_event_unref (select->sinkpad_delayed_event);
-        select->sinkpad_delayed_event = event;
-        if (select->sinkpad_data_probe)
-          gst_pad_remove_data_probe (select->sinkpad,
-              select->sinkpad_data_probe);
-
-        /* we go to the trouble of setting a probe on the pad to send
-           the playbin2-stream-changed event as sending it here might
-           find that the pad is blocked, so we'd block here, and the
-           pad might not be linked yet. Additionally, sending it here
-           apparently would be on the wrong thread */
-        select->sinkpad_data_probe =
-            gst_pad_add_data_probe (select->sinkpad,
-            (GCallback) stream_changed_data_probe, (gpointer) select);
-
-        g_mutex_unlock (group->stream_changed_pending_lock);
-        gst_message_unref (msg);
-      }
+  GST_DEBUG_OBJECT (playbin, "no more pads in group %p", group);
 
-      if (select->srcpad) {
-        GST_DEBUG_OBJECT (playbin, "unblocking %" GST_PTR_FORMAT,
-            select->srcpad);
-        gst_pad_set_blocked_async (select->srcpad, FALSE, selector_blocked,
-            NULL);
-      }
+  GST_PLAY_BIN_SHUTDOWN_LOCK (playbin, shutdown);
+
+  GST_SOURCE_GROUP_LOCK (group);
+  /* a standby group is linked when it takes over from the current group */
+  if (!group->standby)
+    link_group_to_sink (playbin, group);
+
+  GST_DEBUG_OBJECT (playbin, "pending %d > %d", group->pending,
+      group->pending - 1);
+
+  if (group->pending > 0)
+    group->pending--;
+
+  if (group->suburidecodebin == decodebin)
+    group->sub_pending = FALSE;
+
+  if (group->pending == 0) {
+    if (group->standby) {
+      /* keep the selectors blocked, the output will be configured when the
+       * current group is drained */
+      GST_LOG_OBJECT (playbin, "standby group %p complete", group);
+      group->configure_pending = TRUE;
+      configure = FALSE;
+    } else {
+      /* we are the last group to complete, we will configure the output and
+       * then signal the other waiters. */
+      GST_LOG_OBJECT (playbin, "last group complete");
+      configure = TRUE;
     }
-    GST_SOURCE_GROUP_UNLOCK (group);
+  } else {
+    GST_LOG_OBJECT (playbin, "have more pending groups");
+    configure = FALSE;
   }
+  GST_SOURCE_GROUP_UNLOCK (group);
+
+  if (configure)
+    configure_group_output (playbin, group);
 
   GST_PLAY_BIN_SHUTDOWN_UNLOCK (playbin);
 
@@ -2985,22 +3105,191 @@ shutdown:
   }
 }
 
+/* called from the streaming thread of @group when its decoded data gets
+ * within gapless-preroll-time of the end of the stream. Emits about-to-finish
+ * and starts prerolling the next group when the application set a new uri. */
+static void
+preroll_next_group (GstPlayBin * playbin, GstSourceGroup * group)
+{
+  GstSourceGroup *next_group;
+
+  GST_DEBUG_OBJECT (playbin, "about to finish in group %p, prerolling next",
+      group);
+
+  g_signal_emit (G_OBJECT (playbin),
+      gst_play_bin_signals[SIGNAL_ABOUT_TO_FINISH], 0, NULL);
+
+  if (G_UNLIKELY (g_atomic_int_get (&playbin->shutdown)))
+    return;
+
+  GST_PLAY_BIN_LOCK (playbin);
+  next_group = playbin->next_group;
+  if (playbin->curr_group != group || !next_group->valid || next_group->active) {
+    GST_DEBUG_OBJECT (playbin, "no next group to preroll");
+    GST_PLAY_BIN_UNLOCK (playbin);
+    return;
+  }
+
+  GST_SOURCE_GROUP_LOCK (next_group);
+  next_group->standby = TRUE;
+  next_group->configure_pending = FALSE;
+  GST_SOURCE_GROUP_UNLOCK (next_group);
+
+  if (!activate_group (playbin, next_group, GST_STATE_PAUSED)) {
+    /* we will try again the normal way when the current group is drained */
+    GST_WARNING_OBJECT (playbin, "failed to preroll next group %p",
+        next_group);
+    GST_SOURCE_GROUP_LOCK (next_group);
+    next_group->standby = FALSE;
+    GST_SOURCE_GROUP_UNLOCK (next_group);
+  }
+  GST_PLAY_BIN_UNLOCK (playbin);
+}
+
+static gboolean
+gapless_preroll_probe (GstPad * pad, GstMiniObject * object,
+    GstSourceGroup * group)
+{
+  GstPlayBin *playbin = group->playbin;
+  GstClockTime timestamp, preroll_time;
+  gint64 duration;
+  gboolean query;
+
+  if (!GST_IS_BUFFER (object))
+    return TRUE;
+
+  timestamp = GST_BUFFER_TIMESTAMP (GST_BUFFER_CAST (object));
+  if (!GST_CLOCK_TIME_IS_VALID (timestamp))
+    return TRUE;
+
+  if (g_atomic_int_get (&group->about_to_finish))
+    return TRUE;
+
+  GST_OBJECT_LOCK (playbin);
+  preroll_time = playbin->gapless_preroll_time;
+  GST_OBJECT_UNLOCK (playbin);
+  if (preroll_time == 0)
+    return TRUE;
+
+  /* the duration is usually only unknown at the start, don't query it for
+   * every buffer */
+  GST_SOURCE_GROUP_LOCK (group);
+  duration = group->duration;
+  query = duration == -1 &&
+      (!GST_CLOCK_TIME_IS_VALID (group->duration_query_ts) ||
+      timestamp >= group->duration_query_ts + GST_SECOND);
+  if (query)
+    group->duration_query_ts = timestamp;
+  GST_SOURCE_GROUP_UNLOCK (group);
+
+  if (query && group->uridecodebin) {
+    GstFormat format = GST_FORMAT_TIME;
+
+    if (!gst_element_query_duration (group->uridecodebin, &format, &duration)
+        || format != GST_FORMAT_TIME)
+      duration = -1;
+
+    GST_DEBUG_OBJECT (playbin, "duration of group %p: %" GST_TIME_FORMAT,
+        group, GST_TIME_ARGS (duration));
+
+    GST_SOURCE_GROUP_LOCK (group);
+    group->duration = duration;
+    GST_SOURCE_GROUP_UNLOCK (group);
+  }
+
+  if (duration == -1 || timestamp + preroll_time < duration)
+    return TRUE;
+
+  /* only one of the streams of the group triggers the preroll */
+  if (g_atomic_int_compare_and_exchange (&group->about_to_finish, FALSE, TRUE))
+    preroll_next_group (playbin, group);
+
+  return TRUE;
+}
+
+/* switch to the next group when it was prerolled ahead of time. */
+static gboolean
+activate_standby_group (GstPlayBin * playbin)
+{
+  GstSourceGroup *new_group, *old_group;
+  gboolean configure;
+
+  GST_PLAY_BIN_LOCK (playbin);
+  new_group = playbin->next_group;
+  if (!new_group || !new_group->valid || !new_group->active ||
+      !new_group->standby) {
+    GST_PLAY_BIN_UNLOCK (playbin);
+    return FALSE;
+  }
+
+  GST_PLAY_BIN_SHUTDOWN_LOCK (playbin, shutdown);
+
+  GST_DEBUG_OBJECT (playbin, "switching to standby group %p", new_group);
+
+  /* first unlink the current source */
+  old_group = playbin->curr_group;
+  if (old_group && old_group->valid && old_group->active) {
+    gst_play_bin_update_cached_duration (playbin);
+    deactivate_group (playbin, old_group);
+    old_group->valid = FALSE;
+  }
+
+  /* swap old and new */
+  playbin->curr_group = new_group;
+  playbin->next_group = old_group;
+
+  /* if the new group already found all its pads, link it now. Else this is
+   * done when the last no-more-pads arrives. */
+  GST_SOURCE_GROUP_LOCK (new_group);
+  new_group->standby = FALSE;
+  configure = new_group->configure_pending;
+  new_group->configure_pending = FALSE;
+  if (configure)
+    link_group_to_sink (playbin, new_group);
+  GST_SOURCE_GROUP_UNLOCK (new_group);
+
+  if (configure)
+    configure_group_output (playbin, new_group);
+
+  GST_PLAY_BIN_SHUTDOWN_UNLOCK (playbin);
+  GST_PLAY_BIN_UNLOCK (playbin);
+
+  return TRUE;
+
+shutdown:
+  {
+    GST_DEBUG_OBJECT (playbin, "shutting down, not switching groups");
+    GST_PLAY_BIN_UNLOCK (playbin);
+    return TRUE;
+  }
+}
+
 static void
 drained_cb (GstElement * decodebin, GstSourceGroup * group)
 {
   GstPlayBin *playbin;
+  gboolean emit;
 
   playbin = group->playbin;
 
   GST_DEBUG_OBJECT (playbin, "about to finish in group %p", group);
 
-  /* after this call, we should have a next group to activate or we EOS */
-  g_signal_emit (G_OBJECT (playbin),
-      gst_play_bin_signals[SIGNAL_ABOUT_TO_FINISH], 0, NULL);
+  /* the signal was already emitted when we tried to preroll the next group,
+   * only emit it again when that did not give us a new uri */
+  GST_PLAY_BIN_LOCK (playbin);
+  emit = !g_atomic_int_get (&group->about_to_finish) ||
+      !playbin->next_group->valid;
+  GST_PLAY_BIN_UNLOCK (playbin);
 
-  /* now activate the next group. If the app did not set a uri, this will
-   * fail and we can do EOS */
-  setup_next_source (playbin, GST_STATE_PAUSED);
+  /* after this call, we should have a next group to activate or we EOS */
+  if (emit)
+    g_signal_emit (G_OBJECT (playbin),
+        gst_play_bin_signals[SIGNAL_ABOUT_TO_FINISH], 0, NULL);
+
+  /* now activate the next group. If it was prerolled already, we only need to
+   * link it. If the app did not set a uri, this will fail and we can do EOS */
+  if (!activate_standby_group (playbin))
+    setup_next_source (playbin, GST_STATE_PAUSED);
 }
 
 /* Like gst_element_factory_can_sink_any_caps() but doesn't
@@ -3489,6 +3778,10 @@ activate_group (GstPlayBin * playbin, GstSourceGroup * group, GstState target)
   if (!group->stream_changed_pending_lock)
     group->stream_changed_pending_lock = g_mutex_new ();
 
+  g_atomic_int_set (&group->about_to_finish, FALSE);
+  group->duration = -1;
+  group->duration_query_ts = GST_CLOCK_TIME_NONE;
+
   if (group->uridecodebin) {
     GST_DEBUG_OBJECT (playbin, "reusing existing uridecodebin");
     uridecodebin = group->uridecodebin;
@@ -3698,12 +3991,20 @@ deactivate_group (GstPlayBin * playbin, GstSourceGroup * group)
 
   GST_SOURCE_GROUP_LOCK (group);
   group->active = FALSE;
+  group->standby = FALSE;
+  group->configure_pending = FALSE;
   for (i = 0; i < PLAYBIN_STREAM_LAST; i++) {
     GstSourceSelect *select = &group->selector[i];
 
     GST_DEBUG_OBJECT (playbin, "unlinking selector %s", select->media_list[0]);
 
     if (select->srcpad) {
+      if (select->srcpad_preroll_probe) {
+        gst_pad_remove_data_probe (select->srcpad,
+            select->srcpad_preroll_probe);
+        select->srcpad_preroll_probe = 0;
+      }
+
       if (select->sinkpad) {
         GST_LOG_OBJECT (playbin, "unlinking from sink");
         gst_pad_unlink (select->srcpad, select->sinkpad);
@@ -3779,6 +4080,27 @@ deactivate_group (GstPlayBin * playbin, GstSourceGroup * group)
   return TRUE;
 }
 
+/* stop a group that was prerolled ahead of time, for example because the
+ * application changed the uri again. The group is activated again the normal
+ * way when the current group is drained.
+ * must be called with PLAY_BIN_LOCK */
+static void
+cancel_standby_group (GstPlayBin * playbin, GstSourceGroup * group)
+{
+  if (!group->active || !group->standby)
+    return;
+
+  GST_DEBUG_OBJECT (playbin, "cancelling standby group %p", group);
+
+  deactivate_group (playbin, group);
+
+  /* stop the streaming threads that wait in the blocked selectors */
+  if (group->suburidecodebin)
+    gst_element_set_state (group->suburidecodebin, GST_STATE_READY);
+  if (group->uridecodebin)
+    gst_element_set_state (group->uridecodebin, GST_STATE_READY);
+}
+
 /* setup the next group to play, this assumes the next_group is valid and
  * configured. It swaps out the current_group and activates the valid
  * next_group. */
@@ -3850,6 +4172,9 @@ save_current_group (GstPlayBin * playbin)
     /* unlink our pads with the sink */
     deactivate_group (playbin, curr_group);
   }
+  /* the next group is prepared again when we start playing */
+  if (playbin->next_group)
+    cancel_standby_group (playbin, playbin->next_group);
   /* swap old and new */
   playbin->curr_group = playbin->next_group;
   playbin->next_group = curr_group;
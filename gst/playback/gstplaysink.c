@@ -2829,6 +2829,15 @@ gst_play_sink_get_av_offset (GstPlaySink * playsink)
   return result;
 }
 
+/* closes the segments of all streams at a common position when switching
+ * to the streams of the next uri, for gapless playback */
+void
+gst_play_sink_set_gapless (GstPlaySink * playsink, gboolean gapless)
+{
+  g_object_set (playsink->stream_synchronizer, "close-segments", gapless,
+      NULL);
+}
+
 /**
  * gst_play_sink_get_last_frame:
  * @playsink: a #GstPlaySink
@@ -59,6 +59,14 @@ static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink_%d",
 
 static const gboolean passthrough = TRUE;
 
+enum
+{
+  PROP_0,
+  PROP_CLOSE_SEGMENTS
+};
+
+#define DEFAULT_CLOSE_SEGMENTS FALSE
+
 GST_BOILERPLATE (GstStreamSynchronizer, gst_stream_synchronizer,
     GstElement, GST_TYPE_ELEMENT);
 
@@ -75,10 +83,14 @@ typedef struct
   gboolean drop_discont;
   gboolean is_eos;
   gboolean seen_data;
+  gboolean pending_close;
 
   gint64 running_time_diff;
 } GstStream;
 
+static void gst_stream_synchronizer_passthrough_event (GstStreamSynchronizer *
+    self, GstPad * pad, GstEvent * event);
+
 /* Must be called with lock! */
 static GstPad *
 gst_stream_get_other_pad (GstStream * stream, GstPad * pad)
@@ -273,6 +285,112 @@ out:
 }
 
 /* sinkpad functions */
+
+/* Must be called with lock! Called for the first stream that switches to
+ * a new segment after a group of streams played. Marks all streams that have
+ * data in their current segment for closing, at the position where the last
+ * of them ended. All data of the previous group has passed by now, the
+ * streams are only switched once all of them are drained. */
+static void
+gst_stream_synchronizer_prepare_close (GstStreamSynchronizer * self)
+{
+  GList *l;
+
+  self->close_position = -1;
+  for (l = self->streams; l; l = l->next) {
+    GstStream *stream = l->data;
+
+    if (stream->seen_data && stream->segment.format == GST_FORMAT_TIME
+        && stream->segment.rate > 0.0) {
+      stream->pending_close = TRUE;
+      self->close_position =
+          MAX (self->close_position, stream->segment.last_stop);
+    }
+  }
+
+  GST_DEBUG_OBJECT (self, "Closing segments at %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (self->close_position));
+}
+
+/* Even without adjusting the running times, make sure that the running time
+ * of new streams starts where the data of the previous streams ended. The
+ * sinks accumulate the segment stop (or position) of the previous segment
+ * into the running time, which leaves a gap when the previous segment was
+ * configured longer than the data that was actually decoded. All streams are
+ * closed at the same position, or streams that ended at different positions
+ * would drift apart with every switch. This is only done for gapless
+ * playback, when close-segments is set. */
+static void
+gst_stream_synchronizer_passthrough_event (GstStreamSynchronizer * self,
+    GstPad * pad, GstEvent * event)
+{
+  GstStream *stream;
+  GstEvent *close_event = NULL;
+  GstPad *srcpad = NULL;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_NEWSEGMENT:{
+      gboolean update;
+      gdouble rate, applied_rate;
+      GstFormat format;
+      gint64 start, stop, position;
+
+      gst_event_parse_new_segment_full (event,
+          &update, &rate, &applied_rate, &format, &start, &stop, &position);
+
+      GST_STREAM_SYNCHRONIZER_LOCK (self);
+      stream = gst_pad_get_element_private (pad);
+      if (stream && self->close_segments && !update
+          && format == GST_FORMAT_TIME) {
+        if (!stream->pending_close && stream->seen_data
+            && stream->segment.format == GST_FORMAT_TIME
+            && stream->segment.rate > 0.0)
+          gst_stream_synchronizer_prepare_close (self);
+
+        if (stream->pending_close) {
+          stream->pending_close = FALSE;
+          if (self->close_position != stream->segment.stop) {
+            GST_DEBUG_OBJECT (pad, "Closing previous segment at %"
+                GST_TIME_FORMAT " instead of %" GST_TIME_FORMAT,
+                GST_TIME_ARGS (self->close_position),
+                GST_TIME_ARGS (stream->segment.stop));
+            close_event = gst_event_new_new_segment_full (TRUE,
+                stream->segment.rate, stream->segment.applied_rate,
+                GST_FORMAT_TIME, stream->segment.start, self->close_position,
+                stream->segment.time);
+            srcpad = gst_object_ref (stream->srcpad);
+          }
+        }
+      }
+      if (stream) {
+        gst_segment_set_newsegment_full (&stream->segment, update, rate,
+            applied_rate, format, start, stop, position);
+        if (!update)
+          stream->seen_data = FALSE;
+      }
+      GST_STREAM_SYNCHRONIZER_UNLOCK (self);
+
+      if (close_event) {
+        gst_pad_push_event (srcpad, close_event);
+        gst_object_unref (srcpad);
+      }
+      break;
+    }
+    case GST_EVENT_FLUSH_STOP:
+      GST_STREAM_SYNCHRONIZER_LOCK (self);
+      stream = gst_pad_get_element_private (pad);
+      if (stream) {
+        gst_segment_init (&stream->segment, GST_FORMAT_UNDEFINED);
+        stream->seen_data = FALSE;
+        stream->pending_close = FALSE;
+      }
+      GST_STREAM_SYNCHRONIZER_UNLOCK (self);
+      break;
+    default:
+      break;
+  }
+}
+
 static gboolean
 gst_stream_synchronizer_sink_event (GstPad * pad, GstEvent * event)
 {
@@ -281,8 +399,10 @@ gst_stream_synchronizer_sink_event (GstPad * pad, GstEvent * event)
   GstPad *opad;
   gboolean ret = FALSE;
 
-  if (passthrough)
+  if (passthrough) {
+    gst_stream_synchronizer_passthrough_event (self, pad, event);
     goto skip_adjustments;
+  }
 
   GST_LOG_OBJECT (pad, "Handling event %s: %" GST_PTR_FORMAT,
       GST_EVENT_TYPE_NAME (event), event->structure);
@@ -596,6 +716,21 @@ gst_stream_synchronizer_sink_chain (GstPad * pad, GstBuffer * buffer)
   GstClockTime timestamp_end = GST_CLOCK_TIME_NONE;
 
   if (passthrough) {
+    /* remember where the data ended for closing the segment, this is
+     * serialized with the events by the stream lock */
+    stream = gst_pad_get_element_private (pad);
+    if (stream && stream->segment.format == GST_FORMAT_TIME
+        && GST_BUFFER_TIMESTAMP_IS_VALID (buffer)) {
+      timestamp_end = GST_BUFFER_TIMESTAMP (buffer);
+      if (GST_BUFFER_DURATION_IS_VALID (buffer))
+        timestamp_end += GST_BUFFER_DURATION (buffer);
+      if ((gint64) timestamp_end > stream->segment.last_stop
+          || !stream->seen_data)
+        gst_segment_set_last_stop (&stream->segment, GST_FORMAT_TIME,
+            timestamp_end);
+      stream->seen_data = TRUE;
+    }
+
     opad = gst_stream_get_other_pad_from_pad (pad);
     if (opad) {
       ret = gst_pad_push (opad, buffer);
@@ -957,6 +1092,42 @@ gst_stream_synchronizer_finalize (GObject * object)
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_stream_synchronizer_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstStreamSynchronizer *self = GST_STREAM_SYNCHRONIZER (object);
+
+  switch (prop_id) {
+    case PROP_CLOSE_SEGMENTS:
+      GST_STREAM_SYNCHRONIZER_LOCK (self);
+      self->close_segments = g_value_get_boolean (value);
+      GST_STREAM_SYNCHRONIZER_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_stream_synchronizer_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstStreamSynchronizer *self = GST_STREAM_SYNCHRONIZER (object);
+
+  switch (prop_id) {
+    case PROP_CLOSE_SEGMENTS:
+      GST_STREAM_SYNCHRONIZER_LOCK (self);
+      g_value_set_boolean (value, self->close_segments);
+      GST_STREAM_SYNCHRONIZER_UNLOCK (self);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
 /* GObject type initialization */
 static void
 gst_stream_synchronizer_init (GstStreamSynchronizer * self,
@@ -964,6 +1135,8 @@ gst_stream_synchronizer_init (GstStreamSynchronizer * self,
 {
   self->lock = g_mutex_new ();
   self->stream_finish_cond = g_cond_new ();
+  self->close_segments = DEFAULT_CLOSE_SEGMENTS;
+  self->close_position = -1;
 }
 
 static void
@@ -990,6 +1163,14 @@ gst_stream_synchronizer_class_init (GstStreamSynchronizerClass * klass)
       "streamsynchronizer", 0, "Stream Synchronizer");
 
   gobject_class->finalize = gst_stream_synchronizer_finalize;
+  gobject_class->set_property = gst_stream_synchronizer_set_property;
+  gobject_class->get_property = gst_stream_synchronizer_get_property;
+
+  g_object_class_install_property (gobject_class, PROP_CLOSE_SEGMENTS,
+      g_param_spec_boolean ("close-segments", "Close segments",
+          "Close the segments of all streams at the position where the last "
+          "of them ended when switching to new streams (for gapless playback)",
+          DEFAULT_CLOSE_SEGMENTS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   element_class->change_state =
       GST_DEBUG_FUNCPTR (gst_stream_synchronizer_change_state);
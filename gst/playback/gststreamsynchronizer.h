@@ -53,6 +53,10 @@ struct _GstStreamSynchronizer
   guint current_stream_number;
 
   GstClockTime group_start_time;
+
+  /* close all streams at a common position when switching streams */
+  gboolean close_segments;
+  gint64 close_position;
 };
 
 struct _GstStreamSynchronizerClass
@@ -485,37 +485,45 @@ detect_encoding (const gchar * str, gsize len)
   return NULL;
 }
 
-static gchar *
-convert_encoding (GstSubParse * self, const gchar * str, gsize len,
-    gsize * consumed)
+/* Converts as much of @str as possible to UTF-8 and appends it to the text
+ * buffer, returns the number of input bytes consumed */
+static gsize
+convert_encoding (GstSubParse * self, const gchar * str, gsize len)
 {
   const gchar *encoding;
   GError *err = NULL;
   gchar *ret = NULL;
-
-  *consumed = 0;
+  gsize consumed = 0;
 
   /* First try any detected encoding */
   if (self->detected_encoding) {
     ret =
-        gst_convert_to_utf8 (str, len, self->detected_encoding, consumed, &err);
+        gst_convert_to_utf8 (str, len, self->detected_encoding, &consumed,
+        &err);
 
     if (!err)
-      return ret;
+      goto done;
 
     GST_WARNING_OBJECT (self, "could not convert string from '%s' to UTF-8: %s",
         self->detected_encoding, err->message);
     g_free (self->detected_encoding);
     self->detected_encoding = NULL;
     g_error_free (err);
+    err = NULL;
   }
 
   /* Otherwise check if it's UTF8 */
   if (self->valid_utf8) {
-    if (g_utf8_validate (str, len, NULL)) {
+    const gchar *end;
+
+    /* a character might be split over two buffers, keep the incomplete
+     * character at the end for later then */
+    if (g_utf8_validate (str, len, &end) ||
+        g_utf8_get_char_validated (end, str + len - end) == (gunichar) - 2) {
       GST_LOG_OBJECT (self, "valid UTF-8, no conversion needed");
-      *consumed = len;
-      return g_strndup (str, len);
+      /* append as is, no need to copy it around first */
+      g_string_append_len (self->textbuf, str, end - str);
+      return end - str;
     }
     GST_INFO_OBJECT (self, "invalid UTF-8!");
     self->valid_utf8 = FALSE;
@@ -534,7 +542,7 @@ convert_encoding (GstSubParse * self, const gchar * str, gsize len,
     }
   }
 
-  ret = gst_convert_to_utf8 (str, len, encoding, consumed, &err);
+  ret = gst_convert_to_utf8 (str, len, encoding, &consumed, &err);
 
   if (err) {
     GST_WARNING_OBJECT (self, "could not convert string from '%s' to UTF-8: %s",
@@ -542,41 +550,45 @@ convert_encoding (GstSubParse * self, const gchar * str, gsize len,
     g_error_free (err);
 
     /* invalid input encoding, fall back to ISO-8859-15 (always succeeds) */
-    ret = gst_convert_to_utf8 (str, len, "ISO-8859-15", consumed, NULL);
+    ret = gst_convert_to_utf8 (str, len, "ISO-8859-15", &consumed, NULL);
   }
 
   GST_LOG_OBJECT (self,
       "successfully converted %" G_GSIZE_FORMAT " characters from %s to UTF-8"
       "%s", len, encoding, (err) ? " , using ISO-8859-15 as fallback" : "");
 
-  return ret;
+done:
+  if (ret) {
+    g_string_append (self->textbuf, ret);
+    g_free (ret);
+  }
+
+  return consumed;
 }
 
-static gchar *
+/* Returns the next complete line of the text buffer without the line ending,
+ * or NULL if more data is needed. The line is terminated in place and is
+ * valid until the text buffer is fed again. */
+static const gchar *
 get_next_line (GstSubParse * self)
 {
-  char *line = NULL;
-  const char *line_end;
-  int line_len;
-  gboolean have_r = FALSE;
+  gchar *line, *line_end;
 
-  line_end = strchr (self->textbuf->str, '\n');
+  line = self->textbuf->str + self->textbuf_pos;
+  line_end = memchr (line, '\n', self->textbuf->len - self->textbuf_pos);
 
   if (!line_end) {
     /* end-of-line not found; return for more data */
     return NULL;
   }
 
+  self->textbuf_pos = line_end + 1 - self->textbuf->str;
+
   /* get rid of '\r' */
-  if (line_end != self->textbuf->str && *(line_end - 1) == '\r') {
+  if (line_end != line && *(line_end - 1) == '\r')
     line_end--;
-    have_r = TRUE;
-  }
 
-  line_len = line_end - self->textbuf->str;
-  line = g_strndup (self->textbuf->str, line_len);
-  self->textbuf = g_string_erase (self->textbuf, 0,
-      line_len + (have_r ? 2 : 1));
+  *line_end = '\0';
   return line;
 }
 
@@ -1219,52 +1231,131 @@ parser_state_dispose (GstSubParse * self, ParserState * state)
   }
 }
 
-/* regex type enum */
-typedef enum
+/* Small matchers for the format autodetection, they all take and return
+ * NULL if an earlier part of the pattern didn't match already */
+static const gchar *
+skip_char (const gchar * p, gchar c)
 {
-  GST_SUB_PARSE_REGEX_UNKNOWN = 0,
-  GST_SUB_PARSE_REGEX_MDVDSUB = 1,
-  GST_SUB_PARSE_REGEX_SUBRIP = 2,
-  GST_SUB_PARSE_REGEX_DKS = 3,
-} GstSubParseRegex;
-
-static gpointer
-gst_sub_parse_data_format_autodetect_regex_once (GstSubParseRegex regtype)
+  return (p != NULL && *p == c) ? p + 1 : NULL;
+}
+
+static const gchar *
+skip_optional_char (const gchar * p, gchar c)
 {
-  gpointer result = NULL;
-  GError *gerr = NULL;
-  switch (regtype) {
-    case GST_SUB_PARSE_REGEX_MDVDSUB:
-      result =
-          (gpointer) g_regex_new ("^\\{[0-9]+\\}\\{[0-9]+\\}",
-          G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, &gerr);
-      if (result == NULL) {
-        g_warning ("Compilation of mdvd regex failed: %s", gerr->message);
-        g_error_free (gerr);
-      }
-      break;
-    case GST_SUB_PARSE_REGEX_SUBRIP:
-      result = (gpointer) g_regex_new ("^ {0,3}[ 0-9]{1,4}\\s*(\x0d)?\x0a"
-          " ?[0-9]{1,2}: ?[0-9]{1,2}: ?[0-9]{1,2}[,.] {0,2}[0-9]{1,3}"
-          " +--> +[0-9]{1,2}: ?[0-9]{1,2}: ?[0-9]{1,2}[,.] {0,2}[0-9]{1,2}",
-          G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, &gerr);
-      if (result == NULL) {
-        g_warning ("Compilation of subrip regex failed: %s", gerr->message);
-        g_error_free (gerr);
-      }
-      break;
-    case GST_SUB_PARSE_REGEX_DKS:
-      result = (gpointer) g_regex_new ("^\\[[0-9]+:[0-9]+:[0-9]+\\].*",
-          G_REGEX_RAW | G_REGEX_OPTIMIZE, 0, &gerr);
-      if (result == NULL) {
-        g_warning ("Compilation of dks regex failed: %s", gerr->message);
-        g_error_free (gerr);
-      }
-      break;
-    default:
-      GST_WARNING ("Trying to allocate regex of unknown type %u", regtype);
+  return (p != NULL && *p == c) ? p + 1 : p;
+}
+
+/* skips a run of @min to @max digits */
+static const gchar *
+skip_digits (const gchar * p, guint min, guint max)
+{
+  guint n = 0;
+
+  if (p == NULL)
+    return NULL;
+
+  while (g_ascii_isdigit (p[n]))
+    n++;
+
+  return (n >= min && n <= max) ? p + n : NULL;
+}
+
+/* skips a run of @min to @max spaces */
+static const gchar *
+skip_spaces (const gchar * p, guint min, guint max)
+{
+  guint n = 0;
+
+  if (p == NULL)
+    return NULL;
+
+  while (p[n] == ' ')
+    n++;
+
+  return (n >= min && n <= max) ? p + n : NULL;
+}
+
+/* ^\{[0-9]+\}\{[0-9]+\} */
+static gboolean
+gst_sub_parse_match_mdvdsub (const gchar * str)
+{
+  str = skip_char (str, '{');
+  str = skip_digits (str, 1, G_MAXUINT);
+  str = skip_char (str, '}');
+  str = skip_char (str, '{');
+  str = skip_digits (str, 1, G_MAXUINT);
+  return skip_char (str, '}') != NULL;
+}
+
+/* ^\[[0-9]+:[0-9]+:[0-9]+\] */
+static gboolean
+gst_sub_parse_match_dks (const gchar * str)
+{
+  str = skip_char (str, '[');
+  str = skip_digits (str, 1, G_MAXUINT);
+  str = skip_char (str, ':');
+  str = skip_digits (str, 1, G_MAXUINT);
+  str = skip_char (str, ':');
+  str = skip_digits (str, 1, G_MAXUINT);
+  return skip_char (str, ']') != NULL;
+}
+
+/*  ?[0-9]{1,2}: ?[0-9]{1,2}: ?[0-9]{1,2}[,.] {0,2} */
+static const gchar *
+skip_subrip_time (const gchar * p)
+{
+  p = skip_optional_char (p, ' ');
+  p = skip_digits (p, 1, 2);
+  p = skip_char (p, ':');
+  p = skip_optional_char (p, ' ');
+  p = skip_digits (p, 1, 2);
+  p = skip_char (p, ':');
+  p = skip_optional_char (p, ' ');
+  p = skip_digits (p, 1, 2);
+  if (p == NULL || (*p != ',' && *p != '.'))
+    return NULL;
+  return skip_spaces (p + 1, 0, 2);
+}
+
+/* ^ {0,3}[ 0-9]{1,4}\s*(\x0d)?\x0a
+ *  ?[0-9]{1,2}: ?[0-9]{1,2}: ?[0-9]{1,2}[,.] {0,2}[0-9]{1,3}
+ *  +--> +[0-9]{1,2}: ?[0-9]{1,2}: ?[0-9]{1,2}[,.] {0,2}[0-9]{1,2} */
+static gboolean
+gst_sub_parse_match_subrip (const gchar * str)
+{
+  const gchar *p = str, *nl = NULL;
+  guint n_spaces = 0, n_digits_end = 0, n;
+
+  /* the chunk number: at most 3 spaces, then 1-4 spaces or digits, where
+   * spaces after the last digit can also be part of the white space */
+  for (n = 0; str[n] == ' ' || g_ascii_isdigit (str[n]); n++) {
+    if (str[n] != ' ')
+      n_digits_end = n + 1;
+    else if (n == n_spaces)
+      n_spaces++;
+  }
+  if (n == 0 || MAX (n_digits_end, 1) > MIN (n_spaces, 3) + 4)
+    return FALSE;
+
+  /* white space up to the last newline */
+  for (p = str + n; *p == ' ' || *p == '\t' || *p == '\n' || *p == '\f' ||
+      *p == '\r'; p++) {
+    if (*p == '\n')
+      nl = p;
   }
-  return result;
+  if (nl == NULL)
+    return FALSE;
+
+  p = skip_subrip_time (nl + 1);
+  p = skip_digits (p, 1, 3);
+  p = skip_spaces (p, 1, G_MAXUINT);
+  p = skip_char (p, '-');
+  p = skip_char (p, '-');
+  p = skip_char (p, '>');
+  p = skip_spaces (p, 1, G_MAXUINT);
+  p = skip_subrip_time (p);
+
+  return p != NULL && g_ascii_isdigit (*p);
 }
 
 /*
@@ -1278,37 +1369,15 @@ gst_sub_parse_data_format_autodetect (gchar * match_str)
 {
   guint n1, n2, n3;
 
-  static GOnce mdvd_rx_once = G_ONCE_INIT;
-  static GOnce subrip_rx_once = G_ONCE_INIT;
-  static GOnce dks_rx_once = G_ONCE_INIT;
-
-  GRegex *mdvd_grx;
-  GRegex *subrip_grx;
-  GRegex *dks_grx;
-
-  g_once (&mdvd_rx_once,
-      (GThreadFunc) gst_sub_parse_data_format_autodetect_regex_once,
-      (gpointer) GST_SUB_PARSE_REGEX_MDVDSUB);
-  g_once (&subrip_rx_once,
-      (GThreadFunc) gst_sub_parse_data_format_autodetect_regex_once,
-      (gpointer) GST_SUB_PARSE_REGEX_SUBRIP);
-  g_once (&dks_rx_once,
-      (GThreadFunc) gst_sub_parse_data_format_autodetect_regex_once,
-      (gpointer) GST_SUB_PARSE_REGEX_DKS);
-
-  mdvd_grx = (GRegex *) mdvd_rx_once.retval;
-  subrip_grx = (GRegex *) subrip_rx_once.retval;
-  dks_grx = (GRegex *) dks_rx_once.retval;
-
-  if (g_regex_match (mdvd_grx, match_str, 0, NULL) == TRUE) {
+  if (gst_sub_parse_match_mdvdsub (match_str)) {
     GST_LOG ("MicroDVD (frame based) format detected");
     return GST_SUB_PARSE_FORMAT_MDVDSUB;
   }
-  if (g_regex_match (subrip_grx, match_str, 0, NULL) == TRUE) {
+  if (gst_sub_parse_match_subrip (match_str)) {
     GST_LOG ("SubRip (time based) format detected");
     return GST_SUB_PARSE_FORMAT_SUBRIP;
   }
-  if (g_regex_match (dks_grx, match_str, 0, NULL) == TRUE) {
+  if (gst_sub_parse_match_dks (match_str)) {
     GST_LOG ("DKS (time based) format detected");
     return GST_SUB_PARSE_FORMAT_DKS;
   }
@@ -1356,12 +1425,14 @@ gst_sub_parse_format_autodetect (GstSubParse * self)
   gchar *data;
   GstSubParseFormat format;
 
-  if (strlen (self->textbuf->str) < 30) {
+  data = self->textbuf->str + self->textbuf_pos;
+
+  if (strlen (data) < 30) {
     GST_DEBUG ("File too small to be a subtitles file");
     return NULL;
   }
 
-  data = g_strndup (self->textbuf->str, 35);
+  data = g_strndup (data, 35);
   format = gst_sub_parse_data_format_autodetect (data);
   g_free (data);
 
@@ -1415,8 +1486,8 @@ static void
 feed_textbuf (GstSubParse * self, GstBuffer * buf)
 {
   gboolean discont;
+  guint avail;
   gsize consumed;
-  gchar *input = NULL;
 
   discont = GST_BUFFER_IS_DISCONT (buf);
 
@@ -1431,6 +1502,7 @@ feed_textbuf (GstSubParse * self, GstBuffer * buf)
     /* flush the parser state */
     parser_state_init (&self->state);
     g_string_truncate (self->textbuf, 0);
+    self->textbuf_pos = 0;
     gst_adapter_clear (self->adapter);
 #ifndef GST_DISABLE_XML
     if (self->parser_type == GST_SUB_PARSE_FORMAT_SAMI)
@@ -1446,17 +1518,19 @@ feed_textbuf (GstSubParse * self, GstBuffer * buf)
 
   gst_adapter_push (self->adapter, buf);
 
-  input =
-      convert_encoding (self, (const gchar *) gst_adapter_peek (self->adapter,
-          gst_adapter_available (self->adapter)),
-      (gsize) gst_adapter_available (self->adapter), &consumed);
-
-  if (input && consumed > 0) {
-    self->textbuf = g_string_append (self->textbuf, input);
-    gst_adapter_flush (self->adapter, consumed);
+  /* drop the lines parsed already, so only the last incomplete line is
+   * moved instead of the whole text for every line */
+  if (self->textbuf_pos > 0) {
+    g_string_erase (self->textbuf, 0, self->textbuf_pos);
+    self->textbuf_pos = 0;
   }
 
-  g_free (input);
+  avail = gst_adapter_available (self->adapter);
+  consumed = convert_encoding (self,
+      (const gchar *) gst_adapter_peek (self->adapter, avail), avail);
+
+  if (consumed > 0)
+    gst_adapter_flush (self->adapter, consumed);
 }
 
 static GstFlowReturn
@@ -1464,7 +1538,8 @@ handle_buffer (GstSubParse * self, GstBuffer * buf)
 {
   GstFlowReturn ret = GST_FLOW_OK;
   GstCaps *caps = NULL;
-  gchar *line, *subtitle;
+  const gchar *line;
+  gchar *subtitle;
 
   if (self->first_buffer) {
     self->detected_encoding =
@@ -1507,7 +1582,6 @@ handle_buffer (GstSubParse * self, GstBuffer * buf)
     /* Now parse the line, out of segment lines will just return NULL */
     GST_LOG_OBJECT (self, "Parsing line '%s'", line + offset);
     subtitle = self->parse_line (&self->state, line + offset);
-    g_free (line);
 
     if (subtitle) {
       guint subtitle_len = strlen (subtitle);
@@ -1686,6 +1760,7 @@ gst_sub_parse_change_state (GstElement * element, GstStateChange transition)
       g_free (self->detected_encoding);
       self->detected_encoding = NULL;
       g_string_truncate (self->textbuf, 0);
+      self->textbuf_pos = 0;
       gst_adapter_clear (self->adapter);
       break;
     default:
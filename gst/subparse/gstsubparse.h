@@ -81,6 +81,8 @@ struct _GstSubParse {
   GstAdapter *adapter;
   /* contains the UTF-8 decoded input */
   GString *textbuf;
+  /* start of the text not parsed yet */
+  gsize textbuf_pos;
 
   GstSubParseFormat parser_type;
   gboolean parser_detected;
@@ -0,0 +1,517 @@
+/* GStreamer
+ * gstshmgdp.c: shared memory helpers for shmgdpsink and shmgdpsrc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+
+#include <glib/gstdio.h>
+
+#include "gstshmgdp.h"
+
+GST_DEBUG_CATEGORY_EXTERN (tcp_debug);
+#define GST_CAT_DEFAULT tcp_debug
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+/* the memory of a slot buffer, keeps the area alive and the slot in use */
+typedef struct
+{
+  GstShmGDPArea *area;
+  guint slot;
+} GstShmGDPSlotRef;
+
+static GstShmGDPArea *
+gst_shm_gdp_area_map (gint fd, guint n_slots, guint slot_size,
+    gboolean readonly)
+{
+  GstShmGDPArea *area;
+  gsize size;
+  gpointer data;
+
+  size = (gsize) n_slots * slot_size;
+  data = mmap (NULL, size, readonly ? PROT_READ : PROT_READ | PROT_WRITE,
+      MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED)
+    return NULL;
+
+  area = g_slice_new0 (GstShmGDPArea);
+  area->refcount = 1;
+  area->fd = fd;
+  area->data = data;
+  area->size = size;
+  area->n_slots = n_slots;
+  area->slot_size = slot_size;
+  area->readonly = readonly;
+  area->lock = g_mutex_new ();
+  area->release_fd = -1;
+  area->send_lock = g_mutex_new ();
+
+  return area;
+}
+
+/* create a new area in a file that is unlinked right away, it can only be
+ * reached by passing the file descriptor. Returns NULL and sets errno on
+ * failure. */
+GstShmGDPArea *
+gst_shm_gdp_area_new (guint n_slots, guint slot_size)
+{
+  GstShmGDPArea *area;
+  gchar *filename = NULL;
+  gint fd = -1, err;
+
+  g_return_val_if_fail (n_slots > 0, NULL);
+  g_return_val_if_fail (slot_size > 0, NULL);
+
+  if (n_slots > G_MAXSIZE / slot_size) {
+    errno = EINVAL;
+    return NULL;
+  }
+
+  /* prefer tmpfs so that the pages are never written back to disk */
+  if (g_file_test ("/dev/shm", G_FILE_TEST_IS_DIR)) {
+    filename = g_strdup ("/dev/shm/gst-shmgdp-XXXXXX");
+    fd = g_mkstemp (filename);
+  }
+  if (fd < 0) {
+    g_free (filename);
+    fd = g_file_open_tmp ("gst-shmgdp-XXXXXX", &filename, NULL);
+    if (fd < 0)
+      return NULL;
+  }
+  g_unlink (filename);
+  g_free (filename);
+
+  if (ftruncate (fd, (off_t) n_slots * slot_size) < 0)
+    goto error;
+
+  if (!(area = gst_shm_gdp_area_map (fd, n_slots, slot_size, FALSE)))
+    goto error;
+
+  area->slot_refs = g_new0 (guint, n_slots);
+
+  GST_DEBUG ("created area of %u slots of %u bytes", n_slots, slot_size);
+
+  return area;
+
+error:
+  {
+    err = errno;
+    close (fd);
+    errno = err;
+    return NULL;
+  }
+}
+
+/* map the area of @fd, which must be at least @n_slots * @slot_size bytes.
+ * Takes ownership of @fd. Releasing a slot sends a message on a copy of
+ * @release_fd until gst_shm_gdp_area_disconnect() is called. */
+GstShmGDPArea *
+gst_shm_gdp_area_new_from_fd (gint fd, guint n_slots, guint slot_size,
+    gint release_fd)
+{
+  GstShmGDPArea *area;
+  struct stat st;
+
+  if (n_slots == 0 || slot_size == 0 || n_slots > G_MAXSIZE / slot_size)
+    goto invalid;
+
+  /* don't map beyond the end of the file, we'd crash when reading it */
+  if (fstat (fd, &st) < 0 || st.st_size < (off_t) n_slots * slot_size)
+    goto invalid;
+
+  if (!(area = gst_shm_gdp_area_map (fd, n_slots, slot_size, TRUE)))
+    goto invalid;
+
+  /* buffers can outlive the socket of the src, keep our own copy so that
+   * we never write to a closed or reused file descriptor */
+  if ((area->release_fd = dup (release_fd)) < 0) {
+    gst_shm_gdp_area_unref (area);
+    return NULL;
+  }
+  area->connected = TRUE;
+
+  return area;
+
+invalid:
+  {
+    close (fd);
+    return NULL;
+  }
+}
+
+GstShmGDPArea *
+gst_shm_gdp_area_ref (GstShmGDPArea * area)
+{
+  g_atomic_int_inc (&area->refcount);
+
+  return area;
+}
+
+void
+gst_shm_gdp_area_unref (GstShmGDPArea * area)
+{
+  if (!g_atomic_int_dec_and_test (&area->refcount))
+    return;
+
+  munmap (area->data, area->size);
+  close (area->fd);
+  if (area->release_fd >= 0)
+    close (area->release_fd);
+  g_mutex_free (area->lock);
+  g_mutex_free (area->send_lock);
+  g_free (area->slot_refs);
+  g_slice_free (GstShmGDPArea, area);
+}
+
+/* find an unused slot and mark it in use, returns -1 when all slots are in
+ * use */
+gint
+gst_shm_gdp_area_acquire_slot (GstShmGDPArea * area)
+{
+  gint result = -1;
+  guint i, slot;
+
+  g_mutex_lock (area->lock);
+  for (i = 0; i < area->n_slots; i++) {
+    slot = (area->next_slot + i) % area->n_slots;
+    if (area->slot_refs[slot] == 0) {
+      area->slot_refs[slot] = 1;
+      area->next_slot = slot + 1;
+      result = slot;
+      break;
+    }
+  }
+  g_mutex_unlock (area->lock);
+
+  return result;
+}
+
+/* the slot that contains all @size bytes of @data, -1 if there is none */
+gint
+gst_shm_gdp_area_find_slot (GstShmGDPArea * area, const guint8 * data,
+    guint size)
+{
+  guint slot;
+
+  if (data < area->data || data >= area->data + area->size)
+    return -1;
+
+  slot = (data - area->data) / area->slot_size;
+  if (data + size > area->data + (gsize) (slot + 1) * area->slot_size)
+    return -1;
+
+  return slot;
+}
+
+void
+gst_shm_gdp_area_ref_slot (GstShmGDPArea * area, guint slot)
+{
+  g_return_if_fail (slot < area->n_slots);
+  g_return_if_fail (area->slot_refs != NULL);
+
+  g_mutex_lock (area->lock);
+  area->slot_refs[slot]++;
+  g_mutex_unlock (area->lock);
+}
+
+void
+gst_shm_gdp_area_unref_slot (GstShmGDPArea * area, guint slot)
+{
+  gboolean release = FALSE;
+
+  g_return_if_fail (slot < area->n_slots);
+
+  g_mutex_lock (area->lock);
+  if (area->slot_refs) {
+    g_assert (area->slot_refs[slot] > 0);
+    area->slot_refs[slot]--;
+  } else {
+    release = area->connected;
+  }
+  g_mutex_unlock (area->lock);
+
+  if (release) {
+    guint8 body[GST_SHM_GDP_RELEASE_LENGTH];
+    gboolean res;
+
+    GST_WRITE_UINT32_BE (body, slot);
+    g_mutex_lock (area->send_lock);
+    res = gst_shm_gdp_write_message (area->release_fd,
+        GST_SHM_GDP_MSG_RELEASE, body, sizeof (body), NULL, 0);
+    g_mutex_unlock (area->send_lock);
+    if (!res)
+      GST_WARNING ("could not release slot %u: %s", slot, g_strerror (errno));
+  }
+}
+
+/* stop sending RELEASE messages, the slots are released by the sink when it
+ * sees the connection close */
+void
+gst_shm_gdp_area_disconnect (GstShmGDPArea * area)
+{
+  g_mutex_lock (area->lock);
+  area->connected = FALSE;
+  g_mutex_unlock (area->lock);
+
+  /* our copy keeps the connection open, shut it down so that the sink sees
+   * it close and a blocked RELEASE message fails */
+  if (area->release_fd >= 0)
+    shutdown (area->release_fd, SHUT_RDWR);
+}
+
+static void
+gst_shm_gdp_slot_ref_free (gpointer data)
+{
+  GstShmGDPSlotRef *ref = data;
+
+  gst_shm_gdp_area_unref_slot (ref->area, ref->slot);
+  gst_shm_gdp_area_unref (ref->area);
+  g_slice_free (GstShmGDPSlotRef, ref);
+}
+
+/* make a buffer of @size bytes at @offset in @slot. The buffer takes over one
+ * use of the slot, which is released when the buffer is freed. */
+GstBuffer *
+gst_shm_gdp_area_wrap_slot (GstShmGDPArea * area, guint slot, guint offset,
+    guint size)
+{
+  GstShmGDPSlotRef *ref;
+  GstBuffer *buffer;
+
+  g_return_val_if_fail (slot < area->n_slots, NULL);
+  g_return_val_if_fail (offset <= area->slot_size, NULL);
+  g_return_val_if_fail (size <= area->slot_size - offset, NULL);
+
+  ref = g_slice_new (GstShmGDPSlotRef);
+  ref->area = gst_shm_gdp_area_ref (area);
+  ref->slot = slot;
+
+  buffer = gst_buffer_new ();
+  GST_BUFFER_DATA (buffer) = area->data + (gsize) slot * area->slot_size +
+      offset;
+  GST_BUFFER_SIZE (buffer) = size;
+  GST_BUFFER_MALLOCDATA (buffer) = (guint8 *) ref;
+  GST_BUFFER_FREE_FUNC (buffer) = gst_shm_gdp_slot_ref_free;
+
+  /* the mapping is read-only, make in-place elements copy */
+  if (area->readonly)
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_READONLY);
+
+  return buffer;
+}
+
+/* write a message with a body of @data1 followed by @data2 in one go.
+ * Returns FALSE and sets errno on failure. */
+gboolean
+gst_shm_gdp_write_message (int socket, GstShmGDPMessageType type,
+    const guint8 * data1, guint size1, const guint8 * data2, guint size2)
+{
+  guint8 header[GST_SHM_GDP_MSG_HEADER_LENGTH];
+  struct iovec iov[3];
+  struct msghdr msg;
+  ssize_t wrote;
+
+  GST_WRITE_UINT32_BE (header, type);
+  GST_WRITE_UINT32_BE (header + 4, size1 + size2);
+
+  iov[0].iov_base = header;
+  iov[0].iov_len = sizeof (header);
+  iov[1].iov_base = (gpointer) data1;
+  iov[1].iov_len = size1;
+  iov[2].iov_base = (gpointer) data2;
+  iov[2].iov_len = size2;
+
+  memset (&msg, 0, sizeof (msg));
+  msg.msg_iov = iov;
+  msg.msg_iovlen = 3;
+
+  while (msg.msg_iovlen > 0) {
+    wrote = sendmsg (socket, &msg, MSG_NOSIGNAL);
+    if (wrote < 0) {
+      if (errno == EINTR)
+        continue;
+      return FALSE;
+    }
+    /* skip what was written and continue with the rest */
+    while (msg.msg_iovlen > 0 && (gsize) wrote >= msg.msg_iov[0].iov_len) {
+      wrote -= msg.msg_iov[0].iov_len;
+      msg.msg_iov++;
+      msg.msg_iovlen--;
+    }
+    if (msg.msg_iovlen > 0) {
+      msg.msg_iov[0].iov_base = (guint8 *) msg.msg_iov[0].iov_base + wrote;
+      msg.msg_iov[0].iov_len -= wrote;
+    }
+  }
+
+  return TRUE;
+}
+
+/* send the AREA message, passing the file descriptor of the area */
+gboolean
+gst_shm_gdp_write_area (int socket, GstShmGDPArea * area)
+{
+  guint8 data[GST_SHM_GDP_MSG_HEADER_LENGTH + GST_SHM_GDP_AREA_LENGTH];
+  union
+  {
+    struct cmsghdr hdr;
+    gchar buf[CMSG_SPACE (sizeof (int))];
+  } control;
+  struct cmsghdr *cmsg;
+  struct iovec iov;
+  struct msghdr msg;
+
+  GST_WRITE_UINT32_BE (data, GST_SHM_GDP_MSG_AREA);
+  GST_WRITE_UINT32_BE (data + 4, GST_SHM_GDP_AREA_LENGTH);
+  GST_WRITE_UINT32_BE (data + 8, area->n_slots);
+  GST_WRITE_UINT32_BE (data + 12, area->slot_size);
+
+  iov.iov_base = data;
+  iov.iov_len = sizeof (data);
+
+  memset (&msg, 0, sizeof (msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof (control.buf);
+
+  cmsg = CMSG_FIRSTHDR (&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN (sizeof (int));
+  memcpy (CMSG_DATA (cmsg), &area->fd, sizeof (int));
+
+  /* the message is tiny and the first one on the connection, it is never
+   * written partially */
+  return sendmsg (socket, &msg, MSG_NOSIGNAL) == sizeof (data);
+}
+
+/* read the AREA message and map the area it passes, cancellable */
+GstFlowReturn
+gst_shm_gdp_read_area (GstElement * this, int socket, GstPoll * fdset,
+    GstShmGDPArea ** area)
+{
+  guint8 data[GST_SHM_GDP_MSG_HEADER_LENGTH + GST_SHM_GDP_AREA_LENGTH];
+  union
+  {
+    struct cmsghdr hdr;
+    gchar buf[CMSG_SPACE (sizeof (int))];
+  } control;
+  struct cmsghdr *cmsg;
+  struct iovec iov;
+  struct msghdr msg;
+  ssize_t n;
+  gint fd = -1, ret;
+
+  if ((ret = gst_poll_wait (fdset, GST_CLOCK_TIME_NONE)) <= 0) {
+    if (ret == -1 && errno == EBUSY)
+      goto cancelled;
+    else
+      goto select_error;
+  }
+
+  iov.iov_base = data;
+  iov.iov_len = sizeof (data);
+
+  memset (&msg, 0, sizeof (msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof (control.buf);
+
+  do {
+    n = recvmsg (socket, &msg, MSG_WAITALL);
+  } while (n < 0 && errno == EINTR);
+
+  if (n == 0)
+    goto got_eos;
+  if (n < 0)
+    goto read_error;
+
+  for (cmsg = CMSG_FIRSTHDR (&msg); cmsg; cmsg = CMSG_NXTHDR (&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS &&
+        cmsg->cmsg_len == CMSG_LEN (sizeof (int)))
+      memcpy (&fd, CMSG_DATA (cmsg), sizeof (int));
+  }
+
+  if (n != sizeof (data) || fd < 0 ||
+      GST_READ_UINT32_BE (data) != GST_SHM_GDP_MSG_AREA ||
+      GST_READ_UINT32_BE (data + 4) != GST_SHM_GDP_AREA_LENGTH)
+    goto invalid_message;
+
+  *area = gst_shm_gdp_area_new_from_fd (fd, GST_READ_UINT32_BE (data + 8),
+      GST_READ_UINT32_BE (data + 12), socket);
+  if (*area == NULL)
+    goto map_failed;
+
+  GST_DEBUG_OBJECT (this, "mapped area of %u slots of %u bytes",
+      (*area)->n_slots, (*area)->slot_size);
+
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+select_error:
+  {
+    GST_ELEMENT_ERROR (this, RESOURCE, READ, (NULL),
+        ("select failed: %s", g_strerror (errno)));
+    return GST_FLOW_ERROR;
+  }
+cancelled:
+  {
+    GST_DEBUG_OBJECT (this, "Select was cancelled");
+    return GST_FLOW_WRONG_STATE;
+  }
+got_eos:
+  {
+    GST_DEBUG_OBJECT (this, "Got EOS on socket stream");
+    return GST_FLOW_UNEXPECTED;
+  }
+read_error:
+  {
+    GST_ELEMENT_ERROR (this, RESOURCE, READ, (NULL),
+        ("read failed: %s", g_strerror (errno)));
+    return GST_FLOW_ERROR;
+  }
+invalid_message:
+  {
+    if (fd >= 0)
+      close (fd);
+    GST_ELEMENT_ERROR (this, STREAM, DECODE, (NULL),
+        ("did not receive a shared memory area"));
+    return GST_FLOW_ERROR;
+  }
+map_failed:
+  {
+    GST_ELEMENT_ERROR (this, RESOURCE, READ, (NULL),
+        ("could not map the shared memory area"));
+    return GST_FLOW_ERROR;
+  }
+}
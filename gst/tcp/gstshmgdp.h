@@ -0,0 +1,114 @@
+/* GStreamer
+ * gstshmgdp.h: shared memory helpers for shmgdpsink and shmgdpsrc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GST_SHM_GDP_H__
+#define __GST_SHM_GDP_H__
+
+#include <gst/gst.h>
+
+#include "gsttcp.h"
+
+G_BEGIN_DECLS
+
+/* Messages exchanged over the unix socket. Each message starts with a
+ * 32 bit type and a 32 bit body length, both big endian.
+ *
+ * AREA:    sink -> src, the first message on a connection. The body has the
+ *          number of slots and the slot size, the file descriptor of the
+ *          shared memory area is passed along as ancillary data.
+ * PACKET:  sink -> src, a complete GDP packet (caps, event or a buffer with
+ *          its payload inline).
+ * SLOT:    sink -> src, a GDP buffer header followed by the slot index and the
+ *          offset of the payload in the slot. The payload length in the
+ *          header is the size of the data in the slot.
+ * RELEASE: src -> sink, the src no longer uses the slot it was sent.
+ */
+typedef enum {
+  GST_SHM_GDP_MSG_AREA = 1,
+  GST_SHM_GDP_MSG_PACKET,
+  GST_SHM_GDP_MSG_SLOT,
+  GST_SHM_GDP_MSG_RELEASE
+} GstShmGDPMessageType;
+
+#define GST_SHM_GDP_MSG_HEADER_LENGTH   8
+#define GST_SHM_GDP_AREA_LENGTH         8
+#define GST_SHM_GDP_SLOT_LENGTH         (GST_DP_HEADER_LENGTH + 8)
+#define GST_SHM_GDP_RELEASE_LENGTH      4
+
+typedef struct _GstShmGDPArea GstShmGDPArea;
+
+/* GstShmGDPArea:
+ *
+ * A shared memory area split in @n_slots slots of @slot_size bytes.
+ *
+ * On the sink side, @slot_refs counts the users of each slot: the buffer
+ * that was allocated in the slot and every client that was sent the slot and
+ * did not release it yet. A slot is reused when its count drops to 0.
+ *
+ * On the src side, the area is mapped @readonly, @release_fd is a copy of the
+ * socket to the sink owned by the area and dropping the last ref to a slot
+ * buffer sends a RELEASE message for the slot while @connected is set.
+ * @send_lock serializes these messages, @lock is never held while writing.
+ */
+struct _GstShmGDPArea {
+  gint refcount;
+
+  gint fd;
+  guint8 *data;
+  gsize size;
+
+  guint n_slots;
+  guint slot_size;
+  gboolean readonly;
+
+  GMutex *lock;
+  guint *slot_refs;
+  guint next_slot;
+  gint release_fd;
+  gboolean connected;
+
+  GMutex *send_lock;
+};
+
+GstShmGDPArea * gst_shm_gdp_area_new         (guint n_slots, guint slot_size);
+GstShmGDPArea * gst_shm_gdp_area_new_from_fd (gint fd, guint n_slots, guint slot_size,
+                                              gint release_fd);
+GstShmGDPArea * gst_shm_gdp_area_ref         (GstShmGDPArea * area);
+void            gst_shm_gdp_area_unref       (GstShmGDPArea * area);
+
+gint            gst_shm_gdp_area_acquire_slot (GstShmGDPArea * area);
+gint            gst_shm_gdp_area_find_slot    (GstShmGDPArea * area, const guint8 * data,
+                                               guint size);
+void            gst_shm_gdp_area_ref_slot     (GstShmGDPArea * area, guint slot);
+void            gst_shm_gdp_area_unref_slot   (GstShmGDPArea * area, guint slot);
+void            gst_shm_gdp_area_disconnect   (GstShmGDPArea * area);
+
+GstBuffer *     gst_shm_gdp_area_wrap_slot    (GstShmGDPArea * area, guint slot,
+                                               guint offset, guint size);
+
+gboolean        gst_shm_gdp_write_message     (int socket, GstShmGDPMessageType type,
+                                               const guint8 * data1, guint size1,
+                                               const guint8 * data2, guint size2);
+gboolean        gst_shm_gdp_write_area        (int socket, GstShmGDPArea * area);
+GstFlowReturn   gst_shm_gdp_read_area         (GstElement * this, int socket, GstPoll * fdset,
+                                               GstShmGDPArea ** area);
+
+G_END_DECLS
+
+#endif /* __GST_SHM_GDP_H__ */
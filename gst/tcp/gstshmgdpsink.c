@@ -0,0 +1,849 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * SECTION:element-shmgdpsink
+ * @see_also: #shmgdpsrc, #tcpserversink
+ *
+ * Sends buffers to shmgdpsrc elements in other processes on the same
+ * machine. The GDP headers, caps and events go over a unix socket while the
+ * buffer data is placed in a shared memory area, so that the receiving
+ * process can use it without copying.
+ *
+ * The shared memory area is split in #GstShmGDPSink:num-slots slots of
+ * #GstShmGDPSink:slot-size bytes. Buffers that upstream allocates with
+ * gst_pad_alloc_buffer() are placed directly in a free slot and are sent
+ * without any copy. Other buffers are copied into a free slot once. A slot
+ * is reused when all clients released it. When no slot is free or a buffer
+ * does not fit in a slot, the data is sent over the socket instead.
+ *
+ * Writing to a client blocks when it does not read, like tcpserversink.
+ *
+ * <refsect2>
+ * <title>Example launch line</title>
+ * |[
+ * # server:
+ * gst-launch videotestsrc ! video/x-raw-yuv,width=1280,height=720 ! shmgdpsink socket-path=/tmp/video
+ * # client:
+ * gst-launch shmgdpsrc socket-path=/tmp/video ! ffmpegcolorspace ! xvimagesink
+ * ]| Passes raw video frames between two processes.
+ * </refsect2>
+ *
+ * Since: 0.10.37
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <glib/gstdio.h>
+
+#include "gstshmgdpsink.h"
+
+GST_DEBUG_CATEGORY_STATIC (shmgdpsink_debug);
+#define GST_CAT_DEFAULT shmgdpsink_debug
+
+#define CLIENTS_LOCK(sink)      (g_mutex_lock ((sink)->clientslock))
+#define CLIENTS_UNLOCK(sink)    (g_mutex_unlock ((sink)->clientslock))
+
+#define DEFAULT_SOCKET_PATH     NULL
+#define DEFAULT_NUM_SLOTS       8
+#define DEFAULT_SLOT_SIZE       (4 * 1024 * 1024)
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+enum
+{
+  PROP_0,
+  PROP_SOCKET_PATH,
+  PROP_NUM_SLOTS,
+  PROP_SLOT_SIZE
+};
+
+/* a connected shmgdpsrc. The socket is written from the streaming thread
+ * without the CLIENTS_LOCK, the writer holds a ref on the client so that a
+ * concurrent removal does not close the socket under it. */
+typedef struct
+{
+  gint refcount;
+
+  GstPollFD fd;
+
+  /* how many times each slot was sent and not released yet */
+  guint *held;
+
+  /* partially read RELEASE message */
+  guint8 data[GST_SHM_GDP_MSG_HEADER_LENGTH + GST_SHM_GDP_RELEASE_LENGTH];
+  guint data_len;
+
+  /* no longer in the clients list */
+  gboolean removed;
+
+  /* only used by the streaming thread */
+  gboolean setup;
+  gboolean failed;
+} GstShmGDPClient;
+
+GST_BOILERPLATE (GstShmGDPSink, gst_shm_gdp_sink, GstBaseSink,
+    GST_TYPE_BASE_SINK);
+
+static void gst_shm_gdp_sink_finalize (GObject * gobject);
+
+static gboolean gst_shm_gdp_sink_start (GstBaseSink * bsink);
+static gboolean gst_shm_gdp_sink_stop (GstBaseSink * bsink);
+static gboolean gst_shm_gdp_sink_set_caps (GstBaseSink * bsink,
+    GstCaps * caps);
+static gboolean gst_shm_gdp_sink_event (GstBaseSink * bsink,
+    GstEvent * event);
+static GstFlowReturn gst_shm_gdp_sink_buffer_alloc (GstBaseSink * bsink,
+    guint64 offset, guint size, GstCaps * caps, GstBuffer ** buf);
+static GstFlowReturn gst_shm_gdp_sink_render (GstBaseSink * bsink,
+    GstBuffer * buf);
+
+static void gst_shm_gdp_sink_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_shm_gdp_sink_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
+static void
+gst_shm_gdp_sink_base_init (gpointer g_class)
+{
+  GstElementClass *element_class = GST_ELEMENT_CLASS (g_class);
+
+  gst_element_class_add_static_pad_template (element_class, &sinktemplate);
+
+  gst_element_class_set_details_simple (element_class,
+      "Shared memory GDP sink", "Sink/Network",
+      "Send data to other processes on this machine through shared memory",
+      "GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>");
+}
+
+static void
+gst_shm_gdp_sink_class_init (GstShmGDPSinkClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstBaseSinkClass *gstbasesink_class;
+
+  gobject_class = (GObjectClass *) klass;
+  gstbasesink_class = (GstBaseSinkClass *) klass;
+
+  gobject_class->set_property = gst_shm_gdp_sink_set_property;
+  gobject_class->get_property = gst_shm_gdp_sink_get_property;
+  gobject_class->finalize = gst_shm_gdp_sink_finalize;
+
+  g_object_class_install_property (gobject_class, PROP_SOCKET_PATH,
+      g_param_spec_string ("socket-path", "Socket Path",
+          "The path of the unix socket to listen on", DEFAULT_SOCKET_PATH,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_NUM_SLOTS,
+      g_param_spec_uint ("num-slots", "Number of slots",
+          "The number of buffers the shared memory area can hold", 1, 1024,
+          DEFAULT_NUM_SLOTS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SLOT_SIZE,
+      g_param_spec_uint ("slot-size", "Slot size",
+          "The size in bytes of one buffer in the shared memory area", 1,
+          G_MAXINT, DEFAULT_SLOT_SIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gstbasesink_class->start = gst_shm_gdp_sink_start;
+  gstbasesink_class->stop = gst_shm_gdp_sink_stop;
+  gstbasesink_class->set_caps = gst_shm_gdp_sink_set_caps;
+  gstbasesink_class->event = gst_shm_gdp_sink_event;
+  gstbasesink_class->buffer_alloc = gst_shm_gdp_sink_buffer_alloc;
+  gstbasesink_class->render = gst_shm_gdp_sink_render;
+
+  GST_DEBUG_CATEGORY_INIT (shmgdpsink_debug, "shmgdpsink", 0,
+      "Shared memory GDP sink");
+}
+
+static void
+gst_shm_gdp_sink_init (GstShmGDPSink * this, GstShmGDPSinkClass * klass)
+{
+  this->socket_path = g_strdup (DEFAULT_SOCKET_PATH);
+  this->num_slots = DEFAULT_NUM_SLOTS;
+  this->slot_size = DEFAULT_SLOT_SIZE;
+
+  gst_poll_fd_init (&this->server_sock);
+  this->clientslock = g_mutex_new ();
+}
+
+static void
+gst_shm_gdp_sink_finalize (GObject * gobject)
+{
+  GstShmGDPSink *this = GST_SHM_GDP_SINK (gobject);
+
+  g_free (this->socket_path);
+  g_mutex_free (this->clientslock);
+
+  G_OBJECT_CLASS (parent_class)->finalize (gobject);
+}
+
+static GstShmGDPClient *
+gst_shm_gdp_client_ref (GstShmGDPClient * client)
+{
+  g_atomic_int_inc (&client->refcount);
+
+  return client;
+}
+
+static void
+gst_shm_gdp_client_unref (GstShmGDPClient * client)
+{
+  if (!g_atomic_int_dec_and_test (&client->refcount))
+    return;
+
+  close (client->fd.fd);
+  g_free (client->held);
+  g_slice_free (GstShmGDPClient, client);
+}
+
+/* called with the CLIENTS_LOCK */
+static void
+gst_shm_gdp_sink_remove_client (GstShmGDPSink * sink, GstShmGDPClient * client)
+{
+  guint i;
+
+  GST_DEBUG_OBJECT (sink, "removing client on fd %d", client->fd.fd);
+
+  gst_poll_remove_fd (sink->fdset, &client->fd);
+  /* wake up a write that blocks on the client, the socket is closed when the
+   * last ref is dropped */
+  shutdown (client->fd.fd, SHUT_RDWR);
+
+  /* the client can't use the slots anymore */
+  for (i = 0; i < sink->area->n_slots; i++) {
+    while (client->held[i] > 0) {
+      gst_shm_gdp_area_unref_slot (sink->area, i);
+      client->held[i]--;
+    }
+  }
+
+  sink->clients = g_list_remove (sink->clients, client);
+  client->removed = TRUE;
+  gst_shm_gdp_client_unref (client);
+}
+
+/* take a ref on all clients so that they can be written to without the
+ * CLIENTS_LOCK. Called with the CLIENTS_LOCK */
+static GList *
+gst_shm_gdp_sink_ref_clients (GstShmGDPSink * sink)
+{
+  GList *clients;
+
+  clients = g_list_copy (sink->clients);
+  g_list_foreach (clients, (GFunc) gst_shm_gdp_client_ref, NULL);
+
+  return clients;
+}
+
+/* remove the clients of @clients that could not be written to and drop the
+ * refs. Takes the CLIENTS_LOCK */
+static void
+gst_shm_gdp_sink_unref_clients (GstShmGDPSink * sink, GList * clients)
+{
+  GList *walk;
+
+  CLIENTS_LOCK (sink);
+  for (walk = clients; walk; walk = walk->next) {
+    GstShmGDPClient *client = walk->data;
+
+    if (client->failed && !client->removed) {
+      GST_WARNING_OBJECT (sink, "could not write to client on fd %d",
+          client->fd.fd);
+      gst_shm_gdp_sink_remove_client (sink, client);
+    }
+    gst_shm_gdp_client_unref (client);
+  }
+  CLIENTS_UNLOCK (sink);
+
+  g_list_free (clients);
+}
+
+static gboolean
+gst_shm_gdp_sink_send_packet (GstShmGDPSink * sink, GstShmGDPClient * client,
+    guint8 * header, guint length, const guint8 * payload)
+{
+  return gst_shm_gdp_write_message (client->fd.fd, GST_SHM_GDP_MSG_PACKET,
+      header, length, payload, gst_dp_header_payload_length (header));
+}
+
+static gboolean
+gst_shm_gdp_sink_send_caps (GstShmGDPSink * sink, GstShmGDPClient * client,
+    GstCaps * caps)
+{
+  guint8 *header, *payload;
+  guint length;
+  gboolean res;
+
+  if (!sink->packetizer->packet_from_caps (caps, 0, &length, &header,
+          &payload))
+    return FALSE;
+
+  res = gst_shm_gdp_sink_send_packet (sink, client, header, length, payload);
+  g_free (header);
+  g_free (payload);
+
+  return res;
+}
+
+static gboolean
+gst_shm_gdp_sink_send_event (GstShmGDPSink * sink, GstShmGDPClient * client,
+    GstEvent * event)
+{
+  guint8 *header, *payload;
+  guint length;
+  gboolean res;
+
+  if (!sink->packetizer->packet_from_event (event, 0, &length, &header,
+          &payload))
+    return FALSE;
+
+  res = gst_shm_gdp_sink_send_packet (sink, client, header, length, payload);
+  g_free (header);
+  g_free (payload);
+
+  return res;
+}
+
+/* tell a new client where the data lives and what it looks like. Returns
+ * TRUE when the client was set up just now, the current caps and newsegment
+ * are sent then. Called from the streaming thread without the
+ * CLIENTS_LOCK */
+static gboolean
+gst_shm_gdp_sink_setup_client (GstShmGDPSink * sink, GstShmGDPClient * client)
+{
+  if (client->setup)
+    return FALSE;
+
+  client->setup = TRUE;
+
+  if (!gst_shm_gdp_write_area (client->fd.fd, sink->area) ||
+      (sink->caps && !gst_shm_gdp_sink_send_caps (sink, client, sink->caps)) ||
+      (sink->newsegment &&
+          !gst_shm_gdp_sink_send_event (sink, client, sink->newsegment)))
+    client->failed = TRUE;
+
+  GST_DEBUG_OBJECT (sink, "set up client on fd %d", client->fd.fd);
+
+  return TRUE;
+}
+
+/* called with the CLIENTS_LOCK. The client is set up by the streaming
+ * thread before it is sent anything else. */
+static void
+gst_shm_gdp_sink_accept_client (GstShmGDPSink * sink)
+{
+  GstShmGDPClient *client;
+  gint fd;
+
+  if ((fd = accept (sink->server_sock.fd, NULL, NULL)) < 0) {
+    GST_WARNING_OBJECT (sink, "could not accept client: %s",
+        g_strerror (errno));
+    return;
+  }
+
+  client = g_slice_new0 (GstShmGDPClient);
+  client->refcount = 1;
+  gst_poll_fd_init (&client->fd);
+  client->fd.fd = fd;
+  client->held = g_new0 (guint, sink->area->n_slots);
+
+  gst_poll_add_fd (sink->fdset, &client->fd);
+  gst_poll_fd_ctl_read (sink->fdset, &client->fd, TRUE);
+  sink->clients = g_list_prepend (sink->clients, client);
+
+  GST_DEBUG_OBJECT (sink, "added client on fd %d", fd);
+}
+
+/* read the RELEASE messages of @client without blocking. Returns FALSE when
+ * the client is gone or misbehaves. Called with the CLIENTS_LOCK */
+static gboolean
+gst_shm_gdp_sink_read_client (GstShmGDPSink * sink, GstShmGDPClient * client)
+{
+  guint32 slot;
+  ssize_t n;
+
+  while (TRUE) {
+    n = recv (client->fd.fd, client->data + client->data_len,
+        sizeof (client->data) - client->data_len, MSG_DONTWAIT);
+    if (n == 0)
+      return FALSE;
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+
+    client->data_len += n;
+    if (client->data_len < sizeof (client->data))
+      continue;
+    client->data_len = 0;
+
+    if (GST_READ_UINT32_BE (client->data) != GST_SHM_GDP_MSG_RELEASE ||
+        GST_READ_UINT32_BE (client->data + 4) != GST_SHM_GDP_RELEASE_LENGTH)
+      goto invalid_message;
+
+    slot = GST_READ_UINT32_BE (client->data + GST_SHM_GDP_MSG_HEADER_LENGTH);
+    if (slot >= sink->area->n_slots || client->held[slot] == 0)
+      goto invalid_message;
+
+    GST_LOG_OBJECT (sink, "client on fd %d released slot %u", client->fd.fd,
+        slot);
+    client->held[slot]--;
+    gst_shm_gdp_area_unref_slot (sink->area, slot);
+  }
+
+invalid_message:
+  {
+    GST_WARNING_OBJECT (sink, "invalid message from client on fd %d",
+        client->fd.fd);
+    return FALSE;
+  }
+}
+
+/* accept new clients and handle released slots without blocking. Called with
+ * the CLIENTS_LOCK */
+static void
+gst_shm_gdp_sink_handle_clients (GstShmGDPSink * sink)
+{
+  GList *walk, *next;
+
+  if (gst_poll_wait (sink->fdset, 0) <= 0)
+    return;
+
+  for (walk = sink->clients; walk; walk = next) {
+    GstShmGDPClient *client = walk->data;
+
+    next = walk->next;
+
+    if (gst_poll_fd_has_error (sink->fdset, &client->fd) ||
+        (gst_poll_fd_can_read (sink->fdset, &client->fd) &&
+            !gst_shm_gdp_sink_read_client (sink, client)))
+      gst_shm_gdp_sink_remove_client (sink, client);
+  }
+
+  if (gst_poll_fd_can_read (sink->fdset, &sink->server_sock))
+    gst_shm_gdp_sink_accept_client (sink);
+}
+
+static GstFlowReturn
+gst_shm_gdp_sink_buffer_alloc (GstBaseSink * bsink, guint64 offset,
+    guint size, GstCaps * caps, GstBuffer ** buf)
+{
+  GstShmGDPSink *sink = GST_SHM_GDP_SINK (bsink);
+  GstShmGDPArea *area;
+  gint slot;
+
+  /* let the core allocate the buffer when we can't */
+  *buf = NULL;
+
+  /* this can be called from any thread, keep the area alive when we are
+   * stopped meanwhile */
+  CLIENTS_LOCK (sink);
+  area = sink->area ? gst_shm_gdp_area_ref (sink->area) : NULL;
+  CLIENTS_UNLOCK (sink);
+
+  if (area == NULL)
+    return GST_FLOW_OK;
+  if (size > area->slot_size)
+    goto done;
+
+  if ((slot = gst_shm_gdp_area_acquire_slot (area)) < 0) {
+    /* maybe clients released slots in the meantime */
+    CLIENTS_LOCK (sink);
+    if (sink->area == area)
+      gst_shm_gdp_sink_handle_clients (sink);
+    CLIENTS_UNLOCK (sink);
+
+    if ((slot = gst_shm_gdp_area_acquire_slot (area)) < 0)
+      goto done;
+  }
+
+  GST_LOG_OBJECT (sink, "allocated buffer of %u bytes in slot %d", size, slot);
+
+  *buf = gst_shm_gdp_area_wrap_slot (area, slot, 0, size);
+  GST_BUFFER_OFFSET (*buf) = offset;
+  gst_buffer_set_caps (*buf, caps);
+
+done:
+  gst_shm_gdp_area_unref (area);
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_shm_gdp_sink_render (GstBaseSink * bsink, GstBuffer * buf)
+{
+  GstShmGDPSink *sink = GST_SHM_GDP_SINK (bsink);
+  GstShmGDPArea *area = sink->area;
+  guint8 body[GST_SHM_GDP_SLOT_LENGTH];
+  guint8 *header, *data;
+  guint length, size, offset = 0;
+  GList *clients, *walk;
+  gint slot;
+
+  CLIENTS_LOCK (sink);
+  gst_shm_gdp_sink_handle_clients (sink);
+
+  if (sink->clients == NULL) {
+    GST_LOG_OBJECT (sink, "no clients, dropping buffer");
+    CLIENTS_UNLOCK (sink);
+    return GST_FLOW_OK;
+  }
+
+  if (!sink->packetizer->header_from_buffer (buf, 0, &length, &header))
+    goto header_failed;
+
+  data = GST_BUFFER_DATA (buf);
+  size = GST_BUFFER_SIZE (buf);
+
+  /* take a slot for the time we send it, either the one the buffer was
+   * allocated in or a free one we copy the data to */
+  if ((slot = gst_shm_gdp_area_find_slot (area, data, size)) >= 0) {
+    gst_shm_gdp_area_ref_slot (area, slot);
+    offset = data - (area->data + (gsize) slot * area->slot_size);
+  } else if (size <= area->slot_size &&
+      (slot = gst_shm_gdp_area_acquire_slot (area)) >= 0) {
+    GST_LOG_OBJECT (sink, "copying buffer to slot %d", slot);
+    memcpy (area->data + (gsize) slot * area->slot_size, data, size);
+  } else {
+    GST_LOG_OBJECT (sink, "no slot for buffer of %u bytes, sending inline",
+        size);
+  }
+
+  clients = gst_shm_gdp_sink_ref_clients (sink);
+
+  if (slot >= 0) {
+    memcpy (body, header, GST_DP_HEADER_LENGTH);
+    GST_WRITE_UINT32_BE (body + GST_DP_HEADER_LENGTH, slot);
+    GST_WRITE_UINT32_BE (body + GST_DP_HEADER_LENGTH + 4, offset);
+
+    /* account the slot to the clients before they can release it, a client
+     * that can't be written to gives it back when it is removed */
+    for (walk = clients; walk; walk = walk->next) {
+      GstShmGDPClient *client = walk->data;
+
+      gst_shm_gdp_area_ref_slot (area, slot);
+      client->held[slot]++;
+    }
+  }
+  CLIENTS_UNLOCK (sink);
+
+  for (walk = clients; walk; walk = walk->next) {
+    GstShmGDPClient *client = walk->data;
+
+    gst_shm_gdp_sink_setup_client (sink, client);
+    if (client->failed)
+      continue;
+
+    if (slot >= 0) {
+      client->failed = !gst_shm_gdp_write_message (client->fd.fd,
+          GST_SHM_GDP_MSG_SLOT, body, sizeof (body), NULL, 0);
+    } else {
+      client->failed = !gst_shm_gdp_write_message (client->fd.fd,
+          GST_SHM_GDP_MSG_PACKET, header, length, data, size);
+    }
+  }
+
+  gst_shm_gdp_sink_unref_clients (sink, clients);
+
+  if (slot >= 0)
+    gst_shm_gdp_area_unref_slot (area, slot);
+  g_free (header);
+
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+header_failed:
+  {
+    CLIENTS_UNLOCK (sink);
+    GST_ELEMENT_ERROR (sink, STREAM, ENCODE, (NULL),
+        ("Could not create GDP header from buffer"));
+    return GST_FLOW_ERROR;
+  }
+}
+
+static gboolean
+gst_shm_gdp_sink_set_caps (GstBaseSink * bsink, GstCaps * caps)
+{
+  GstShmGDPSink *sink = GST_SHM_GDP_SINK (bsink);
+  GList *clients, *walk;
+
+  CLIENTS_LOCK (sink);
+  gst_caps_replace (&sink->caps, caps);
+  clients = gst_shm_gdp_sink_ref_clients (sink);
+  CLIENTS_UNLOCK (sink);
+
+  for (walk = clients; walk; walk = walk->next) {
+    GstShmGDPClient *client = walk->data;
+
+    /* a new client gets the caps when it is set up */
+    if (!gst_shm_gdp_sink_setup_client (sink, client) && !client->failed)
+      client->failed = !gst_shm_gdp_sink_send_caps (sink, client, caps);
+  }
+
+  gst_shm_gdp_sink_unref_clients (sink, clients);
+
+  return TRUE;
+}
+
+static gboolean
+gst_shm_gdp_sink_event (GstBaseSink * bsink, GstEvent * event)
+{
+  GstShmGDPSink *sink = GST_SHM_GDP_SINK (bsink);
+  GList *clients, *walk;
+  gboolean newsegment = FALSE;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_FLUSH_START:
+    case GST_EVENT_FLUSH_STOP:
+      /* the src side has its own flushing */
+      return TRUE;
+    case GST_EVENT_NEWSEGMENT:
+      newsegment = TRUE;
+      break;
+    default:
+      break;
+  }
+
+  CLIENTS_LOCK (sink);
+  if (newsegment)
+    gst_event_replace (&sink->newsegment, event);
+  clients = gst_shm_gdp_sink_ref_clients (sink);
+  CLIENTS_UNLOCK (sink);
+
+  for (walk = clients; walk; walk = walk->next) {
+    GstShmGDPClient *client = walk->data;
+
+    /* a new client gets the newsegment when it is set up */
+    if (gst_shm_gdp_sink_setup_client (sink, client) && newsegment)
+      continue;
+    if (!client->failed)
+      client->failed = !gst_shm_gdp_sink_send_event (sink, client, event);
+  }
+
+  gst_shm_gdp_sink_unref_clients (sink, clients);
+
+  return TRUE;
+}
+
+/* removes the socket at socket-path, other kinds of files are left alone.
+ * Returns FALSE if there is such a file */
+static gboolean
+gst_shm_gdp_sink_unlink_socket (GstShmGDPSink * sink)
+{
+  struct stat st;
+
+  /* don't follow symlinks, and let bind() report other errors */
+  if (lstat (sink->socket_path, &st) < 0)
+    return TRUE;
+  if (!S_ISSOCK (st.st_mode))
+    return FALSE;
+
+  g_unlink (sink->socket_path);
+  return TRUE;
+}
+
+static gboolean
+gst_shm_gdp_sink_start (GstBaseSink * bsink)
+{
+  GstShmGDPSink *sink = GST_SHM_GDP_SINK (bsink);
+  struct sockaddr_un addr;
+
+  if (sink->socket_path == NULL)
+    goto no_path;
+  if (strlen (sink->socket_path) >= sizeof (addr.sun_path))
+    goto path_too_long;
+
+  if ((sink->fdset = gst_poll_new (TRUE)) == NULL)
+    goto socket_pair;
+
+  if (!(sink->area = gst_shm_gdp_area_new (sink->num_slots, sink->slot_size)))
+    goto no_area;
+
+  if ((sink->server_sock.fd = socket (AF_UNIX, SOCK_STREAM, 0)) < 0)
+    goto no_socket;
+
+  memset (&addr, 0, sizeof (addr));
+  addr.sun_family = AF_UNIX;
+  strcpy (addr.sun_path, sink->socket_path);
+
+  /* remove a stale socket of a previous run */
+  if (!gst_shm_gdp_sink_unlink_socket (sink))
+    goto not_a_socket;
+
+  GST_DEBUG_OBJECT (sink, "binding server socket to %s", sink->socket_path);
+  if (bind (sink->server_sock.fd, (struct sockaddr *) &addr, sizeof (addr)) < 0)
+    goto bind_failed;
+  if (listen (sink->server_sock.fd, 5) < 0)
+    goto listen_failed;
+
+  gst_poll_add_fd (sink->fdset, &sink->server_sock);
+  gst_poll_fd_ctl_read (sink->fdset, &sink->server_sock, TRUE);
+
+  sink->packetizer = gst_dp_packetizer_new (GST_DP_VERSION_1_0);
+
+  return TRUE;
+
+  /* ERRORS */
+no_path:
+  {
+    GST_ELEMENT_ERROR (sink, RESOURCE, NOT_FOUND, (NULL),
+        ("no socket-path specified"));
+    return FALSE;
+  }
+path_too_long:
+  {
+    GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE, (NULL),
+        ("socket path \"%s\" is too long", sink->socket_path));
+    return FALSE;
+  }
+socket_pair:
+  {
+    GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_READ_WRITE, (NULL),
+        GST_ERROR_SYSTEM);
+    return FALSE;
+  }
+no_area:
+  {
+    GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE, (NULL),
+        ("could not create shared memory area: %s", g_strerror (errno)));
+    gst_shm_gdp_sink_stop (bsink);
+    return FALSE;
+  }
+no_socket:
+  {
+    GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE, (NULL), GST_ERROR_SYSTEM);
+    gst_shm_gdp_sink_stop (bsink);
+    return FALSE;
+  }
+not_a_socket:
+  {
+    GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE, (NULL),
+        ("%s exists and is not a socket", sink->socket_path));
+    gst_shm_gdp_sink_stop (bsink);
+    return FALSE;
+  }
+bind_failed:
+  {
+    GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE, (NULL),
+        ("bind to %s failed: %s", sink->socket_path, g_strerror (errno)));
+    gst_shm_gdp_sink_stop (bsink);
+    return FALSE;
+  }
+listen_failed:
+  {
+    GST_ELEMENT_ERROR (sink, RESOURCE, OPEN_WRITE, (NULL),
+        ("listen on %s failed: %s", sink->socket_path, g_strerror (errno)));
+    gst_shm_gdp_sink_stop (bsink);
+    return FALSE;
+  }
+}
+
+static gboolean
+gst_shm_gdp_sink_stop (GstBaseSink * bsink)
+{
+  GstShmGDPSink *sink = GST_SHM_GDP_SINK (bsink);
+
+  /* buffer_alloc can run in another thread and looks at the area and the
+   * clients with the CLIENTS_LOCK */
+  CLIENTS_LOCK (sink);
+  while (sink->clients)
+    gst_shm_gdp_sink_remove_client (sink, sink->clients->data);
+
+  if (sink->server_sock.fd >= 0) {
+    close (sink->server_sock.fd);
+    if (!gst_shm_gdp_sink_unlink_socket (sink))
+      GST_WARNING_OBJECT (sink, "%s is not a socket anymore, not removing it",
+          sink->socket_path);
+    gst_poll_fd_init (&sink->server_sock);
+  }
+  if (sink->fdset) {
+    gst_poll_free (sink->fdset);
+    sink->fdset = NULL;
+  }
+  /* buffers allocated in the area keep it alive */
+  if (sink->area) {
+    gst_shm_gdp_area_unref (sink->area);
+    sink->area = NULL;
+  }
+  CLIENTS_UNLOCK (sink);
+  if (sink->packetizer) {
+    gst_dp_packetizer_free (sink->packetizer);
+    sink->packetizer = NULL;
+  }
+  gst_caps_replace (&sink->caps, NULL);
+  gst_event_replace (&sink->newsegment, NULL);
+
+  return TRUE;
+}
+
+static void
+gst_shm_gdp_sink_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstShmGDPSink *sink = GST_SHM_GDP_SINK (object);
+
+  switch (prop_id) {
+    case PROP_SOCKET_PATH:
+      g_free (sink->socket_path);
+      sink->socket_path = g_value_dup_string (value);
+      break;
+    case PROP_NUM_SLOTS:
+      sink->num_slots = g_value_get_uint (value);
+      break;
+    case PROP_SLOT_SIZE:
+      sink->slot_size = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_shm_gdp_sink_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstShmGDPSink *sink = GST_SHM_GDP_SINK (object);
+
+  switch (prop_id) {
+    case PROP_SOCKET_PATH:
+      g_value_set_string (value, sink->socket_path);
+      break;
+    case PROP_NUM_SLOTS:
+      g_value_set_uint (value, sink->num_slots);
+      break;
+    case PROP_SLOT_SIZE:
+      g_value_set_uint (value, sink->slot_size);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
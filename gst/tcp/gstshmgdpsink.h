@@ -0,0 +1,76 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#ifndef __GST_SHM_GDP_SINK_H__
+#define __GST_SHM_GDP_SINK_H__
+
+
+#include <gst/gst.h>
+#include <gst/base/gstbasesink.h>
+
+G_BEGIN_DECLS
+
+#include "gstshmgdp.h"
+
+#define GST_TYPE_SHM_GDP_SINK \
+  (gst_shm_gdp_sink_get_type())
+#define GST_SHM_GDP_SINK(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_SHM_GDP_SINK,GstShmGDPSink))
+#define GST_SHM_GDP_SINK_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_SHM_GDP_SINK,GstShmGDPSinkClass))
+#define GST_IS_SHM_GDP_SINK(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_SHM_GDP_SINK))
+#define GST_IS_SHM_GDP_SINK_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_SHM_GDP_SINK))
+
+typedef struct _GstShmGDPSink GstShmGDPSink;
+typedef struct _GstShmGDPSinkClass GstShmGDPSinkClass;
+
+struct _GstShmGDPSink {
+  GstBaseSink element;
+
+  /* properties */
+  gchar *socket_path;
+  guint num_slots;
+  guint slot_size;
+
+  /* listening socket */
+  GstPollFD server_sock;
+  GstPoll *fdset;
+
+  GstShmGDPArea *area;
+  GstDPPacketizer *packetizer;
+
+  GMutex *clientslock;  /* lock to protect the clients list */
+  GList *clients;       /* list of GstShmGDPClient */
+
+  /* sent to clients that connect later */
+  GstCaps *caps;
+  GstEvent *newsegment;
+};
+
+struct _GstShmGDPSinkClass {
+  GstBaseSinkClass parent_class;
+};
+
+GType gst_shm_gdp_sink_get_type (void);
+
+G_END_DECLS
+
+#endif /* __GST_SHM_GDP_SINK_H__ */
@@ -0,0 +1,504 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * SECTION:element-shmgdpsrc
+ * @see_also: #shmgdpsink, #tcpclientsrc
+ *
+ * Receives buffers from a shmgdpsink in another process on the same machine.
+ * Buffers that the sink placed in its shared memory area are pushed without
+ * copying the data, they point into the area and are marked read-only. The
+ * slot is handed back to the sink when the buffer is freed.
+ *
+ * See shmgdpsink for an example.
+ *
+ * Since: 0.10.37
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "gstshmgdpsrc.h"
+
+GST_DEBUG_CATEGORY_STATIC (shmgdpsrc_debug);
+#define GST_CAT_DEFAULT shmgdpsrc_debug
+
+#define DEFAULT_SOCKET_PATH     NULL
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+enum
+{
+  PROP_0,
+  PROP_SOCKET_PATH
+};
+
+GST_BOILERPLATE (GstShmGDPSrc, gst_shm_gdp_src, GstPushSrc, GST_TYPE_PUSH_SRC);
+
+static void gst_shm_gdp_src_finalize (GObject * gobject);
+
+static GstCaps *gst_shm_gdp_src_getcaps (GstBaseSrc * bsrc);
+static gboolean gst_shm_gdp_src_start (GstBaseSrc * bsrc);
+static gboolean gst_shm_gdp_src_stop (GstBaseSrc * bsrc);
+static gboolean gst_shm_gdp_src_unlock (GstBaseSrc * bsrc);
+static gboolean gst_shm_gdp_src_unlock_stop (GstBaseSrc * bsrc);
+static GstFlowReturn gst_shm_gdp_src_create (GstPushSrc * psrc,
+    GstBuffer ** outbuf);
+
+static void gst_shm_gdp_src_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_shm_gdp_src_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+
+static void
+gst_shm_gdp_src_base_init (gpointer g_class)
+{
+  GstElementClass *element_class = GST_ELEMENT_CLASS (g_class);
+
+  gst_element_class_add_static_pad_template (element_class, &srctemplate);
+
+  gst_element_class_set_details_simple (element_class,
+      "Shared memory GDP source", "Source/Network",
+      "Receive data from another process on this machine through shared memory",
+      "GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>");
+}
+
+static void
+gst_shm_gdp_src_class_init (GstShmGDPSrcClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstBaseSrcClass *gstbasesrc_class;
+  GstPushSrcClass *gstpush_src_class;
+
+  gobject_class = (GObjectClass *) klass;
+  gstbasesrc_class = (GstBaseSrcClass *) klass;
+  gstpush_src_class = (GstPushSrcClass *) klass;
+
+  gobject_class->set_property = gst_shm_gdp_src_set_property;
+  gobject_class->get_property = gst_shm_gdp_src_get_property;
+  gobject_class->finalize = gst_shm_gdp_src_finalize;
+
+  g_object_class_install_property (gobject_class, PROP_SOCKET_PATH,
+      g_param_spec_string ("socket-path", "Socket Path",
+          "The path of the unix socket of the shmgdpsink",
+          DEFAULT_SOCKET_PATH, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gstbasesrc_class->get_caps = gst_shm_gdp_src_getcaps;
+  gstbasesrc_class->start = gst_shm_gdp_src_start;
+  gstbasesrc_class->stop = gst_shm_gdp_src_stop;
+  gstbasesrc_class->unlock = gst_shm_gdp_src_unlock;
+  gstbasesrc_class->unlock_stop = gst_shm_gdp_src_unlock_stop;
+
+  gstpush_src_class->create = gst_shm_gdp_src_create;
+
+  GST_DEBUG_CATEGORY_INIT (shmgdpsrc_debug, "shmgdpsrc", 0,
+      "Shared memory GDP source");
+}
+
+static void
+gst_shm_gdp_src_init (GstShmGDPSrc * this, GstShmGDPSrcClass * g_class)
+{
+  this->socket_path = g_strdup (DEFAULT_SOCKET_PATH);
+  gst_poll_fd_init (&this->sock_fd);
+}
+
+static void
+gst_shm_gdp_src_finalize (GObject * gobject)
+{
+  GstShmGDPSrc *this = GST_SHM_GDP_SRC (gobject);
+
+  g_free (this->socket_path);
+
+  G_OBJECT_CLASS (parent_class)->finalize (gobject);
+}
+
+static GstCaps *
+gst_shm_gdp_src_getcaps (GstBaseSrc * bsrc)
+{
+  GstShmGDPSrc *src = GST_SHM_GDP_SRC (bsrc);
+  GstCaps *caps;
+
+  GST_OBJECT_LOCK (src);
+  if (src->caps)
+    caps = gst_caps_copy (src->caps);
+  else
+    caps = gst_caps_new_any ();
+  GST_OBJECT_UNLOCK (src);
+
+  return caps;
+}
+
+/* set the buffer fields from the GDP header, like gst_dp_buffer_from_header()
+ * does for a new buffer */
+static void
+gst_shm_gdp_src_set_metadata (GstBuffer * buffer, const guint8 * header)
+{
+  GST_BUFFER_TIMESTAMP (buffer) = GST_READ_UINT64_BE (header + 10);
+  GST_BUFFER_DURATION (buffer) = GST_READ_UINT64_BE (header + 18);
+  GST_BUFFER_OFFSET (buffer) = GST_READ_UINT64_BE (header + 26);
+  GST_BUFFER_OFFSET_END (buffer) = GST_READ_UINT64_BE (header + 34);
+  GST_BUFFER_FLAGS (buffer) |= GST_READ_UINT16_BE (header + 42);
+}
+
+/* a buffer with its data in a slot of the area */
+static GstFlowReturn
+gst_shm_gdp_src_read_slot (GstShmGDPSrc * src, guint length,
+    GstBuffer ** outbuf)
+{
+  GstShmGDPArea *area = src->area;
+  guint8 body[GST_SHM_GDP_SLOT_LENGTH];
+  guint slot, offset, size;
+  GstFlowReturn ret;
+
+  if (length != GST_SHM_GDP_SLOT_LENGTH)
+    goto invalid_message;
+
+  ret = gst_tcp_socket_read (GST_ELEMENT (src), src->sock_fd.fd, body,
+      sizeof (body), src->fdset);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  slot = GST_READ_UINT32_BE (body + GST_DP_HEADER_LENGTH);
+  offset = GST_READ_UINT32_BE (body + GST_DP_HEADER_LENGTH + 4);
+  size = gst_dp_header_payload_length (body);
+
+  if (slot >= area->n_slots || offset > area->slot_size ||
+      size > area->slot_size - offset)
+    goto invalid_message;
+
+  GST_LOG_OBJECT (src, "buffer of %u bytes at offset %u in slot %u", size,
+      offset, slot);
+
+  *outbuf = gst_shm_gdp_area_wrap_slot (area, slot, offset, size);
+  gst_shm_gdp_src_set_metadata (*outbuf, body);
+
+  return GST_FLOW_OK;
+
+invalid_message:
+  {
+    GST_ELEMENT_ERROR (src, STREAM, DECODE, (NULL),
+        ("received an invalid slot message"));
+    return GST_FLOW_ERROR;
+  }
+}
+
+/* a GDP packet, which is either a buffer with its data inline or caps or an
+ * event. *outbuf is only set for buffers. */
+static GstFlowReturn
+gst_shm_gdp_src_read_packet (GstShmGDPSrc * src, guint length,
+    GstBuffer ** outbuf)
+{
+  guint8 header[GST_DP_HEADER_LENGTH];
+  guint8 *payload = NULL;
+  guint payload_length;
+  GstDPPayloadType type;
+  GstFlowReturn ret;
+
+  if (length < GST_DP_HEADER_LENGTH)
+    goto invalid_message;
+
+  ret = gst_tcp_socket_read (GST_ELEMENT (src), src->sock_fd.fd, header,
+      GST_DP_HEADER_LENGTH, src->fdset);
+  if (ret != GST_FLOW_OK)
+    return ret;
+
+  payload_length = gst_dp_header_payload_length (header);
+  type = gst_dp_header_payload_type (header);
+  if (payload_length != length - GST_DP_HEADER_LENGTH)
+    goto invalid_message;
+
+  if (type == GST_DP_PAYLOAD_BUFFER) {
+    *outbuf = gst_dp_buffer_from_header (GST_DP_HEADER_LENGTH, header);
+    if (*outbuf == NULL)
+      goto invalid_message;
+
+    ret = gst_tcp_socket_read (GST_ELEMENT (src), src->sock_fd.fd,
+        GST_BUFFER_DATA (*outbuf), payload_length, src->fdset);
+    if (ret != GST_FLOW_OK) {
+      gst_buffer_unref (*outbuf);
+      *outbuf = NULL;
+    }
+    return ret;
+  }
+
+  if (payload_length > 0) {
+    payload = g_malloc (payload_length);
+    ret = gst_tcp_socket_read (GST_ELEMENT (src), src->sock_fd.fd, payload,
+        payload_length, src->fdset);
+    if (ret != GST_FLOW_OK) {
+      g_free (payload);
+      return ret;
+    }
+  }
+
+  if (type == GST_DP_PAYLOAD_CAPS) {
+    GstCaps *caps;
+
+    caps = gst_dp_caps_from_packet (GST_DP_HEADER_LENGTH, header, payload);
+    g_free (payload);
+    if (caps == NULL)
+      goto invalid_message;
+
+    GST_DEBUG_OBJECT (src, "received caps %" GST_PTR_FORMAT, caps);
+    GST_OBJECT_LOCK (src);
+    gst_caps_replace (&src->caps, caps);
+    GST_OBJECT_UNLOCK (src);
+    gst_caps_unref (caps);
+  } else if (type >= GST_DP_PAYLOAD_EVENT_NONE) {
+    GstEvent *event;
+
+    event = gst_dp_event_from_packet (GST_DP_HEADER_LENGTH, header, payload);
+    g_free (payload);
+    if (event == NULL)
+      goto invalid_message;
+
+    GST_DEBUG_OBJECT (src, "received %s event", GST_EVENT_TYPE_NAME (event));
+    if (GST_EVENT_TYPE (event) == GST_EVENT_EOS) {
+      /* base class sends EOS */
+      gst_event_unref (event);
+      return GST_FLOW_UNEXPECTED;
+    }
+    gst_pad_push_event (GST_BASE_SRC_PAD (src), event);
+  } else {
+    g_free (payload);
+    goto invalid_message;
+  }
+
+  return GST_FLOW_OK;
+
+invalid_message:
+  {
+    GST_ELEMENT_ERROR (src, STREAM, DECODE, (NULL),
+        ("received an invalid GDP packet"));
+    return GST_FLOW_ERROR;
+  }
+}
+
+static GstFlowReturn
+gst_shm_gdp_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
+{
+  GstShmGDPSrc *src = GST_SHM_GDP_SRC (psrc);
+  guint8 header[GST_SHM_GDP_MSG_HEADER_LENGTH];
+  GstFlowReturn ret;
+  guint type, length;
+
+  /* the sink sends the area when it accepts our connection */
+  if (src->area == NULL) {
+    ret = gst_shm_gdp_read_area (GST_ELEMENT (src), src->sock_fd.fd,
+        src->fdset, &src->area);
+    if (ret != GST_FLOW_OK)
+      return ret;
+  }
+
+  /* caps and events are handled on the way, loop until we have a buffer */
+  *outbuf = NULL;
+  while (*outbuf == NULL) {
+    ret = gst_tcp_socket_read (GST_ELEMENT (src), src->sock_fd.fd, header,
+        sizeof (header), src->fdset);
+    if (ret != GST_FLOW_OK)
+      return ret;
+
+    type = GST_READ_UINT32_BE (header);
+    length = GST_READ_UINT32_BE (header + 4);
+
+    switch (type) {
+      case GST_SHM_GDP_MSG_SLOT:
+        ret = gst_shm_gdp_src_read_slot (src, length, outbuf);
+        break;
+      case GST_SHM_GDP_MSG_PACKET:
+        ret = gst_shm_gdp_src_read_packet (src, length, outbuf);
+        break;
+      default:
+        goto invalid_message;
+    }
+    if (ret != GST_FLOW_OK)
+      return ret;
+  }
+
+  GST_LOG_OBJECT (src, "returning buffer of size %u, ts %" GST_TIME_FORMAT,
+      GST_BUFFER_SIZE (*outbuf),
+      GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (*outbuf)));
+  gst_buffer_set_caps (*outbuf, src->caps);
+
+  return GST_FLOW_OK;
+
+invalid_message:
+  {
+    GST_ELEMENT_ERROR (src, STREAM, DECODE, (NULL),
+        ("received an unknown message of type %u", type));
+    return GST_FLOW_ERROR;
+  }
+}
+
+static gboolean
+gst_shm_gdp_src_start (GstBaseSrc * bsrc)
+{
+  GstShmGDPSrc *src = GST_SHM_GDP_SRC (bsrc);
+  struct sockaddr_un addr;
+
+  if (src->socket_path == NULL)
+    goto no_path;
+  if (strlen (src->socket_path) >= sizeof (addr.sun_path))
+    goto path_too_long;
+
+  if ((src->fdset = gst_poll_new (TRUE)) == NULL)
+    goto socket_pair;
+
+  if ((src->sock_fd.fd = socket (AF_UNIX, SOCK_STREAM, 0)) < 0)
+    goto no_socket;
+
+  memset (&addr, 0, sizeof (addr));
+  addr.sun_family = AF_UNIX;
+  strcpy (addr.sun_path, src->socket_path);
+
+  GST_DEBUG_OBJECT (src, "connecting to %s", src->socket_path);
+  if (connect (src->sock_fd.fd, (struct sockaddr *) &addr, sizeof (addr)) < 0)
+    goto connect_failed;
+
+  gst_poll_add_fd (src->fdset, &src->sock_fd);
+  gst_poll_fd_ctl_read (src->fdset, &src->sock_fd, TRUE);
+
+  return TRUE;
+
+  /* ERRORS */
+no_path:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, NOT_FOUND, (NULL),
+        ("no socket-path specified"));
+    return FALSE;
+  }
+path_too_long:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ, (NULL),
+        ("socket path \"%s\" is too long", src->socket_path));
+    return FALSE;
+  }
+socket_pair:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ_WRITE, (NULL),
+        GST_ERROR_SYSTEM);
+    return FALSE;
+  }
+no_socket:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ, (NULL), GST_ERROR_SYSTEM);
+    gst_shm_gdp_src_stop (bsrc);
+    return FALSE;
+  }
+connect_failed:
+  {
+    GST_ELEMENT_ERROR (src, RESOURCE, OPEN_READ, (NULL),
+        ("connect to %s failed: %s", src->socket_path, g_strerror (errno)));
+    gst_shm_gdp_src_stop (bsrc);
+    return FALSE;
+  }
+}
+
+static gboolean
+gst_shm_gdp_src_stop (GstBaseSrc * bsrc)
+{
+  GstShmGDPSrc *src = GST_SHM_GDP_SRC (bsrc);
+
+  /* buffers we pushed keep the area mapped, but they must not use the
+   * socket anymore */
+  if (src->area) {
+    gst_shm_gdp_area_disconnect (src->area);
+    gst_shm_gdp_area_unref (src->area);
+    src->area = NULL;
+  }
+  if (src->sock_fd.fd >= 0) {
+    close (src->sock_fd.fd);
+    gst_poll_fd_init (&src->sock_fd);
+  }
+  if (src->fdset) {
+    gst_poll_free (src->fdset);
+    src->fdset = NULL;
+  }
+
+  GST_OBJECT_LOCK (src);
+  gst_caps_replace (&src->caps, NULL);
+  GST_OBJECT_UNLOCK (src);
+
+  return TRUE;
+}
+
+/* will be called only between calls to start() and stop() */
+static gboolean
+gst_shm_gdp_src_unlock (GstBaseSrc * bsrc)
+{
+  GstShmGDPSrc *src = GST_SHM_GDP_SRC (bsrc);
+
+  gst_poll_set_flushing (src->fdset, TRUE);
+
+  return TRUE;
+}
+
+/* will be called only between calls to start() and stop() */
+static gboolean
+gst_shm_gdp_src_unlock_stop (GstBaseSrc * bsrc)
+{
+  GstShmGDPSrc *src = GST_SHM_GDP_SRC (bsrc);
+
+  gst_poll_set_flushing (src->fdset, FALSE);
+
+  return TRUE;
+}
+
+static void
+gst_shm_gdp_src_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstShmGDPSrc *src = GST_SHM_GDP_SRC (object);
+
+  switch (prop_id) {
+    case PROP_SOCKET_PATH:
+      g_free (src->socket_path);
+      src->socket_path = g_value_dup_string (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_shm_gdp_src_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstShmGDPSrc *src = GST_SHM_GDP_SRC (object);
+
+  switch (prop_id) {
+    case PROP_SOCKET_PATH:
+      g_value_set_string (value, src->socket_path);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
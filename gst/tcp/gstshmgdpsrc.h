@@ -0,0 +1,66 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+
+#ifndef __GST_SHM_GDP_SRC_H__
+#define __GST_SHM_GDP_SRC_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstpushsrc.h>
+
+G_BEGIN_DECLS
+
+#include "gstshmgdp.h"
+
+#define GST_TYPE_SHM_GDP_SRC \
+  (gst_shm_gdp_src_get_type())
+#define GST_SHM_GDP_SRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_SHM_GDP_SRC,GstShmGDPSrc))
+#define GST_SHM_GDP_SRC_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST((klass),GST_TYPE_SHM_GDP_SRC,GstShmGDPSrcClass))
+#define GST_IS_SHM_GDP_SRC(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_SHM_GDP_SRC))
+#define GST_IS_SHM_GDP_SRC_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_SHM_GDP_SRC))
+
+typedef struct _GstShmGDPSrc GstShmGDPSrc;
+typedef struct _GstShmGDPSrcClass GstShmGDPSrcClass;
+
+struct _GstShmGDPSrc {
+  GstPushSrc element;
+
+  gchar *socket_path;
+
+  /* socket */
+  GstPollFD sock_fd;
+  GstPoll *fdset;
+
+  /* received on the socket after connecting */
+  GstShmGDPArea *area;
+  GstCaps *caps;
+};
+
+struct _GstShmGDPSrcClass {
+  GstPushSrcClass parent_class;
+};
+
+GType gst_shm_gdp_src_get_type (void);
+
+G_END_DECLS
+
+#endif /* __GST_SHM_GDP_SRC_H__ */
@@ -123,7 +123,7 @@ gst_tcp_socket_write (int socket, const void *buf, size_t count)
 /* atomically read count bytes into buf, cancellable. return val of GST_FLOW_OK
  * indicates success, anything else is failure.
  */
-static GstFlowReturn
+GstFlowReturn
 gst_tcp_socket_read (GstElement * this, int socket, void *buf, size_t count,
     GstPoll * fdset)
 {
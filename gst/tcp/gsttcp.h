@@ -57,6 +57,7 @@ typedef enum
 gchar * gst_tcp_host_to_ip (GstElement *element, const gchar *host);
 
 gint gst_tcp_socket_write (int socket, const void *buf, size_t count);
+GstFlowReturn gst_tcp_socket_read (GstElement * this, int socket, void *buf, size_t count, GstPoll * fdset);
 
 void gst_tcp_socket_close (GstPollFD *socket);
 
@@ -27,6 +27,8 @@
 #include "gsttcpserversrc.h"
 #include "gsttcpserversink.h"
 #include "gstmultifdsink.h"
+#include "gstshmgdpsrc.h"
+#include "gstshmgdpsink.h"
 
 GST_DEBUG_CATEGORY (tcp_debug);
 
@@ -50,6 +52,12 @@ plugin_init (GstPlugin * plugin)
   if (!gst_element_register (plugin, "multifdsink", GST_RANK_NONE,
           GST_TYPE_MULTI_FD_SINK))
     return FALSE;
+  if (!gst_element_register (plugin, "shmgdpsink", GST_RANK_NONE,
+          GST_TYPE_SHM_GDP_SINK))
+    return FALSE;
+  if (!gst_element_register (plugin, "shmgdpsrc", GST_RANK_NONE,
+          GST_TYPE_SHM_GDP_SRC))
+    return FALSE;
 
   GST_DEBUG_CATEGORY_INIT (tcp_debug, "tcp", 0, "TCP calls");
 
@@ -170,6 +170,233 @@ GST_START_TEST (test_appsrc_non_null_caps)
 
 GST_END_TEST;
 
+static void
+count_enough_data (GstAppSrc * src, gpointer user_data)
+{
+  gint *count = user_data;
+
+  *count = *count + 1;
+}
+
+/*
+ * Pushes timestamped buffers into appsrc and checks that the queue is
+ * considered full when max-time is reached.
+ */
+GST_START_TEST (test_appsrc_max_time)
+{
+  GstElement *src;
+  GstBuffer *buffer;
+  guint64 level;
+  gint i, enough = 0;
+
+  src = setup_appsrc ();
+
+  g_object_set (src, "max-bytes", (guint64) 0, "max-time", GST_SECOND, NULL);
+  g_signal_connect (src, "enough-data", G_CALLBACK (count_enough_data),
+      &enough);
+
+  for (i = 0; i < 5; i++) {
+    buffer = gst_buffer_new_and_alloc (10);
+    GST_BUFFER_TIMESTAMP (buffer) = i * 200 * GST_MSECOND;
+    GST_BUFFER_DURATION (buffer) = 200 * GST_MSECOND;
+    fail_unless (gst_app_src_push_buffer (GST_APP_SRC (src),
+            buffer) == GST_FLOW_OK);
+
+    g_object_get (src, "current-level-time", &level, NULL);
+    fail_unless_equals_uint64 (level, (i + 1) * 200 * GST_MSECOND);
+    fail_unless_equals_int (enough, 0);
+  }
+
+  /* the queue is full now */
+  buffer = gst_buffer_new_and_alloc (10);
+  GST_BUFFER_TIMESTAMP (buffer) = GST_SECOND;
+  GST_BUFFER_DURATION (buffer) = 200 * GST_MSECOND;
+  fail_unless (gst_app_src_push_buffer (GST_APP_SRC (src),
+          buffer) == GST_FLOW_OK);
+  fail_unless_equals_int (enough, 1);
+
+  fail_unless_equals_uint64 (gst_app_src_get_current_level_bytes (GST_APP_SRC
+          (src)), 60);
+
+  cleanup_appsrc (src);
+}
+
+GST_END_TEST;
+
+static gint min_time_gate;
+static gint min_time_pushed;
+static guint64 min_time_max_level;
+
+static GstFlowReturn
+gated_chain (GstPad * pad, GstBuffer * buffer)
+{
+  while (!g_atomic_int_get (&min_time_gate))
+    g_usleep (1000);
+
+  gst_buffer_unref (buffer);
+  g_atomic_int_inc (&min_time_pushed);
+
+  return GST_FLOW_OK;
+}
+
+static void
+record_need_data_level (GstAppSrc * src, guint length, gpointer user_data)
+{
+  guint64 level = gst_app_src_get_current_level_bytes (src);
+
+  min_time_max_level = MAX (min_time_max_level, level);
+}
+
+/*
+ * Pushes buffers without timestamps with min-time set and checks that
+ * need-data is not emitted while there is still data queued.
+ */
+GST_START_TEST (test_appsrc_min_time_no_timestamps)
+{
+  GstElement *src;
+  gint i;
+
+  src = setup_appsrc ();
+  gst_pad_set_chain_function (mysinkpad, gated_chain);
+  min_time_gate = min_time_pushed = 0;
+  min_time_max_level = 0;
+
+  g_object_set (src, "min-time", GST_SECOND, NULL);
+  g_signal_connect (src, "need-data", G_CALLBACK (record_need_data_level),
+      NULL);
+
+  ASSERT_SET_STATE (src, GST_STATE_PLAYING, GST_STATE_CHANGE_SUCCESS);
+
+  /* the first buffer blocks the streaming thread, the others are queued */
+  for (i = 0; i < 5; i++) {
+    fail_unless (gst_app_src_push_buffer (GST_APP_SRC (src),
+            gst_buffer_new_and_alloc (10)) == GST_FLOW_OK);
+  }
+  g_atomic_int_set (&min_time_gate, 1);
+
+  while (g_atomic_int_get (&min_time_pushed) < 5)
+    g_usleep (1000);
+
+  ASSERT_SET_STATE (src, GST_STATE_NULL, GST_STATE_CHANGE_SUCCESS);
+
+  fail_unless_equals_uint64 (min_time_max_level, 0);
+
+  cleanup_appsrc (src);
+}
+
+GST_END_TEST;
+
+static gint pool_next_value;
+
+static GstFlowReturn
+check_pool_chain (GstPad * pad, GstBuffer * buffer)
+{
+  /* buffers arrive in order and recycling didn't clobber their data */
+  fail_unless_equals_int (GST_BUFFER_DATA (buffer)[0], pool_next_value & 0xff);
+  fail_unless_equals_int (GST_BUFFER_DATA (buffer)[GST_BUFFER_SIZE (buffer) -
+          1], pool_next_value & 0xff);
+  g_atomic_int_inc (&pool_next_value);
+  gst_buffer_unref (buffer);
+
+  return GST_FLOW_OK;
+}
+
+#define POOL_BUFFER_SIZE   4096
+#define POOL_NUM_BUFFERS   1000
+/* the default value of max-pool-buffers */
+#define DEFAULT_POOL_ALLOCS_LIMIT 16
+
+GST_START_TEST (test_appsrc_buffer_pool)
+{
+  GstElement *src;
+  GstBuffer *buffer;
+  guint8 *data;
+  guint64 hits, misses;
+
+  src = setup_appsrc ();
+
+  /* a released buffer is handed out again */
+  buffer = gst_app_src_acquire_buffer (GST_APP_SRC (src), 100);
+  fail_unless (GST_BUFFER_SIZE (buffer) == 100);
+  data = GST_BUFFER_DATA (buffer);
+  GST_BUFFER_TIMESTAMP (buffer) = GST_SECOND;
+  gst_buffer_unref (buffer);
+
+  buffer = gst_app_src_acquire_buffer (GST_APP_SRC (src), 50);
+  fail_unless (GST_BUFFER_DATA (buffer) == data);
+  fail_unless (GST_BUFFER_SIZE (buffer) == 50);
+  fail_unless (GST_BUFFER_TIMESTAMP (buffer) == GST_CLOCK_TIME_NONE);
+
+  /* too small for this request, needs a new one */
+  gst_buffer_unref (buffer);
+  buffer = gst_app_src_acquire_buffer (GST_APP_SRC (src), 200);
+  fail_unless (GST_BUFFER_SIZE (buffer) == 200);
+  gst_buffer_unref (buffer);
+
+  gst_app_src_get_pool_stats (GST_APP_SRC (src), &hits, &misses);
+  fail_unless_equals_uint64 (hits, 1);
+  fail_unless_equals_uint64 (misses, 2);
+
+  /* no recycling, buffers are freed on release */
+  g_object_set (src, "max-pool-buffers", 0, NULL);
+  buffer = gst_app_src_acquire_buffer (GST_APP_SRC (src), 10);
+  gst_buffer_unref (buffer);
+  buffer = gst_app_src_acquire_buffer (GST_APP_SRC (src), 10);
+  gst_app_src_get_pool_stats (GST_APP_SRC (src), &hits, &misses);
+  fail_unless_equals_uint64 (hits, 1);
+  fail_unless_equals_uint64 (misses, 4);
+
+  /* buffers can outlive appsrc */
+  cleanup_appsrc (src);
+  gst_buffer_unref (buffer);
+}
+
+GST_END_TEST;
+
+/* pushes POOL_NUM_BUFFERS buffers taken from the pool through appsrc and
+ * checks that only the buffers in flight between the application, the queue
+ * and the sink pad needed to be allocated */
+GST_START_TEST (test_appsrc_buffer_pool_recycling)
+{
+  GstElement *src;
+  guint64 hits = 0, misses = 0;
+  gint i;
+
+  src = setup_appsrc ();
+  gst_pad_set_chain_function (mysinkpad, check_pool_chain);
+  pool_next_value = 0;
+
+  g_object_set (src, "max-bytes", (guint64) 4 * POOL_BUFFER_SIZE,
+      "block", TRUE, NULL);
+
+  ASSERT_SET_STATE (src, GST_STATE_PLAYING, GST_STATE_CHANGE_SUCCESS);
+
+  for (i = 0; i < POOL_NUM_BUFFERS; i++) {
+    GstBuffer *buffer;
+
+    buffer = gst_app_src_acquire_buffer (GST_APP_SRC (src), POOL_BUFFER_SIZE);
+    fail_unless (GST_BUFFER_SIZE (buffer) == POOL_BUFFER_SIZE);
+    memset (GST_BUFFER_DATA (buffer), i & 0xff, POOL_BUFFER_SIZE);
+
+    fail_unless (gst_app_src_push_buffer (GST_APP_SRC (src),
+            buffer) == GST_FLOW_OK);
+  }
+  fail_unless (gst_app_src_end_of_stream (GST_APP_SRC (src)) == GST_FLOW_OK);
+
+  /* wait for the streaming thread to push everything */
+  while (g_atomic_int_get (&pool_next_value) < POOL_NUM_BUFFERS)
+    g_usleep (1000);
+
+  ASSERT_SET_STATE (src, GST_STATE_NULL, GST_STATE_CHANGE_SUCCESS);
+
+  gst_app_src_get_pool_stats (GST_APP_SRC (src), &hits, &misses);
+  fail_unless_equals_uint64 (hits + misses, POOL_NUM_BUFFERS);
+  fail_unless (misses <= DEFAULT_POOL_ALLOCS_LIMIT);
+
+  cleanup_appsrc (src);
+}
+
+GST_END_TEST;
 
 static Suite *
 appsrc_suite (void)
@@ -179,6 +406,10 @@ appsrc_suite (void)
 
   tcase_add_test (tc_chain, test_appsrc_null_caps);
   tcase_add_test (tc_chain, test_appsrc_non_null_caps);
+  tcase_add_test (tc_chain, test_appsrc_max_time);
+  tcase_add_test (tc_chain, test_appsrc_min_time_no_timestamps);
+  tcase_add_test (tc_chain, test_appsrc_buffer_pool);
+  tcase_add_test (tc_chain, test_appsrc_buffer_pool_recycling);
 
   suite_add_tcase (s, tc_chain);
 
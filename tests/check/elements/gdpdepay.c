@@ -396,6 +396,193 @@ GST_START_TEST (test_streamheader)
 
 GST_END_TEST;
 
+/* make one buffer with the caps packet, when @caps is set, followed by
+ * @n_packets buffer packets of @size bytes */
+static GstBuffer *
+make_gdp_stream (GstDPPacketizer * pk, GstCaps * caps, guint n_packets,
+    guint size, GstDPHeaderFlag flags)
+{
+  GstBuffer *stream, *buffer;
+  guint8 *header, *payload, *data;
+  guint len, payload_len, i;
+
+  stream = gst_buffer_new_and_alloc (4096 + n_packets *
+      (GST_DP_HEADER_LENGTH + size));
+  data = GST_BUFFER_DATA (stream);
+
+  if (caps) {
+    fail_unless (pk->packet_from_caps (caps, flags, &len, &header, &payload));
+    payload_len = gst_dp_header_payload_length (header);
+    fail_unless (len + payload_len <= 4096);
+    memcpy (data, header, len);
+    memcpy (data + len, payload, payload_len);
+    data += len + payload_len;
+    g_free (header);
+    g_free (payload);
+  }
+
+  for (i = 0; i < n_packets; i++) {
+    buffer = gst_buffer_new_and_alloc (size);
+    memset (GST_BUFFER_DATA (buffer), i, size);
+    GST_BUFFER_TIMESTAMP (buffer) = i * GST_MSECOND;
+    GST_BUFFER_DURATION (buffer) = GST_MSECOND;
+    GST_BUFFER_OFFSET (buffer) = i;
+    GST_BUFFER_OFFSET_END (buffer) = i + 1;
+    if (i & 1)
+      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+    fail_unless (pk->header_from_buffer (buffer, flags, &len, &header));
+    memcpy (data, header, len);
+    memcpy (data + len, GST_BUFFER_DATA (buffer), size);
+    data += len + size;
+    g_free (header);
+    gst_buffer_unref (buffer);
+  }
+  GST_BUFFER_SIZE (stream) = data - GST_BUFFER_DATA (stream);
+
+  return stream;
+}
+
+GST_START_TEST (test_subbuffers)
+{
+  GstCaps *caps;
+  GstElement *gdpdepay;
+  GstBuffer *inbuffer, *outbuffer;
+  GstDPPacketizer *pk;
+  GList *l;
+  guint i;
+
+  pk = gst_dp_packetizer_new (GST_DP_VERSION_1_0);
+  gdpdepay = setup_gdpdepay ();
+
+  fail_unless (gst_element_set_state (gdpdepay,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (AUDIO_CAPS_STRING);
+  inbuffer = make_gdp_stream (pk, caps, 16, 160,
+      GST_DP_HEADER_FLAG_CRC_HEADER | GST_DP_HEADER_FLAG_CRC_PAYLOAD);
+  gst_caps_unref (caps);
+
+  /* keep a ref so we can check where the output data points to */
+  fail_unless (gst_pad_push (mysrcpad, gst_buffer_ref (inbuffer)) ==
+      GST_FLOW_OK);
+  fail_unless_equals_int (g_list_length (buffers), 16);
+
+  for (l = buffers, i = 0; l; l = l->next, i++) {
+    outbuffer = GST_BUFFER_CAST (l->data);
+
+    fail_unless_equals_int (GST_BUFFER_SIZE (outbuffer), 160);
+    fail_unless (GST_BUFFER_DATA (outbuffer) > GST_BUFFER_DATA (inbuffer));
+    fail_unless (GST_BUFFER_DATA (outbuffer) + 160 <=
+        GST_BUFFER_DATA (inbuffer) + GST_BUFFER_SIZE (inbuffer));
+    fail_unless_equals_int (GST_BUFFER_DATA (outbuffer)[159], i);
+
+    fail_unless_equals_uint64 (GST_BUFFER_TIMESTAMP (outbuffer),
+        i * GST_MSECOND);
+    fail_unless_equals_uint64 (GST_BUFFER_DURATION (outbuffer), GST_MSECOND);
+    fail_unless_equals_uint64 (GST_BUFFER_OFFSET (outbuffer), i);
+    fail_unless_equals_uint64 (GST_BUFFER_OFFSET_END (outbuffer), i + 1);
+    fail_unless_equals_int (GST_BUFFER_FLAG_IS_SET (outbuffer,
+            GST_BUFFER_FLAG_DELTA_UNIT) ? 1 : 0, i & 1);
+    fail_unless (GST_BUFFER_CAPS (outbuffer) != NULL);
+  }
+  gst_buffer_unref (inbuffer);
+
+  fail_unless (gst_element_set_state (gdpdepay,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+
+  g_list_foreach (buffers, (GFunc) gst_mini_object_unref, NULL);
+  g_list_free (buffers);
+  buffers = NULL;
+  ASSERT_OBJECT_REFCOUNT (gdpdepay, "gdpdepay", 1);
+  cleanup_gdpdepay (gdpdepay);
+
+  gst_dp_packetizer_free (pk);
+}
+
+GST_END_TEST;
+
+#define CRC_STREAM_PACKETS 8
+#define CRC_PACKET_SIZE 160
+
+/* push a stream with a corrupt payload in packet 3 and a corrupt header
+ * checksum in packet 5 and return the result of the push */
+static GstFlowReturn
+push_corrupt_stream (GstDPPacketizer * pk, gboolean validate_crc)
+{
+  GstCaps *caps;
+  GstElement *gdpdepay;
+  GstBuffer *stream;
+  GstFlowReturn ret;
+  guint8 *data;
+
+  gdpdepay = setup_gdpdepay ();
+  g_object_set (gdpdepay, "validate-crc", validate_crc, NULL);
+
+  fail_unless (gst_element_set_state (gdpdepay,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  /* send the caps first */
+  caps = gst_caps_from_string (AUDIO_CAPS_STRING);
+  stream = make_gdp_stream (pk, caps, 0, 0, GST_DP_HEADER_FLAG_CRC_HEADER);
+  gst_caps_unref (caps);
+  fail_unless (gst_pad_push (mysrcpad, stream) == GST_FLOW_OK);
+
+  stream = make_gdp_stream (pk, NULL, CRC_STREAM_PACKETS, CRC_PACKET_SIZE,
+      GST_DP_HEADER_FLAG_CRC_HEADER | GST_DP_HEADER_FLAG_CRC_PAYLOAD);
+  data = GST_BUFFER_DATA (stream);
+  data[3 * (GST_DP_HEADER_LENGTH + CRC_PACKET_SIZE) + GST_DP_HEADER_LENGTH] ^=
+      0xff;
+  /* the header checksum is stored in the 4th and 3rd last header bytes */
+  data[5 * (GST_DP_HEADER_LENGTH + CRC_PACKET_SIZE) + GST_DP_HEADER_LENGTH -
+      4] ^= 0xff;
+
+  ret = gst_pad_push (mysrcpad, stream);
+
+  fail_unless (gst_element_set_state (gdpdepay,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+  ASSERT_OBJECT_REFCOUNT (gdpdepay, "gdpdepay", 1);
+  cleanup_gdpdepay (gdpdepay);
+
+  return ret;
+}
+
+GST_START_TEST (test_validate_crc)
+{
+  GstDPPacketizer *pk;
+  GstBuffer *outbuffer;
+  GList *l;
+  guint i;
+
+  pk = gst_dp_packetizer_new (GST_DP_VERSION_1_0);
+
+  /* the corrupt payload is detected, only the packets before it are pushed */
+  fail_unless_equals_int (push_corrupt_stream (pk, TRUE), GST_FLOW_ERROR);
+  fail_unless_equals_int (g_list_length (buffers), 3);
+  gst_check_drop_buffers ();
+
+  /* without validation all packets are pushed, the corruption included */
+  fail_unless_equals_int (push_corrupt_stream (pk, FALSE), GST_FLOW_OK);
+  fail_unless_equals_int (g_list_length (buffers), CRC_STREAM_PACKETS);
+  for (l = buffers, i = 0; l; l = l->next, i++) {
+    outbuffer = GST_BUFFER_CAST (l->data);
+
+    fail_unless_equals_int (GST_BUFFER_SIZE (outbuffer), CRC_PACKET_SIZE);
+    fail_unless_equals_int (GST_BUFFER_DATA (outbuffer)[0],
+        i == 3 ? i ^ 0xff : i);
+    fail_unless_equals_int (GST_BUFFER_DATA (outbuffer)[CRC_PACKET_SIZE - 1],
+        i);
+    fail_unless_equals_uint64 (GST_BUFFER_TIMESTAMP (outbuffer),
+        i * GST_MSECOND);
+  }
+  gst_check_drop_buffers ();
+
+  gst_dp_packetizer_free (pk);
+}
+
+GST_END_TEST;
+
 static Suite *
 gdpdepay_suite (void)
 {
@@ -406,6 +593,8 @@ gdpdepay_suite (void)
   tcase_add_test (tc_chain, test_audio_per_byte);
   tcase_add_test (tc_chain, test_audio_in_one_buffer);
   tcase_add_test (tc_chain, test_streamheader);
+  tcase_add_test (tc_chain, test_subbuffers);
+  tcase_add_test (tc_chain, test_validate_crc);
 
   return s;
 }
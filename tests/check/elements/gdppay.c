@@ -546,6 +546,96 @@ GST_START_TEST (test_crc)
 
 GST_END_TEST;
 
+GST_START_TEST (test_buffer_list)
+{
+  GstCaps *caps;
+  GstElement *gdppay;
+  GstBuffer *inbuffer, *outbuffer;
+  GstEvent *event;
+  GstDPPacketizer *packetizer;
+  guint8 *header;
+  guint len;
+  gint i;
+
+  gdppay = setup_gdppay ();
+  g_object_set (gdppay, "buffer-list", TRUE, "crc-header", TRUE,
+      "crc-payload", TRUE, NULL);
+
+  fail_unless (gst_element_set_state (gdppay,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  event =
+      gst_event_new_new_segment (FALSE, 1.0, GST_FORMAT_TIME, 0, GST_SECOND, 0);
+  fail_unless (gst_pad_push_event (mysrcpad, event));
+
+  packetizer = gst_dp_packetizer_new (GST_DP_VERSION_1_0);
+  caps = gst_caps_from_string (AUDIO_CAPS_STRING);
+
+  /* more buffers than fit in one block of headers */
+  for (i = 0; i < 100; i++) {
+    inbuffer = gst_buffer_new_and_alloc (4 + i);
+    memset (GST_BUFFER_DATA (inbuffer), i, GST_BUFFER_SIZE (inbuffer));
+    GST_BUFFER_TIMESTAMP (inbuffer) = i * GST_MSECOND;
+    GST_BUFFER_DURATION (inbuffer) = GST_MSECOND;
+    GST_BUFFER_OFFSET (inbuffer) = i;
+    GST_BUFFER_OFFSET_END (inbuffer) = i + 1;
+    if (i & 1)
+      GST_BUFFER_FLAG_SET (inbuffer, GST_BUFFER_FLAG_DELTA_UNIT);
+    gst_buffer_set_caps (inbuffer, caps);
+
+    /* the header the packetizer makes for this buffer */
+    fail_unless (packetizer->header_from_buffer (inbuffer,
+            GST_DP_HEADER_FLAG_CRC_HEADER | GST_DP_HEADER_FLAG_CRC_PAYLOAD,
+            &len, &header));
+    fail_unless_equals_int (len, GST_DP_HEADER_LENGTH);
+
+    fail_unless (gst_pad_push (mysrcpad, inbuffer) == GST_FLOW_OK);
+
+    /* new_segment and caps come first */
+    if (i == 0) {
+      fail_unless_equals_int (g_list_length (buffers), 3);
+      outbuffer = (GstBuffer *) buffers->data;
+      buffers = g_list_remove (buffers, outbuffer);
+      gst_buffer_unref (outbuffer);
+      outbuffer = (GstBuffer *) buffers->data;
+      buffers = g_list_remove (buffers, outbuffer);
+      gst_buffer_unref (outbuffer);
+    }
+
+    /* the group of the list arrives merged in one buffer on our pad */
+    fail_unless_equals_int (g_list_length (buffers), 1);
+    outbuffer = (GstBuffer *) buffers->data;
+    buffers = g_list_remove (buffers, outbuffer);
+
+    fail_unless_equals_int (GST_BUFFER_SIZE (outbuffer),
+        GST_DP_HEADER_LENGTH + 4 + i);
+    fail_unless (memcmp (GST_BUFFER_DATA (outbuffer), header,
+            GST_DP_HEADER_LENGTH) == 0);
+    fail_unless_equals_int (GST_BUFFER_DATA (outbuffer)[GST_DP_HEADER_LENGTH],
+        i);
+    fail_unless_equals_uint64 (GST_BUFFER_TIMESTAMP (outbuffer),
+        i * GST_MSECOND);
+    fail_unless (GST_BUFFER_CAPS (outbuffer) != NULL);
+
+    g_free (header);
+    gst_buffer_unref (outbuffer);
+  }
+
+  fail_unless (gst_element_set_state (gdppay,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+
+  gst_dp_packetizer_free (packetizer);
+  gst_caps_unref (caps);
+  g_list_foreach (buffers, (GFunc) gst_mini_object_unref, NULL);
+  g_list_free (buffers);
+  buffers = NULL;
+  ASSERT_OBJECT_REFCOUNT (gdppay, "gdppay", 1);
+  cleanup_gdppay (gdppay);
+}
+
+GST_END_TEST;
+
 
 static Suite *
 gdppay_suite (void)
@@ -559,6 +649,7 @@ gdppay_suite (void)
   tcase_add_test (tc_chain, test_first_no_new_segment);
   tcase_add_test (tc_chain, test_streamheader);
   tcase_add_test (tc_chain, test_crc);
+  tcase_add_test (tc_chain, test_buffer_list);
 
   return s;
 }
@@ -30,6 +30,7 @@
 
 static GType gst_red_video_src_get_type (void);
 static GType gst_codec_src_get_type (void);
+static GType gst_gapless_audio_src_get_type (void);
 
 /* make sure the audio sink is not touched for video-only streams */
 GST_START_TEST (test_sink_usage_video_only_stream)
@@ -507,6 +508,331 @@ GST_START_TEST (test_source_setup)
 
 GST_END_TEST;
 
+/* 1 second of audio per uri in buffers of 10ms */
+#define GAPLESS_AUDIO_RATE 8000
+#define GAPLESS_AUDIO_SAMPLES 80
+#define GAPLESS_AUDIO_BUFFERS 100
+
+typedef struct
+{
+  GMutex *lock;
+  gint segments;
+  GstSegment segment;
+  GstClockTime first_end;
+  GstClockTime second_start;
+  GstClockTime last_end;
+  gint gaps;
+  gint buffers;
+  gint about_to_finish;
+  gint buffers_at_about_to_finish;
+} GaplessData;
+
+static gboolean
+gapless_sink_probe (GstPad * pad, GstMiniObject * object, GaplessData * data)
+{
+  g_mutex_lock (data->lock);
+  if (GST_IS_EVENT (object)) {
+    GstEvent *event = GST_EVENT_CAST (object);
+
+    if (GST_EVENT_TYPE (event) == GST_EVENT_NEWSEGMENT) {
+      gboolean update;
+      gdouble rate, applied_rate;
+      GstFormat format;
+      gint64 start, stop, position;
+
+      gst_event_parse_new_segment_full (event, &update, &rate, &applied_rate,
+          &format, &start, &stop, &position);
+      fail_unless_equals_int (format, GST_FORMAT_TIME);
+      if (!update)
+        data->segments++;
+      gst_segment_set_newsegment_full (&data->segment, update, rate,
+          applied_rate, format, start, stop, position);
+    }
+  } else {
+    GstBuffer *buffer = GST_BUFFER_CAST (object);
+    GstClockTime start, end;
+
+    start = gst_segment_to_running_time (&data->segment, GST_FORMAT_TIME,
+        GST_BUFFER_TIMESTAMP (buffer));
+    end = gst_segment_to_running_time (&data->segment, GST_FORMAT_TIME,
+        GST_BUFFER_TIMESTAMP (buffer) + GST_BUFFER_DURATION (buffer));
+
+    /* like the sink, track the position to accumulate the running time */
+    gst_segment_set_last_stop (&data->segment, GST_FORMAT_TIME,
+        GST_BUFFER_TIMESTAMP (buffer) + GST_BUFFER_DURATION (buffer));
+
+    if (data->segments == 1)
+      data->first_end = end;
+    else if (data->segments == 2 && data->second_start == GST_CLOCK_TIME_NONE)
+      data->second_start = start;
+
+    /* every buffer starts at the running time where the previous one ended */
+    if (GST_CLOCK_TIME_IS_VALID (data->last_end) && start != data->last_end) {
+      GST_WARNING ("gap: buffer at %" GST_TIME_FORMAT " after %"
+          GST_TIME_FORMAT, GST_TIME_ARGS (start),
+          GST_TIME_ARGS (data->last_end));
+      data->gaps++;
+    }
+    data->last_end = end;
+    data->buffers++;
+  }
+  g_mutex_unlock (data->lock);
+
+  return TRUE;
+}
+
+static void
+gapless_about_to_finish (GstElement * playbin, GaplessData * data)
+{
+  g_mutex_lock (data->lock);
+  if (data->about_to_finish++ == 0) {
+    data->buffers_at_about_to_finish = data->buffers;
+    g_object_set (playbin, "uri", "gaplessaudio://2", NULL);
+  }
+  g_mutex_unlock (data->lock);
+}
+
+GST_START_TEST (test_gapless_preroll)
+{
+  GstElement *playbin, *audiosink;
+  GstMessage *msg;
+  GstBus *bus;
+  GstPad *pad;
+  GaplessData data;
+
+  fail_unless (gst_element_register (NULL, "gaplessaudiosrc",
+          GST_RANK_PRIMARY, gst_gapless_audio_src_get_type ()));
+
+  data.lock = g_mutex_new ();
+  data.segments = 0;
+  gst_segment_init (&data.segment, GST_FORMAT_UNDEFINED);
+  data.first_end = GST_CLOCK_TIME_NONE;
+  data.second_start = GST_CLOCK_TIME_NONE;
+  data.last_end = GST_CLOCK_TIME_NONE;
+  data.gaps = 0;
+  data.buffers = 0;
+  data.about_to_finish = 0;
+  data.buffers_at_about_to_finish = 0;
+
+  playbin = gst_element_factory_make ("playbin2", NULL);
+  audiosink = gst_element_factory_make ("fakesink", "myaudiosink");
+  g_object_set (audiosink, "sync", FALSE, NULL);
+
+  pad = gst_element_get_static_pad (audiosink, "sink");
+  gst_pad_add_data_probe (pad, G_CALLBACK (gapless_sink_probe), &data);
+  gst_object_unref (pad);
+
+  g_object_set (playbin, "audio-sink", audiosink, "flags", 0x02,
+      "gapless-preroll-time", 500 * GST_MSECOND,
+      "uri", "gaplessaudio://1", NULL);
+  g_signal_connect (playbin, "about-to-finish",
+      G_CALLBACK (gapless_about_to_finish), &data);
+
+  fail_unless_equals_int (gst_element_set_state (playbin, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_ASYNC);
+
+  bus = gst_element_get_bus (playbin);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  fail_unless_equals_int (gst_element_set_state (playbin, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+
+  /* the next uri was requested before the first one was drained */
+  fail_unless (data.about_to_finish > 0);
+  fail_unless (data.buffers_at_about_to_finish < GAPLESS_AUDIO_BUFFERS);
+  fail_unless_equals_int (data.buffers, 2 * GAPLESS_AUDIO_BUFFERS);
+  fail_unless_equals_int (data.segments, 2);
+
+  /* and the second uri starts exactly where the first one ended */
+  GST_DEBUG ("first stream ended at %" GST_TIME_FORMAT ", second started at %"
+      GST_TIME_FORMAT, GST_TIME_ARGS (data.first_end),
+      GST_TIME_ARGS (data.second_start));
+  fail_unless (GST_CLOCK_TIME_IS_VALID (data.first_end));
+  fail_unless (GST_CLOCK_TIME_IS_VALID (data.second_start));
+  fail_unless_equals_uint64 (data.second_start, data.first_end);
+  fail_unless_equals_int (data.gaps, 0);
+  fail_unless_equals_uint64 (data.last_end, 2 * GST_SECOND);
+
+  gst_object_unref (playbin);
+  g_mutex_free (data.lock);
+}
+
+GST_END_TEST;
+
+/* tracks the running time of a stream like a sink does */
+typedef struct
+{
+  GstSegment segment;
+  gint segments;
+  GstClockTime second_start;
+} SwitchStream;
+
+static gboolean
+switch_sink_event (GstPad * pad, GstEvent * event)
+{
+  SwitchStream *stream = gst_pad_get_element_private (pad);
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_NEWSEGMENT) {
+    gboolean update;
+    gdouble rate, applied_rate;
+    GstFormat format;
+    gint64 start, stop, position;
+
+    gst_event_parse_new_segment_full (event, &update, &rate, &applied_rate,
+        &format, &start, &stop, &position);
+    if (!update)
+      stream->segments++;
+    gst_segment_set_newsegment_full (&stream->segment, update, rate,
+        applied_rate, format, start, stop, position);
+  }
+  gst_event_unref (event);
+
+  return TRUE;
+}
+
+static GstFlowReturn
+switch_sink_chain (GstPad * pad, GstBuffer * buffer)
+{
+  SwitchStream *stream = gst_pad_get_element_private (pad);
+
+  if (stream->segments == 2 && stream->second_start == GST_CLOCK_TIME_NONE)
+    stream->second_start = gst_segment_to_running_time (&stream->segment,
+        GST_FORMAT_TIME, GST_BUFFER_TIMESTAMP (buffer));
+  gst_segment_set_last_stop (&stream->segment, GST_FORMAT_TIME,
+      GST_BUFFER_TIMESTAMP (buffer) + GST_BUFFER_DURATION (buffer));
+  gst_buffer_unref (buffer);
+
+  return GST_FLOW_OK;
+}
+
+static void
+push_switch_buffers (GstPad * pad, GstClockTime duration, guint count)
+{
+  guint i;
+
+  for (i = 0; i < count; i++) {
+    GstBuffer *buffer = gst_buffer_new ();
+
+    GST_BUFFER_TIMESTAMP (buffer) = i * duration;
+    GST_BUFFER_DURATION (buffer) = duration;
+    fail_unless_equals_int (gst_pad_push (pad, buffer), GST_FLOW_OK);
+  }
+}
+
+/* 10 seconds of audio and 301 video frames, which end 33ms later */
+#define SWITCH_AUDIO_DURATION (100 * GST_MSECOND)
+#define SWITCH_AUDIO_BUFFERS 100
+#define SWITCH_VIDEO_DURATION (GST_SECOND / 30)
+#define SWITCH_VIDEO_BUFFERS 301
+
+/* plays an audio and a video stream through the stream synchronizer of
+ * playsink, switches both to a new stream and returns the running times at
+ * which the new streams start */
+static void
+run_stream_switch (gboolean close_segments, GstClockTime * audio_start,
+    GstClockTime * video_start)
+{
+  GstElement *playsink, *sync;
+  GstPad *srcpads[2], *sinkpads[2], *pad, *peer;
+  SwitchStream streams[2];
+  GType sync_type;
+  gchar *name;
+  gint i;
+
+  /* the stream synchronizer type is registered with the playback plugin */
+  playsink = gst_element_factory_make ("playsink", NULL);
+  fail_unless (playsink != NULL);
+  gst_object_unref (playsink);
+  sync_type = g_type_from_name ("GstStreamSynchronizer");
+  fail_unless (sync_type != 0);
+
+  sync = g_object_new (sync_type, "close-segments", close_segments, NULL);
+  fail_unless_equals_int (gst_element_set_state (sync, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_SUCCESS);
+
+  for (i = 0; i < 2; i++) {
+    gst_segment_init (&streams[i].segment, GST_FORMAT_UNDEFINED);
+    streams[i].segments = 0;
+    streams[i].second_start = GST_CLOCK_TIME_NONE;
+
+    pad = gst_element_get_request_pad (sync, "sink_%d");
+    fail_unless (pad != NULL);
+    srcpads[i] = gst_pad_new ("src", GST_PAD_SRC);
+    fail_unless_equals_int (gst_pad_link (srcpads[i], pad), GST_PAD_LINK_OK);
+    gst_object_unref (pad);
+
+    name = g_strdup_printf ("src_%d", i);
+    peer = gst_element_get_static_pad (sync, name);
+    g_free (name);
+    fail_unless (peer != NULL);
+    sinkpads[i] = gst_pad_new ("sink", GST_PAD_SINK);
+    gst_pad_set_element_private (sinkpads[i], &streams[i]);
+    gst_pad_set_event_function (sinkpads[i], switch_sink_event);
+    gst_pad_set_chain_function (sinkpads[i], switch_sink_chain);
+    fail_unless_equals_int (gst_pad_link (peer, sinkpads[i]), GST_PAD_LINK_OK);
+    gst_object_unref (peer);
+
+    gst_pad_set_active (srcpads[i], TRUE);
+    gst_pad_set_active (sinkpads[i], TRUE);
+  }
+
+  /* the first streams, the video ends a bit after the audio */
+  for (i = 0; i < 2; i++) {
+    fail_unless (gst_pad_push_event (srcpads[i],
+            gst_event_new_new_segment (FALSE, 1.0, GST_FORMAT_TIME, 0, -1,
+                0)));
+  }
+  push_switch_buffers (srcpads[0], SWITCH_AUDIO_DURATION, SWITCH_AUDIO_BUFFERS);
+  push_switch_buffers (srcpads[1], SWITCH_VIDEO_DURATION, SWITCH_VIDEO_BUFFERS);
+
+  /* the next streams */
+  for (i = 0; i < 2; i++) {
+    fail_unless (gst_pad_push_event (srcpads[i],
+            gst_event_new_new_segment (FALSE, 1.0, GST_FORMAT_TIME, 0, -1,
+                0)));
+  }
+  push_switch_buffers (srcpads[0], SWITCH_AUDIO_DURATION, 1);
+  push_switch_buffers (srcpads[1], SWITCH_VIDEO_DURATION, 1);
+
+  *audio_start = streams[0].second_start;
+  *video_start = streams[1].second_start;
+
+  fail_unless_equals_int (gst_element_set_state (sync, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+  for (i = 0; i < 2; i++) {
+    gst_pad_set_active (srcpads[i], FALSE);
+    gst_pad_set_active (sinkpads[i], FALSE);
+    gst_object_unref (srcpads[i]);
+    gst_object_unref (sinkpads[i]);
+  }
+  gst_object_unref (sync);
+}
+
+GST_START_TEST (test_gapless_segment_close)
+{
+  GstClockTime audio_start, video_start;
+
+  /* by default the segments are passed on untouched */
+  run_stream_switch (FALSE, &audio_start, &video_start);
+  fail_unless_equals_uint64 (audio_start,
+      SWITCH_AUDIO_BUFFERS * SWITCH_AUDIO_DURATION);
+  fail_unless_equals_uint64 (video_start,
+      SWITCH_VIDEO_BUFFERS * SWITCH_VIDEO_DURATION);
+
+  /* for gapless playback both streams are closed where the video ended, so
+   * they stay in sync */
+  run_stream_switch (TRUE, &audio_start, &video_start);
+  fail_unless_equals_uint64 (audio_start,
+      SWITCH_VIDEO_BUFFERS * SWITCH_VIDEO_DURATION);
+  fail_unless_equals_uint64 (video_start, audio_start);
+}
+
+GST_END_TEST;
+
 /*** redvideo:// source ***/
 
 static GstURIType
@@ -717,6 +1043,167 @@ gst_codec_src_init (GstCodecSrc * src, GstCodecSrcClass * klass)
 {
 }
 
+/*** gaplessaudio:// source ***/
+
+static GstURIType
+gst_gapless_audio_src_uri_get_type (void)
+{
+  return GST_URI_SRC;
+}
+
+static gchar **
+gst_gapless_audio_src_uri_get_protocols (void)
+{
+  static gchar *protocols[] = { (char *) "gaplessaudio", NULL };
+
+  return protocols;
+}
+
+static const gchar *
+gst_gapless_audio_src_uri_get_uri (GstURIHandler * handler)
+{
+  return "gaplessaudio://";
+}
+
+static gboolean
+gst_gapless_audio_src_uri_set_uri (GstURIHandler * handler, const gchar * uri)
+{
+  return (uri != NULL && g_str_has_prefix (uri, "gaplessaudio:"));
+}
+
+static void
+gst_gapless_audio_src_uri_handler_init (gpointer g_iface, gpointer iface_data)
+{
+  GstURIHandlerInterface *iface = (GstURIHandlerInterface *) g_iface;
+
+  iface->get_type = gst_gapless_audio_src_uri_get_type;
+  iface->get_protocols = gst_gapless_audio_src_uri_get_protocols;
+  iface->get_uri = gst_gapless_audio_src_uri_get_uri;
+  iface->set_uri = gst_gapless_audio_src_uri_set_uri;
+}
+
+static void
+gst_gapless_audio_src_init_type (GType type)
+{
+  static const GInterfaceInfo uri_hdlr_info = {
+    gst_gapless_audio_src_uri_handler_init, NULL, NULL
+  };
+
+  g_type_add_interface_static (type, GST_TYPE_URI_HANDLER, &uri_hdlr_info);
+}
+
+#undef parent_class
+#define parent_class gapless_audio_src_parent_class
+
+typedef struct
+{
+  GstPushSrc parent;
+
+  guint n_buffers;
+} GstGaplessAudioSrc;
+
+typedef GstPushSrcClass GstGaplessAudioSrcClass;
+
+GST_BOILERPLATE_FULL (GstGaplessAudioSrc, gst_gapless_audio_src, GstPushSrc,
+    GST_TYPE_PUSH_SRC, gst_gapless_audio_src_init_type);
+
+static void
+gst_gapless_audio_src_base_init (gpointer klass)
+{
+  static GstStaticPadTemplate src_templ = GST_STATIC_PAD_TEMPLATE ("src",
+      GST_PAD_SRC, GST_PAD_ALWAYS,
+      GST_STATIC_CAPS ("audio/x-raw-int, rate=(int)8000, channels=(int)1, "
+          "width=(int)16, depth=(int)16, signed=(boolean)true, "
+          "endianness=(int)BYTE_ORDER")
+      );
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+
+  gst_element_class_add_static_pad_template (element_class, &src_templ);
+  gst_element_class_set_details_simple (element_class,
+      "Gapless Audio Src", "Source/Audio", "yep", "me");
+}
+
+static gboolean
+gst_gapless_audio_src_start (GstBaseSrc * basesrc)
+{
+  GstGaplessAudioSrc *src = (GstGaplessAudioSrc *) basesrc;
+
+  src->n_buffers = 0;
+
+  return TRUE;
+}
+
+static gboolean
+gst_gapless_audio_src_query (GstBaseSrc * basesrc, GstQuery * query)
+{
+  if (GST_QUERY_TYPE (query) == GST_QUERY_DURATION) {
+    GstFormat format;
+
+    gst_query_parse_duration (query, &format, NULL);
+    if (format == GST_FORMAT_TIME) {
+      gst_query_set_duration (query, GST_FORMAT_TIME,
+          gst_util_uint64_scale_int (GAPLESS_AUDIO_BUFFERS *
+              GAPLESS_AUDIO_SAMPLES, GST_SECOND, GAPLESS_AUDIO_RATE));
+      return TRUE;
+    }
+  }
+
+  return GST_BASE_SRC_CLASS (parent_class)->query (basesrc, query);
+}
+
+static GstFlowReturn
+gst_gapless_audio_src_create (GstPushSrc * pushsrc, GstBuffer ** p_buf)
+{
+  GstGaplessAudioSrc *src = (GstGaplessAudioSrc *) pushsrc;
+  GstBuffer *buf;
+  GstCaps *caps;
+  guint64 offset;
+
+  if (src->n_buffers == GAPLESS_AUDIO_BUFFERS)
+    return GST_FLOW_UNEXPECTED;
+
+  buf = gst_buffer_new_and_alloc (GAPLESS_AUDIO_SAMPLES * 2);
+  memset (GST_BUFFER_DATA (buf), 0, GST_BUFFER_SIZE (buf));
+
+  offset = src->n_buffers * GAPLESS_AUDIO_SAMPLES;
+  GST_BUFFER_OFFSET (buf) = offset;
+  GST_BUFFER_OFFSET_END (buf) = offset + GAPLESS_AUDIO_SAMPLES;
+  GST_BUFFER_TIMESTAMP (buf) =
+      gst_util_uint64_scale_int (offset, GST_SECOND, GAPLESS_AUDIO_RATE);
+  GST_BUFFER_DURATION (buf) =
+      gst_util_uint64_scale_int (offset + GAPLESS_AUDIO_SAMPLES, GST_SECOND,
+      GAPLESS_AUDIO_RATE) - GST_BUFFER_TIMESTAMP (buf);
+  src->n_buffers++;
+
+  caps = gst_caps_new_simple ("audio/x-raw-int", "rate", G_TYPE_INT,
+      GAPLESS_AUDIO_RATE, "channels", G_TYPE_INT, 1, "width", G_TYPE_INT, 16,
+      "depth", G_TYPE_INT, 16, "signed", G_TYPE_BOOLEAN, TRUE,
+      "endianness", G_TYPE_INT, G_BYTE_ORDER, NULL);
+  gst_buffer_set_caps (buf, caps);
+  gst_caps_unref (caps);
+
+  *p_buf = buf;
+  return GST_FLOW_OK;
+}
+
+static void
+gst_gapless_audio_src_class_init (GstGaplessAudioSrcClass * klass)
+{
+  GstBaseSrcClass *basesrc_class = GST_BASE_SRC_CLASS (klass);
+  GstPushSrcClass *pushsrc_class = GST_PUSH_SRC_CLASS (klass);
+
+  basesrc_class->start = gst_gapless_audio_src_start;
+  basesrc_class->query = gst_gapless_audio_src_query;
+  pushsrc_class->create = gst_gapless_audio_src_create;
+}
+
+static void
+gst_gapless_audio_src_init (GstGaplessAudioSrc * src,
+    GstGaplessAudioSrcClass * klass)
+{
+  gst_base_src_set_format (GST_BASE_SRC (src), GST_FORMAT_TIME);
+}
+
 #endif /* GST_DISABLE_REGISTRY */
 
 
@@ -738,6 +1225,8 @@ playbin2_suite (void)
   tcase_add_test (tc_chain, test_missing_primary_decoder);
   tcase_add_test (tc_chain, test_refcount);
   tcase_add_test (tc_chain, test_source_setup);
+  tcase_add_test (tc_chain, test_gapless_preroll);
+  tcase_add_test (tc_chain, test_gapless_segment_close);
 
   /* one day we might also want to have the following checks:
    * tcase_add_test (tc_chain, test_missing_secondary_decoder_one_fatal);
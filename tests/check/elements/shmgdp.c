@@ -0,0 +1,237 @@
+/* GStreamer
+ *
+ * unit tests for shmgdpsink and shmgdpsrc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <string.h>
+#include <unistd.h>
+
+#include <glib/gstdio.h>
+
+#include <gst/check/gstcheck.h>
+
+static GstPad *mysrcpad, *mysinkpad;
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-gst-check")
+    );
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+#define NUM_SLOTS 2
+#define SLOT_SIZE 4096
+
+static gchar *
+make_socket_path (void)
+{
+  return g_strdup_printf ("%s/shmgdp-test-%d", g_get_tmp_dir (),
+      (gint) getpid ());
+}
+
+static GstElement *
+setup_shmgdpsink (const gchar * socket_path)
+{
+  GstElement *sink;
+
+  GST_DEBUG ("setup_shmgdpsink");
+  sink = gst_check_setup_element ("shmgdpsink");
+  g_object_set (sink, "socket-path", socket_path, "num-slots", NUM_SLOTS,
+      "slot-size", SLOT_SIZE, "sync", FALSE, NULL);
+  mysrcpad = gst_check_setup_src_pad (sink, &srctemplate, NULL);
+  gst_pad_set_active (mysrcpad, TRUE);
+
+  return sink;
+}
+
+static GstElement *
+setup_shmgdpsrc (const gchar * socket_path)
+{
+  GstElement *src;
+
+  GST_DEBUG ("setup_shmgdpsrc");
+  src = gst_check_setup_element ("shmgdpsrc");
+  g_object_set (src, "socket-path", socket_path, NULL);
+  mysinkpad = gst_check_setup_sink_pad (src, &sinktemplate, NULL);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  return src;
+}
+
+static void
+wait_buffers (guint n)
+{
+  g_mutex_lock (check_mutex);
+  while (g_list_length (buffers) < n)
+    g_cond_wait (check_cond, check_mutex);
+  g_mutex_unlock (check_mutex);
+}
+
+static void
+drop_buffers (void)
+{
+  g_mutex_lock (check_mutex);
+  g_list_foreach (buffers, (GFunc) gst_mini_object_unref, NULL);
+  g_list_free (buffers);
+  buffers = NULL;
+  g_mutex_unlock (check_mutex);
+}
+
+static void
+push_buffer (GstCaps * caps, guint size, guint8 fill, gboolean alloc)
+{
+  GstBuffer *buffer;
+
+  if (alloc) {
+    fail_unless (gst_pad_alloc_buffer (mysrcpad, 0, size, caps,
+            &buffer) == GST_FLOW_OK);
+    /* allocated in the shared memory area */
+    fail_unless (GST_BUFFER_FREE_FUNC (buffer) != NULL);
+  } else {
+    buffer = gst_buffer_new_and_alloc (size);
+    gst_buffer_set_caps (buffer, caps);
+  }
+  memset (GST_BUFFER_DATA (buffer), fill, size);
+  GST_BUFFER_TIMESTAMP (buffer) = fill * GST_SECOND;
+
+  fail_unless (gst_pad_push (mysrcpad, buffer) == GST_FLOW_OK);
+}
+
+static void
+check_buffer (GstBuffer * buffer, guint size, guint8 fill, gboolean in_slot)
+{
+  fail_unless_equals_int (GST_BUFFER_SIZE (buffer), size);
+  fail_unless_equals_int (GST_BUFFER_DATA (buffer)[0], fill);
+  fail_unless_equals_int (GST_BUFFER_DATA (buffer)[size - 1], fill);
+  fail_unless_equals_uint64 (GST_BUFFER_TIMESTAMP (buffer), fill * GST_SECOND);
+  fail_unless (GST_BUFFER_CAPS (buffer) != NULL);
+  /* buffers in the shared memory area are read-only */
+  fail_unless_equals_int (GST_BUFFER_FLAG_IS_SET (buffer,
+          GST_BUFFER_FLAG_READONLY) ? TRUE : FALSE, in_slot);
+}
+
+GST_START_TEST (test_slots)
+{
+  GstElement *sink, *src;
+  GstBuffer *buffer;
+  GstCaps *caps;
+  gchar *socket_path;
+  gboolean in_slot = FALSE;
+  gint i;
+
+  socket_path = make_socket_path ();
+  sink = setup_shmgdpsink (socket_path);
+  ASSERT_SET_STATE (sink, GST_STATE_PLAYING, GST_STATE_CHANGE_ASYNC);
+
+  src = setup_shmgdpsrc (socket_path);
+  ASSERT_SET_STATE (src, GST_STATE_PLAYING, GST_STATE_CHANGE_SUCCESS);
+
+  caps = gst_caps_from_string ("application/x-gst-check");
+
+  /* allocated in a slot, sent without copy */
+  push_buffer (caps, 1000, 1, TRUE);
+  /* copied to the last free slot */
+  push_buffer (caps, 1000, 2, FALSE);
+  /* the src holds both slots, sent inline */
+  push_buffer (caps, 1000, 3, FALSE);
+  /* doesn't fit in a slot, sent inline */
+  push_buffer (caps, 2 * SLOT_SIZE, 4, FALSE);
+
+  wait_buffers (4);
+  check_buffer (g_list_nth_data (buffers, 0), 1000, 1, TRUE);
+  check_buffer (g_list_nth_data (buffers, 1), 1000, 2, TRUE);
+  check_buffer (g_list_nth_data (buffers, 2), 1000, 3, FALSE);
+  check_buffer (g_list_nth_data (buffers, 3), 2 * SLOT_SIZE, 4, FALSE);
+
+  /* freeing the buffers releases the slots to the sink */
+  drop_buffers ();
+  for (i = 0; i < 100 && !in_slot; i++) {
+    fail_unless (gst_pad_alloc_buffer (mysrcpad, 0, 1000, caps,
+            &buffer) == GST_FLOW_OK);
+    in_slot = GST_BUFFER_FREE_FUNC (buffer) != NULL;
+    gst_buffer_unref (buffer);
+    if (!in_slot)
+      g_usleep (G_USEC_PER_SEC / 100);
+  }
+  fail_unless (in_slot, "slots were not released");
+
+  push_buffer (caps, 1000, 5, TRUE);
+  wait_buffers (1);
+  check_buffer (g_list_nth_data (buffers, 0), 1000, 5, TRUE);
+  drop_buffers ();
+
+  ASSERT_SET_STATE (src, GST_STATE_NULL, GST_STATE_CHANGE_SUCCESS);
+  ASSERT_SET_STATE (sink, GST_STATE_NULL, GST_STATE_CHANGE_SUCCESS);
+
+  gst_check_teardown_sink_pad (src);
+  gst_check_teardown_element (src);
+  gst_check_teardown_src_pad (sink);
+  gst_check_teardown_element (sink);
+
+  gst_caps_unref (caps);
+  g_free (socket_path);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_keep_other_files)
+{
+  GstElement *sink;
+  gchar *socket_path, *contents = NULL;
+
+  /* a regular file where the socket should go is not removed */
+  socket_path = make_socket_path ();
+  fail_unless (g_file_set_contents (socket_path, "data", -1, NULL));
+
+  sink = setup_shmgdpsink (socket_path);
+  fail_unless_equals_int (gst_element_set_state (sink, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_FAILURE);
+  fail_unless_equals_int (gst_element_set_state (sink, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+
+  fail_unless (g_file_get_contents (socket_path, &contents, NULL, NULL));
+  fail_unless_equals_string (contents, "data");
+  g_free (contents);
+
+  gst_check_teardown_src_pad (sink);
+  gst_check_teardown_element (sink);
+
+  g_unlink (socket_path);
+  g_free (socket_path);
+}
+
+GST_END_TEST;
+
+static Suite *
+shmgdp_suite (void)
+{
+  Suite *s = suite_create ("shmgdp");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_slots);
+  tcase_add_test (tc_chain, test_keep_other_files);
+
+  return s;
+}
+
+GST_CHECK_MAIN (shmgdp);
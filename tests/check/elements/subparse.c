@@ -682,6 +682,176 @@ GST_START_TEST (test_sami)
 GST_END_TEST;
 #endif
 
+/* the SubRip autodetection only looks at the first 35 characters; @head is
+ * followed by a well-formed entry, which is parsed if @head is detected */
+static void
+check_srt_detection (const gchar * head, gboolean detected)
+{
+  GstBuffer *buf, *last;
+  gchar *input;
+
+  GST_LOG ("srt detection: '%s'", head);
+
+  setup_subparse ();
+
+  input = g_strconcat (head, "2\n00:00:05,000 --> 00:00:06,000\nTwo\n\n", NULL);
+  buf = gst_buffer_new ();
+  GST_BUFFER_MALLOCDATA (buf) = (guint8 *) input;
+  GST_BUFFER_DATA (buf) = GST_BUFFER_MALLOCDATA (buf);
+  GST_BUFFER_SIZE (buf) = strlen (input);
+
+  if (detected) {
+    fail_unless_equals_int (gst_pad_push (mysrcpad, buf), GST_FLOW_OK);
+    gst_pad_push_event (mysrcpad, gst_event_new_eos ());
+
+    fail_unless (buffers != NULL);
+    last = GST_BUFFER_CAST (g_list_last (buffers)->data);
+    fail_unless_equals_uint64 (GST_BUFFER_TIMESTAMP (last), 5 * GST_SECOND);
+    fail_unless_equals_uint64 (GST_BUFFER_DURATION (last), GST_SECOND);
+    fail_unless_equals_string ((gchar *) GST_BUFFER_DATA (last), "Two");
+  } else {
+    fail_unless_equals_int (gst_pad_push (mysrcpad, buf), GST_FLOW_UNEXPECTED);
+    fail_unless (buffers == NULL);
+  }
+
+  teardown_subparse ();
+}
+
+GST_START_TEST (test_srt_detection)
+{
+  /* indented or space-padded chunk numbers */
+  check_srt_detection ("   1\n00:00:01,000 --> 00:00:02,000\nOne\n\n", TRUE);
+  check_srt_detection ("1   \n00:00:01,000 --> 00:00:02,000\nOne\n\n", TRUE);
+  check_srt_detection ("   1234\n00:00:01,000 --> 00:00:02,000\nOne\n\n",
+      TRUE);
+  /* up to three spaces of indentation plus a space-padded number */
+  check_srt_detection ("    1\n00:00:01,000 --> 00:00:02,000\nOne\n\n", TRUE);
+
+  /* DOS line endings */
+  check_srt_detection ("1\r\n00:00:01,000 --> 00:00:02,000\r\nOne\r\n\r\n",
+      TRUE);
+
+  /* blank lines between the chunk number and the timing line */
+  check_srt_detection ("1\n\n00:00:01,000 --> 00:00:02,000\nOne\n\n", TRUE);
+  check_srt_detection ("1\r\n \r\n00:00:01,000 --> 00:00:02,000\nOne\n\n",
+      TRUE);
+
+  /* both separators for the milliseconds */
+  check_srt_detection ("1\n00:00:01.000 --> 00:00:02.000\nOne\n\n", TRUE);
+  check_srt_detection ("1\n00:00:01,000 --> 00:00:02.000\nOne\n\n", TRUE);
+  check_srt_detection ("1\n 0: 0:01, 0 --> 0: 0:02, 0\nOne\n\n", TRUE);
+
+  /* near misses */
+  check_srt_detection ("12345\n00:00:01,000 --> 00:00:02,000\nOne\n\n",
+      FALSE);
+  check_srt_detection ("      12\n00:00:01,000 --> 00:00:02,000\nOne\n\n",
+      FALSE);
+  check_srt_detection ("1 One\n00:00:01,000 --> 00:00:02,000\nOne\n\n",
+      FALSE);
+  check_srt_detection ("1\n00:00:01,000 -> 00:00:02,000\nOne\n\n", FALSE);
+  check_srt_detection ("1\n00:00:01,000-->00:00:02,000\nOne\n\n", FALSE);
+  check_srt_detection ("1\n00:00:01 --> 00:00:02\nOne\n\n", FALSE);
+  check_srt_detection ("1\n00:00:01:000 --> 00:00:02:000\nOne\n\n", FALSE);
+  check_srt_detection ("1\n000:00:01,000 --> 00:00:02,000\nOne\n\n", FALSE);
+  check_srt_detection ("1\n00:00:01,000 --> 00:00:02,\nOne\n\n", FALSE);
+}
+
+GST_END_TEST;
+
+#define CHUNKED_ENTRIES 2000
+#define CHUNK_SIZE 4096
+
+static guint chunked_n_buffers;
+static guint chunked_n_bad;
+
+static GstFlowReturn
+chunked_chain (GstPad * pad, GstBuffer * buf)
+{
+  /* all the subtitles contain a two-byte UTF-8 character, which has to
+   * survive being split over two input chunks */
+  if (strstr ((const gchar *) GST_BUFFER_DATA (buf), "caf\303\251") == NULL)
+    chunked_n_bad++;
+  chunked_n_buffers++;
+  gst_buffer_unref (buf);
+
+  return GST_FLOW_OK;
+}
+
+/* creates @n_entries subtitles of the given format ("srt", "mdvd" or
+ * "mpl2"), each one two seconds long */
+static GstBuffer *
+create_chunked_input (const gchar * format, guint n_entries)
+{
+  GstBuffer *buf;
+  GString *str;
+  guint i;
+
+  str = g_string_new (NULL);
+  for (i = 0; i < n_entries; i++) {
+    guint start = i * 3, end = start + 2;
+
+    if (strcmp (format, "srt") == 0) {
+      g_string_append_printf (str, "%u\n%02u:%02u:%02u,000 --> "
+          "%02u:%02u:%02u,500\nLine %u in the caf\303\251\n<i>and a second "
+          "one</i>\n\n", i + 1, start / 3600, (start / 60) % 60, start % 60,
+          end / 3600, (end / 60) % 60, end % 60, i);
+    } else if (strcmp (format, "mdvd") == 0) {
+      g_string_append_printf (str, "{%u}{%u}Line %u in the caf\303\251|"
+          "/and a second one\n", start * 25, end * 25, i);
+    } else {
+      g_string_append_printf (str, "[%u][%u]Line %u in the caf\303\251|"
+          "/and a second one\n", start * 10, end * 10, i);
+    }
+  }
+
+  buf = gst_buffer_new ();
+  GST_BUFFER_SIZE (buf) = str->len;
+  GST_BUFFER_MALLOCDATA (buf) = (guint8 *) g_string_free (str, FALSE);
+  GST_BUFFER_DATA (buf) = GST_BUFFER_MALLOCDATA (buf);
+
+  return buf;
+}
+
+/* feeds the input in chunks that split lines and characters */
+static void
+do_chunked_test (const gchar * format)
+{
+  GstBuffer *input;
+  guint offset, size;
+
+  input = create_chunked_input (format, CHUNKED_ENTRIES);
+  size = GST_BUFFER_SIZE (input);
+
+  setup_subparse ();
+  gst_pad_set_chain_function (mysinkpad, chunked_chain);
+  chunked_n_buffers = chunked_n_bad = 0;
+
+  for (offset = 0; offset < size; offset += CHUNK_SIZE) {
+    GstBuffer *buf;
+
+    buf = gst_buffer_create_sub (input, offset,
+        MIN (CHUNK_SIZE, size - offset));
+    GST_BUFFER_OFFSET (buf) = offset;
+    fail_unless_equals_int (gst_pad_push (mysrcpad, buf), GST_FLOW_OK);
+  }
+  gst_pad_push_event (mysrcpad, gst_event_new_eos ());
+
+  fail_unless_equals_int (chunked_n_buffers, CHUNKED_ENTRIES);
+  fail_unless_equals_int (chunked_n_bad, 0);
+
+  teardown_subparse ();
+  gst_buffer_unref (input);
+}
+
+GST_START_TEST (test_chunked_input)
+{
+  do_chunked_test ("srt");
+  do_chunked_test ("mdvd");
+  do_chunked_test ("mpl2");
+}
+
+GST_END_TEST;
+
 /* TODO:
  *  - add/modify tests so that lines aren't dogfed to the parsers in complete
  *    lines or sets of complete lines, but rather in random chunks
@@ -710,6 +880,8 @@ subparse_suite (void)
   tcase_add_test (tc_chain, test_subviewer);
   tcase_add_test (tc_chain, test_subviewer2);
   tcase_add_test (tc_chain, test_dks);
+  tcase_add_test (tc_chain, test_srt_detection);
+  tcase_add_test (tc_chain, test_chunked_input);
 #ifndef GST_DISABLE_XML
   tcase_add_test (tc_chain, test_sami);
 #endif
@@ -65,22 +65,40 @@ static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS_ANY);
+static GstStaticPadTemplate s16_sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("audio/x-raw-int, width = (int) 16, depth = (int) 16, "
+        "signed = (boolean) true, endianness = (int) BYTE_ORDER"));
+static GstStaticPadTemplate s32_sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("audio/x-raw-int, width = (int) 32, depth = (int) 32, "
+        "signed = (boolean) true, endianness = (int) BYTE_ORDER"));
+
+#define STREAM_RATE 44100
 
 static GstElement *
-setup_vorbisdec (void)
+setup_vorbisdec_with_template (GstStaticPadTemplate * sinktmpl)
 {
   GstElement *vorbisdec;
 
   GST_DEBUG ("setup_vorbisdec");
   vorbisdec = gst_check_setup_element ("vorbisdec");
   mysrcpad = gst_check_setup_src_pad (vorbisdec, &srctemplate, NULL);
-  mysinkpad = gst_check_setup_sink_pad (vorbisdec, &sinktemplate, NULL);
+  mysinkpad = gst_check_setup_sink_pad (vorbisdec, sinktmpl, NULL);
   gst_pad_set_active (mysrcpad, TRUE);
   gst_pad_set_active (mysinkpad, TRUE);
 
   return vorbisdec;
 }
 
+static GstElement *
+setup_vorbisdec (void)
+{
+  return setup_vorbisdec_with_template (&sinktemplate);
+}
+
 static void
 cleanup_vorbisdec (GstElement * vorbisdec)
 {
@@ -286,6 +304,266 @@ GST_START_TEST (test_empty_vorbis_packet)
 
 GST_END_TEST;
 
+static GstBuffer *
+buffer_from_packet (ogg_packet * packet)
+{
+  GstBuffer *buffer;
+
+  buffer = gst_buffer_new_and_alloc (packet->bytes);
+  memcpy (GST_BUFFER_DATA (buffer), packet->packet, packet->bytes);
+
+  return buffer;
+}
+
+/* encode @seconds of a triangle wave, returns the three headers and the
+ * audio packets */
+static GList *
+encode_stream (gint channels, gint seconds)
+{
+  GList *list = NULL;
+  ogg_packet header, header_comm, header_code, packet;
+  gint n, len, total = seconds * STREAM_RATE;
+
+  vorbis_info_init (&vi);
+  fail_unless (vorbis_encode_init_vbr (&vi, channels, STREAM_RATE, 0.5) == 0);
+  vorbis_analysis_init (&vd, &vi);
+  vorbis_block_init (&vd, &vb);
+  vorbis_comment_init (&vc);
+  vorbis_analysis_headerout (&vd, &vc, &header, &header_comm, &header_code);
+  list = g_list_append (list, buffer_from_packet (&header));
+  list = g_list_append (list, buffer_from_packet (&header_comm));
+  list = g_list_append (list, buffer_from_packet (&header_code));
+
+  /* the last round writes 0 samples to signal the end of the stream */
+  for (n = 0;; n += len) {
+    gint i, j;
+
+    len = MIN (1024, total - n);
+    if (len > 0) {
+      float **data = vorbis_analysis_buffer (&vd, len);
+
+      /* 441 Hz, with a different amplitude for each channel */
+      for (i = 0; i < channels; i++) {
+        for (j = 0; j < len; j++) {
+          gint phase = (n + j) % 100;
+          float v = (phase < 50 ? phase : 100 - phase) / 25.0 - 1.0;
+
+          data[i][j] = v * 0.8 / (i + 1);
+        }
+      }
+    }
+    vorbis_analysis_wrote (&vd, len);
+
+    while (vorbis_analysis_blockout (&vd, &vb) == 1) {
+      vorbis_analysis (&vb, NULL);
+      vorbis_bitrate_addblock (&vb);
+      while (vorbis_bitrate_flushpacket (&vd, &packet))
+        list = g_list_append (list, buffer_from_packet (&packet));
+    }
+    if (len == 0)
+      break;
+  }
+
+  vorbis_comment_clear (&vc);
+  vorbis_block_clear (&vb);
+  vorbis_dsp_clear (&vd);
+  vorbis_info_clear (&vi);
+
+  return list;
+}
+
+static void
+free_stream (GList * list)
+{
+  g_list_foreach (list, (GFunc) gst_mini_object_unref, NULL);
+  g_list_free (list);
+}
+
+static void
+drop_buffers (void)
+{
+  g_list_foreach (buffers, (GFunc) gst_mini_object_unref, NULL);
+  g_list_free (buffers);
+  buffers = NULL;
+}
+
+static void
+push_buffers (GList * list)
+{
+  for (; list; list = list->next) {
+    fail_unless_equals_int (gst_pad_push (mysrcpad,
+            gst_buffer_ref (GST_BUFFER_CAST (list->data))), GST_FLOW_OK);
+  }
+}
+
+/* decode @stream to the format of @sinktmpl, returns the decoded data of all
+ * output buffers concatenated */
+static GstBuffer *
+decode_stream (GList * stream, GstStaticPadTemplate * sinktmpl,
+    const gchar * name, gint width)
+{
+  GstElement *vorbisdec;
+  GstStructure *s;
+  GstBuffer *result, *buffer;
+  GList *walk;
+  guint size = 0;
+  gint caps_width;
+
+  vorbisdec = setup_vorbisdec_with_template (sinktmpl);
+  fail_unless_equals_int (gst_element_set_state (vorbisdec, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_SUCCESS);
+
+  push_buffers (stream);
+  fail_unless (buffers != NULL);
+
+  for (walk = buffers; walk; walk = walk->next) {
+    buffer = GST_BUFFER_CAST (walk->data);
+    fail_unless (GST_BUFFER_CAPS (buffer) != NULL);
+    s = gst_caps_get_structure (GST_BUFFER_CAPS (buffer), 0);
+    fail_unless (gst_structure_has_name (s, name));
+    fail_unless (gst_structure_get_int (s, "width", &caps_width));
+    fail_unless_equals_int (caps_width, width);
+    size += GST_BUFFER_SIZE (buffer);
+  }
+
+  result = gst_buffer_new_and_alloc (size);
+  size = 0;
+  for (walk = buffers; walk; walk = walk->next) {
+    buffer = GST_BUFFER_CAST (walk->data);
+    memcpy (GST_BUFFER_DATA (result) + size, GST_BUFFER_DATA (buffer),
+        GST_BUFFER_SIZE (buffer));
+    size += GST_BUFFER_SIZE (buffer);
+  }
+
+  drop_buffers ();
+  cleanup_vorbisdec (vorbisdec);
+
+  return result;
+}
+
+static void
+check_integer_output (gint channels)
+{
+  GList *stream;
+  GstBuffer *f32, *s16, *s32;
+  const gfloat *fdata;
+  const gint16 *s16data;
+  const gint32 *s32data;
+  guint i, n_samples;
+
+  stream = encode_stream (channels, 1);
+
+  f32 = decode_stream (stream, &sinktemplate, "audio/x-raw-float", 32);
+  s16 = decode_stream (stream, &s16_sinktemplate, "audio/x-raw-int", 16);
+  s32 = decode_stream (stream, &s32_sinktemplate, "audio/x-raw-int", 32);
+
+  n_samples = GST_BUFFER_SIZE (f32) / sizeof (gfloat);
+  fail_unless (n_samples > 0);
+  fail_unless_equals_int (n_samples % channels, 0);
+  fail_unless_equals_int (GST_BUFFER_SIZE (s16), n_samples * sizeof (gint16));
+  fail_unless_equals_int (GST_BUFFER_SIZE (s32), n_samples * sizeof (gint32));
+
+  /* the integer samples are the rounded and clipped float samples */
+  fdata = (const gfloat *) GST_BUFFER_DATA (f32);
+  s16data = (const gint16 *) GST_BUFFER_DATA (s16);
+  s32data = (const gint32 *) GST_BUFFER_DATA (s32);
+  for (i = 0; i < n_samples; i++) {
+    gdouble v16 = CLAMP (fdata[i] * 32768.0, -32768.0, 32767.0);
+    gdouble v32 = CLAMP (fdata[i] * 2147483648.0, -2147483648.0, 2147483647.0);
+
+    fail_unless (ABS (s16data[i] - v16) <= 0.5, "sample %u: %d != %f", i,
+        s16data[i], v16);
+    fail_unless (ABS (s32data[i] - v32) <= 0.5, "sample %u: %d != %f", i,
+        s32data[i], v32);
+  }
+
+  gst_buffer_unref (f32);
+  gst_buffer_unref (s16);
+  gst_buffer_unref (s32);
+  free_stream (stream);
+}
+
+/* mono and stereo have their own interleaving loops, 3 channels takes the
+ * generic one */
+GST_START_TEST (test_integer_output_mono)
+{
+  check_integer_output (1);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_integer_output_stereo)
+{
+  check_integer_output (2);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_integer_output_multichannel)
+{
+  check_integer_output (3);
+}
+
+GST_END_TEST;
+
+/* decodes the audio packets of @stream again after a flush and checks that
+ * the decoder produces exactly the output of a fresh decoder */
+static void
+check_decode_after_flush (GList * stream, GstStaticPadTemplate * sinktmpl,
+    const gchar * name, gint width)
+{
+  GstElement *vorbisdec;
+  GstBuffer *expected;
+  GList *walk;
+  guint size = 0;
+
+  expected = decode_stream (stream, sinktmpl, name, width);
+
+  vorbisdec = setup_vorbisdec_with_template (sinktmpl);
+  fail_unless_equals_int (gst_element_set_state (vorbisdec, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_SUCCESS);
+
+  push_buffers (stream);
+  drop_buffers ();
+
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_flush_start ()));
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_flush_stop ()));
+
+  /* the headers are kept over the flush */
+  push_buffers (g_list_nth (stream, 3));
+  fail_unless (buffers != NULL);
+
+  for (walk = buffers; walk; walk = walk->next) {
+    GstBuffer *buffer = GST_BUFFER_CAST (walk->data);
+
+    fail_unless (size + GST_BUFFER_SIZE (buffer) <= GST_BUFFER_SIZE (expected));
+    fail_unless (memcmp (GST_BUFFER_DATA (expected) + size,
+            GST_BUFFER_DATA (buffer), GST_BUFFER_SIZE (buffer)) == 0,
+        "output differs after %u bytes", size);
+    size += GST_BUFFER_SIZE (buffer);
+  }
+  fail_unless_equals_int (size, GST_BUFFER_SIZE (expected));
+
+  drop_buffers ();
+  cleanup_vorbisdec (vorbisdec);
+  gst_buffer_unref (expected);
+}
+
+GST_START_TEST (test_decode_after_flush)
+{
+  GList *stream;
+
+  stream = encode_stream (2, 2);
+
+  check_decode_after_flush (stream, &sinktemplate, "audio/x-raw-float", 32);
+  check_decode_after_flush (stream, &s16_sinktemplate, "audio/x-raw-int", 16);
+  check_decode_after_flush (stream, &s32_sinktemplate, "audio/x-raw-int", 32);
+
+  free_stream (stream);
+}
+
+GST_END_TEST;
+
 static Suite *
 vorbisdec_suite (void)
 {
@@ -295,6 +573,10 @@ vorbisdec_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_identification_header);
   tcase_add_test (tc_chain, test_empty_vorbis_packet);
+  tcase_add_test (tc_chain, test_integer_output_mono);
+  tcase_add_test (tc_chain, test_integer_output_stereo);
+  tcase_add_test (tc_chain, test_integer_output_multichannel);
+  tcase_add_test (tc_chain, test_decode_after_flush);
 
   return s;
 }
@@ -26,8 +26,10 @@
 #include <gst/pbutils/pbutils.h>
 
 #include <stdio.h>
+#include <string.h>
 #include <glib/gstdio.h>
 #include <glib/gprintf.h>
+#include <utime.h>
 
 
 GST_START_TEST (test_disco_init)
@@ -78,6 +80,437 @@ GST_START_TEST (test_disco_sync)
 
 GST_END_TEST;
 
+static void
+remove_cache_dir (const gchar * path)
+{
+  GDir *dir;
+  const gchar *name;
+
+  dir = g_dir_open (path, 0, NULL);
+  if (dir) {
+    while ((name = g_dir_read_name (dir))) {
+      gchar *child = g_build_filename (path, name, NULL);
+
+      if (g_file_test (child, G_FILE_TEST_IS_DIR))
+        remove_cache_dir (child);
+      else
+        g_unlink (child);
+      g_free (child);
+    }
+    g_dir_close (dir);
+  }
+  g_rmdir (path);
+}
+
+/* a fixed whole second, the cache compares sub-second times too */
+#define CACHE_TEST_MTIME 1000000000
+
+/* Encodes a short Ogg/Vorbis file to @path, returns FALSE if the needed
+ * elements are not available */
+static gboolean
+make_cache_test_file (const gchar * path)
+{
+  GstElement *pipeline;
+  GstMessage *msg;
+  gchar *desc;
+
+  desc = g_strdup_printf ("audiotestsrc num-buffers=10 ! audioconvert ! "
+      "vorbisenc ! oggmux ! filesink location=\"%s\"", path);
+  pipeline = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  if (pipeline == NULL)
+    return FALSE;
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+  msg = gst_bus_poll (GST_ELEMENT_BUS (pipeline),
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR, -1);
+  fail_unless (msg != NULL);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return TRUE;
+}
+
+static void
+set_file_mtime (const gchar * path, glong mtime)
+{
+  struct utimbuf times;
+
+  times.actime = times.modtime = mtime;
+  fail_unless (g_utime (path, &times) == 0);
+}
+
+/* overwrites the content of @path in place with garbage, so that the inode
+ * stays the same, and appends @extra bytes */
+static void
+clobber_file (const gchar * path, gsize extra)
+{
+  FILE *f;
+  gchar *data;
+  gsize length;
+
+  fail_unless (g_file_get_contents (path, &data, &length, NULL));
+  memset (data, 'x', length);
+
+  f = g_fopen (path, "r+b");
+  fail_unless (f != NULL);
+  fail_unless (fwrite (data, 1, length, f) == length);
+  while (extra--)
+    fputc ('x', f);
+  fclose (f);
+  g_free (data);
+}
+
+/* total size of the entries in the cache directory */
+static gint64
+get_cache_dir_size (const gchar * path, guint * n_entries)
+{
+  GDir *dir;
+  const gchar *name;
+  gint64 total = 0;
+
+  dir = g_dir_open (path, 0, NULL);
+  if (dir == NULL)
+    return 0;
+
+  while ((name = g_dir_read_name (dir))) {
+    gchar *child = g_build_filename (path, name, NULL);
+
+    if (g_file_test (child, G_FILE_TEST_IS_DIR)) {
+      total += get_cache_dir_size (child, n_entries);
+    } else {
+      gchar *data;
+      gsize length;
+
+      if (g_file_get_contents (child, &data, &length, NULL)) {
+        total += length;
+        (*n_entries)++;
+        g_free (data);
+      }
+    }
+    g_free (child);
+  }
+  g_dir_close (dir);
+
+  return total;
+}
+
+typedef struct
+{
+  gchar *dir;
+  gchar *cache_dir;
+  gchar *file;
+  gchar *uri;
+  GstDiscoverer *dc;
+} CacheTest;
+
+static gboolean
+cache_test_setup (CacheTest * test)
+{
+  GError *err = NULL;
+
+  test->dir = g_strdup_printf ("%s" G_DIR_SEPARATOR_S
+      "gst-discoverer-cache-test-%u", g_get_tmp_dir (), g_random_int ());
+  fail_unless (g_mkdir_with_parents (test->dir, 0755) == 0);
+  test->cache_dir = g_build_filename (test->dir, "cache", NULL);
+  test->file = g_build_filename (test->dir, "test.ogg", NULL);
+
+  if (!make_cache_test_file (test->file)) {
+    GST_INFO ("no vorbis encoder or ogg muxer, skipping test");
+    remove_cache_dir (test->dir);
+    g_free (test->dir);
+    g_free (test->cache_dir);
+    g_free (test->file);
+    return FALSE;
+  }
+  set_file_mtime (test->file, CACHE_TEST_MTIME);
+
+  test->uri = g_filename_to_uri (test->file, NULL, &err);
+  fail_unless (err == NULL);
+
+  test->dc = gst_discoverer_new (5 * GST_SECOND, &err);
+  fail_unless (test->dc != NULL);
+  fail_unless (err == NULL);
+  g_object_set (test->dc, "use-cache", TRUE, "cache-directory",
+      test->cache_dir, NULL);
+
+  return TRUE;
+}
+
+static void
+cache_test_teardown (CacheTest * test)
+{
+  g_object_unref (test->dc);
+  remove_cache_dir (test->dir);
+  g_free (test->dir);
+  g_free (test->cache_dir);
+  g_free (test->file);
+  g_free (test->uri);
+}
+
+static GstDiscovererInfo *
+cache_test_discover (CacheTest * test, const gchar * uri,
+    GstDiscovererResult expected)
+{
+  GstDiscovererInfo *info;
+  GError *err = NULL;
+
+  info = gst_discoverer_discover_uri (test->dc, uri, &err);
+  fail_unless (info != NULL);
+  fail_unless_equals_int (gst_discoverer_info_get_result (info), expected);
+  if (err)
+    g_error_free (err);
+
+  return info;
+}
+
+GST_START_TEST (test_disco_cache)
+{
+  CacheTest test;
+  GstDiscovererInfo *info, *cached;
+  GList *streams, *cached_streams;
+
+  if (!cache_test_setup (&test))
+    return;
+
+  info = cache_test_discover (&test, test.uri, GST_DISCOVERER_OK);
+
+  /* the file can't be discovered anymore, but it has the same size, inode
+   * and modification time, so the result must come from the cache */
+  clobber_file (test.file, 0);
+  set_file_mtime (test.file, CACHE_TEST_MTIME);
+  cached = cache_test_discover (&test, test.uri, GST_DISCOVERER_OK);
+
+  fail_unless_equals_string (gst_discoverer_info_get_uri (cached), test.uri);
+  fail_unless_equals_uint64 (gst_discoverer_info_get_duration (cached),
+      gst_discoverer_info_get_duration (info));
+  fail_unless_equals_int (gst_discoverer_info_get_seekable (cached),
+      gst_discoverer_info_get_seekable (info));
+
+  streams = gst_discoverer_info_get_stream_list (info);
+  cached_streams = gst_discoverer_info_get_stream_list (cached);
+  fail_unless_equals_int (g_list_length (cached_streams),
+      g_list_length (streams));
+  gst_discoverer_stream_info_list_free (streams);
+  gst_discoverer_stream_info_list_free (cached_streams);
+
+  gst_discoverer_info_unref (info);
+  gst_discoverer_info_unref (cached);
+
+  /* a new discoverer uses the same entries */
+  g_object_unref (test.dc);
+  test.dc = gst_discoverer_new (5 * GST_SECOND, NULL);
+  g_object_set (test.dc, "use-cache", TRUE, "cache-directory",
+      test.cache_dir, NULL);
+  cached = cache_test_discover (&test, test.uri, GST_DISCOVERER_OK);
+  gst_discoverer_info_unref (cached);
+
+  cache_test_teardown (&test);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_disco_cache_invalidate)
+{
+  CacheTest test;
+  GstDiscovererInfo *info;
+
+  if (!cache_test_setup (&test))
+    return;
+
+  /* a different modification time invalidates the entry */
+  info = cache_test_discover (&test, test.uri, GST_DISCOVERER_OK);
+  gst_discoverer_info_unref (info);
+  clobber_file (test.file, 0);
+  set_file_mtime (test.file, CACHE_TEST_MTIME + 1);
+  info = gst_discoverer_discover_uri (test.dc, test.uri, NULL);
+  fail_if (info != NULL
+      && gst_discoverer_info_get_result (info) == GST_DISCOVERER_OK);
+  if (info)
+    gst_discoverer_info_unref (info);
+
+  /* and so does a different size */
+  fail_unless (make_cache_test_file (test.file));
+  set_file_mtime (test.file, CACHE_TEST_MTIME);
+  info = cache_test_discover (&test, test.uri, GST_DISCOVERER_OK);
+  gst_discoverer_info_unref (info);
+  clobber_file (test.file, 1);
+  set_file_mtime (test.file, CACHE_TEST_MTIME);
+  info = gst_discoverer_discover_uri (test.dc, test.uri, NULL);
+  fail_if (info != NULL
+      && gst_discoverer_info_get_result (info) == GST_DISCOVERER_OK);
+  if (info)
+    gst_discoverer_info_unref (info);
+
+  cache_test_teardown (&test);
+}
+
+GST_END_TEST;
+
+#define PRUNE_FILES 8
+
+GST_START_TEST (test_disco_cache_prune)
+{
+  CacheTest test;
+  GstDiscovererInfo *info;
+  gchar *data, *path, *uri;
+  gsize length;
+  gint64 entry_size, max_size;
+  guint i, n_entries = 0;
+
+  if (!cache_test_setup (&test))
+    return;
+
+  /* find out how big an entry is */
+  info = cache_test_discover (&test, test.uri, GST_DISCOVERER_OK);
+  gst_discoverer_info_unref (info);
+  entry_size = get_cache_dir_size (test.cache_dir, &n_entries);
+  fail_unless_equals_int (n_entries, 1);
+  fail_unless (entry_size > 0);
+
+  /* room for three entries, storing a fourth prunes the cache */
+  max_size = entry_size * 3 + entry_size / 2;
+  g_object_set (test.dc, "cache-max-size", (guint64) max_size, NULL);
+
+  fail_unless (g_file_get_contents (test.file, &data, &length, NULL));
+  for (i = 0; i < PRUNE_FILES; i++) {
+    gchar name[16];
+
+    g_snprintf (name, sizeof (name), "prune-%u.ogg", i);
+    path = g_build_filename (test.dir, name, NULL);
+    fail_unless (g_file_set_contents (path, data, length, NULL));
+    uri = g_filename_to_uri (path, NULL, NULL);
+
+    info = cache_test_discover (&test, uri, GST_DISCOVERER_OK);
+    gst_discoverer_info_unref (info);
+
+    n_entries = 0;
+    fail_unless (get_cache_dir_size (test.cache_dir, &n_entries) <= max_size);
+    fail_unless (n_entries <= 3);
+
+    g_free (uri);
+    g_free (path);
+  }
+  g_free (data);
+
+  cache_test_teardown (&test);
+}
+
+GST_END_TEST;
+
+#define POOL_URIS 20
+
+typedef struct
+{
+  GMainLoop *loop;
+  gchar *uris[POOL_URIS];
+  guint n_discovered;
+  guint n_errors;
+  guint seen[POOL_URIS];
+  gboolean in_order;
+} PoolData;
+
+static void
+pool_discovered_cb (GstDiscoverer * dc, GstDiscovererInfo * info,
+    GError * err, PoolData * data)
+{
+  const gchar *uri = gst_discoverer_info_get_uri (info);
+  guint i;
+
+  fail_unless (data->n_discovered < POOL_URIS);
+  if (!g_str_equal (uri, data->uris[data->n_discovered]))
+    data->in_order = FALSE;
+  data->n_discovered++;
+
+  if (err != NULL) {
+    data->n_errors++;
+    /* the missing files have unique uris, each is reported once */
+    for (i = 1; i < POOL_URIS; i += 2) {
+      if (g_str_equal (uri, data->uris[i]))
+        data->seen[i]++;
+    }
+  }
+}
+
+static void
+pool_finished_cb (GstDiscoverer * dc, PoolData * data)
+{
+  g_main_loop_quit (data->loop);
+}
+
+/* discovers a mix of existing and missing files, the missing ones finish
+ * much faster so the results come back out of order from the pool */
+static void
+run_disco_pool (guint max_parallel, gboolean ordered, gboolean * in_order)
+{
+  GError *err = NULL;
+  GstDiscoverer *dc;
+  PoolData data;
+  gchar *uri;
+  guint i;
+
+  uri = g_filename_to_uri (GST_TEST_FILE, NULL, &err);
+  fail_unless (err == NULL);
+
+  memset (&data, 0, sizeof (data));
+  data.loop = g_main_loop_new (NULL, FALSE);
+  data.in_order = TRUE;
+  for (i = 0; i < POOL_URIS; i++) {
+    if (i % 2)
+      data.uris[i] = g_strdup_printf ("file:///nonexistent-disco-file-%u", i);
+    else
+      data.uris[i] = g_strdup (uri);
+  }
+  g_free (uri);
+
+  dc = gst_discoverer_new (5 * GST_SECOND, &err);
+  fail_unless (dc != NULL);
+  fail_unless (err == NULL);
+  g_object_set (dc, "max-parallel", max_parallel, "ordered", ordered, NULL);
+  g_signal_connect (dc, "discovered", G_CALLBACK (pool_discovered_cb), &data);
+  g_signal_connect (dc, "finished", G_CALLBACK (pool_finished_cb), &data);
+
+  gst_discoverer_start (dc);
+  for (i = 0; i < POOL_URIS; i++)
+    fail_unless (gst_discoverer_discover_uri_async (dc, data.uris[i]));
+  g_main_loop_run (data.loop);
+
+  /* every uri got its result, the same as with a single pipeline */
+  fail_unless_equals_int (data.n_discovered, POOL_URIS);
+  fail_unless_equals_int (data.n_errors, POOL_URIS / 2);
+  for (i = 1; i < POOL_URIS; i += 2)
+    fail_unless_equals_int (data.seen[i], 1);
+
+  gst_discoverer_stop (dc);
+  g_object_unref (dc);
+  g_main_loop_unref (data.loop);
+  for (i = 0; i < POOL_URIS; i++)
+    g_free (data.uris[i]);
+
+  if (in_order)
+    *in_order = data.in_order;
+}
+
+GST_START_TEST (test_disco_parallel_ordered)
+{
+  gboolean in_order = FALSE;
+
+  run_disco_pool (4, TRUE, &in_order);
+  fail_unless (in_order);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_disco_parallel_unordered)
+{
+  run_disco_pool (1, TRUE, NULL);
+  run_disco_pool (4, FALSE, NULL);
+}
+
+GST_END_TEST;
 
 static Suite *
 discoverer_suite (void)
@@ -88,6 +521,11 @@ discoverer_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_disco_init);
   tcase_add_test (tc_chain, test_disco_sync);
+  tcase_add_test (tc_chain, test_disco_cache);
+  tcase_add_test (tc_chain, test_disco_cache_invalidate);
+  tcase_add_test (tc_chain, test_disco_cache_prune);
+  tcase_add_test (tc_chain, test_disco_parallel_ordered);
+  tcase_add_test (tc_chain, test_disco_parallel_unordered);
   return s;
 }
 
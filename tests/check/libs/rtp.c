@@ -24,6 +24,8 @@
 
 #include <gst/check/gstcheck.h>
 
+#include <gst/rtp/gstbasertpaudiopayload.h>
+#include <gst/rtp/gstbasertpdepayload.h>
 #include <gst/rtp/gstrtpbuffer.h>
 #include <gst/rtp/gstrtcpbuffer.h>
 #include <string.h>
@@ -204,6 +206,624 @@ GST_START_TEST (test_rtp_buffer_list)
 
 GST_END_TEST;
 
+static GstBufferList *
+create_rtp_buffer_list (guint n_packets, guint32 ssrc1, guint32 ssrc2)
+{
+  GstBufferList *list;
+  GstBufferListIterator *it;
+  GstBuffer *rtp_header;
+  guint i;
+
+  list = gst_buffer_list_new ();
+  it = gst_buffer_list_iterate (list);
+  for (i = 0; i < n_packets; i++) {
+    gst_buffer_list_iterator_add_group (it);
+    rtp_header = gst_rtp_buffer_new_allocate (0, 0, 0);
+    gst_rtp_buffer_set_marker (rtp_header, i & 1);
+    gst_rtp_buffer_set_payload_type (rtp_header, 96);
+    gst_rtp_buffer_set_seq (rtp_header, 65534 + i);
+    gst_rtp_buffer_set_timestamp (rtp_header, 0xfffffff0 + i * 8);
+    gst_rtp_buffer_set_ssrc (rtp_header, (i % 3) ? ssrc1 : ssrc2);
+    gst_buffer_list_iterator_add (it, rtp_header);
+    gst_buffer_list_iterator_add (it, gst_buffer_new_and_alloc (42));
+  }
+  gst_buffer_list_iterator_free (it);
+
+  return list;
+}
+
+GST_START_TEST (test_rtp_buffer_list_rewrite)
+{
+  GstBufferList *list;
+  GstBufferListIterator *it;
+  GstBuffer *rtp_header;
+  GstRTPRewrite rewrite = { 0, };
+  const guint32 ssrc_map[] = { 0x11111111, 0xaaaaaaaa, 0x22222222, 0xbbbbbbbb };
+  guint i;
+
+  list = create_rtp_buffer_list (6, 0x11111111, 0x33333333);
+
+  /* change nothing but count the packets */
+  fail_unless_equals_int (gst_rtp_buffer_list_rewrite (list, &rewrite), 6);
+
+  rewrite.flags = GST_RTP_REWRITE_SEQ | GST_RTP_REWRITE_TIMESTAMP |
+      GST_RTP_REWRITE_PAYLOAD_TYPE | GST_RTP_REWRITE_SSRC;
+  rewrite.seq_offset = 100;
+  rewrite.ts_offset = 0x20;
+  rewrite.payload_type = 127;
+  rewrite.ssrc_map = ssrc_map;
+  rewrite.n_ssrc = 2;
+  fail_unless_equals_int (gst_rtp_buffer_list_rewrite (list, &rewrite), 6);
+  fail_unless (gst_rtp_buffer_list_validate (list));
+
+  it = gst_buffer_list_iterate (list);
+  i = 0;
+  while (gst_buffer_list_iterator_next_group (it)) {
+    rtp_header = gst_buffer_list_iterator_next (it);
+    fail_unless_equals_int (gst_rtp_buffer_get_version (rtp_header), 2);
+    fail_unless_equals_int (gst_rtp_buffer_get_marker (rtp_header), i & 1);
+    fail_unless_equals_int (gst_rtp_buffer_get_payload_type (rtp_header), 127);
+    fail_unless_equals_int (gst_rtp_buffer_get_seq (rtp_header),
+        (guint16) (65534 + i + 100));
+    fail_unless (gst_rtp_buffer_get_timestamp (rtp_header) ==
+        (guint32) (0xfffffff0 + i * 8 + 0x20));
+    /* unmapped SSRCs are kept */
+    fail_unless (gst_rtp_buffer_get_ssrc (rtp_header) ==
+        ((i % 3) ? 0xaaaaaaaa : 0x33333333));
+    i++;
+  }
+  gst_buffer_list_iterator_free (it);
+  fail_unless_equals_int (i, 6);
+
+  gst_buffer_list_unref (list);
+}
+
+GST_END_TEST;
+
+/* a minimal sample based payloader, 8 bit mono at 8000 Hz */
+typedef GstBaseRTPAudioPayload TestAudioPay;
+typedef GstBaseRTPAudioPayloadClass TestAudioPayClass;
+
+static GstStaticPadTemplate test_audio_pay_sink_template =
+GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("audio/x-test")
+    );
+
+static GstStaticPadTemplate test_audio_pay_src_template =
+GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-rtp")
+    );
+
+static GType test_audio_pay_get_type (void);
+
+GST_BOILERPLATE (TestAudioPay, test_audio_pay, GstBaseRTPAudioPayload,
+    GST_TYPE_BASE_RTP_AUDIO_PAYLOAD);
+
+static gboolean
+test_audio_pay_set_caps (GstBaseRTPPayload * payload, GstCaps * caps)
+{
+  gst_basertppayload_set_options (payload, "audio", TRUE, "L8", 8000);
+
+  return gst_basertppayload_set_outcaps (payload, NULL);
+}
+
+static void
+test_audio_pay_base_init (gpointer klass)
+{
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+
+  gst_element_class_add_static_pad_template (element_class,
+      &test_audio_pay_sink_template);
+  gst_element_class_add_static_pad_template (element_class,
+      &test_audio_pay_src_template);
+
+  gst_element_class_set_details_simple (element_class, "Test payloader",
+      "Codec/Payloader/Network/RTP", "Payloads 8 bit test samples",
+      "Foo Bar <foo@bar.com>");
+}
+
+static void
+test_audio_pay_class_init (TestAudioPayClass * klass)
+{
+  GST_BASE_RTP_PAYLOAD_CLASS (klass)->set_caps = test_audio_pay_set_caps;
+}
+
+static void
+test_audio_pay_init (TestAudioPay * pay, TestAudioPayClass * klass)
+{
+  gst_base_rtp_audio_payload_set_sample_based (pay);
+  gst_base_rtp_audio_payload_set_sample_options (pay, 1);
+}
+
+static GstStaticPadTemplate test_audio_sinktemplate =
+GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-rtp")
+    );
+
+static GstStaticPadTemplate test_audio_srctemplate =
+GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("audio/x-test")
+    );
+
+#define AUDIO_PAY_PAYLOAD 100
+#define AUDIO_PAY_BUFFER 1000
+#define AUDIO_PAY_BUFFERS 2
+
+/* push AUDIO_PAY_BUFFERS buffers of AUDIO_PAY_BUFFER samples into the test
+ * payloader, with packets of AUDIO_PAY_PAYLOAD samples, and check the seqnum
+ * and RTP timestamp of every packet */
+static void
+check_audio_pay_headers (gboolean buffer_list)
+{
+  GstElement *pay;
+  GstPad *srcpad, *sinkpad;
+  GstCaps *caps;
+  GstBuffer *buf;
+  GList *l;
+  guint16 seq0 = 0;
+  guint32 rtptime0 = 0;
+  guint i;
+
+  pay = g_object_new (test_audio_pay_get_type (), NULL);
+  g_object_set (pay, "mtu", RTP_HEADER_LEN + AUDIO_PAY_PAYLOAD,
+      "buffer-list", buffer_list, NULL);
+
+  srcpad = gst_check_setup_src_pad (pay, &test_audio_srctemplate, NULL);
+  sinkpad = gst_check_setup_sink_pad (pay, &test_audio_sinktemplate, NULL);
+  gst_pad_set_active (srcpad, TRUE);
+  gst_pad_set_active (sinkpad, TRUE);
+  fail_unless (gst_element_set_state (pay, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_SUCCESS);
+
+  fail_unless (gst_pad_push_event (srcpad,
+          gst_event_new_new_segment (FALSE, 1.0, GST_FORMAT_TIME, 0, -1, 0)));
+
+  caps = gst_caps_new_simple ("audio/x-test", NULL);
+  for (i = 0; i < AUDIO_PAY_BUFFERS; i++) {
+    buf = gst_buffer_new_and_alloc (AUDIO_PAY_BUFFER);
+    memset (GST_BUFFER_DATA (buf), i, AUDIO_PAY_BUFFER);
+    GST_BUFFER_TIMESTAMP (buf) =
+        gst_util_uint64_scale_int (i * AUDIO_PAY_BUFFER, GST_SECOND, 8000);
+    gst_buffer_set_caps (buf, caps);
+    fail_unless_equals_int (gst_pad_push (srcpad, buf), GST_FLOW_OK);
+  }
+  gst_caps_unref (caps);
+
+  fail_unless_equals_int (g_list_length (buffers),
+      AUDIO_PAY_BUFFERS * AUDIO_PAY_BUFFER / AUDIO_PAY_PAYLOAD);
+
+  for (l = buffers, i = 0; l; l = l->next, i++) {
+    buf = GST_BUFFER_CAST (l->data);
+
+    fail_unless (gst_rtp_buffer_validate (buf));
+    fail_unless_equals_int (gst_rtp_buffer_get_payload_len (buf),
+        AUDIO_PAY_PAYLOAD);
+    if (i == 0) {
+      seq0 = gst_rtp_buffer_get_seq (buf);
+      rtptime0 = gst_rtp_buffer_get_timestamp (buf);
+    }
+    /* every packet has the next seqnum and is stamped with its own first
+     * sample, also when it was pushed as a group of a list */
+    fail_unless_equals_int (gst_rtp_buffer_get_seq (buf),
+        (guint16) (seq0 + i));
+    fail_unless (gst_rtp_buffer_get_timestamp (buf) ==
+        rtptime0 + i * AUDIO_PAY_PAYLOAD);
+  }
+
+  gst_element_set_state (pay, GST_STATE_NULL);
+  gst_check_drop_buffers ();
+  gst_pad_set_active (srcpad, FALSE);
+  gst_pad_set_active (sinkpad, FALSE);
+  gst_check_teardown_src_pad (pay);
+  gst_check_teardown_sink_pad (pay);
+  gst_check_teardown_element (pay);
+}
+
+GST_START_TEST (test_rtp_audio_payload_headers)
+{
+  check_audio_pay_headers (FALSE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rtp_audio_payload_headers_list)
+{
+  check_audio_pay_headers (TRUE);
+}
+
+GST_END_TEST;
+
+/* a depayloader that outputs the payload of every packet, the test packets
+ * carry their seqnum as payload */
+typedef GstBaseRTPDepayload TestDepay;
+typedef GstBaseRTPDepayloadClass TestDepayClass;
+
+static GstStaticPadTemplate test_depay_sink_template =
+GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-rtp")
+    );
+
+static GstStaticPadTemplate test_depay_src_template =
+GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-test")
+    );
+
+static GType test_depay_get_type (void);
+
+GST_BOILERPLATE (TestDepay, test_depay, GstBaseRTPDepayload,
+    GST_TYPE_BASE_RTP_DEPAYLOAD);
+
+static gboolean
+test_depay_set_caps (GstBaseRTPDepayload * depay, GstCaps * caps)
+{
+  GstCaps *srccaps;
+  gboolean res;
+
+  depay->clock_rate = 8000;
+
+  srccaps = gst_caps_new_simple ("application/x-test", NULL);
+  res = gst_pad_set_caps (GST_BASE_RTP_DEPAYLOAD_SRCPAD (depay), srccaps);
+  gst_caps_unref (srccaps);
+
+  return res;
+}
+
+static GstBuffer *
+test_depay_process (GstBaseRTPDepayload * depay, GstBuffer * buf)
+{
+  return gst_rtp_buffer_get_payload_buffer (buf);
+}
+
+static void
+test_depay_base_init (gpointer klass)
+{
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+
+  gst_element_class_add_static_pad_template (element_class,
+      &test_depay_sink_template);
+  gst_element_class_add_static_pad_template (element_class,
+      &test_depay_src_template);
+
+  gst_element_class_set_details_simple (element_class, "Test depayloader",
+      "Codec/Depayloader/Network/RTP", "Outputs the payload of RTP packets",
+      "Foo Bar <foo@bar.com>");
+}
+
+static void
+test_depay_class_init (TestDepayClass * klass)
+{
+  GstBaseRTPDepayloadClass *depay_class = GST_BASE_RTP_DEPAYLOAD_CLASS (klass);
+
+  depay_class->set_caps = test_depay_set_caps;
+  depay_class->process = test_depay_process;
+}
+
+static void
+test_depay_init (TestDepay * depay, TestDepayClass * klass)
+{
+}
+
+static GstStaticPadTemplate test_depay_sinktemplate =
+GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-test")
+    );
+
+static GstStaticPadTemplate test_depay_srctemplate =
+GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-rtp")
+    );
+
+static GstPad *depay_srcpad, *depay_sinkpad;
+
+static GstElement *
+setup_test_depay (guint window, guint time)
+{
+  GstElement *depay;
+
+  depay = g_object_new (test_depay_get_type (), NULL);
+  g_object_set (depay, "reorder-window", window, "reorder-time", time, NULL);
+
+  depay_srcpad = gst_check_setup_src_pad (depay, &test_depay_srctemplate,
+      NULL);
+  depay_sinkpad = gst_check_setup_sink_pad (depay, &test_depay_sinktemplate,
+      NULL);
+  gst_pad_set_active (depay_srcpad, TRUE);
+  gst_pad_set_active (depay_sinkpad, TRUE);
+  fail_unless (gst_element_set_state (depay, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_SUCCESS);
+
+  fail_unless (gst_pad_push_event (depay_srcpad,
+          gst_event_new_new_segment (FALSE, 1.0, GST_FORMAT_TIME, 0, -1, 0)));
+
+  return depay;
+}
+
+static void
+cleanup_test_depay (GstElement * depay)
+{
+  gst_element_set_state (depay, GST_STATE_NULL);
+  gst_check_drop_buffers ();
+  gst_pad_set_active (depay_srcpad, FALSE);
+  gst_pad_set_active (depay_sinkpad, FALSE);
+  gst_check_teardown_src_pad (depay);
+  gst_check_teardown_sink_pad (depay);
+  gst_check_teardown_element (depay);
+}
+
+/* push a packet with @seqnum as payload, received at @msecs */
+static void
+push_test_packet (guint16 seqnum, guint msecs)
+{
+  GstBuffer *buf;
+  GstCaps *caps;
+
+  buf = gst_rtp_buffer_new_allocate (2, 0, 0);
+  gst_rtp_buffer_set_seq (buf, seqnum);
+  gst_rtp_buffer_set_timestamp (buf, msecs * 8);
+  GST_WRITE_UINT16_BE (gst_rtp_buffer_get_payload (buf), seqnum);
+  GST_BUFFER_TIMESTAMP (buf) = msecs * GST_MSECOND;
+
+  caps = gst_caps_new_simple ("application/x-rtp",
+      "clock-rate", G_TYPE_INT, 8000, NULL);
+  gst_buffer_set_caps (buf, caps);
+  gst_caps_unref (caps);
+
+  fail_unless_equals_int (gst_pad_push (depay_srcpad, buf), GST_FLOW_OK);
+}
+
+/* check that the depayloader output the packets @seqnums, in that order */
+static void
+check_test_output (const guint16 * seqnums, guint n_seqnums)
+{
+  GList *l;
+  guint i;
+
+  fail_unless_equals_int (g_list_length (buffers), n_seqnums);
+  for (l = buffers, i = 0; l; l = l->next, i++) {
+    GstBuffer *buf = GST_BUFFER_CAST (l->data);
+
+    fail_unless_equals_int (GST_BUFFER_SIZE (buf), 2);
+    fail_unless_equals_int (GST_READ_UINT16_BE (GST_BUFFER_DATA (buf)),
+        seqnums[i]);
+  }
+}
+
+GST_START_TEST (test_rtp_depayload_reorder_swapped)
+{
+  const guint16 out[] = { 0, 1, 2, 3 };
+  GstElement *depay;
+
+  depay = setup_test_depay (8, 0);
+
+  push_test_packet (0, 0);
+  push_test_packet (2, 20);
+  /* 2 is held until 1 arrives */
+  check_test_output (out, 1);
+  push_test_packet (1, 10);
+  check_test_output (out, 3);
+  push_test_packet (3, 30);
+  check_test_output (out, 4);
+
+  cleanup_test_depay (depay);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rtp_depayload_reorder_window)
+{
+  const guint16 out[] = { 0, 2, 3, 4, 5, 6 };
+  GstElement *depay;
+  guint16 i;
+
+  depay = setup_test_depay (4, 0);
+
+  push_test_packet (0, 0);
+  for (i = 2; i < 5; i++)
+    push_test_packet (i, i * 10);
+  check_test_output (out, 1);
+
+  /* 5 does not fit in the window after 1, stop waiting for 1 */
+  push_test_packet (5, 50);
+  check_test_output (out, 5);
+  push_test_packet (6, 60);
+  check_test_output (out, 6);
+
+  /* 1 arrives too late and is dropped */
+  push_test_packet (1, 70);
+  check_test_output (out, 6);
+
+  cleanup_test_depay (depay);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rtp_depayload_reorder_wraparound)
+{
+  const guint16 out[] = { 65534, 65535, 0, 1 };
+  GstElement *depay;
+
+  depay = setup_test_depay (8, 0);
+
+  push_test_packet (65534, 0);
+  push_test_packet (0, 20);
+  check_test_output (out, 1);
+  push_test_packet (65535, 10);
+  check_test_output (out, 3);
+  push_test_packet (1, 30);
+  check_test_output (out, 4);
+
+  cleanup_test_depay (depay);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rtp_depayload_reorder_time)
+{
+  const guint16 out[] = { 0, 2, 3, 4 };
+  GstElement *depay;
+
+  depay = setup_test_depay (8, 20);
+
+  push_test_packet (0, 0);
+  push_test_packet (2, 20);
+  push_test_packet (3, 30);
+  check_test_output (out, 1);
+
+  /* 2 was held for 20 ms now, stop waiting for 1 */
+  push_test_packet (4, 40);
+  check_test_output (out, 4);
+
+  cleanup_test_depay (depay);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rtp_depayload_reorder_eos)
+{
+  const guint16 out[] = { 0, 2, 3 };
+  GstElement *depay;
+
+  depay = setup_test_depay (8, 0);
+
+  push_test_packet (0, 0);
+  push_test_packet (2, 20);
+  push_test_packet (3, 30);
+  check_test_output (out, 1);
+
+  fail_unless (gst_pad_push_event (depay_srcpad, gst_event_new_eos ()));
+  check_test_output (out, 3);
+
+  cleanup_test_depay (depay);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_rtp_depayload_reorder_flush)
+{
+  const guint16 out[] = { 0, 10 };
+  GstElement *depay;
+
+  depay = setup_test_depay (8, 0);
+
+  push_test_packet (0, 0);
+  push_test_packet (2, 20);
+  check_test_output (out, 1);
+
+  /* the held packet is dropped */
+  fail_unless (gst_pad_push_event (depay_srcpad, gst_event_new_flush_start ()));
+  fail_unless (gst_pad_push_event (depay_srcpad, gst_event_new_flush_stop ()));
+  fail_unless (gst_pad_push_event (depay_srcpad,
+          gst_event_new_new_segment (FALSE, 1.0, GST_FORMAT_TIME, 0, -1, 0)));
+
+  push_test_packet (10, 100);
+  check_test_output (out, 2);
+
+  fail_unless (gst_pad_push_event (depay_srcpad, gst_event_new_eos ()));
+  check_test_output (out, 2);
+
+  cleanup_test_depay (depay);
+}
+
+GST_END_TEST;
+
+#define REWRITE_PACKETS 64
+#define REWRITE_ROUNDS 1000
+
+/* rewrite the headers of @list one field at a time with the setters */
+static void
+rewrite_with_setters (GstBufferList * list, const GstRTPRewrite * rewrite)
+{
+  GstBufferListIterator *it;
+  GstBuffer *rtp_header;
+  guint i;
+
+  it = gst_buffer_list_iterate (list);
+  while (gst_buffer_list_iterator_next_group (it)) {
+    rtp_header = gst_buffer_list_iterator_next (it);
+    gst_rtp_buffer_set_seq (rtp_header,
+        gst_rtp_buffer_get_seq (rtp_header) + rewrite->seq_offset);
+    gst_rtp_buffer_set_timestamp (rtp_header,
+        gst_rtp_buffer_get_timestamp (rtp_header) + rewrite->ts_offset);
+    gst_rtp_buffer_set_payload_type (rtp_header, rewrite->payload_type);
+    for (i = 0; i < rewrite->n_ssrc; i++) {
+      if (gst_rtp_buffer_get_ssrc (rtp_header) == rewrite->ssrc_map[2 * i]) {
+        gst_rtp_buffer_set_ssrc (rtp_header, rewrite->ssrc_map[2 * i + 1]);
+        break;
+      }
+    }
+  }
+  gst_buffer_list_iterator_free (it);
+}
+
+GST_START_TEST (test_rtp_buffer_list_rewrite_rounds)
+{
+  GstBufferList *list, *ref;
+  GstBufferListIterator *it, *ref_it;
+  GstRTPRewrite rewrite = { 0, };
+  /* swaps the two SSRCs in every round */
+  const guint32 ssrc_map[] = {
+    0x11111111, 0x33333333, 0x33333333, 0x11111111
+  };
+  GstBuffer *rtp_header, *ref_header;
+  guint i;
+
+  list = create_rtp_buffer_list (REWRITE_PACKETS, 0x11111111, 0x33333333);
+  ref = create_rtp_buffer_list (REWRITE_PACKETS, 0x11111111, 0x33333333);
+
+  rewrite.flags = GST_RTP_REWRITE_SEQ | GST_RTP_REWRITE_TIMESTAMP |
+      GST_RTP_REWRITE_PAYLOAD_TYPE | GST_RTP_REWRITE_SSRC;
+  rewrite.ssrc_map = ssrc_map;
+  rewrite.n_ssrc = 2;
+
+  /* offsets that make the seqnums and timestamps wrap many times */
+  for (i = 0; i < REWRITE_ROUNDS; i++) {
+    rewrite.seq_offset = 1021 * i;
+    rewrite.ts_offset = 0x9e3779b9 * i;
+    rewrite.payload_type = i & 0x7f;
+
+    fail_unless_equals_int (gst_rtp_buffer_list_rewrite (list, &rewrite),
+        REWRITE_PACKETS);
+    rewrite_with_setters (ref, &rewrite);
+  }
+
+  /* the single pass gives the same headers as the setters */
+  it = gst_buffer_list_iterate (list);
+  ref_it = gst_buffer_list_iterate (ref);
+  while (gst_buffer_list_iterator_next_group (it)) {
+    fail_unless (gst_buffer_list_iterator_next_group (ref_it));
+    rtp_header = gst_buffer_list_iterator_next (it);
+    ref_header = gst_buffer_list_iterator_next (ref_it);
+    fail_unless_equals_int (GST_BUFFER_SIZE (rtp_header),
+        GST_BUFFER_SIZE (ref_header));
+    fail_unless (memcmp (GST_BUFFER_DATA (rtp_header),
+            GST_BUFFER_DATA (ref_header), GST_BUFFER_SIZE (rtp_header)) == 0);
+  }
+  gst_buffer_list_iterator_free (it);
+  gst_buffer_list_iterator_free (ref_it);
+  fail_unless (gst_rtp_buffer_list_validate (list));
+
+  gst_buffer_list_unref (list);
+  gst_buffer_list_unref (ref);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_rtp_buffer_set_extension_data)
 {
   GstBuffer *buf;
@@ -727,6 +1347,286 @@ GST_START_TEST (test_rtcp_buffer)
 
 GST_END_TEST;
 
+/* build an SR with 2 + @n_extra report blocks, an SDES and a BYE packet */
+static guint
+build_compound_buffer (GstBuffer * buf, guint n_extra)
+{
+  GstRTCPPacket packet;
+  guint i;
+
+  fail_unless (gst_rtcp_buffer_add_packet (buf, GST_RTCP_TYPE_SR, &packet));
+  gst_rtcp_packet_sr_set_sender_info (&packet, 0x44556677,
+      G_GUINT64_CONSTANT (1), 0x11111111, 101, 123456);
+  fail_unless (gst_rtcp_packet_add_rb (&packet, 0x01020304, 12, -3, 0x10000,
+          20, 0x1234, 0x5678));
+  fail_unless (gst_rtcp_packet_add_rb (&packet, 0x05060708, 0, 7, 0x20000,
+          40, 0x4321, 0x8765));
+  for (i = 0; i < n_extra; i++)
+    fail_unless (gst_rtcp_packet_add_rb (&packet, 0x1000 + i, i, i, i, i, i,
+            i));
+
+  fail_unless (gst_rtcp_buffer_add_packet (buf, GST_RTCP_TYPE_SDES, &packet));
+  fail_unless (gst_rtcp_packet_sdes_add_item (&packet, 0xff658743));
+  fail_unless (gst_rtcp_packet_sdes_add_entry (&packet, GST_RTCP_SDES_CNAME,
+          sizeof ("test@foo.bar"), (guint8 *) "test@foo.bar"));
+
+  fail_unless (gst_rtcp_buffer_add_packet (buf, GST_RTCP_TYPE_BYE, &packet));
+  fail_unless (gst_rtcp_packet_bye_add_ssrc (&packet, 0x5613212f));
+  fail_unless (gst_rtcp_packet_bye_add_ssrc (&packet, 0x00112233));
+
+  gst_rtcp_buffer_end (buf);
+
+  return GST_BUFFER_SIZE (buf);
+}
+
+static guint
+build_compound_writer (guint8 * data, guint size, guint n_extra)
+{
+  GstRTCPWriter writer;
+  guint i;
+
+  gst_rtcp_writer_init (&writer, data, size);
+
+  fail_unless (gst_rtcp_writer_add_sr (&writer, 0x44556677,
+          G_GUINT64_CONSTANT (1), 0x11111111, 101, 123456));
+  fail_unless (gst_rtcp_writer_add_rb (&writer, 0x01020304, 12, -3, 0x10000,
+          20, 0x1234, 0x5678));
+  fail_unless (gst_rtcp_writer_add_rb (&writer, 0x05060708, 0, 7, 0x20000,
+          40, 0x4321, 0x8765));
+  for (i = 0; i < n_extra; i++)
+    fail_unless (gst_rtcp_writer_add_rb (&writer, 0x1000 + i, i, i, i, i, i,
+            i));
+
+  fail_unless (gst_rtcp_writer_begin_packet (&writer, GST_RTCP_TYPE_SDES, 0));
+  fail_unless (gst_rtcp_writer_add_sdes_item (&writer, 0xff658743));
+  fail_unless (gst_rtcp_writer_add_sdes_entry (&writer, GST_RTCP_SDES_CNAME,
+          sizeof ("test@foo.bar"), (guint8 *) "test@foo.bar"));
+
+  fail_unless (gst_rtcp_writer_begin_packet (&writer, GST_RTCP_TYPE_BYE, 0));
+  fail_unless (gst_rtcp_writer_add_bye_ssrc (&writer, 0x5613212f));
+  fail_unless (gst_rtcp_writer_add_bye_ssrc (&writer, 0x00112233));
+
+  return gst_rtcp_writer_end (&writer);
+}
+
+GST_START_TEST (test_rtcp_reader_writer)
+{
+  GstBuffer *buf;
+  GstRTCPReader reader;
+  GstRTCPWriter writer;
+  guint8 data[1400];
+  guint size, len;
+  guint32 ssrc, rtptime, packet_count, octet_count, exthighestseq;
+  guint64 ntptime;
+  guint8 fractionlost;
+  gint32 packetslost;
+  const guint8 *payload;
+
+  /* the writer produces the same bytes as the GstRTCPPacket API */
+  buf = gst_rtcp_buffer_new (1400);
+  size = build_compound_buffer (buf, 0);
+  memset (data, 0xff, sizeof (data));
+  fail_unless_equals_int (build_compound_writer (data, sizeof (data), 0),
+      size);
+  fail_unless (memcmp (data, GST_BUFFER_DATA (buf), size) == 0);
+  gst_buffer_unref (buf);
+
+  fail_unless (gst_rtcp_reader_init (&reader, data, size));
+  fail_unless_equals_int (gst_rtcp_reader_get_packet_count (&reader), 3);
+
+  fail_unless (gst_rtcp_reader_next (&reader));
+  fail_unless (gst_rtcp_reader_get_type (&reader) == GST_RTCP_TYPE_SR);
+  fail_unless_equals_int (gst_rtcp_reader_get_count (&reader), 2);
+  fail_unless_equals_int (gst_rtcp_reader_get_length (&reader), 18);
+  fail_unless (gst_rtcp_reader_get_ssrc (&reader) == 0x44556677);
+  fail_unless (gst_rtcp_reader_get_sender_info (&reader, &ssrc, &ntptime,
+          &rtptime, &packet_count, &octet_count));
+  fail_unless (ssrc == 0x44556677);
+  fail_unless (ntptime == G_GUINT64_CONSTANT (1));
+  fail_unless (rtptime == 0x11111111);
+  fail_unless (packet_count == 101);
+  fail_unless (octet_count == 123456);
+  fail_unless (gst_rtcp_reader_get_rb (&reader, 0, &ssrc, &fractionlost,
+          &packetslost, &exthighestseq, NULL, NULL, NULL));
+  fail_unless (ssrc == 0x01020304);
+  fail_unless_equals_int (fractionlost, 12);
+  fail_unless_equals_int (packetslost, -3);
+  fail_unless (exthighestseq == 0x10000);
+  fail_unless (gst_rtcp_reader_get_rb (&reader, 1, &ssrc, NULL, &packetslost,
+          NULL, NULL, NULL, NULL));
+  fail_unless (ssrc == 0x05060708);
+  fail_unless_equals_int (packetslost, 7);
+  fail_unless (gst_rtcp_reader_get_rb (&reader, 2, &ssrc, NULL, NULL, NULL,
+          NULL, NULL, NULL) == FALSE);
+
+  fail_unless (gst_rtcp_reader_next (&reader));
+  fail_unless (gst_rtcp_reader_get_type (&reader) == GST_RTCP_TYPE_SDES);
+  fail_unless (gst_rtcp_reader_get_ssrc (&reader) == 0xff658743);
+  fail_unless (gst_rtcp_reader_get_sender_info (&reader, NULL, NULL, NULL,
+          NULL, NULL) == FALSE);
+  payload = gst_rtcp_reader_get_payload (&reader, &len);
+  fail_unless_equals_int (len, 20);
+  fail_unless_equals_int (payload[4], GST_RTCP_SDES_CNAME);
+  fail_unless_equals_int (payload[5], sizeof ("test@foo.bar"));
+  fail_unless (memcmp (payload + 6, "test@foo.bar", 13) == 0);
+
+  fail_unless (gst_rtcp_reader_next (&reader));
+  fail_unless (gst_rtcp_reader_get_type (&reader) == GST_RTCP_TYPE_BYE);
+  fail_unless_equals_int (gst_rtcp_reader_get_count (&reader), 2);
+  fail_unless (gst_rtcp_reader_get_ssrc (&reader) == 0x5613212f);
+
+  fail_unless (gst_rtcp_reader_next (&reader) == FALSE);
+
+  gst_rtcp_reader_rewind (&reader);
+  fail_unless (gst_rtcp_reader_next (&reader));
+  fail_unless (gst_rtcp_reader_get_type (&reader) == GST_RTCP_TYPE_SR);
+
+  /* a truncated compound packet is rejected and yields no packets */
+  fail_unless (gst_rtcp_reader_init (&reader, data, size - 4) == FALSE);
+  fail_unless_equals_int (gst_rtcp_reader_get_packet_count (&reader), 0);
+  fail_unless (gst_rtcp_reader_next (&reader) == FALSE);
+
+  /* the writer never writes beyond the memory it was given */
+  memset (data, 0, sizeof (data));
+  gst_rtcp_writer_init (&writer, data, 40);
+  fail_unless (gst_rtcp_writer_add_rr (&writer, 0x44556677));
+  fail_unless (gst_rtcp_writer_add_rb (&writer, 0x01020304, 0, 0, 0, 0, 0,
+          0));
+  fail_unless (gst_rtcp_writer_add_rb (&writer, 0x05060708, 0, 0, 0, 0, 0,
+          0) == FALSE);
+  fail_unless (gst_rtcp_writer_add_fb (&writer, GST_RTCP_TYPE_PSFB,
+          GST_RTCP_PSFB_TYPE_PLI, 0x44556677, 0x01020304) == FALSE);
+  fail_unless (gst_rtcp_writer_begin_packet (&writer, GST_RTCP_TYPE_APP, 0));
+  fail_unless (gst_rtcp_writer_put_data (&writer, (guint8 *) "abcdef",
+          6) == FALSE);
+  fail_unless (gst_rtcp_writer_put_data (&writer, (guint8 *) "abc", 3));
+  size = gst_rtcp_writer_end (&writer);
+  fail_unless_equals_int (size, 40);
+
+  fail_unless (gst_rtcp_reader_init (&reader, data, size));
+  fail_unless_equals_int (gst_rtcp_reader_get_packet_count (&reader), 2);
+  fail_unless (gst_rtcp_reader_next (&reader));
+  fail_unless (gst_rtcp_reader_get_type (&reader) == GST_RTCP_TYPE_RR);
+  fail_unless_equals_int (gst_rtcp_reader_get_count (&reader), 1);
+  fail_unless (gst_rtcp_reader_next (&reader));
+  fail_unless (gst_rtcp_reader_get_type (&reader) == GST_RTCP_TYPE_APP);
+  fail_unless_equals_int (gst_rtcp_reader_get_length (&reader), 1);
+  payload = gst_rtcp_reader_get_payload (&reader, &len);
+  fail_unless_equals_int (len, 4);
+  fail_unless (memcmp (payload, "abc", 4) == 0);
+}
+
+GST_END_TEST;
+
+static guint32
+parse_compound_buffer (GstBuffer * buf)
+{
+  GstRTCPPacket packet;
+  guint32 ssrc, sum = 0;
+  guint i;
+
+  fail_unless (gst_rtcp_buffer_validate (buf));
+  if (gst_rtcp_buffer_get_first_packet (buf, &packet)) {
+    do {
+      switch (gst_rtcp_packet_get_type (&packet)) {
+        case GST_RTCP_TYPE_SR:
+          gst_rtcp_packet_sr_get_sender_info (&packet, &ssrc, NULL, NULL, NULL,
+              NULL);
+          sum += ssrc;
+          for (i = 0; i < gst_rtcp_packet_get_rb_count (&packet); i++) {
+            gst_rtcp_packet_get_rb (&packet, i, &ssrc, NULL, NULL, NULL, NULL,
+                NULL, NULL);
+            sum += ssrc;
+          }
+          break;
+        case GST_RTCP_TYPE_BYE:
+          sum += gst_rtcp_packet_bye_get_nth_ssrc (&packet, 0);
+          break;
+        default:
+          break;
+      }
+    } while (gst_rtcp_packet_move_to_next (&packet));
+  }
+  return sum;
+}
+
+static guint32
+parse_compound_reader (const guint8 * data, guint size)
+{
+  GstRTCPReader reader;
+  guint32 ssrc, sum = 0;
+  guint i;
+
+  fail_unless (gst_rtcp_reader_init (&reader, data, size));
+  while (gst_rtcp_reader_next (&reader)) {
+    switch (gst_rtcp_reader_get_type (&reader)) {
+      case GST_RTCP_TYPE_SR:
+        sum += gst_rtcp_reader_get_ssrc (&reader);
+        for (i = 0; gst_rtcp_reader_get_rb (&reader, i, &ssrc, NULL, NULL,
+                NULL, NULL, NULL, NULL); i++)
+          sum += ssrc;
+        break;
+      case GST_RTCP_TYPE_BYE:
+        sum += gst_rtcp_reader_get_ssrc (&reader);
+        break;
+      default:
+        break;
+    }
+  }
+  return sum;
+}
+
+/* an SR holds up to 31 report blocks, the compound has 2 of its own */
+#define MAX_EXTRA_RBS 29
+
+GST_START_TEST (test_rtcp_reader_writer_compounds)
+{
+  GstBuffer *buf;
+  GstRTCPPacket packet;
+  GstRTCPWriter writer;
+  guint8 data[1400];
+  guint32 expected;
+  guint i, n_extra, size;
+
+  for (n_extra = 0; n_extra <= MAX_EXTRA_RBS; n_extra++) {
+    /* both APIs build the same bytes */
+    buf = gst_rtcp_buffer_new (1400);
+    size = build_compound_buffer (buf, n_extra);
+    memset (data, 0xff, sizeof (data));
+    fail_unless_equals_int (build_compound_writer (data, sizeof (data),
+            n_extra), size);
+    fail_unless (memcmp (data, GST_BUFFER_DATA (buf), size) == 0);
+
+    /* and both see the same SSRCs in it */
+    expected = 0x44556677 + 0x01020304 + 0x05060708 + 0x5613212f;
+    for (i = 0; i < n_extra; i++)
+      expected += 0x1000 + i;
+    fail_unless (parse_compound_buffer (buf) == expected);
+    fail_unless (parse_compound_reader (data, size) == expected);
+    gst_buffer_unref (buf);
+  }
+
+  /* both refuse a 32nd report block */
+  buf = gst_rtcp_buffer_new (1400);
+  fail_unless (gst_rtcp_buffer_add_packet (buf, GST_RTCP_TYPE_RR, &packet));
+  gst_rtcp_packet_rr_set_ssrc (&packet, 0x44556677);
+  gst_rtcp_writer_init (&writer, data, sizeof (data));
+  fail_unless (gst_rtcp_writer_add_rr (&writer, 0x44556677));
+  for (i = 0; i < 32; i++) {
+    fail_unless (gst_rtcp_packet_add_rb (&packet, i, 0, 0, 0, 0, 0, 0) ==
+        (i < 31));
+    fail_unless (gst_rtcp_writer_add_rb (&writer, i, 0, 0, 0, 0, 0, 0) ==
+        (i < 31));
+  }
+  gst_rtcp_buffer_end (buf);
+  size = gst_rtcp_writer_end (&writer);
+  fail_unless_equals_int (size, GST_BUFFER_SIZE (buf));
+  fail_unless (memcmp (data, GST_BUFFER_DATA (buf), size) == 0);
+  gst_buffer_unref (buf);
+}
+
+GST_END_TEST;
+
 static Suite *
 rtp_suite (void)
 {
@@ -741,8 +1641,22 @@ rtp_suite (void)
   tcase_add_test (tc_chain, test_rtp_seqnum_compare);
 
   tcase_add_test (tc_chain, test_rtcp_buffer);
+  tcase_add_test (tc_chain, test_rtcp_reader_writer);
+  tcase_add_test (tc_chain, test_rtcp_reader_writer_compounds);
 
   tcase_add_test (tc_chain, test_rtp_buffer_list);
+  tcase_add_test (tc_chain, test_rtp_buffer_list_rewrite);
+  tcase_add_test (tc_chain, test_rtp_buffer_list_rewrite_rounds);
+
+  tcase_add_test (tc_chain, test_rtp_audio_payload_headers);
+  tcase_add_test (tc_chain, test_rtp_audio_payload_headers_list);
+
+  tcase_add_test (tc_chain, test_rtp_depayload_reorder_swapped);
+  tcase_add_test (tc_chain, test_rtp_depayload_reorder_window);
+  tcase_add_test (tc_chain, test_rtp_depayload_reorder_wraparound);
+  tcase_add_test (tc_chain, test_rtp_depayload_reorder_time);
+  tcase_add_test (tc_chain, test_rtp_depayload_reorder_eos);
+  tcase_add_test (tc_chain, test_rtp_depayload_reorder_flush);
 
   return s;
 }
@@ -25,8 +25,13 @@
 #include <gst/check/gstcheck.h>
 
 #include <gst/rtsp/gstrtspurl.h>
+#include <gst/rtsp/gstrtspconnection.h>
 #include <string.h>
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
 GST_START_TEST (test_rtsp_url_basic)
 {
   GstRTSPUrl *url = NULL;
@@ -120,6 +125,326 @@ GST_START_TEST (test_rtsp_url_components_3)
 
 GST_END_TEST;
 
+GST_START_TEST (test_rtsp_message_headers)
+{
+  GstRTSPMessage *msg;
+  GString *str;
+  gchar *val;
+  guint i;
+
+  fail_unless (gst_rtsp_message_new_request (&msg, GST_RTSP_PLAY,
+          "rtsp://localhost/test") == GST_RTSP_OK);
+  fail_unless (gst_rtsp_message_get_header (msg, GST_RTSP_HDR_CSEQ, &val,
+          0) == GST_RTSP_ENOTIMPL);
+
+  gst_rtsp_message_add_header (msg, GST_RTSP_HDR_CSEQ, "1");
+  gst_rtsp_message_add_header (msg, GST_RTSP_HDR_SESSION, "abc");
+  gst_rtsp_message_add_header (msg, GST_RTSP_HDR_CSEQ, "2");
+
+  fail_unless (gst_rtsp_message_get_header (msg, GST_RTSP_HDR_CSEQ, &val,
+          1) == GST_RTSP_OK);
+  fail_unless_equals_string (val, "2");
+  fail_unless (gst_rtsp_message_get_header (msg, GST_RTSP_HDR_CSEQ, &val,
+          2) == GST_RTSP_ENOTIMPL);
+
+  str = g_string_new ("");
+  gst_rtsp_message_append_headers (msg, str);
+  fail_unless_equals_string (str->str, "CSeq: 1\r\nSession: abc\r\n"
+      "CSeq: 2\r\n");
+  g_string_free (str, TRUE);
+
+  /* removing shifts the other headers */
+  fail_unless (gst_rtsp_message_remove_header (msg, GST_RTSP_HDR_CSEQ,
+          0) == GST_RTSP_OK);
+  fail_unless (gst_rtsp_message_get_header (msg, GST_RTSP_HDR_CSEQ, &val,
+          0) == GST_RTSP_OK);
+  fail_unless_equals_string (val, "2");
+  fail_unless (gst_rtsp_message_get_header (msg, GST_RTSP_HDR_SESSION, &val,
+          0) == GST_RTSP_OK);
+  fail_unless_equals_string (val, "abc");
+  fail_unless (gst_rtsp_message_remove_header (msg, GST_RTSP_HDR_SESSION,
+          -1) == GST_RTSP_OK);
+  fail_unless (gst_rtsp_message_get_header (msg, GST_RTSP_HDR_SESSION, &val,
+          0) == GST_RTSP_ENOTIMPL);
+
+  /* headers beyond the positions that fit in the index */
+  for (i = 0; i < 300; i++)
+    gst_rtsp_message_add_header (msg, GST_RTSP_HDR_ACCEPT, "text/plain");
+  gst_rtsp_message_add_header (msg, GST_RTSP_HDR_TRANSPORT, "RTP/AVP");
+  fail_unless (gst_rtsp_message_get_header (msg, GST_RTSP_HDR_TRANSPORT, &val,
+          0) == GST_RTSP_OK);
+  fail_unless_equals_string (val, "RTP/AVP");
+  fail_unless (gst_rtsp_message_get_header (msg, GST_RTSP_HDR_ACCEPT, &val,
+          299) == GST_RTSP_OK);
+  fail_unless (gst_rtsp_message_remove_header (msg, GST_RTSP_HDR_ACCEPT,
+          -1) == GST_RTSP_OK);
+  fail_unless (gst_rtsp_message_get_header (msg, GST_RTSP_HDR_TRANSPORT, &val,
+          0) == GST_RTSP_OK);
+  fail_unless_equals_string (val, "RTP/AVP");
+
+  gst_rtsp_message_free (msg);
+}
+
+GST_END_TEST;
+
+static guint n_sent;
+
+static GstRTSPResult
+message_sent (GstRTSPWatch * watch, guint id, gpointer user_data)
+{
+  n_sent++;
+  return GST_RTSP_OK;
+}
+
+static guint8 *
+make_data_packet (guint size)
+{
+  guint8 *data;
+
+  data = g_malloc0 (size + 4);
+  data[0] = '$';
+  data[1] = 0;
+  GST_WRITE_UINT16_BE (data + 2, size);
+
+  return data;
+}
+
+GST_START_TEST (test_rtsp_watch_send_backlog)
+{
+  GstRTSPWatchFuncs funcs = { NULL, };
+  GstRTSPConnection *conn;
+  GstRTSPWatch *watch;
+  GstRTSPMessage *response;
+  GMainContext *context;
+  GByteArray *received;
+  gsize queued_bytes, bytes;
+  guint queued_messages, messages, id, i;
+  guint64 dropped_bytes, dropped_messages;
+  gint fds[2];
+  guint8 buf[4096];
+  gboolean in_sync = TRUE;
+
+  fail_unless (socketpair (AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+  fcntl (fds[1], F_SETFL, O_NONBLOCK);
+  fail_unless (gst_rtsp_connection_create_from_fd (fds[0], "127.0.0.1", 554,
+          NULL, &conn) == GST_RTSP_OK);
+
+  funcs.message_sent = message_sent;
+  watch = gst_rtsp_watch_new (conn, &funcs, NULL, NULL);
+  gst_rtsp_watch_set_send_backlog (watch, 0, 8);
+  gst_rtsp_watch_get_send_backlog (watch, &bytes, &messages);
+  fail_unless_equals_int (bytes, 0);
+  fail_unless_equals_int (messages, 8);
+
+  /* fill the socket until data starts queueing in the watch */
+  for (i = 0; in_sync && i < 100000; i++) {
+    fail_unless (gst_rtsp_watch_write_data (watch, make_data_packet (1020),
+            1024, &id) == GST_RTSP_OK);
+    in_sync = (id == 0);
+  }
+  fail_if (in_sync);
+
+  /* the backlog is bounded by dropping the oldest data packets */
+  for (i = 0; i < 32; i++)
+    fail_unless (gst_rtsp_watch_write_data (watch, make_data_packet (1020),
+            1024, &id) == GST_RTSP_OK);
+  gst_rtsp_watch_get_send_stats (watch, &queued_bytes, &queued_messages,
+      &dropped_bytes, &dropped_messages);
+  fail_unless_equals_int (queued_messages, 8);
+  fail_unless (queued_bytes <= 8 * 1024);
+  fail_unless (dropped_messages >= 24);
+  fail_unless_equals_int (dropped_bytes, dropped_messages * 1024);
+
+  /* control messages are never dropped */
+  gst_rtsp_message_new_response (&response, GST_RTSP_STS_OK, "OK", NULL);
+  fail_unless (gst_rtsp_watch_send_message (watch, response, &id) ==
+      GST_RTSP_OK);
+  fail_unless (id != 0);
+  gst_rtsp_message_free (response);
+  gst_rtsp_watch_get_send_stats (watch, NULL, &queued_messages, NULL, NULL);
+  fail_unless_equals_int (queued_messages, 9);
+
+  /* drain the socket and let the watch flush its queue */
+  context = g_main_context_new ();
+  gst_rtsp_watch_attach (watch, context);
+  received = g_byte_array_new ();
+  for (i = 0; queued_messages > 0 && i < 100000; i++) {
+    gssize r;
+
+    while ((r = read (fds[1], buf, sizeof (buf))) > 0)
+      g_byte_array_append (received, buf, r);
+    g_main_context_iteration (context, FALSE);
+    gst_rtsp_watch_get_send_stats (watch, &queued_bytes, &queued_messages,
+        NULL, NULL);
+  }
+  fail_unless_equals_int (queued_messages, 0);
+  fail_unless_equals_int (queued_bytes, 0);
+  fail_unless_equals_int (n_sent, 9);
+
+  /* dropping must not corrupt the stream: only complete data packets followed
+   * by the response */
+  {
+    gssize r;
+
+    while ((r = read (fds[1], buf, sizeof (buf))) > 0)
+      g_byte_array_append (received, buf, r);
+
+    i = 0;
+    while (i + 4 <= received->len && received->data[i] == '$') {
+      fail_unless_equals_int (GST_READ_UINT16_BE (received->data + i + 2),
+          1020);
+      i += 1024;
+    }
+    fail_unless (i + 8 <= received->len);
+    fail_unless (memcmp (received->data + i, "RTSP/1.0", 8) == 0);
+  }
+  g_byte_array_free (received, TRUE);
+
+  g_source_destroy ((GSource *) watch);
+  gst_rtsp_watch_unref (watch);
+  g_main_context_unref (context);
+  gst_rtsp_connection_free (conn);
+  close (fds[1]);
+}
+
+GST_END_TEST;
+
+static void
+write_data_frames (gint fd, guint8 channel, guint size, guint count)
+{
+  guint8 *data;
+  guint i;
+
+  data = make_data_packet (size);
+  data[1] = channel;
+  for (i = 0; i < size; i++)
+    data[i + 4] = i & 0xff;
+
+  for (i = 0; i < count; i++)
+    fail_unless (write (fd, data, size + 4) == size + 4);
+
+  g_free (data);
+}
+
+GST_START_TEST (test_rtsp_connection_receive_buffer)
+{
+  GstRTSPConnection *conn;
+  GstRTSPMessage msg = { 0, };
+  GstBuffer *buffer;
+  const gchar *response = "RTSP/1.0 200 OK\r\nCSeq: 3\r\n\r\n";
+  gchar *hdr;
+  gint fds[2];
+  guint i;
+
+  fail_unless (socketpair (AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+  fail_unless (gst_rtsp_connection_create_from_fd (fds[0], "127.0.0.1", 554,
+          NULL, &conn) == GST_RTSP_OK);
+
+  write_data_frames (fds[1], 1, 1400, 2);
+  fail_unless (write (fds[1], response, strlen (response)) ==
+      strlen (response));
+  write_data_frames (fds[1], 0, 200, 1);
+
+  for (i = 0; i < 2; i++) {
+    fail_unless (gst_rtsp_connection_receive_buffer (conn, &msg, &buffer,
+            NULL) == GST_RTSP_OK);
+    fail_unless (msg.type == GST_RTSP_MESSAGE_DATA);
+    fail_unless_equals_int (msg.type_data.data.channel, 1);
+    fail_unless (msg.body == NULL);
+    fail_unless (buffer != NULL);
+    fail_unless_equals_int (GST_BUFFER_SIZE (buffer), 1400);
+    fail_unless_equals_int (GST_BUFFER_DATA (buffer)[1399], 1399 & 0xff);
+    gst_buffer_unref (buffer);
+    gst_rtsp_message_unset (&msg);
+  }
+
+  /* control messages are parsed as before */
+  fail_unless (gst_rtsp_connection_receive_buffer (conn, &msg, &buffer,
+          NULL) == GST_RTSP_OK);
+  fail_unless (buffer == NULL);
+  fail_unless (msg.type == GST_RTSP_MESSAGE_RESPONSE);
+  fail_unless (gst_rtsp_message_get_header (&msg, GST_RTSP_HDR_CSEQ, &hdr,
+          0) == GST_RTSP_OK);
+  fail_unless_equals_string (hdr, "3");
+  gst_rtsp_message_unset (&msg);
+
+  /* and data is copied into the body without a buffer */
+  fail_unless (gst_rtsp_connection_receive (conn, &msg, NULL) == GST_RTSP_OK);
+  fail_unless (msg.type == GST_RTSP_MESSAGE_DATA);
+  fail_unless_equals_int (msg.type_data.data.channel, 0);
+  /* includes the trailing 0 byte */
+  fail_unless_equals_int (msg.body_size, 201);
+  fail_unless_equals_int (msg.body[199], 199);
+  gst_rtsp_message_unset (&msg);
+
+  gst_rtsp_connection_free (conn);
+  close (fds[1]);
+}
+
+GST_END_TEST;
+
+#define BURST_FRAMES 256
+#define BURST_SIZE 16
+
+/* frames of different sizes, each with its own contents */
+#define BURST_FRAME_SIZE(n) (1000 + ((n) * 37) % 500)
+#define BURST_FRAME_BYTE(n, i) (((n) + (i)) & 0xff)
+
+GST_START_TEST (test_rtsp_connection_receive_burst)
+{
+  GstRTSPConnection *conn;
+  GstRTSPMessage msg = { 0, };
+  GstBuffer *buffers[BURST_FRAMES];
+  gint fds[2];
+  guint n, i;
+
+  fail_unless (socketpair (AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+  fail_unless (gst_rtsp_connection_create_from_fd (fds[0], "127.0.0.1", 554,
+          NULL, &conn) == GST_RTSP_OK);
+
+  for (n = 0; n < BURST_FRAMES; n++) {
+    /* write a burst of frames, so that the read buffer holds several of
+     * them and frames end up split between two reads */
+    if (n % BURST_SIZE == 0) {
+      for (i = n; i < n + BURST_SIZE; i++) {
+        guint8 *data;
+        guint j, size = BURST_FRAME_SIZE (i);
+
+        data = make_data_packet (size);
+        data[1] = i % 4;
+        for (j = 0; j < size; j++)
+          data[j + 4] = BURST_FRAME_BYTE (i, j);
+        fail_unless (write (fds[1], data, size + 4) == size + 4);
+        g_free (data);
+      }
+    }
+
+    fail_unless (gst_rtsp_connection_receive_buffer (conn, &msg, &buffers[n],
+            NULL) == GST_RTSP_OK);
+    fail_unless (msg.type == GST_RTSP_MESSAGE_DATA);
+    fail_unless_equals_int (msg.type_data.data.channel, n % 4);
+    fail_unless (buffers[n] != NULL);
+    fail_unless_equals_int (GST_BUFFER_SIZE (buffers[n]),
+        BURST_FRAME_SIZE (n));
+    gst_rtsp_message_unset (&msg);
+  }
+
+  /* all buffers were kept while reading on, so none of them may have been
+   * overwritten by a later read */
+  for (n = 0; n < BURST_FRAMES; n++) {
+    for (i = 0; i < GST_BUFFER_SIZE (buffers[n]); i++) {
+      fail_unless_equals_int (GST_BUFFER_DATA (buffers[n])[i],
+          BURST_FRAME_BYTE (n, i));
+    }
+    gst_buffer_unref (buffers[n]);
+  }
+
+  gst_rtsp_connection_free (conn);
+  close (fds[1]);
+}
+
+GST_END_TEST;
+
 static Suite *
 rtsp_suite (void)
 {
@@ -131,6 +456,10 @@ rtsp_suite (void)
   tcase_add_test (tc_chain, test_rtsp_url_components_1);
   tcase_add_test (tc_chain, test_rtsp_url_components_2);
   tcase_add_test (tc_chain, test_rtsp_url_components_3);
+  tcase_add_test (tc_chain, test_rtsp_message_headers);
+  tcase_add_test (tc_chain, test_rtsp_watch_send_backlog);
+  tcase_add_test (tc_chain, test_rtsp_connection_receive_buffer);
+  tcase_add_test (tc_chain, test_rtsp_connection_receive_burst);
 
   return s;
 }
@@ -27,9 +27,12 @@
 #include <gst/check/gstcheck.h>
 
 #include <gst/tag/tag.h>
+#include <gst/tag/gsttagdemux.h>
 #include <gst/base/gstbytewriter.h>
+#include <glib/gstdio.h>
 #include <string.h>
 #include <locale.h>
+#include <unistd.h>
 
 GST_START_TEST (test_parse_extended_comment)
 {
@@ -1828,6 +1831,879 @@ GST_START_TEST (test_exif_tags_serialization_deserialization)
 
 GST_END_TEST;
 
+/* minimal ID3v2 demuxer on top of GstTagDemux. In lazy mode it leaves
+ * the APIC, GEOB and PRIV frames of ID3v2.3 and ID3v2.4 tags for later */
+typedef struct
+{
+  GstTagDemux demux;
+
+  /* header of the start tag and the frames that were left out of it */
+  guint8 deferred_header[GST_TAG_ID3V2_HEADER_SIZE];
+  GArray *deferred;
+} GstTestTagDemux;
+
+typedef GstTagDemuxClass GstTestTagDemuxClass;
+
+/* a deferred frame in the upstream stream */
+typedef struct
+{
+  guint offset;
+  guint size;
+} TestTagDemuxFrame;
+
+GType gst_test_tag_demux_get_type (void);
+GST_BOILERPLATE (GstTestTagDemux, gst_test_tag_demux, GstTagDemux,
+    GST_TYPE_TAG_DEMUX);
+
+static GstStaticPadTemplate test_tag_demux_sink_template =
+GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+/* size of the largest tag buffer that was parsed */
+static guint test_tag_demux_max_parse_size;
+
+static const gchar test_tag_demux_deferred_ids[][5] = {
+  "APIC", "GEOB", "PRIV"
+};
+
+static gboolean
+gst_test_tag_demux_identify_tag (GstTagDemux * demux, GstBuffer * buffer,
+    gboolean start_tag, guint * tag_size)
+{
+  if (!start_tag || memcmp (GST_BUFFER_DATA (buffer), "ID3", 3) != 0)
+    return FALSE;
+
+  *tag_size = gst_tag_get_id3v2_tag_size (buffer);
+  return TRUE;
+}
+
+static GstTagDemuxResult
+gst_test_tag_demux_parse_tag (GstTagDemux * demux, GstBuffer * buffer,
+    gboolean start_tag, guint * tag_size, GstTagList ** tags)
+{
+  test_tag_demux_max_parse_size = MAX (test_tag_demux_max_parse_size,
+      GST_BUFFER_SIZE (buffer));
+
+  *tag_size = gst_tag_get_id3v2_tag_size (buffer);
+  *tags = gst_tag_list_from_id3v2_tag (buffer);
+
+  return (*tags) ? GST_TAG_DEMUX_RESULT_OK : GST_TAG_DEMUX_RESULT_BROKEN_TAG;
+}
+
+/* get @size bytes at @offset, from @start if it has them */
+static GstBuffer *
+gst_test_tag_demux_pull_bytes (GstTagDemux * demux, GstBuffer * start,
+    guint offset, guint size)
+{
+  GstBuffer *buffer = NULL;
+  GstPad *sinkpad;
+  GstFlowReturn ret;
+
+  if (start && offset + size <= GST_BUFFER_SIZE (start))
+    return gst_buffer_create_sub (start, offset, size);
+
+  sinkpad = gst_element_get_static_pad (GST_ELEMENT (demux), "sink");
+  ret = gst_pad_pull_range (sinkpad, offset, size, &buffer);
+  gst_object_unref (sinkpad);
+
+  if (ret == GST_FLOW_OK && GST_BUFFER_SIZE (buffer) < size) {
+    gst_buffer_unref (buffer);
+    return NULL;
+  }
+  return (ret == GST_FLOW_OK) ? buffer : NULL;
+}
+
+/* turn @tag, an ID3v2 header followed by frames, into a tag buffer */
+static GstBuffer *
+gst_test_tag_demux_finish_tag (GByteArray * tag)
+{
+  GstBuffer *buffer;
+  guint size = tag->len - GST_TAG_ID3V2_HEADER_SIZE;
+
+  /* no footer */
+  tag->data[5] &= ~0x10;
+  tag->data[6] = (size >> 21) & 0x7f;
+  tag->data[7] = (size >> 14) & 0x7f;
+  tag->data[8] = (size >> 7) & 0x7f;
+  tag->data[9] = size & 0x7f;
+
+  buffer = gst_buffer_new ();
+  GST_BUFFER_SIZE (buffer) = tag->len;
+  GST_BUFFER_DATA (buffer) = g_byte_array_free (tag, FALSE);
+  GST_BUFFER_MALLOCDATA (buffer) = GST_BUFFER_DATA (buffer);
+
+  return buffer;
+}
+
+static gboolean
+gst_test_tag_demux_is_deferred_frame (const guint8 * frame_id)
+{
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (test_tag_demux_deferred_ids); i++) {
+    if (memcmp (frame_id, test_tag_demux_deferred_ids[i], 4) == 0)
+      return TRUE;
+  }
+  return FALSE;
+}
+
+/* Walks the frame headers of the start tag and returns a copy of it
+ * without the deferred frames, whose bodies are never read. Returns NULL
+ * for tags that can't be handled like this. */
+static GstBuffer *
+gst_test_tag_demux_index_tag (GstTestTagDemux * demux, GstBuffer * start,
+    guint tag_size)
+{
+  const guint8 *data = GST_BUFFER_DATA (start);
+  GByteArray *tag;
+  GArray *deferred;
+  GstBuffer *buffer;
+  guint version, offset, end;
+
+  /* v2.2 has different frame headers, in v2.3 unsynchronisation applies to
+   * the frame headers too, and the extended header would need rewriting */
+  version = data[3];
+  if ((version != 3 && version != 4) || (data[5] & 0x40) ||
+      (version == 3 && (data[5] & 0x80)))
+    return NULL;
+
+  end = tag_size;
+  if (data[5] & 0x10)
+    end -= GST_TAG_ID3V2_HEADER_SIZE;
+
+  tag = g_byte_array_new ();
+  g_byte_array_append (tag, data, GST_TAG_ID3V2_HEADER_SIZE);
+  deferred = g_array_new (FALSE, FALSE, sizeof (TestTagDemuxFrame));
+
+  offset = GST_TAG_ID3V2_HEADER_SIZE;
+  while (offset + GST_TAG_ID3V2_HEADER_SIZE <= end) {
+    guint8 frame_hdr[GST_TAG_ID3V2_HEADER_SIZE];
+    guint frame_size;
+
+    buffer = gst_test_tag_demux_pull_bytes (GST_TAG_DEMUX (demux), start,
+        offset, GST_TAG_ID3V2_HEADER_SIZE);
+    if (buffer == NULL)
+      goto read_error;
+    memcpy (frame_hdr, GST_BUFFER_DATA (buffer), GST_TAG_ID3V2_HEADER_SIZE);
+    gst_buffer_unref (buffer);
+
+    /* padding */
+    if (frame_hdr[0] == 0)
+      break;
+
+    if (version == 4)
+      frame_size = (frame_hdr[4] << 21) | (frame_hdr[5] << 14) |
+          (frame_hdr[6] << 7) | frame_hdr[7];
+    else
+      frame_size = GST_READ_UINT32_BE (frame_hdr + 4);
+
+    /* the parser stops at broken frames as well */
+    if (frame_size > end - offset - GST_TAG_ID3V2_HEADER_SIZE)
+      break;
+
+    if (gst_test_tag_demux_is_deferred_frame (frame_hdr)) {
+      TestTagDemuxFrame frame;
+
+      frame.offset = offset;
+      frame.size = GST_TAG_ID3V2_HEADER_SIZE + frame_size;
+      g_array_append_val (deferred, frame);
+    } else {
+      buffer = gst_test_tag_demux_pull_bytes (GST_TAG_DEMUX (demux), start,
+          offset, GST_TAG_ID3V2_HEADER_SIZE + frame_size);
+      if (buffer == NULL)
+        goto read_error;
+      g_byte_array_append (tag, GST_BUFFER_DATA (buffer),
+          GST_BUFFER_SIZE (buffer));
+      gst_buffer_unref (buffer);
+    }
+
+    offset += GST_TAG_ID3V2_HEADER_SIZE + frame_size;
+  }
+
+  GST_OBJECT_LOCK (demux);
+  memcpy (demux->deferred_header, data, GST_TAG_ID3V2_HEADER_SIZE);
+  if (demux->deferred)
+    g_array_free (demux->deferred, TRUE);
+  demux->deferred = deferred;
+  GST_OBJECT_UNLOCK (demux);
+
+  return gst_test_tag_demux_finish_tag (tag);
+
+read_error:
+  {
+    g_byte_array_free (tag, TRUE);
+    g_array_free (deferred, TRUE);
+    return NULL;
+  }
+}
+
+static void
+gst_test_tag_demux_clear_deferred (GstTestTagDemux * demux)
+{
+  GST_OBJECT_LOCK (demux);
+  if (demux->deferred) {
+    g_array_free (demux->deferred, TRUE);
+    demux->deferred = NULL;
+  }
+  GST_OBJECT_UNLOCK (demux);
+}
+
+static GstTagDemuxResult
+gst_test_tag_demux_parse_tag_lazy (GstTagDemux * demux, GstBuffer * buffer,
+    guint tag_size, GstTagList ** tags)
+{
+  GstTestTagDemux *test_demux = (GstTestTagDemux *) demux;
+  GstTagDemuxResult ret;
+  GstBuffer *index;
+  guint size;
+
+  index = gst_test_tag_demux_index_tag (test_demux, buffer, tag_size);
+  if (index == NULL)
+    return GST_TAG_DEMUX_RESULT_BROKEN_TAG;
+
+  /* nothing but deferred frames, which the parser would call broken */
+  if (GST_BUFFER_SIZE (index) == GST_TAG_ID3V2_HEADER_SIZE &&
+      test_demux->deferred->len > 0) {
+    gst_buffer_unref (index);
+    return GST_TAG_DEMUX_RESULT_OK;
+  }
+
+  size = GST_BUFFER_SIZE (index);
+  ret = gst_test_tag_demux_parse_tag (demux, index, TRUE, &size, tags);
+  gst_buffer_unref (index);
+
+  if (ret != GST_TAG_DEMUX_RESULT_OK)
+    gst_test_tag_demux_clear_deferred (test_demux);
+
+  return ret;
+}
+
+static GstTagList *
+gst_test_tag_demux_load_deferred_tags (GstTagDemux * demux)
+{
+  GstTestTagDemux *test_demux = (GstTestTagDemux *) demux;
+  GstTagList *tags = NULL;
+  GstBuffer *buffer;
+  GByteArray *tag;
+  GArray *deferred = NULL;
+  guint i, size;
+
+  tag = g_byte_array_new ();
+
+  GST_OBJECT_LOCK (demux);
+  if (test_demux->deferred && test_demux->deferred->len > 0) {
+    deferred = g_array_sized_new (FALSE, FALSE, sizeof (TestTagDemuxFrame),
+        test_demux->deferred->len);
+    g_array_append_vals (deferred, test_demux->deferred->data,
+        test_demux->deferred->len);
+    g_byte_array_append (tag, test_demux->deferred_header,
+        GST_TAG_ID3V2_HEADER_SIZE);
+  }
+  GST_OBJECT_UNLOCK (demux);
+
+  if (deferred == NULL) {
+    g_byte_array_free (tag, TRUE);
+    return NULL;
+  }
+
+  for (i = 0; i < deferred->len; i++) {
+    TestTagDemuxFrame *frame = &g_array_index (deferred, TestTagDemuxFrame, i);
+
+    buffer = gst_test_tag_demux_pull_bytes (demux, NULL, frame->offset,
+        frame->size);
+    if (buffer == NULL) {
+      g_byte_array_free (tag, TRUE);
+      g_array_free (deferred, TRUE);
+      return NULL;
+    }
+    g_byte_array_append (tag, GST_BUFFER_DATA (buffer),
+        GST_BUFFER_SIZE (buffer));
+    gst_buffer_unref (buffer);
+  }
+  g_array_free (deferred, TRUE);
+
+  buffer = gst_test_tag_demux_finish_tag (tag);
+  size = GST_BUFFER_SIZE (buffer);
+  if (gst_test_tag_demux_parse_tag (demux, buffer, TRUE, &size, &tags) !=
+      GST_TAG_DEMUX_RESULT_OK && tags != NULL) {
+    gst_tag_list_free (tags);
+    tags = NULL;
+  }
+  gst_buffer_unref (buffer);
+
+  return tags;
+}
+
+static GstStateChangeReturn
+gst_test_tag_demux_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstStateChangeReturn ret;
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+  if (transition == GST_STATE_CHANGE_PAUSED_TO_READY)
+    gst_test_tag_demux_clear_deferred ((GstTestTagDemux *) element);
+
+  return ret;
+}
+
+static void
+gst_test_tag_demux_finalize (GObject * object)
+{
+  gst_test_tag_demux_clear_deferred ((GstTestTagDemux *) object);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+gst_test_tag_demux_base_init (gpointer klass)
+{
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+
+  gst_element_class_add_static_pad_template (element_class,
+      &test_tag_demux_sink_template);
+  gst_element_class_set_details_simple (element_class, "Test tag demuxer",
+      "Codec/Demuxer/Metadata", "Reads ID3v2 tags for the unit tests",
+      "GStreamer maintainers <gstreamer-devel@lists.freedesktop.org>");
+}
+
+static void
+gst_test_tag_demux_class_init (GstTestTagDemuxClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+
+  gobject_class->finalize = gst_test_tag_demux_finalize;
+  element_class->change_state = gst_test_tag_demux_change_state;
+
+  klass->identify_tag = gst_test_tag_demux_identify_tag;
+  klass->parse_tag = gst_test_tag_demux_parse_tag;
+  klass->parse_tag_lazy = gst_test_tag_demux_parse_tag_lazy;
+  klass->load_deferred_tags = gst_test_tag_demux_load_deferred_tags;
+  klass->min_start_size = GST_TAG_ID3V2_HEADER_SIZE;
+  klass->min_end_size = 0;
+}
+
+static void
+gst_test_tag_demux_init (GstTestTagDemux * demux, GstTestTagDemuxClass * klass)
+{
+}
+
+static GstStaticCaps lazy_caps = GST_STATIC_CAPS ("application/x-lazy-test");
+
+static void
+lazy_type_find (GstTypeFind * tf, gpointer unused)
+{
+  const guint8 *data = gst_type_find_peek (tf, 0, 4);
+
+  if (data && memcmp (data, "LAZY", 4) == 0)
+    gst_type_find_suggest (tf, GST_TYPE_FIND_MAXIMUM,
+        gst_static_caps_get (&lazy_caps));
+}
+
+#define LAZY_PICTURE_SIZE (256 * 1024)
+
+/* writes a frame header for ID3v2.@version and the frame data */
+static void
+write_id3v2_frame (GstByteWriter * bw, guint version, const gchar * id,
+    const guint8 * data, guint size)
+{
+  if (version == 2) {
+    gst_byte_writer_put_data (bw, (const guint8 *) id, 3);
+    gst_byte_writer_put_uint24_be (bw, size);
+  } else if (version == 3) {
+    gst_byte_writer_put_data (bw, (const guint8 *) id, 4);
+    gst_byte_writer_put_uint32_be (bw, size);
+    gst_byte_writer_put_uint16_be (bw, 0);
+  } else {
+    gst_byte_writer_put_data (bw, (const guint8 *) id, 4);
+    gst_byte_writer_put_uint8 (bw, (size >> 21) & 0x7f);
+    gst_byte_writer_put_uint8 (bw, (size >> 14) & 0x7f);
+    gst_byte_writer_put_uint8 (bw, (size >> 7) & 0x7f);
+    gst_byte_writer_put_uint8 (bw, size & 0x7f);
+    gst_byte_writer_put_uint16_be (bw, 0);
+  }
+  gst_byte_writer_put_data (bw, data, size);
+}
+
+static void
+write_id3v2_text_frame (GstByteWriter * bw, guint version, const gchar * id,
+    const gchar * text)
+{
+  guint8 *data;
+  guint len = strlen (text);
+
+  /* UTF-8 only exists since v2.4, the texts are plain ASCII anyway */
+  data = g_malloc (len + 1);
+  data[0] = (version == 4) ? 3 : 0;
+  memcpy (data + 1, text, len);
+  write_id3v2_frame (bw, version, id, data, len + 1);
+  g_free (data);
+}
+
+/* writes a file with an ID3v2.@version tag with a title, a large picture and
+ * an album, followed by a bit of data, returns the file name. @flags are the
+ * tag header flags; with the extended header flag an empty extended header
+ * is written. The picture never contains 0xff, so the data is the same with
+ * and without unsynchronisation. */
+static gchar *
+write_lazy_tag_file (guint version, guint8 flags)
+{
+  static const guint8 png_header[] = {
+    0x89, 'P', 'N', 'G', 0x0d, 0x0a, 0x1a, 0x0a,
+    0x00, 0x00, 0x00, 0x0d, 'I', 'H', 'D', 'R'
+  };
+  GstByteWriter *bw;
+  guint8 *picture, *data;
+  gchar *filename;
+  guint size, tag_size, picture_hdr_size;
+  gint fd;
+
+  bw = gst_byte_writer_new ();
+  gst_byte_writer_put_data (bw, (const guint8 *) "ID3", 3);
+  gst_byte_writer_put_uint8 (bw, version);
+  gst_byte_writer_put_uint8 (bw, 0);
+  gst_byte_writer_put_uint8 (bw, flags);
+  /* size, filled in later */
+  gst_byte_writer_put_uint32_be (bw, 0);
+
+  if (flags & 0x40) {
+    /* size (including itself), one flag byte, no flags set */
+    gst_byte_writer_put_uint32_be (bw, 6);
+    gst_byte_writer_put_uint8 (bw, 1);
+    gst_byte_writer_put_uint8 (bw, 0);
+  }
+
+  write_id3v2_text_frame (bw, version, (version == 2) ? "TT2" : "TIT2",
+      "Lazy title");
+
+  /* latin1, image format, front cover, empty description, image data */
+  picture = g_malloc0 (LAZY_PICTURE_SIZE + 13);
+  if (version == 2) {
+    picture_hdr_size = 6;
+    memcpy (picture, "\000PNG\003\000", picture_hdr_size);
+  } else {
+    picture_hdr_size = 13;
+    memcpy (picture, "\000image/png\000\003\000", picture_hdr_size);
+  }
+  memcpy (picture + picture_hdr_size, png_header, sizeof (png_header));
+  write_id3v2_frame (bw, version, (version == 2) ? "PIC" : "APIC", picture,
+      LAZY_PICTURE_SIZE + picture_hdr_size);
+  g_free (picture);
+
+  write_id3v2_text_frame (bw, version, (version == 2) ? "TAL" : "TALB",
+      "Lazy album");
+
+  /* padding */
+  gst_byte_writer_fill (bw, 0, 1024);
+
+  tag_size = gst_byte_writer_get_pos (bw) - GST_TAG_ID3V2_HEADER_SIZE;
+  gst_byte_writer_set_pos (bw, 6);
+  gst_byte_writer_put_uint8 (bw, (tag_size >> 21) & 0x7f);
+  gst_byte_writer_put_uint8 (bw, (tag_size >> 14) & 0x7f);
+  gst_byte_writer_put_uint8 (bw, (tag_size >> 7) & 0x7f);
+  gst_byte_writer_put_uint8 (bw, tag_size & 0x7f);
+  gst_byte_writer_set_pos (bw, tag_size + GST_TAG_ID3V2_HEADER_SIZE);
+
+  gst_byte_writer_put_data (bw, (const guint8 *) "LAZY", 4);
+  gst_byte_writer_fill (bw, 0x42, 4096);
+
+  size = gst_byte_writer_get_size (bw);
+  data = gst_byte_writer_free_and_get_data (bw);
+
+  fd = g_file_open_tmp ("lazytagXXXXXX", &filename, NULL);
+  fail_unless (fd >= 0);
+  fail_unless_equals_int (write (fd, data, size), size);
+  close (fd);
+  g_free (data);
+
+  return filename;
+}
+
+static void
+lazy_tag_demux_pad_added (GstElement * demux, GstPad * pad, GstElement * bin)
+{
+  GstElement *sink;
+  GstPad *sinkpad;
+
+  /* the deferred tags can only be read in pull mode, so add the sink once
+   * the source pad exists and let it activate the demuxer in pull mode */
+  sink = gst_element_factory_make ("fakesink", NULL);
+  fail_unless (sink != NULL);
+  g_object_set (sink, "can-activate-pull", TRUE, NULL);
+  gst_bin_add (GST_BIN (bin), sink);
+
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  fail_unless_equals_int (gst_pad_link (pad, sinkpad), GST_PAD_LINK_OK);
+  gst_object_unref (sinkpad);
+
+  gst_element_sync_state_with_parent (sink);
+}
+
+/* preroll filesrc ! testtagdemux ! fakesink in pull mode, returns the
+ * demuxer and the tags it posted */
+static GstElement *
+preroll_lazy_tag_file (const gchar * filename, gboolean lazy,
+    GstTagList ** tags, GstElement ** pipeline)
+{
+  GstElement *bin, *src, *demux;
+  GstMessage *msg;
+
+  bin = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("filesrc", NULL);
+  demux = gst_element_factory_make ("testtagdemux", NULL);
+  fail_unless (src != NULL && demux != NULL);
+
+  g_object_set (src, "location", filename, NULL);
+  g_object_set (demux, "lazy-tags", lazy, NULL);
+
+  gst_bin_add_many (GST_BIN (bin), src, demux, NULL);
+  fail_unless (gst_element_link (src, demux));
+  g_signal_connect (demux, "pad-added",
+      G_CALLBACK (lazy_tag_demux_pad_added), bin);
+
+  fail_unless_equals_int (gst_element_set_state (bin, GST_STATE_PAUSED),
+      GST_STATE_CHANGE_ASYNC);
+  fail_unless_equals_int (gst_element_get_state (bin, NULL, NULL, -1),
+      GST_STATE_CHANGE_SUCCESS);
+
+  *tags = NULL;
+  while ((msg = gst_bus_pop_filtered (GST_ELEMENT_BUS (bin),
+              GST_MESSAGE_TAG))) {
+    GstTagList *msg_tags, *merged;
+
+    gst_message_parse_tag (msg, &msg_tags);
+    merged = gst_tag_list_merge (*tags, msg_tags, GST_TAG_MERGE_APPEND);
+    if (*tags)
+      gst_tag_list_free (*tags);
+    gst_tag_list_free (msg_tags);
+    *tags = merged;
+    gst_message_unref (msg);
+  }
+  fail_unless (*tags != NULL);
+
+  *pipeline = bin;
+  return demux;
+}
+
+static void
+check_lazy_text_tags (const GstTagList * tags)
+{
+  gchar *str = NULL;
+
+  fail_unless (gst_tag_list_get_string (tags, GST_TAG_TITLE, &str));
+  fail_unless_equals_string (str, "Lazy title");
+  g_free (str);
+  fail_unless (gst_tag_list_get_string (tags, GST_TAG_ALBUM, &str));
+  fail_unless_equals_string (str, "Lazy album");
+  g_free (str);
+}
+
+static void
+check_lazy_picture (const GstTagList * tags)
+{
+  const GValue *val;
+  GstBuffer *image;
+
+  val = gst_tag_list_get_value_index (tags, GST_TAG_IMAGE, 0);
+  fail_unless (val != NULL);
+  image = gst_value_get_buffer (val);
+  fail_unless_equals_int (GST_BUFFER_SIZE (image), LAZY_PICTURE_SIZE);
+}
+
+static void
+register_lazy_tag_demux (void)
+{
+  static gboolean registered = FALSE;
+
+  if (registered)
+    return;
+
+  gst_element_register (NULL, "testtagdemux", GST_RANK_NONE,
+      gst_test_tag_demux_get_type ());
+  gst_type_find_register (NULL, "application/x-lazy-test", GST_RANK_PRIMARY,
+      lazy_type_find, NULL, gst_static_caps_get (&lazy_caps), NULL, NULL);
+  registered = TRUE;
+}
+
+GST_START_TEST (test_tag_demux_lazy_tags)
+{
+  GstElement *bin, *demux;
+  GstTagList *tags, *deferred;
+  gchar *filename;
+
+  register_lazy_tag_demux ();
+
+  filename = write_lazy_tag_file (4, 0);
+
+  /* everything is parsed up front by default */
+  test_tag_demux_max_parse_size = 0;
+  demux = preroll_lazy_tag_file (filename, FALSE, &tags, &bin);
+  check_lazy_text_tags (tags);
+  check_lazy_picture (tags);
+  fail_unless (test_tag_demux_max_parse_size > LAZY_PICTURE_SIZE);
+  fail_unless (gst_tag_demux_load_deferred_tags (GST_TAG_DEMUX (demux)) ==
+      NULL);
+  gst_tag_list_free (tags);
+  gst_element_set_state (bin, GST_STATE_NULL);
+  gst_object_unref (bin);
+
+  /* the picture is skipped, but the frame after it is parsed */
+  test_tag_demux_max_parse_size = 0;
+  demux = preroll_lazy_tag_file (filename, TRUE, &tags, &bin);
+  check_lazy_text_tags (tags);
+  fail_unless (gst_tag_list_get_tag_size (tags, GST_TAG_IMAGE) == 0);
+  fail_unless (test_tag_demux_max_parse_size < 1024);
+  gst_tag_list_free (tags);
+
+  /* and can be loaded on request */
+  deferred = gst_tag_demux_load_deferred_tags (GST_TAG_DEMUX (demux));
+  fail_unless (deferred != NULL);
+  check_lazy_picture (deferred);
+  fail_unless (gst_tag_list_get_tag_size (deferred, GST_TAG_TITLE) == 0);
+  gst_tag_list_free (deferred);
+
+  gst_element_set_state (bin, GST_STATE_NULL);
+  gst_object_unref (bin);
+
+  g_unlink (filename);
+  g_free (filename);
+}
+
+GST_END_TEST;
+
+/* tags the demuxer can't index are read completely, even in lazy mode */
+static void
+check_lazy_tags_fallback (guint version, guint8 flags)
+{
+  GstElement *bin, *demux;
+  GstTagList *tags;
+  gchar *filename;
+
+  filename = write_lazy_tag_file (version, flags);
+
+  test_tag_demux_max_parse_size = 0;
+  demux = preroll_lazy_tag_file (filename, TRUE, &tags, &bin);
+  check_lazy_text_tags (tags);
+  check_lazy_picture (tags);
+  fail_unless (test_tag_demux_max_parse_size > LAZY_PICTURE_SIZE);
+  fail_unless (gst_tag_demux_load_deferred_tags (GST_TAG_DEMUX (demux)) ==
+      NULL);
+  gst_tag_list_free (tags);
+
+  gst_element_set_state (bin, GST_STATE_NULL);
+  gst_object_unref (bin);
+
+  g_unlink (filename);
+  g_free (filename);
+}
+
+GST_START_TEST (test_tag_demux_lazy_tags_fallback)
+{
+  register_lazy_tag_demux ();
+
+  /* ID3v2.2 */
+  check_lazy_tags_fallback (2, 0);
+  /* ID3v2.3 with whole-tag unsynchronisation */
+  check_lazy_tags_fallback (3, 0x80);
+  /* ID3v2.4 with an extended header */
+  check_lazy_tags_fallback (4, 0x40);
+}
+
+GST_END_TEST;
+
+#define CORPUS_PICTURE_SIZE 8192
+#define CORPUS_PRIV_SIZE 512
+
+/* inserts a 0x00 after each 0xff */
+static guint8 *
+unsync_id3v2_data (const guint8 * data, guint * size)
+{
+  guint8 *out;
+  guint i, n = 0;
+
+  out = g_malloc (*size * 2);
+  for (i = 0; i < *size; i++) {
+    out[n++] = data[i];
+    if (data[i] == 0xff)
+      out[n++] = 0x00;
+  }
+  *size = n;
+  return out;
+}
+
+static void
+put_id3v2_synch_uint (GstByteWriter * bw, guint size)
+{
+  gst_byte_writer_put_uint8 (bw, (size >> 21) & 0x7f);
+  gst_byte_writer_put_uint8 (bw, (size >> 14) & 0x7f);
+  gst_byte_writer_put_uint8 (bw, (size >> 7) & 0x7f);
+  gst_byte_writer_put_uint8 (bw, size & 0x7f);
+}
+
+static void
+put_corpus_frame (GstByteWriter * bw, guint version, gboolean unsync,
+    const gchar * id, const guint8 * data, guint size)
+{
+  guint8 *uu = NULL;
+
+  if (unsync)
+    data = uu = unsync_id3v2_data (data, &size);
+
+  gst_byte_writer_put_data (bw, (const guint8 *) id, 4);
+  if (version == 3)
+    gst_byte_writer_put_uint32_be (bw, size);
+  else
+    put_id3v2_synch_uint (bw, size);
+  /* frame unsynchronisation flag */
+  gst_byte_writer_put_uint16_be (bw, unsync ? 0x0002 : 0);
+  gst_byte_writer_put_data (bw, data, size);
+
+  g_free (uu);
+}
+
+/* creates an ID3v2 tag with a latin1 title with a 0xff byte, an artist, a
+ * JPEG picture and a private frame with lots of 0xff bytes. @tag_unsync
+ * unsyncs the entire v2.3 tag, @frame_unsync each v2.4 frame */
+static GstBuffer *
+create_corpus_tag (guint version, gboolean tag_unsync, gboolean frame_unsync)
+{
+  static const guint8 jpeg_header[] = {
+    0xff, 0xd8, 0xff, 0xe0, 0x00, 0x10, 'J', 'F', 'I', 'F', 0x00
+  };
+  GstByteWriter *bw, *frames;
+  GstBuffer *buf;
+  guint8 *data, *frames_data;
+  guint i, size;
+
+  frames = gst_byte_writer_new ();
+
+  put_corpus_frame (frames, version, frame_unsync, "TIT2",
+      (const guint8 *) "\000Caf\377", 5);
+  put_corpus_frame (frames, version, frame_unsync, "TPE1",
+      (const guint8 *) "\003Corpus artist", 14);
+
+  /* obsolete in v2.4, to be skipped */
+  if (version == 3)
+    put_corpus_frame (frames, version, frame_unsync, "TSIZ",
+        (const guint8 *) "\000123456", 7);
+
+  /* latin1, mime type, front cover, empty description, image data */
+  data = g_malloc (CORPUS_PICTURE_SIZE + 14);
+  memcpy (data, "\000image/jpeg\000\003\000", 14);
+  memcpy (data + 14, jpeg_header, sizeof (jpeg_header));
+  for (i = sizeof (jpeg_header); i < CORPUS_PICTURE_SIZE; i++)
+    data[14 + i] = (i % 3) ? 0xff : i & 0xff;
+  put_corpus_frame (frames, version, frame_unsync, "APIC", data,
+      CORPUS_PICTURE_SIZE + 14);
+  g_free (data);
+
+  /* unknown frame, added to the tags as a blob */
+  data = g_malloc (CORPUS_PRIV_SIZE);
+  for (i = 0; i < CORPUS_PRIV_SIZE; i++)
+    data[i] = (i % 2) ? 0xff : 0x00;
+  put_corpus_frame (frames, version, frame_unsync, "PRIV", data,
+      CORPUS_PRIV_SIZE);
+  g_free (data);
+
+  /* padding */
+  gst_byte_writer_fill (frames, 0, 256);
+
+  size = gst_byte_writer_get_size (frames);
+  frames_data = gst_byte_writer_free_and_get_data (frames);
+  if (tag_unsync) {
+    data = unsync_id3v2_data (frames_data, &size);
+    g_free (frames_data);
+    frames_data = data;
+  }
+
+  bw = gst_byte_writer_new ();
+  gst_byte_writer_put_data (bw, (const guint8 *) "ID3", 3);
+  gst_byte_writer_put_uint8 (bw, version);
+  gst_byte_writer_put_uint8 (bw, 0);
+  gst_byte_writer_put_uint8 (bw, tag_unsync ? 0x80 : 0);
+  put_id3v2_synch_uint (bw, size);
+  gst_byte_writer_put_data (bw, frames_data, size);
+  g_free (frames_data);
+
+  size = gst_byte_writer_get_size (bw);
+  buf = gst_buffer_new ();
+  GST_BUFFER_MALLOCDATA (buf) = gst_byte_writer_free_and_get_data (bw);
+  GST_BUFFER_DATA (buf) = GST_BUFFER_MALLOCDATA (buf);
+  GST_BUFFER_SIZE (buf) = size;
+
+  return buf;
+}
+
+static void
+check_corpus_tags (const GstTagList * tags)
+{
+  GstBuffer *image = NULL, *frame = NULL;
+  gchar *s = NULL;
+  guint i;
+
+  fail_unless (tags != NULL);
+
+  fail_unless (gst_tag_list_get_string (tags, GST_TAG_TITLE, &s));
+  fail_unless_equals_string (s, "Caf\303\277");
+  g_free (s);
+
+  fail_unless (gst_tag_list_get_string (tags, GST_TAG_ARTIST, &s));
+  fail_unless_equals_string (s, "Corpus artist");
+  g_free (s);
+
+  fail_unless (gst_tag_list_get_buffer (tags, GST_TAG_IMAGE, &image));
+  fail_unless_equals_int (GST_BUFFER_SIZE (image), CORPUS_PICTURE_SIZE);
+  fail_unless_equals_int (GST_BUFFER_DATA (image)[0], 0xff);
+  fail_unless_equals_int (GST_BUFFER_DATA (image)[1], 0xd8);
+  for (i = 11; i < CORPUS_PICTURE_SIZE; i++) {
+    fail_unless_equals_int (GST_BUFFER_DATA (image)[i],
+        (i % 3) ? 0xff : i & 0xff);
+  }
+  gst_buffer_unref (image);
+
+  /* only the private frame, the obsolete one is skipped */
+  fail_unless_equals_int (gst_tag_list_get_tag_size (tags,
+          "private-id3v2-frame"), 1);
+  fail_unless (gst_tag_list_get_buffer (tags, "private-id3v2-frame", &frame));
+  fail_unless (memcmp (GST_BUFFER_DATA (frame), "PRIV", 4) == 0);
+  gst_buffer_unref (frame);
+}
+
+GST_START_TEST (test_id3v2_parse_corpus)
+{
+  GstBuffer *corpus[3];
+  GstTagList *tags;
+  guint8 *orig;
+  gint i, j;
+
+  corpus[0] = create_corpus_tag (3, TRUE, FALSE);
+  corpus[1] = create_corpus_tag (4, FALSE, FALSE);
+  corpus[2] = create_corpus_tag (4, FALSE, TRUE);
+
+  for (j = 0; j < G_N_ELEMENTS (corpus); j++) {
+    /* frames are parsed in place when possible, but the tag data must not be
+     * modified, so parsing it again gives the same result */
+    orig = g_memdup (GST_BUFFER_DATA (corpus[j]), GST_BUFFER_SIZE (corpus[j]));
+    for (i = 0; i < 2; i++) {
+      tags = gst_tag_list_from_id3v2_tag (corpus[j]);
+      check_corpus_tags (tags);
+      gst_tag_list_free (tags);
+      fail_unless (memcmp (orig, GST_BUFFER_DATA (corpus[j]),
+              GST_BUFFER_SIZE (corpus[j])) == 0);
+    }
+    g_free (orig);
+  }
+
+  for (j = 0; j < G_N_ELEMENTS (corpus); j++)
+    gst_buffer_unref (corpus[j]);
+}
+
+GST_END_TEST;
+
 static Suite *
 tag_suite (void)
 {
@@ -1849,6 +2725,9 @@ tag_suite (void)
   tcase_add_test (tc_chain, test_exif_parsing);
   tcase_add_test (tc_chain, test_exif_tags_serialization_deserialization);
   tcase_add_test (tc_chain, test_exif_multiple_tags);
+  tcase_add_test (tc_chain, test_tag_demux_lazy_tags);
+  tcase_add_test (tc_chain, test_tag_demux_lazy_tags_fallback);
+  tcase_add_test (tc_chain, test_id3v2_parse_corpus);
   return s;
 }
 
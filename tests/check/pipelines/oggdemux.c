@@ -0,0 +1,552 @@
+/* GStreamer
+ *
+ * unit tests for oggdemux seeking in pull mode
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <glib/gstdio.h>
+#include <gst/check/gstcheck.h>
+
+#ifdef HAVE_VORBIS
+
+/* every test buffer is 100ms of white noise, which vorbis can not compress
+ * much, so that the files are large enough to need several pulls to bisect */
+#define BUFFER_DURATION (GST_SECOND / 10)
+
+static GMutex *probe_lock;
+static GCond *probe_cond;
+static gboolean have_newsegment;
+static gint64 segment_start;
+static gint64 segment_time;
+static GstClockTime first_position;
+static GstClockTime start_position;
+
+static gchar *
+make_temp_name (const gchar * what)
+{
+  return g_strdup_printf ("%s" G_DIR_SEPARATOR_S "oggdemux-test-%s-%u",
+      g_get_tmp_dir (), what, g_random_int ());
+}
+
+static void
+remove_dir (const gchar * path)
+{
+  GDir *dir;
+  const gchar *name;
+
+  dir = g_dir_open (path, 0, NULL);
+  if (dir) {
+    while ((name = g_dir_read_name (dir))) {
+      gchar *child = g_build_filename (path, name, NULL);
+
+      g_unlink (child);
+      g_free (child);
+    }
+    g_dir_close (dir);
+  }
+  g_rmdir (path);
+}
+
+/* encode @n_buffers of noise to a new Ogg Vorbis file at @location */
+static void
+make_ogg_file (const gchar * location, gint n_buffers)
+{
+  GstElement *pipeline;
+  GstMessage *msg;
+  GstBus *bus;
+  gchar *desc;
+
+  desc = g_strdup_printf ("audiotestsrc wave=white-noise num-buffers=%d "
+      "samplesperbuffer=4410 ! audio/x-raw-int,rate=44100,channels=1 ! "
+      "audioconvert ! vorbisenc ! oggmux ! filesink location=%s",
+      n_buffers, location);
+  pipeline = gst_parse_launch (desc, NULL);
+  fail_unless (pipeline != NULL);
+  g_free (desc);
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+}
+
+/* returns the only file in @path, NULL when there are none or several */
+static gchar *
+get_index_file (const gchar * path)
+{
+  GDir *dir;
+  const gchar *name;
+  gchar *file = NULL;
+  gint n_files = 0;
+
+  dir = g_dir_open (path, 0, NULL);
+  if (dir == NULL)
+    return NULL;
+
+  while ((name = g_dir_read_name (dir))) {
+    g_free (file);
+    file = g_build_filename (path, name, NULL);
+    n_files++;
+  }
+  g_dir_close (dir);
+
+  if (n_files != 1) {
+    g_free (file);
+    return NULL;
+  }
+  return file;
+}
+
+static gboolean
+sink_probe (GstPad * pad, GstMiniObject * obj, gpointer user_data)
+{
+  g_mutex_lock (probe_lock);
+  if (GST_IS_EVENT (obj)) {
+    GstEvent *event = GST_EVENT_CAST (obj);
+
+    if (GST_EVENT_TYPE (event) == GST_EVENT_NEWSEGMENT) {
+      GstFormat format;
+      gboolean update;
+
+      gst_event_parse_new_segment (event, &update, NULL, &format,
+          &segment_start, NULL, &segment_time);
+      if (!update && format == GST_FORMAT_TIME)
+        have_newsegment = TRUE;
+    }
+  } else if (have_newsegment && !GST_CLOCK_TIME_IS_VALID (first_position)) {
+    GstBuffer *buf = GST_BUFFER_CAST (obj);
+
+    /* headers have no timestamp, the first data buffer after the seek tells
+     * us where oggdemux ended up */
+    if (GST_BUFFER_TIMESTAMP_IS_VALID (buf)) {
+      first_position = segment_time + GST_BUFFER_TIMESTAMP (buf) -
+          segment_start;
+      g_cond_signal (probe_cond);
+    }
+  }
+  g_mutex_unlock (probe_lock);
+
+  return TRUE;
+}
+
+/* link every pad oggdemux makes, also those of the chains we seek into, to a
+ * sink that does not delay state changes */
+static void
+pad_added_cb (GstElement * demux, GstPad * pad, GstElement * pipeline)
+{
+  GstElement *sink;
+  GstPad *sinkpad;
+
+  sink = gst_element_factory_make ("fakesink", NULL);
+  fail_unless (sink != NULL);
+  g_object_set (sink, "sync", FALSE, "async", FALSE, NULL);
+  gst_bin_add (GST_BIN (pipeline), sink);
+
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_add_data_probe (sinkpad, G_CALLBACK (sink_probe), NULL);
+  fail_unless (gst_pad_link (pad, sinkpad) == GST_PAD_LINK_OK);
+  gst_object_unref (sinkpad);
+
+  gst_element_sync_state_with_parent (sink);
+}
+
+static GstElement *
+setup_demux_pipeline (const gchar * location, const gchar * cache_dir,
+    GstElement ** demux)
+{
+  GstElement *pipeline, *src;
+
+  pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("filesrc", NULL);
+  *demux = gst_element_factory_make ("oggdemux", NULL);
+  fail_unless (src != NULL && *demux != NULL);
+
+  g_object_set (src, "location", location, NULL);
+  g_object_set (*demux, "index-cache-dir", cache_dir, NULL);
+  g_signal_connect (*demux, "pad-added", G_CALLBACK (pad_added_cb), pipeline);
+
+  gst_bin_add_many (GST_BIN (pipeline), src, *demux, NULL);
+  fail_unless (gst_element_link (src, *demux));
+
+  have_newsegment = FALSE;
+  first_position = GST_CLOCK_TIME_NONE;
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PAUSED) !=
+      GST_STATE_CHANGE_FAILURE);
+  fail_unless (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE) != GST_STATE_CHANGE_FAILURE);
+
+  /* wait for the first buffer so that the chains are known */
+  g_mutex_lock (probe_lock);
+  while (!GST_CLOCK_TIME_IS_VALID (first_position))
+    g_cond_wait (probe_cond, probe_lock);
+  start_position = first_position;
+  g_mutex_unlock (probe_lock);
+
+  return pipeline;
+}
+
+static void
+cleanup_demux_pipeline (GstElement * pipeline)
+{
+  /* going to READY writes the index */
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+}
+
+/* do an accurate seek to @position, returns where the data after the seek
+ * starts and the number of pull requests the seek took in @pulls */
+static GstClockTime
+seek_demux (GstElement * pipeline, GstElement * demux, GstClockTime position,
+    guint * pulls)
+{
+  GstClockTime result;
+
+  g_mutex_lock (probe_lock);
+  have_newsegment = FALSE;
+  first_position = GST_CLOCK_TIME_NONE;
+  g_mutex_unlock (probe_lock);
+
+  fail_unless (gst_element_seek_simple (pipeline, GST_FORMAT_TIME,
+          GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE, position));
+
+  g_mutex_lock (probe_lock);
+  while (!GST_CLOCK_TIME_IS_VALID (first_position))
+    g_cond_wait (probe_cond, probe_lock);
+  result = first_position;
+  g_mutex_unlock (probe_lock);
+
+  g_object_get (demux, "seek-pulls", pulls, NULL);
+  GST_INFO ("seek to %" GST_TIME_FORMAT " landed at %" GST_TIME_FORMAT
+      " with %u pulls", GST_TIME_ARGS (position), GST_TIME_ARGS (result),
+      *pulls);
+
+  return result;
+}
+
+/* the data after an accurate seek must start on the page before the target,
+ * a page of our test files is well below a second */
+#define fail_unless_landed_at(result, position)                         \
+G_STMT_START {                                                          \
+  fail_unless ((result) <= (position), "landed at %" GST_TIME_FORMAT    \
+      " after %" GST_TIME_FORMAT, GST_TIME_ARGS (result),               \
+      GST_TIME_ARGS (position));                                        \
+  fail_unless ((result) + GST_SECOND > (position), "landed at %"        \
+      GST_TIME_FORMAT " too far before %" GST_TIME_FORMAT,              \
+      GST_TIME_ARGS (result), GST_TIME_ARGS (position));                \
+} G_STMT_END
+
+/* oggdemux only pushes the packets of a page once it knows their granule, so
+ * the data of a chain starts at the end of its first page */
+#define fail_unless_landed_near_start(result, position)                 \
+G_STMT_START {                                                          \
+  fail_unless ((result) >= (position) &&                                \
+      (result) < (position) + GST_SECOND, "landed at %" GST_TIME_FORMAT \
+      " not after the start at %" GST_TIME_FORMAT,                      \
+      GST_TIME_ARGS (result), GST_TIME_ARGS (position));                \
+} G_STMT_END
+
+/* bisecting a file takes about log2 (size / CHUNKSIZE) pulls, allow a few more
+ * for scanning backwards to the page before the target */
+static guint
+max_seek_pulls (const gchar * location)
+{
+  gchar *data;
+  gsize size;
+
+  fail_unless (g_file_get_contents (location, &data, &size, NULL));
+  g_free (data);
+
+  return 2 * g_bit_storage (size / 8500) + 4;
+}
+
+static void
+check_seek (GstElement * pipeline, GstElement * demux, GstClockTime position,
+    guint max_pulls)
+{
+  GstClockTime pos;
+  guint pulls;
+
+  pos = seek_demux (pipeline, demux, position, &pulls);
+  if (position <= start_position)
+    fail_unless_equals_uint64 (pos, start_position);
+  else
+    fail_unless_landed_at (pos, position);
+  fail_unless (pulls <= max_pulls, "seek to %" GST_TIME_FORMAT " did %u "
+      "pulls, expected at most %u", GST_TIME_ARGS (position), pulls,
+      max_pulls);
+}
+
+static void
+setup (void)
+{
+  probe_lock = g_mutex_new ();
+  probe_cond = g_cond_new ();
+}
+
+static void
+teardown (void)
+{
+  g_mutex_free (probe_lock);
+  g_cond_free (probe_cond);
+}
+
+GST_START_TEST (test_index_cache)
+{
+  GstElement *pipeline, *demux;
+  gchar *location, *cache_dir, *index_file;
+  guint first_pulls, cached_pulls, pulls;
+  GstClockTime target = 200 * BUFFER_DURATION, pos;
+
+  location = make_temp_name ("file");
+  cache_dir = make_temp_name ("index");
+  make_ogg_file (location, 300);
+
+  /* nothing is known about the file yet, the seek has to bisect */
+  pipeline = setup_demux_pipeline (location, cache_dir, &demux);
+  pos = seek_demux (pipeline, demux, target, &first_pulls);
+  fail_unless_landed_at (pos, target);
+  fail_unless (first_pulls > 1);
+  cleanup_demux_pipeline (pipeline);
+
+  index_file = get_index_file (cache_dir);
+  fail_unless (index_file != NULL);
+
+  /* the pages found by the first seek come from the index file now */
+  pipeline = setup_demux_pipeline (location, cache_dir, &demux);
+  pos = seek_demux (pipeline, demux, target, &cached_pulls);
+  fail_unless_landed_at (pos, target);
+  fail_unless (cached_pulls < first_pulls, "indexed seek did %u pulls, "
+      "first seek %u", cached_pulls, first_pulls);
+
+  /* seeks elsewhere still work */
+  pos = seek_demux (pipeline, demux, 5 * BUFFER_DURATION, &pulls);
+  fail_unless_landed_at (pos, 5 * BUFFER_DURATION);
+  pos = seek_demux (pipeline, demux, 290 * BUFFER_DURATION, &pulls);
+  fail_unless_landed_at (pos, 290 * BUFFER_DURATION);
+  cleanup_demux_pipeline (pipeline);
+
+  /* without a cache dir nothing is loaded */
+  pipeline = setup_demux_pipeline (location, NULL, &demux);
+  pos = seek_demux (pipeline, demux, target, &pulls);
+  fail_unless_landed_at (pos, target);
+  fail_unless_equals_int (pulls, first_pulls);
+  cleanup_demux_pipeline (pipeline);
+
+  g_unlink (location);
+  g_free (location);
+  g_free (index_file);
+  remove_dir (cache_dir);
+  g_free (cache_dir);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_index_cache_invalid)
+{
+  GstElement *pipeline, *demux;
+  gchar *location, *cache_dir, *index_file, *contents;
+  gsize size;
+  guint first_pulls, pulls;
+  GstClockTime target = 200 * BUFFER_DURATION, pos;
+
+  location = make_temp_name ("file");
+  cache_dir = make_temp_name ("index");
+  make_ogg_file (location, 300);
+
+  pipeline = setup_demux_pipeline (location, cache_dir, &demux);
+  pos = seek_demux (pipeline, demux, target, &first_pulls);
+  fail_unless_landed_at (pos, target);
+  cleanup_demux_pipeline (pipeline);
+
+  index_file = get_index_file (cache_dir);
+  fail_unless (index_file != NULL);
+  fail_unless (g_file_get_contents (index_file, &contents, &size, NULL));
+  fail_unless (size > 4 && memcmp (contents, "OGIX", 4) == 0);
+
+  /* a truncated index is ignored and the seek bisects again */
+  fail_unless (g_file_set_contents (index_file, contents, size - 1, NULL));
+  pipeline = setup_demux_pipeline (location, cache_dir, &demux);
+  pos = seek_demux (pipeline, demux, target, &pulls);
+  fail_unless_landed_at (pos, target);
+  fail_unless (pulls > 1);
+  cleanup_demux_pipeline (pipeline);
+
+  /* and is replaced by a good one */
+  g_free (contents);
+  fail_unless (g_file_get_contents (index_file, &contents, &size, NULL));
+  fail_unless (size > 4 && memcmp (contents, "OGIX", 4) == 0);
+  g_free (contents);
+  pipeline = setup_demux_pipeline (location, cache_dir, &demux);
+  pos = seek_demux (pipeline, demux, target, &pulls);
+  fail_unless_landed_at (pos, target);
+  fail_unless (pulls < first_pulls);
+  cleanup_demux_pipeline (pipeline);
+
+  /* garbage is ignored too */
+  fail_unless (g_file_set_contents (index_file, "OGIX garbage", -1, NULL));
+  pipeline = setup_demux_pipeline (location, cache_dir, &demux);
+  pos = seek_demux (pipeline, demux, target, &pulls);
+  fail_unless_landed_at (pos, target);
+  cleanup_demux_pipeline (pipeline);
+
+  /* the index of a file that changed since is not used: it is stored under
+   * another name */
+  make_ogg_file (location, 250);
+  pipeline = setup_demux_pipeline (location, cache_dir, &demux);
+  pos = seek_demux (pipeline, demux, target, &pulls);
+  fail_unless_landed_at (pos, target);
+  fail_unless (pulls > 1);
+  cleanup_demux_pipeline (pipeline);
+  fail_unless (get_index_file (cache_dir) == NULL);
+
+  g_unlink (location);
+  g_free (location);
+  g_free (index_file);
+  remove_dir (cache_dir);
+  g_free (cache_dir);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_seek_positions)
+{
+  GstElement *pipeline, *demux;
+  gchar *location;
+  guint max_pulls;
+
+  location = make_temp_name ("file");
+  make_ogg_file (location, 300);
+  max_pulls = max_seek_pulls (location);
+
+  pipeline = setup_demux_pipeline (location, NULL, &demux);
+
+  /* seeking to the start gives the same data as starting to play */
+  check_seek (pipeline, demux, 0, max_pulls);
+  check_seek (pipeline, demux, BUFFER_DURATION / 2, max_pulls);
+  check_seek (pipeline, demux, 3 * BUFFER_DURATION, max_pulls);
+
+  /* near the end, where the last page is */
+  check_seek (pipeline, demux, 299 * BUFFER_DURATION, max_pulls);
+  check_seek (pipeline, demux, 297 * BUFFER_DURATION, max_pulls);
+
+  /* forwards and backwards in the middle */
+  check_seek (pipeline, demux, 150 * BUFFER_DURATION, max_pulls);
+  check_seek (pipeline, demux, 75 * BUFFER_DURATION, max_pulls);
+  check_seek (pipeline, demux, 225 * BUFFER_DURATION, max_pulls);
+
+  /* the start once more, after the pull cache has moved on */
+  check_seek (pipeline, demux, 0, max_pulls);
+
+  cleanup_demux_pipeline (pipeline);
+
+  g_unlink (location);
+  g_free (location);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_seek_chains)
+{
+  GstElement *pipeline, *demux;
+  gchar *location, *first, *second, *data1, *data2, *data;
+  gsize size1, size2;
+  GstClockTime chain_start = 100 * BUFFER_DURATION, pos;
+  guint max_pulls, pulls;
+
+  /* two chains, of 10 and 15 seconds */
+  first = make_temp_name ("chain");
+  second = make_temp_name ("chain");
+  make_ogg_file (first, 100);
+  make_ogg_file (second, 150);
+  fail_unless (g_file_get_contents (first, &data1, &size1, NULL));
+  fail_unless (g_file_get_contents (second, &data2, &size2, NULL));
+  data = g_malloc (size1 + size2);
+  memcpy (data, data1, size1);
+  memcpy (data + size1, data2, size2);
+
+  location = make_temp_name ("file");
+  fail_unless (g_file_set_contents (location, data, size1 + size2, NULL));
+  max_pulls = max_seek_pulls (location);
+
+  pipeline = setup_demux_pipeline (location, NULL, &demux);
+
+  /* the end of the first chain and the start of the second */
+  check_seek (pipeline, demux, chain_start - BUFFER_DURATION, max_pulls);
+  pos = seek_demux (pipeline, demux, chain_start, &pulls);
+  fail_unless_landed_near_start (pos, chain_start);
+  fail_unless (pulls <= max_pulls);
+
+  /* into the second chain and back into the first one */
+  check_seek (pipeline, demux, chain_start + 20 * BUFFER_DURATION, max_pulls);
+  check_seek (pipeline, demux, 30 * BUFFER_DURATION, max_pulls);
+  check_seek (pipeline, demux, 0, max_pulls);
+
+  /* near the end of the last chain */
+  check_seek (pipeline, demux, chain_start + 149 * BUFFER_DURATION,
+      max_pulls);
+
+  cleanup_demux_pipeline (pipeline);
+
+  g_unlink (first);
+  g_unlink (second);
+  g_unlink (location);
+  g_free (first);
+  g_free (second);
+  g_free (location);
+  g_free (data1);
+  g_free (data2);
+  g_free (data);
+}
+
+GST_END_TEST;
+
+#endif /* HAVE_VORBIS */
+
+static Suite *
+oggdemux_suite (void)
+{
+  Suite *s = suite_create ("oggdemux");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+#ifdef HAVE_VORBIS
+  tcase_add_checked_fixture (tc_chain, setup, teardown);
+  tcase_add_test (tc_chain, test_index_cache);
+  tcase_add_test (tc_chain, test_index_cache_invalid);
+  tcase_add_test (tc_chain, test_seek_positions);
+  tcase_add_test (tc_chain, test_seek_chains);
+#endif
+
+  return s;
+}
+
+GST_CHECK_MAIN (oggdemux);
@@ -321,6 +321,316 @@ GST_START_TEST (test_vorbis)
 
 GST_END_TEST;
 
+/* what oggmux pushed in a run of run_page_pipeline() */
+typedef struct
+{
+  GMutex *lock;
+  GCond *cond;
+  gboolean eos;
+  GList *pages;                 /* all pages in push order */
+  GList *lists;                 /* the buffer lists pages came in */
+  guint n_pushes;               /* pages pushed outside of a list */
+  guint n_packets;              /* data packets the encoder produced */
+} PageRun;
+
+static GstFlowReturn
+page_run_chain (GstPad * pad, GstBuffer * buffer)
+{
+  PageRun *run = gst_pad_get_element_private (pad);
+
+  g_mutex_lock (run->lock);
+  run->pages = g_list_append (run->pages, buffer);
+  run->n_pushes++;
+  g_mutex_unlock (run->lock);
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+page_run_chain_list (GstPad * pad, GstBufferList * list)
+{
+  PageRun *run = gst_pad_get_element_private (pad);
+  GstBufferListIterator *it;
+  GstBuffer *buf;
+
+  g_mutex_lock (run->lock);
+  it = gst_buffer_list_iterate (list);
+  while (gst_buffer_list_iterator_next_group (it)) {
+    while ((buf = gst_buffer_list_iterator_next (it)))
+      run->pages = g_list_append (run->pages, gst_buffer_ref (buf));
+  }
+  gst_buffer_list_iterator_free (it);
+  run->lists = g_list_append (run->lists, list);
+  g_mutex_unlock (run->lock);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+page_run_event (GstPad * pad, GstEvent * event)
+{
+  PageRun *run = gst_pad_get_element_private (pad);
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_EOS) {
+    g_mutex_lock (run->lock);
+    run->eos = TRUE;
+    g_cond_signal (run->cond);
+    g_mutex_unlock (run->lock);
+  }
+  gst_event_unref (event);
+
+  return TRUE;
+}
+
+static gboolean
+count_packets_probe (GstPad * pad, GstBuffer * buffer, PageRun * run)
+{
+  if (!GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_IN_CAPS))
+    run->n_packets++;
+
+  return TRUE;
+}
+
+/* run @pipeline, which has an encoder named enc and an oggmux named mux, to
+ * EOS and collect what the muxer pushes */
+static void
+run_page_pipeline (const gchar * pipeline, PageRun * run)
+{
+  GstElement *bin, *mux, *enc;
+  GstPad *srcpad, *sinkpad, *encpad;
+  GError *error = NULL;
+
+  memset (run, 0, sizeof (PageRun));
+  run->lock = g_mutex_new ();
+  run->cond = g_cond_new ();
+
+  bin = gst_parse_launch (pipeline, &error);
+  fail_unless (bin != NULL, "Error parsing pipeline: %s",
+      error ? error->message : "(invalid error)");
+  mux = gst_bin_get_by_name (GST_BIN (bin), "mux");
+  enc = gst_bin_get_by_name (GST_BIN (bin), "enc");
+  fail_unless (mux != NULL && enc != NULL);
+
+  sinkpad = gst_pad_new ("sink", GST_PAD_SINK);
+  gst_pad_set_element_private (sinkpad, run);
+  gst_pad_set_chain_function (sinkpad, page_run_chain);
+  gst_pad_set_chain_list_function (sinkpad, page_run_chain_list);
+  gst_pad_set_event_function (sinkpad, page_run_event);
+  gst_pad_set_active (sinkpad, TRUE);
+
+  srcpad = gst_element_get_static_pad (mux, "src");
+  fail_unless (gst_pad_link (srcpad, sinkpad) == GST_PAD_LINK_OK);
+
+  encpad = gst_element_get_static_pad (enc, "src");
+  gst_pad_add_buffer_probe (encpad, G_CALLBACK (count_packets_probe), run);
+
+  fail_if (gst_element_set_state (bin, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE, "Could not start test pipeline");
+
+  g_mutex_lock (run->lock);
+  while (!run->eos)
+    g_cond_wait (run->cond, run->lock);
+  g_mutex_unlock (run->lock);
+
+  gst_element_set_state (bin, GST_STATE_NULL);
+  gst_pad_unlink (srcpad, sinkpad);
+  gst_pad_set_active (sinkpad, FALSE);
+
+  gst_object_unref (encpad);
+  gst_object_unref (srcpad);
+  gst_object_unref (sinkpad);
+  gst_object_unref (enc);
+  gst_object_unref (mux);
+  gst_object_unref (bin);
+}
+
+static void
+free_page_run (PageRun * run)
+{
+  g_list_foreach (run->pages, (GFunc) gst_mini_object_unref, NULL);
+  g_list_free (run->pages);
+  g_list_foreach (run->lists, (GFunc) gst_mini_object_unref, NULL);
+  g_list_free (run->lists);
+  g_mutex_free (run->lock);
+  g_cond_free (run->cond);
+}
+
+/* check that @buffer holds exactly one page and return some of its fields */
+static void
+parse_page_buffer (GstBuffer * buffer, gint * packets, gint64 * granulepos,
+    gboolean * continued, gboolean * eos)
+{
+  ogg_sync_state sync;
+  ogg_page page;
+  gchar *data;
+
+  ogg_sync_init (&sync);
+  data = ogg_sync_buffer (&sync, GST_BUFFER_SIZE (buffer));
+  memcpy (data, GST_BUFFER_DATA (buffer), GST_BUFFER_SIZE (buffer));
+  ogg_sync_wrote (&sync, GST_BUFFER_SIZE (buffer));
+
+  fail_unless (ogg_sync_pageout (&sync, &page) == 1);
+  fail_unless_equals_int (page.header_len + page.body_len,
+      GST_BUFFER_SIZE (buffer));
+
+  *packets = ogg_page_packets (&page);
+  *granulepos = ogg_page_granulepos (&page);
+  *continued = ogg_page_continued (&page);
+  *eos = ogg_page_eos (&page);
+
+  ogg_sync_clear (&sync);
+}
+
+/* returns the number of pages that are not headers, and checks that only the
+ * last page has the EOS flag */
+static guint
+count_data_pages (GList * pages, gint max_packets)
+{
+  GList *walk;
+  guint n_pages = 0;
+
+  for (walk = pages; walk; walk = walk->next) {
+    GstBuffer *buf = walk->data;
+    gint packets;
+    gint64 granulepos;
+    gboolean continued, eos;
+
+    parse_page_buffer (buf, &packets, &granulepos, &continued, &eos);
+    fail_unless (eos == (walk->next == NULL));
+
+    if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_IN_CAPS))
+      continue;
+
+    if (max_packets > 0) {
+      fail_unless (packets <= max_packets, "page has %d packets", packets);
+      fail_if (continued, "page continues a packet");
+    }
+    n_pages++;
+  }
+  return n_pages;
+}
+
+GST_START_TEST (test_vorbis_low_latency)
+{
+  PageRun run;
+  guint n_pages;
+
+  test_pipeline
+      ("audiotestsrc num-buffers=5 ! audioconvert ! vorbisenc ! "
+      "oggmux low-latency=true");
+
+  /* every packet is flushed out on a page of its own */
+  run_page_pipeline ("audiotestsrc num-buffers=20 ! audioconvert ! "
+      "vorbisenc name=enc ! oggmux name=mux low-latency=true", &run);
+  n_pages = count_data_pages (run.pages, 1);
+  fail_unless (run.n_packets > 1);
+  fail_unless_equals_int (n_pages, run.n_packets);
+  free_page_run (&run);
+
+  /* while pages normally collect several packets */
+  run_page_pipeline ("audiotestsrc num-buffers=20 ! audioconvert ! "
+      "vorbisenc name=enc ! oggmux name=mux", &run);
+  n_pages = count_data_pages (run.pages, 0);
+  fail_unless (n_pages < run.n_packets, "%u pages for %u packets", n_pages,
+      run.n_packets);
+  free_page_run (&run);
+}
+
+GST_END_TEST;
+
+#define LIST_PAGE_DELAY (100 * GST_MSECOND)
+
+static void
+run_buffer_list_pipeline (gboolean buffer_list, PageRun * run)
+{
+  gchar *desc;
+
+  desc = g_strdup_printf ("audiotestsrc num-buffers=100 ! audioconvert ! "
+      "vorbisenc name=enc ! oggmux name=mux max-page-delay=%" G_GUINT64_FORMAT
+      " buffer-list=%s", LIST_PAGE_DELAY, buffer_list ? "true" : "false");
+  run_page_pipeline (desc, run);
+  g_free (desc);
+}
+
+GST_START_TEST (test_vorbis_buffer_list)
+{
+  PageRun run, ref;
+  GList *walk, *ref_walk;
+  guint n_lists = 0;
+
+  run_buffer_list_pipeline (TRUE, &run);
+
+  /* everything comes in lists with a group per page */
+  fail_unless_equals_int (run.n_pushes, 0);
+  fail_unless (g_list_length (run.lists) > 2);
+
+  for (walk = run.lists; walk; walk = walk->next, n_lists++) {
+    GstBufferListIterator *it;
+    GstBuffer *buf, *first = NULL, *last = NULL, *prev = NULL;
+
+    it = gst_buffer_list_iterate (walk->data);
+    while (gst_buffer_list_iterator_next_group (it)) {
+      fail_unless_equals_int (gst_buffer_list_iterator_n_buffers (it), 1);
+      buf = gst_buffer_list_iterator_next (it);
+
+      /* the headers are pushed in a list of their own */
+      fail_unless (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_IN_CAPS) ==
+          (n_lists == 0));
+
+      if (first == NULL)
+        first = buf;
+      prev = last;
+      last = buf;
+    }
+    gst_buffer_list_iterator_free (it);
+    fail_unless (first != NULL);
+
+    if (n_lists == 0 || walk->next == NULL)
+      continue;
+
+    /* a list is pushed as soon as its pages span max-page-delay, only the
+     * last list at EOS can be shorter */
+    fail_unless (GST_BUFFER_TIMESTAMP (last) - GST_BUFFER_TIMESTAMP (first) >=
+        LIST_PAGE_DELAY);
+    if (prev != NULL)
+      fail_unless (GST_BUFFER_TIMESTAMP (prev) -
+          GST_BUFFER_TIMESTAMP (first) < LIST_PAGE_DELAY);
+  }
+
+  /* the pages themselves are the same as without lists */
+  run_buffer_list_pipeline (FALSE, &ref);
+
+  fail_unless (ref.lists == NULL);
+  fail_unless_equals_int (g_list_length (run.pages), g_list_length (ref.pages));
+  fail_unless_equals_int (count_data_pages (run.pages, 0),
+      count_data_pages (ref.pages, 0));
+
+  for (walk = run.pages, ref_walk = ref.pages; walk;
+      walk = walk->next, ref_walk = ref_walk->next) {
+    GstBuffer *buf = walk->data, *ref_buf = ref_walk->data;
+    gint packets, ref_packets;
+    gint64 granulepos, ref_granulepos;
+    gboolean continued, eos;
+
+    parse_page_buffer (buf, &packets, &granulepos, &continued, &eos);
+    parse_page_buffer (ref_buf, &ref_packets, &ref_granulepos, &continued,
+        &eos);
+
+    fail_unless_equals_int (GST_BUFFER_SIZE (buf), GST_BUFFER_SIZE (ref_buf));
+    fail_unless_equals_int (packets, ref_packets);
+    fail_unless_equals_uint64 (granulepos, ref_granulepos);
+    fail_unless_equals_uint64 (GST_BUFFER_TIMESTAMP (buf),
+        GST_BUFFER_TIMESTAMP (ref_buf));
+    fail_unless_equals_uint64 (GST_BUFFER_OFFSET_END (buf),
+        GST_BUFFER_OFFSET_END (ref_buf));
+  }
+
+  free_page_run (&run);
+  free_page_run (&ref);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_vorbis_oggmux_unlinked)
 {
   GstElement *pipe;
@@ -412,6 +722,8 @@ oggmux_suite (void)
   suite_add_tcase (s, tc_chain);
 #ifdef HAVE_VORBIS
   tcase_add_test (tc_chain, test_vorbis);
+  tcase_add_test (tc_chain, test_vorbis_low_latency);
+  tcase_add_test (tc_chain, test_vorbis_buffer_list);
   tcase_add_test (tc_chain, test_vorbis_oggmux_unlinked);
 #endif
 
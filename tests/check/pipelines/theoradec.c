@@ -0,0 +1,310 @@
+/* GStreamer
+ *
+ * unit test for theoradec
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <string.h>
+
+#include <gst/check/gstcheck.h>
+
+#ifndef GST_DISABLE_PARSE
+
+static GstPad *mysrcpad, *mysinkpad;
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-theora")
+    );
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw-yuv")
+    );
+
+static void
+handoff (GstElement * sink, GstBuffer * buffer, GstPad * pad, GList ** list)
+{
+  *list = g_list_append (*list, gst_buffer_ref (buffer));
+}
+
+/* run the @n_frames frames of the videotestsrc @pattern through @filter and
+ * return what comes out in a list */
+static GList *
+capture_stream (gint width, gint height, const gchar * pattern, gint n_frames,
+    const gchar * filter)
+{
+  GstElement *bin, *sink;
+  GstMessage *msg;
+  GList *list = NULL;
+  gchar *desc;
+
+  desc = g_strdup_printf ("videotestsrc num-buffers=%d pattern=%s ! "
+      "video/x-raw-yuv,format=(fourcc)I420,width=%d,height=%d,"
+      "framerate=25/1 ! %s ! fakesink name=sink signal-handoffs=true",
+      n_frames, pattern, width, height, filter);
+  bin = gst_parse_launch (desc, NULL);
+  fail_unless (bin != NULL, "could not create pipeline %s", desc);
+  g_free (desc);
+
+  sink = gst_bin_get_by_name (GST_BIN (bin), "sink");
+  g_signal_connect (sink, "handoff", G_CALLBACK (handoff), &list);
+  gst_object_unref (sink);
+
+  fail_unless (gst_element_set_state (bin, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+  msg = gst_bus_timed_pop_filtered (GST_ELEMENT_BUS (bin), -1,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+
+  fail_unless (gst_element_set_state (bin, GST_STATE_NULL) ==
+      GST_STATE_CHANGE_SUCCESS);
+  gst_object_unref (bin);
+
+  return list;
+}
+
+/* encode @n_frames of the videotestsrc @pattern, returns the headers and
+ * frames in a list */
+static GList *
+encode_stream (gint width, gint height, const gchar * pattern, gint n_frames)
+{
+  GList *list;
+
+  list = capture_stream (width, height, pattern, n_frames, "theoraenc");
+
+  /* three headers and the frames */
+  fail_unless_equals_int (g_list_length (list), 3 + n_frames);
+
+  return list;
+}
+
+/* the raw frames that encode_stream() encodes */
+static GList *
+source_frames (gint width, gint height, const gchar * pattern, gint n_frames)
+{
+  GList *list;
+
+  list = capture_stream (width, height, pattern, n_frames, "identity");
+  fail_unless_equals_int (g_list_length (list), n_frames);
+
+  return list;
+}
+
+static void
+free_stream (GList * list)
+{
+  g_list_foreach (list, (GFunc) gst_mini_object_unref, NULL);
+  g_list_free (list);
+}
+
+static void
+drop_buffers (void)
+{
+  g_list_foreach (buffers, (GFunc) gst_mini_object_unref, NULL);
+  g_list_free (buffers);
+  buffers = NULL;
+}
+
+static GstElement *
+setup_theoradec (void)
+{
+  GstElement *theoradec;
+
+  theoradec = gst_check_setup_element ("theoradec");
+  mysrcpad = gst_check_setup_src_pad (theoradec, &srctemplate, NULL);
+  mysinkpad = gst_check_setup_sink_pad (theoradec, &sinktemplate, NULL);
+  gst_pad_set_active (mysrcpad, TRUE);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  fail_unless (gst_element_set_state (theoradec,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  return theoradec;
+}
+
+static void
+cleanup_theoradec (GstElement * theoradec)
+{
+  fail_unless (gst_element_set_state (theoradec,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+
+  drop_buffers ();
+  gst_pad_set_active (mysrcpad, FALSE);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_check_teardown_src_pad (theoradec);
+  gst_check_teardown_sink_pad (theoradec);
+  gst_check_teardown_element (theoradec);
+}
+
+static void
+push_buffers (GList * list)
+{
+  for (; list; list = list->next) {
+    fail_unless (gst_pad_push (mysrcpad,
+            gst_buffer_ref (GST_BUFFER_CAST (list->data))) == GST_FLOW_OK);
+  }
+}
+
+/* compare every row of a decoded plane with the source. Coding artefacts
+ * average out over a row, rows that end up in the wrong place or are not
+ * written at all do not. */
+static void
+check_plane (const guint8 * data, const guint8 * ref, gint width, gint height,
+    gint stride)
+{
+  gint x, y;
+
+  for (y = 0; y < height; y++) {
+    gint diff = 0;
+
+    for (x = 0; x < width; x++)
+      diff += ABS (data[y * stride + x] - ref[y * stride + x]);
+
+    fail_unless (diff / width <= 8, "row %d differs by %d on average", y,
+        diff / width);
+  }
+}
+
+/* check the decoded frames in @frames against the I420 frames in @ref */
+static void
+check_frames (GList * frames, GList * ref, gint width, gint height)
+{
+  gint cwidth = GST_ROUND_UP_2 (width) / 2;
+  gint cheight = GST_ROUND_UP_2 (height) / 2;
+  gint ystride = GST_ROUND_UP_4 (width);
+  gint cstride = GST_ROUND_UP_4 (cwidth);
+  gint uoffset = ystride * GST_ROUND_UP_2 (height);
+  gint voffset = uoffset + cstride * cheight;
+
+  fail_unless_equals_int (g_list_length (frames), g_list_length (ref));
+
+  for (; frames; frames = frames->next, ref = ref->next) {
+    GstBuffer *buffer = GST_BUFFER_CAST (frames->data);
+    GstBuffer *ref_buffer = GST_BUFFER_CAST (ref->data);
+    const guint8 *data = GST_BUFFER_DATA (buffer);
+    const guint8 *ref_data = GST_BUFFER_DATA (ref_buffer);
+
+    fail_unless_equals_int (GST_BUFFER_SIZE (buffer),
+        GST_BUFFER_SIZE (ref_buffer));
+
+    check_plane (data, ref_data, width, height, ystride);
+    check_plane (data + uoffset, ref_data + uoffset, cwidth, cheight,
+        cstride);
+    check_plane (data + voffset, ref_data + voffset, cwidth, cheight,
+        cstride);
+  }
+}
+
+/* the size is not a multiple of 16, so the decoder has to crop the frame.
+ * The checkers change every 8 rows and columns, so rows copied to the wrong
+ * place or left out show up. */
+GST_START_TEST (test_decode_crop)
+{
+  GstElement *theoradec;
+  GList *stream, *ref;
+  gint width = 172, height = 140;
+
+  stream = encode_stream (width, height, "checkers-8", 3);
+  ref = source_frames (width, height, "checkers-8", 3);
+  theoradec = setup_theoradec ();
+
+  push_buffers (stream);
+  check_frames (buffers, ref, width, height);
+
+  cleanup_theoradec (theoradec);
+  free_stream (stream);
+  free_stream (ref);
+}
+
+GST_END_TEST;
+
+/* a frame of many stripes, decoded again after a flush must give the same
+ * output */
+GST_START_TEST (test_decode_flush)
+{
+  GstElement *theoradec;
+  GList *stream, *ref, *frames, *first, *walk, *fwalk;
+  gint width = 640, height = 360, n_frames = 5;
+  gint i;
+
+  stream = encode_stream (width, height, "smpte", n_frames);
+  ref = source_frames (width, height, "smpte", n_frames);
+  frames = g_list_nth (stream, 3);
+  theoradec = setup_theoradec ();
+
+  /* the headers */
+  for (i = 0; i < 3; i++) {
+    fail_unless (gst_pad_push (mysrcpad,
+            gst_buffer_ref (g_list_nth_data (stream, i))) == GST_FLOW_OK);
+  }
+
+  push_buffers (frames);
+  check_frames (buffers, ref, width, height);
+  first = buffers;
+  buffers = NULL;
+
+  /* the stream starts with a keyframe, so we can decode it again */
+  for (i = 0; i < 2; i++) {
+    fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_flush_start ()));
+    fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_flush_stop ()));
+
+    push_buffers (frames);
+    fail_unless_equals_int (g_list_length (buffers), n_frames);
+    for (walk = buffers, fwalk = first; walk;
+        walk = walk->next, fwalk = fwalk->next) {
+      GstBuffer *buf = GST_BUFFER_CAST (walk->data);
+      GstBuffer *fbuf = GST_BUFFER_CAST (fwalk->data);
+
+      fail_unless_equals_int (GST_BUFFER_SIZE (buf), GST_BUFFER_SIZE (fbuf));
+      fail_unless (memcmp (GST_BUFFER_DATA (buf), GST_BUFFER_DATA (fbuf),
+              GST_BUFFER_SIZE (buf)) == 0);
+    }
+    drop_buffers ();
+  }
+
+  free_stream (first);
+  cleanup_theoradec (theoradec);
+  free_stream (stream);
+  free_stream (ref);
+}
+
+GST_END_TEST;
+
+#endif /* #ifndef GST_DISABLE_PARSE */
+
+static Suite *
+theoradec_suite (void)
+{
+  Suite *s = suite_create ("theoradec");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+
+#ifndef GST_DISABLE_PARSE
+  tcase_add_test (tc_chain, test_decode_crop);
+  tcase_add_test (tc_chain, test_decode_flush);
+#endif
+
+  return s;
+}
+
+GST_CHECK_MAIN (theoradec);
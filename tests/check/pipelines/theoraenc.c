@@ -422,6 +422,74 @@ GST_START_TEST (test_discontinuity)
 
 GST_END_TEST;
 
+#define PARALLEL_GOP_LENGTH 8
+#define PARALLEL_NUM_GOPS 5
+
+GST_START_TEST (test_parallel)
+{
+  GstElement *bin;
+  GstPad *pad;
+  gchar *pipe_str;
+  GstBuffer *buffer;
+  GError *error = NULL;
+  gint i;
+
+  /* GOPs of 8 frames, 4 of them encoded at the same time */
+  pipe_str = g_strdup_printf ("videotestsrc num-buffers=%d"
+      " ! video/x-raw-yuv,format=(fourcc)I420,framerate=10/1"
+      " ! theoraenc threads=4 keyframe-auto=false keyframe-freq=%d"
+      " ! fakesink name=fs0", PARALLEL_GOP_LENGTH * PARALLEL_NUM_GOPS,
+      PARALLEL_GOP_LENGTH);
+
+  bin = gst_parse_launch (pipe_str, &error);
+  fail_unless (bin != NULL, "Error parsing pipeline: %s",
+      error ? error->message : "(invalid error)");
+  g_free (pipe_str);
+
+  /* get the pad */
+  {
+    GstElement *sink = gst_bin_get_by_name (GST_BIN (bin), "fs0");
+
+    fail_unless (sink != NULL, "Could not get fakesink out of bin");
+    pad = gst_element_get_static_pad (sink, "sink");
+    fail_unless (pad != NULL, "Could not get pad out of fakesink");
+    gst_object_unref (sink);
+  }
+
+  gst_buffer_straw_start_pipeline (bin, pad);
+
+  /* header packets */
+  for (i = 0; i < 3; i++) {
+    buffer = gst_buffer_straw_get_buffer (bin, pad);
+    check_buffer_granulepos (buffer, 0);
+    check_buffer_is_header (buffer, TRUE);
+    gst_buffer_unref (buffer);
+  }
+
+  /* the GOPs come out in order, each starting with a keyframe, as if they
+   * were encoded by a single encoder */
+  for (i = 0; i < PARALLEL_GOP_LENGTH * PARALLEL_NUM_GOPS; i++) {
+    gint keyframe = i - i % PARALLEL_GOP_LENGTH;
+
+    buffer = gst_buffer_straw_get_buffer (bin, pad);
+    check_buffer_timestamp (buffer, i * GST_SECOND / 10);
+    check_buffer_granulepos (buffer,
+        ((keyframe + 1) << GRANULEPOS_SHIFT) | (i - keyframe));
+    check_buffer_is_header (buffer, FALSE);
+    fail_unless (GST_BUFFER_FLAG_IS_SET (buffer,
+            GST_BUFFER_FLAG_DELTA_UNIT) == (i != keyframe));
+    fail_if (GST_BUFFER_IS_DISCONT (buffer));
+    gst_buffer_unref (buffer);
+  }
+
+  gst_buffer_straw_stop_pipeline (bin, pad);
+
+  gst_object_unref (pad);
+  gst_object_unref (bin);
+}
+
+GST_END_TEST;
+
 #endif /* #ifndef GST_DISABLE_PARSE */
 
 static Suite *
@@ -438,6 +506,7 @@ theoraenc_suite (void)
   tcase_add_test (tc_chain, test_granulepos_offset);
   tcase_add_test (tc_chain, test_continuity);
   tcase_add_test (tc_chain, test_discontinuity);
+  tcase_add_test (tc_chain, test_parallel);
 #endif
 
   return s;
@@ -20,6 +20,8 @@
  * Boston, MA 02111-1307, USA.
  */
 
+#include <math.h>
+
 #include <gst/check/gstcheck.h>
 #include <gst/check/gstbufferstraw.h>
 
@@ -365,8 +367,366 @@ GST_START_TEST (test_discontinuity)
 
 GST_END_TEST;
 
+static void
+multi_handoff (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    GList ** list)
+{
+  *list = g_list_append (*list, gst_buffer_ref (buffer));
+}
+
+/* check the headers and the granulepos of one vorbismultienc stream and
+ * return the size of the audio packets */
+static guint
+check_multi_stream (GList * list, guint64 n_samples)
+{
+  guint64 last_granulepos = 0;
+  guint size = 0;
+  gint i;
+
+  fail_unless (g_list_length (list) > 3);
+  for (i = 0; i < 3; i++) {
+    GstBuffer *buffer = GST_BUFFER_CAST (list->data);
+
+    fail_unless (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_IN_CAPS),
+        "header %d is not in the caps", i);
+    list = list->next;
+  }
+
+  for (; list; list = list->next) {
+    GstBuffer *buffer = GST_BUFFER_CAST (list->data);
+
+    fail_if (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_IN_CAPS));
+    fail_unless (GST_BUFFER_OFFSET_END (buffer) >= last_granulepos);
+    last_granulepos = GST_BUFFER_OFFSET_END (buffer);
+    size += GST_BUFFER_SIZE (buffer);
+  }
+  fail_unless_equals_uint64 (last_granulepos, n_samples);
+
+  return size;
+}
+
+GST_START_TEST (test_multi_quality)
+{
+  GstElement *bin, *sink;
+  GstMessage *msg;
+  GList *low = NULL, *high = NULL;
+  guint low_size, high_size;
+
+  bin = gst_parse_launch ("audiotestsrc wave=white-noise num-buffers=20 "
+      "samplesperbuffer=1024 ! audio/x-raw-float,rate=44100,channels=2 ! "
+      "vorbismultienc name=enc qualities=\"0.1,0.9\" "
+      "enc.src_0 ! fakesink name=low signal-handoffs=true "
+      "enc.src_1 ! fakesink name=high signal-handoffs=true", NULL);
+  fail_unless (bin != NULL, "could not create pipeline");
+
+  sink = gst_bin_get_by_name (GST_BIN (bin), "low");
+  g_signal_connect (sink, "handoff", G_CALLBACK (multi_handoff), &low);
+  gst_object_unref (sink);
+  sink = gst_bin_get_by_name (GST_BIN (bin), "high");
+  g_signal_connect (sink, "handoff", G_CALLBACK (multi_handoff), &high);
+  gst_object_unref (sink);
+
+  fail_unless (gst_element_set_state (bin, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+  msg = gst_bus_timed_pop_filtered (GST_ELEMENT_BUS (bin), -1,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+
+  fail_unless (gst_element_set_state (bin, GST_STATE_NULL) ==
+      GST_STATE_CHANGE_SUCCESS);
+  gst_object_unref (bin);
+
+  /* both streams contain all the samples, the higher quality needs more
+   * bits for the noise */
+  low_size = check_multi_stream (low, 20 * 1024);
+  high_size = check_multi_stream (high, 20 * 1024);
+  fail_unless (high_size > low_size, "%u <= %u", high_size, low_size);
+
+  g_list_foreach (low, (GFunc) gst_mini_object_unref, NULL);
+  g_list_free (low);
+  g_list_foreach (high, (GFunc) gst_mini_object_unref, NULL);
+  g_list_free (high);
+}
+
+GST_END_TEST;
+
 #endif /* #ifndef GST_DISABLE_PARSE */
 
+#define MULTI_RATE 44100
+#define MULTI_SAMPLES 1024
+
+static GstPad *multi_srcpad, *multi_sinkpad;
+static GstCaps *multi_caps;
+
+static GstClockTime
+samples_to_time (guint64 samples)
+{
+  return gst_util_uint64_scale_int (samples, GST_SECOND, MULTI_RATE);
+}
+
+static void
+push_multi_newsegment (void)
+{
+  fail_unless (gst_pad_push_event (multi_srcpad,
+          gst_event_new_new_segment (FALSE, 1.0, GST_FORMAT_TIME, 0, -1, 0)));
+}
+
+/* a vorbismultienc with one stream, fed mono float from multi_srcpad and
+ * pushing into the global buffers list */
+static GstElement *
+setup_vorbismultienc (void)
+{
+  GstElement *enc;
+  GstPad *pad;
+
+  enc = gst_check_setup_element ("vorbismultienc");
+
+  multi_srcpad = gst_pad_new ("src", GST_PAD_SRC);
+  pad = gst_element_get_static_pad (enc, "sink");
+  fail_unless (gst_pad_link (multi_srcpad, pad) == GST_PAD_LINK_OK);
+  gst_object_unref (pad);
+
+  multi_sinkpad = gst_pad_new ("sink", GST_PAD_SINK);
+  gst_pad_set_chain_function (multi_sinkpad, gst_check_chain_func);
+  pad = gst_element_get_static_pad (enc, "src_0");
+  fail_unless (pad != NULL);
+  fail_unless (gst_pad_link (pad, multi_sinkpad) == GST_PAD_LINK_OK);
+  gst_object_unref (pad);
+
+  gst_pad_set_active (multi_srcpad, TRUE);
+  gst_pad_set_active (multi_sinkpad, TRUE);
+
+  fail_unless (gst_element_set_state (enc, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_SUCCESS, "could not set to playing");
+
+  multi_caps = gst_caps_new_simple ("audio/x-raw-float",
+      "rate", G_TYPE_INT, MULTI_RATE, "channels", G_TYPE_INT, 1,
+      "endianness", G_TYPE_INT, G_BYTE_ORDER, "width", G_TYPE_INT, 32, NULL);
+  push_multi_newsegment ();
+
+  return enc;
+}
+
+static void
+cleanup_vorbismultienc (GstElement * enc)
+{
+  fail_unless (gst_element_set_state (enc, GST_STATE_NULL) ==
+      GST_STATE_CHANGE_SUCCESS, "could not set to null");
+
+  gst_check_drop_buffers ();
+  gst_caps_unref (multi_caps);
+  gst_pad_set_active (multi_srcpad, FALSE);
+  gst_pad_set_active (multi_sinkpad, FALSE);
+  gst_pad_unlink (multi_srcpad, GST_PAD_PEER (multi_srcpad));
+  gst_pad_unlink (GST_PAD_PEER (multi_sinkpad), multi_sinkpad);
+  gst_object_unref (multi_srcpad);
+  gst_object_unref (multi_sinkpad);
+  gst_check_teardown_element (enc);
+}
+
+/* push @n_buffers of MULTI_SAMPLES samples of a sine, starting at
+ * @timestamp */
+static void
+push_multi_samples (GstClockTime timestamp, gint n_buffers, gboolean discont)
+{
+  gint i, j;
+
+  for (i = 0; i < n_buffers; i++) {
+    GstBuffer *buffer;
+    gfloat *data;
+
+    buffer = gst_buffer_new_and_alloc (MULTI_SAMPLES * sizeof (gfloat));
+    data = (gfloat *) GST_BUFFER_DATA (buffer);
+    for (j = 0; j < MULTI_SAMPLES; j++)
+      data[j] = 0.5 * sin ((i * MULTI_SAMPLES + j) * 0.05);
+
+    GST_BUFFER_TIMESTAMP (buffer) = timestamp +
+        samples_to_time (i * MULTI_SAMPLES);
+    GST_BUFFER_DURATION (buffer) = samples_to_time (MULTI_SAMPLES);
+    if (discont && i == 0)
+      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+    gst_buffer_set_caps (buffer, multi_caps);
+
+    fail_unless_equals_int (gst_pad_push (multi_srcpad, buffer), GST_FLOW_OK);
+  }
+}
+
+static void
+flush_multi (void)
+{
+  fail_unless (gst_pad_push_event (multi_srcpad,
+          gst_event_new_flush_start ()));
+  fail_unless (gst_pad_push_event (multi_srcpad, gst_event_new_flush_stop ()));
+  push_multi_newsegment ();
+}
+
+/* skip the three headers at the start of @list and the packets after them,
+ * returns the rest of the list. The last packet must have @granulepos when it
+ * is not -1. */
+static GList *
+check_multi_headers (GList * list, gint64 granulepos)
+{
+  GstBuffer *buffer = NULL;
+  gint i;
+
+  for (i = 0; i < 3; i++) {
+    fail_unless (list != NULL);
+    fail_unless (GST_BUFFER_FLAG_IS_SET (list->data, GST_BUFFER_FLAG_IN_CAPS),
+        "header %d is not in the caps", i);
+    list = list->next;
+  }
+  for (; list; list = list->next) {
+    if (GST_BUFFER_FLAG_IS_SET (list->data, GST_BUFFER_FLAG_IN_CAPS))
+      break;
+    buffer = list->data;
+  }
+  fail_unless (buffer != NULL);
+  if (granulepos != -1)
+    fail_unless_equals_uint64 (GST_BUFFER_OFFSET_END (buffer), granulepos);
+
+  return list;
+}
+
+/* check one complete stream of @n_samples at the start of @list, which
+ * starts at @start and ends at @end, and return the rest of the list */
+static GList *
+check_multi_enc_stream (GList * list, guint64 n_samples, GstClockTime start,
+    GstClockTime end, gint n_discont)
+{
+  GstBuffer *buffer = NULL;
+  guint64 last_granulepos = 0;
+  GList *rest, *walk;
+
+  rest = check_multi_headers (list, n_samples);
+  walk = g_list_nth (list, 3);
+
+  fail_unless_equals_uint64 (GST_BUFFER_TIMESTAMP (walk->data), start);
+  for (; walk != rest; walk = walk->next) {
+    buffer = walk->data;
+
+    fail_unless (GST_BUFFER_OFFSET_END (buffer) >= last_granulepos);
+    last_granulepos = GST_BUFFER_OFFSET_END (buffer);
+    if (GST_BUFFER_FLAG_IS_SET (buffer, GST_BUFFER_FLAG_DISCONT))
+      n_discont--;
+  }
+  fail_unless_equals_int (n_discont, 0);
+  fail_unless_equals_uint64 (GST_BUFFER_TIMESTAMP (buffer) +
+      GST_BUFFER_DURATION (buffer), end);
+
+  return rest;
+}
+
+/* EOS ends the stream, after a flush a new one starts with new headers */
+GST_START_TEST (test_multi_eos_restart)
+{
+  GstElement *enc;
+  GList *rest;
+  guint n_first;
+
+  enc = setup_vorbismultienc ();
+
+  push_multi_samples (0, 10, TRUE);
+  fail_unless (gst_pad_push_event (multi_srcpad, gst_event_new_eos ()));
+  rest = check_multi_enc_stream (buffers, 10 * MULTI_SAMPLES, 0,
+      samples_to_time (10 * MULTI_SAMPLES), 0);
+  fail_unless (rest == NULL);
+  n_first = g_list_length (buffers);
+
+  flush_multi ();
+  push_multi_samples (10 * GST_SECOND, 5, TRUE);
+  fail_unless (gst_pad_push_event (multi_srcpad, gst_event_new_eos ()));
+  rest = check_multi_enc_stream (g_list_nth (buffers, n_first),
+      5 * MULTI_SAMPLES, 10 * GST_SECOND,
+      10 * GST_SECOND + samples_to_time (5 * MULTI_SAMPLES), 0);
+  fail_unless (rest == NULL);
+
+  cleanup_vorbismultienc (enc);
+}
+
+GST_END_TEST;
+
+/* a flush drops what the encoder still had, the data after it is a new
+ * stream */
+GST_START_TEST (test_multi_flush)
+{
+  GstElement *enc;
+  GList *rest;
+
+  enc = setup_vorbismultienc ();
+
+  push_multi_samples (0, 10, TRUE);
+  fail_unless (g_list_length (buffers) > 3);
+
+  flush_multi ();
+  push_multi_samples (0, 5, TRUE);
+  fail_unless (gst_pad_push_event (multi_srcpad, gst_event_new_eos ()));
+
+  /* the first stream never got its last packets */
+  rest = check_multi_headers (buffers, -1);
+  fail_unless (rest != NULL);
+  fail_unless (GST_BUFFER_OFFSET_END (rest->prev->data) < 10 * MULTI_SAMPLES);
+
+  rest = check_multi_enc_stream (rest, 5 * MULTI_SAMPLES, 0,
+      samples_to_time (5 * MULTI_SAMPLES), 0);
+  fail_unless (rest == NULL);
+
+  cleanup_vorbismultienc (enc);
+}
+
+GST_END_TEST;
+
+/* a gap in the timestamps moves the timestamps of the packets after it but
+ * the stream and its granulepos go on, going back in time starts a new
+ * stream */
+GST_START_TEST (test_multi_discont)
+{
+  GstElement *enc;
+  GList *rest;
+  GstClockTime gap_ts = 2 * GST_SECOND;
+  guint n_first;
+
+  enc = setup_vorbismultienc ();
+
+  push_multi_samples (0, 10, TRUE);
+  push_multi_samples (gap_ts, 10, FALSE);
+  fail_unless (gst_pad_push_event (multi_srcpad, gst_event_new_eos ()));
+
+  rest = check_multi_enc_stream (buffers, 20 * MULTI_SAMPLES, 0,
+      gap_ts - samples_to_time (10 * MULTI_SAMPLES) +
+      samples_to_time (20 * MULTI_SAMPLES), 1);
+  fail_unless (rest == NULL);
+  n_first = g_list_length (buffers);
+
+  /* without a gap a DISCONT flag only marks the next packet */
+  flush_multi ();
+  push_multi_samples (0, 10, TRUE);
+  push_multi_samples (samples_to_time (10 * MULTI_SAMPLES), 10, TRUE);
+  fail_unless (gst_pad_push_event (multi_srcpad, gst_event_new_eos ()));
+
+  rest = check_multi_enc_stream (g_list_nth (buffers, n_first),
+      20 * MULTI_SAMPLES, 0, samples_to_time (20 * MULTI_SAMPLES), 1);
+  fail_unless (rest == NULL);
+  n_first = g_list_length (buffers);
+
+  /* going back */
+  flush_multi ();
+  push_multi_samples (gap_ts, 10, TRUE);
+  push_multi_samples (0, 5, TRUE);
+  fail_unless (gst_pad_push_event (multi_srcpad, gst_event_new_eos ()));
+
+  rest = check_multi_enc_stream (g_list_nth (buffers, n_first),
+      10 * MULTI_SAMPLES, gap_ts,
+      gap_ts + samples_to_time (10 * MULTI_SAMPLES), 0);
+  rest = check_multi_enc_stream (rest, 5 * MULTI_SAMPLES, 0,
+      samples_to_time (5 * MULTI_SAMPLES), 0);
+  fail_unless (rest == NULL);
+
+  cleanup_vorbismultienc (enc);
+}
+
+GST_END_TEST;
+
 static Suite *
 vorbisenc_suite (void)
 {
@@ -378,7 +738,11 @@ vorbisenc_suite (void)
   tcase_add_test (tc_chain, test_granulepos_offset);
   tcase_add_test (tc_chain, test_timestamps);
   tcase_add_test (tc_chain, test_discontinuity);
+  tcase_add_test (tc_chain, test_multi_quality);
 #endif
+  tcase_add_test (tc_chain, test_multi_eos_restart);
+  tcase_add_test (tc_chain, test_multi_flush);
+  tcase_add_test (tc_chain, test_multi_discont);
 
   return s;
 }
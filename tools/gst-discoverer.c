@@ -494,6 +494,7 @@ main (int argc, char **argv)
   GError *err = NULL;
   GstDiscoverer *dc;
   gint timeout = 10;
+  gboolean use_cache = FALSE;
   GOptionEntry options[] = {
     {"async", 'a', 0, G_OPTION_ARG_NONE, &async,
         "Run asynchronously", NULL},
@@ -505,6 +506,8 @@ main (int argc, char **argv)
     /*     "Seek on elements instead of pads", NULL}, */
     {"verbose", 'v', 0, G_OPTION_ARG_NONE, &verbose,
         "Verbose properties", NULL},
+    {"cache", 'c', 0, G_OPTION_ARG_NONE, &use_cache,
+        "Use cached results for unchanged local files", NULL},
     {NULL}
   };
   GOptionContext *ctx;
@@ -525,6 +528,8 @@ main (int argc, char **argv)
     exit (1);
   }
 
+  g_object_set (dc, "use-cache", use_cache, NULL);
+
   g_option_context_free (ctx);
 
   if (argc < 2) {